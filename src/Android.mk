@@ -63,6 +63,7 @@ COMMON_SRC_FILES += \
 COMMON_SRC_FILES += \
 	Reactor/Reactor.cpp \
 	Reactor/Routine.cpp \
+	Reactor/CPUID.cpp \
 	Reactor/Debug.cpp \
 	Reactor/DebugAndroid.cpp \
 	Reactor/ExecutableMemory.cpp
@@ -75,8 +76,7 @@ else
 COMMON_SRC_FILES += \
 	Reactor/LLVMReactor.cpp \
 	Reactor/LLVMRoutine.cpp \
-	Reactor/LLVMRoutineManager.cpp \
-	Reactor/CPUID.cpp
+	Reactor/LLVMRoutineManager.cpp
 endif
 
 COMMON_SRC_FILES += \
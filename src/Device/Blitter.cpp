@@ -14,12 +14,16 @@
 
 #include "Blitter.hpp"
 
+#include "RoutineStore.hpp"
+
 #include "Pipeline/ShaderCore.hpp"
 #include "Reactor/Reactor.hpp"
 #include "System/Memory.hpp"
+#include "System/ThreadPool.hpp"
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkImage.hpp"
 
+#include <algorithm>
 #include <utility>
 
 namespace sw
@@ -54,8 +58,6 @@ namespace sw
 			return;
 		}
 
-		void(*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
-
 		VkImageSubresourceLayers subresLayers =
 		{
 			subresourceRange.aspectMask,
@@ -67,6 +69,8 @@ namespace sw
 		uint32_t lastMipLevel = dest->getLastMipLevel(subresourceRange);
 		uint32_t lastLayer = dest->getLastLayerIndex(subresourceRange);
 
+		std::vector<BlitData> blits;
+
 		VkRect2D area = { { 0, 0 }, { 0, 0 } };
 		if(renderArea)
 		{
@@ -106,10 +110,47 @@ namespace sw
 				{
 					data.dest = dest->getTexelPointer({ 0, 0, static_cast<int32_t>(depth) }, subresLayers);
 
-					blitFunction(&data);
+					blits.push_back(data);
 				}
 			}
 		}
+
+		dispatch(blitRoutine, blits);
+		blitRoutine->unbind();
+	}
+
+	bool Blitter::packClearValue(void *pixel, vk::Format format, vk::Format destFormat, void *texel)
+	{
+		State state(format, destFormat, 1, 1, { 0xF });
+		Routine *blitRoutine = getRoutine(state);
+		if(!blitRoutine)
+		{
+			return false;
+		}
+
+		void(*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
+
+		BlitData data =
+		{
+			pixel, texel, // source, dest
+
+			format.bytes(),     // sPitchB
+			destFormat.bytes(), // dPitchB
+			0,                  // sSliceB (unused in clear operations)
+			0,                  // dSliceB (single sample)
+
+			0.5f, 0.5f, 0.0f, 0.0f, // x0, y0, w, h
+
+			0, 1, // y0d, y1d
+			0, 1, // x0d, x1d
+
+			0, 0, // sWidth, sHeight
+		};
+
+		blitFunction(&data);
+		blitRoutine->unbind();
+
+		return true;
 	}
 
 	bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const VkImageSubresourceRange& subresourceRange, const VkRect2D* renderArea)
@@ -181,6 +222,17 @@ namespace sw
 			area = *renderArea;
 		}
 
+		// Each cleared rectangle of a single sample plane
+		struct ClearArea
+		{
+			uint8_t *slice;
+			int rowPitchBytes;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		std::vector<ClearArea> clearAreas;
+
 		for(; subresLayers.mipLevel <= lastMipLevel; subresLayers.mipLevel++)
 		{
 			int rowPitchBytes = dest->rowPitchBytes(aspect, subresLayers.mipLevel);
@@ -201,27 +253,7 @@ namespace sw
 
 					for(int j = 0; j < dest->getSampleCountFlagBits(); j++)
 					{
-						uint8_t *d = slice;
-
-						switch(dest->getFormat(aspect).bytes())
-						{
-						case 2:
-							for(uint32_t i = 0; i < area.extent.height; i++)
-							{
-								sw::clear((uint16_t*)d, packed, area.extent.width);
-								d += rowPitchBytes;
-							}
-							break;
-						case 4:
-							for(uint32_t i = 0; i < area.extent.height; i++)
-							{
-								sw::clear((uint32_t*)d, packed, area.extent.width);
-								d += rowPitchBytes;
-							}
-							break;
-						default:
-							assert(false);
-						}
+						clearAreas.push_back({ slice, rowPitchBytes, area.extent.width, area.extent.height });
 
 						slice += slicePitchBytes;
 					}
@@ -229,6 +261,39 @@ namespace sw
 			}
 		}
 
+		// Split the areas into bands of rows, sized like the blit routine's bands
+		const int bytes = dest->getFormat(aspect).bytes();
+		const uint32_t rowsPerBand = std::max(1u, static_cast<uint32_t>(BAND_PIXELS) / std::max(area.extent.width, 1u));
+		const uint32_t bandsPerArea = (area.extent.height + rowsPerBand - 1) / rowsPerBand;
+
+		ThreadPool::get().parallelFor(static_cast<int>(clearAreas.size() * bandsPerArea), [&](int index, int)
+		{
+			const ClearArea &clearArea = clearAreas[index / bandsPerArea];
+			uint32_t y0 = (index % bandsPerArea) * rowsPerBand;
+			uint32_t y1 = std::min(y0 + rowsPerBand, clearArea.height);
+			uint8_t *d = clearArea.slice + y0 * clearArea.rowPitchBytes;
+
+			switch(bytes)
+			{
+			case 2:
+				for(uint32_t i = y0; i < y1; i++)
+				{
+					sw::clear((uint16_t*)d, packed, clearArea.width);
+					d += clearArea.rowPitchBytes;
+				}
+				break;
+			case 4:
+				for(uint32_t i = y0; i < y1; i++)
+				{
+					sw::clear((uint32_t*)d, packed, clearArea.width);
+					d += clearArea.rowPitchBytes;
+				}
+				break;
+			default:
+				assert(false);
+			}
+		});
+
 		return true;
 	}
 
@@ -1499,30 +1564,27 @@ namespace sw
 			}
 		}
 
-		return function("BlitRoutine");
+		return function(MinimalOptimization, "BlitRoutine");
 	}
 
 	Routine *Blitter::getRoutine(const State &state)
 	{
-		criticalSection.lock();
-		Routine *blitRoutine = blitCache->query(state);
+		State key = state;
+		key.hash = key.computeHash();
 
-		if(!blitRoutine)
+		Routine *blitRoutine = blitCache->getOrCreate(key, [&]()
 		{
-			blitRoutine = generate(state);
+			RoutineStore::Key storeKey("BlitRoutine");
+			storeKey.add(key);
 
-			if(!blitRoutine)
-			{
-				criticalSection.unlock();
-				UNIMPLEMENTED("blitRoutine");
-				return nullptr;
-			}
+			return RoutineStore::getOrGenerate(storeKey, [&]() { return generate(key); });
+		});
 
-			blitCache->add(state, blitRoutine);
+		if(!blitRoutine)
+		{
+			UNIMPLEMENTED("blitRoutine");
 		}
 
-		criticalSection.unlock();
-
 		return blitRoutine;
 	}
 
@@ -1581,8 +1643,6 @@ namespace sw
 			return;
 		}
 
-		void(*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
-
 		BlitData data =
 		{
 			nullptr, // source
@@ -1636,6 +1696,8 @@ namespace sw
 
 		uint32_t lastLayer = src->getLastLayerIndex(srcSubresRange);
 
+		std::vector<BlitData> blits;
+
 		for(; srcSubresLayers.baseArrayLayer <= lastLayer; srcSubresLayers.baseArrayLayer++, dstSubresLayers.baseArrayLayer++)
 		{
 			srcOffset.z = region.srcOffsets[0].z;
@@ -1649,10 +1711,47 @@ namespace sw
 				ASSERT(data.source < src->end());
 				ASSERT(data.dest < dst->end());
 
-				blitFunction(&data);
+				blits.push_back(data);
 				srcOffset.z++;
 				dstOffset.z++;
 			}
 		}
+
+		dispatch(blitRoutine, blits);
+		blitRoutine->unbind();
+	}
+
+	void Blitter::dispatch(Routine *blitRoutine, const std::vector<BlitData> &blits)
+	{
+		void(*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
+
+		// Each destination row only depends on the BlitData and the source image, so every
+		// slice is split into bands of rows which run concurrently on the ThreadPool. Bands
+		// end on multiples of an even row count of the destination surface, so that the row
+		// pairs of 2x2 quad layout lines are never split, whatever the first row is.
+		std::vector<BlitData> bands;
+		for(const BlitData &data : blits)
+		{
+			int width = std::max(data.x1d - data.x0d, 1);
+			int rowsPerBand = std::max(BAND_PIXELS / width, 1);
+			rowsPerBand = (rowsPerBand + 1) & ~1;
+
+			for(int y = data.y0d; y < data.y1d;)
+			{
+				int end = (y / rowsPerBand + 1) * rowsPerBand;
+
+				BlitData band = data;
+				band.y0d = y;
+				band.y1d = std::min(end, data.y1d);
+				bands.push_back(band);
+
+				y = band.y1d;
+			}
+		}
+
+		ThreadPool::get().parallelFor(static_cast<int>(bands.size()), [&](int band, int)
+		{
+			blitFunction(&bands[band]);
+		});
 	}
 }
@@ -17,10 +17,10 @@
 
 #include "RoutineCache.hpp"
 #include "Reactor/Reactor.hpp"
-#include "System/MutexLock.hpp"
 #include "Vulkan/VkFormat.h"
 
 #include <string.h>
+#include <vector>
 
 namespace vk
 {
@@ -66,6 +66,13 @@ namespace sw
 			State(vk::Format sourceFormat, vk::Format destFormat, int srcSamples, int destSamples, const Options &options) :
 				Options(options), sourceFormat(sourceFormat), destFormat(destFormat), srcSamples(srcSamples), destSamples(destSamples) {}
 
+			unsigned int computeHash() const
+			{
+				unsigned int options = writeMask | (clearOperation << 4) | (filter << 5) | (useStencil << 6) | (convertSRGB << 7) | (clampToEdge << 8);
+
+				return options ^ (static_cast<VkFormat>(sourceFormat) << 9) ^ (static_cast<VkFormat>(destFormat) << 18) ^ (srcSamples << 24) ^ (destSamples << 28);
+			}
+
 			bool operator==(const State &state) const
 			{
 				return memcmp(this, &state, sizeof(State)) == 0;
@@ -75,6 +82,7 @@ namespace sw
 			vk::Format destFormat;
 			int srcSamples = 0;
 			int destSamples = 0;
+			unsigned int hash = 0;   // Set by getRoutine()
 		};
 
 		struct BlitData
@@ -106,6 +114,9 @@ namespace sw
 
 		void clear(void *pixel, vk::Format format, vk::Image *dest, const VkImageSubresourceRange& subresourceRange, const VkRect2D* renderArea = nullptr);
 
+		// Converts a clear value to the texel which clear() would write to an image of destFormat
+		bool packClearValue(void *pixel, vk::Format format, vk::Format destFormat, void *texel);
+
 		void blit(vk::Image *src, vk::Image *dst, VkImageBlit region, VkFilter filter);
 
 	private:
@@ -119,11 +130,13 @@ namespace sw
 		static Int ComputeOffset(Int &x, Int &y, Int &pitchB, int bytes, bool quadLayout);
 		static Float4 LinearToSRGB(Float4 &color);
 		static Float4 sRGBtoLinear(Float4 &color);
-		Routine *getRoutine(const State &state);
+		Routine *getRoutine(const State &state);   // Bound for the caller
 		Routine *generate(const State &state);
+		void dispatch(Routine *blitRoutine, const std::vector<BlitData> &blits);
+
+		enum { BAND_PIXELS = 16 * 1024 };   // Approximate number of pixels blitted or cleared per ThreadPool task
 
 		RoutineCache<State> *blitCache;
-		MutexLock criticalSection;
 	};
 }
 
@@ -49,6 +49,9 @@ namespace sw
 			compressedTex = 0;
 			compressedTexTotal = 0;
 			compressedTexFrame = 0;
+
+			vertexCacheHits = 0;
+			vertexCacheMisses = 0;
 		#endif
 	};
 
@@ -68,6 +68,9 @@ namespace sw
 		int64_t compressedTex;
 		int64_t compressedTexTotal;
 		int64_t compressedTexFrame;
+
+		int64_t vertexCacheHits;
+		int64_t vertexCacheMisses;
 		#endif
 	};
 
@@ -76,7 +79,15 @@ namespace sw
 	enum
 	{
 		OUTLINE_RESOLUTION = 8192,   // Maximum vertical resolution of the render target
+		TILE_SIZE_SHIFT = 6,         // Binned rasterization uses 64x64 pixel tiles
+		HIZ_TILE_WIDTH_SHIFT = 5,    // Hierarchical Z tiles are 32 pixels wide and 2 rows high
+		HIZ_TILE_WIDTH = 1 << HIZ_TILE_WIDTH_SHIFT,
+		CLEAR_TILE_WIDTH_SHIFT = HIZ_TILE_WIDTH_SHIFT,   // Deferred clear tiles match the Hierarchical Z ones
+		CLEAR_TILE_WIDTH = 1 << CLEAR_TILE_WIDTH_SHIFT,
 		MIPMAP_LEVELS = 14,
+		VERTEX_CACHE_SETS = 4,            // Vertex cache sets for non-indexed draws
+		INDEXED_VERTEX_CACHE_SETS = 8,    // Indexed draws use a larger vertex cache
+		INDEXED_VERTEX_CACHE_WAYS = 4,    // Ways for indexed triangle lists and fans. Must be a power of 2
 		TEXTURE_IMAGE_UNITS = 16,
 		VERTEX_TEXTURE_IMAGE_UNITS = 16,
 		TOTAL_IMAGE_UNITS = TEXTURE_IMAGE_UNITS + VERTEX_TEXTURE_IMAGE_UNITS,
@@ -36,16 +36,13 @@ namespace sw
 	bool exactColorRounding = false;
 	TransparencyAntialiasing transparencyAntialiasing = TRANSPARENCY_NONE;
 	bool forceClearRegisters = false;
+	bool tileBinning = false;
 
 	Context::Context()
 	{
 		init();
 	}
 
-	Context::~Context()
-	{
-	}
-
 	void *Context::operator new(size_t bytes)
 	{
 		return allocate((unsigned int)bytes);
@@ -213,6 +210,7 @@ namespace sw
 		instanceID = 0;
 
 		occlusionEnabled = false;
+		statisticsEnabled = false;
 
 		lineWidth = 1.0f;
 
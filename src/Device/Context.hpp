@@ -121,8 +121,6 @@ namespace sw
 	public:
 		Context();
 
-		~Context();
-
 		void *operator new(size_t bytes);
 		void operator delete(void *pointer, size_t bytes);
 
@@ -206,6 +204,7 @@ namespace sw
 		int instanceID;
 
 		bool occlusionEnabled;
+		bool statisticsEnabled;
 
 		// Pixel processor states
 		bool rasterizerDiscard;
@@ -0,0 +1,157 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CopyEngine.hpp"
+
+#include "System/CPUID.hpp"
+#include "System/ThreadPool.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+	#include <emmintrin.h>
+#endif
+
+#if defined(__linux__)
+	#include <unistd.h>
+#endif
+
+namespace sw
+{
+	void CopyEngine::copy(void *dst, const void *src, size_t bytes)
+	{
+		copy(dst, src, bytes, 1, 1, 0, 0, 0, 0);
+	}
+
+	void CopyEngine::copy(void *dst, const void *src, size_t rowBytes, int rows, int slices,
+	                      ptrdiff_t dstPitchB, ptrdiff_t srcPitchB, ptrdiff_t dstSliceB, ptrdiff_t srcSliceB)
+	{
+		uint8_t *dstBytes = static_cast<uint8_t*>(dst);
+		const uint8_t *srcBytes = static_cast<const uint8_t*>(src);
+
+		const size_t rowCount = static_cast<size_t>(rows) * slices;
+		const size_t totalBytes = rowBytes * rowCount;
+
+		auto dstRow = [&](size_t row) { return dstBytes + (row / rows) * dstSliceB + (row % rows) * dstPitchB; };
+		auto srcRow = [&](size_t row) { return srcBytes + (row / rows) * srcSliceB + (row % rows) * srcPitchB; };
+
+		if(totalBytes < PARALLEL_COPY_BYTES)
+		{
+			for(size_t row = 0; row < rowCount; row++)
+			{
+				memcpy(dstRow(row), srcRow(row), rowBytes);
+			}
+
+			return;
+		}
+
+		const bool streaming = totalBytes > getLastLevelCacheSize();
+
+		// Long rows are split into chunks, and short ones are grouped into bands
+		const size_t chunksPerRow = (rowBytes + BAND_BYTES - 1) / BAND_BYTES;
+		const size_t chunkBytes = (((rowBytes + chunksPerRow - 1) / chunksPerRow) + 63) & ~size_t(63);
+		const size_t rowsPerBand = (chunksPerRow > 1) ? 1 : std::max(BAND_BYTES / rowBytes, size_t(1));
+		const size_t bandCount = (chunksPerRow > 1) ? (rowCount * chunksPerRow) : ((rowCount + rowsPerBand - 1) / rowsPerBand);
+
+		ThreadPool::get().parallelFor(static_cast<int>(bandCount), [&](int band, int)
+		{
+			if(chunksPerRow > 1)
+			{
+				size_t row = band / chunksPerRow;
+				size_t offset = (band % chunksPerRow) * chunkBytes;
+
+				if(offset < rowBytes)
+				{
+					copySpan(dstRow(row) + offset, srcRow(row) + offset, std::min(chunkBytes, rowBytes - offset), streaming);
+				}
+			}
+			else
+			{
+				size_t lastRow = std::min((band + 1) * rowsPerBand, rowCount);
+
+				for(size_t row = band * rowsPerBand; row < lastRow; row++)
+				{
+					copySpan(dstRow(row), srcRow(row), rowBytes, streaming);
+				}
+			}
+
+			#if defined(__i386__) || defined(__x86_64__)
+				if(streaming)
+				{
+					// Non-temporal stores are weakly ordered, and must be visible when parallelFor() returns
+					_mm_sfence();
+				}
+			#endif
+		});
+	}
+
+	size_t CopyEngine::getLastLevelCacheSize()
+	{
+		static const size_t size = []() -> size_t
+		{
+			#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+				long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+				if(l3 > 0)
+				{
+					return static_cast<size_t>(l3);
+				}
+
+				long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+				if(l2 > 0)
+				{
+					return static_cast<size_t>(l2);
+				}
+			#endif
+
+			return DEFAULT_LAST_LEVEL_CACHE_SIZE;
+		}();
+
+		return size;
+	}
+
+	void CopyEngine::copySpan(uint8_t *dst, const uint8_t *src, size_t bytes, bool streaming)
+	{
+		#if defined(__i386__) || defined(__x86_64__)
+			if(streaming && CPUID::supportsSSE2())
+			{
+				// Streaming stores require an aligned destination
+				size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+
+				if(bytes > head)
+				{
+					memcpy(dst, src, head);
+					dst += head;
+					src += head;
+					bytes -= head;
+
+					for(; bytes >= 64; bytes -= 64, dst += 64, src += 64)
+					{
+						__m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0));
+						__m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+						__m128i c2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+						__m128i c3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+
+						_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 0), c0);
+						_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), c1);
+						_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c2);
+						_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), c3);
+					}
+				}
+			}
+		#endif
+
+		memcpy(dst, src, bytes);
+	}
+}
@@ -0,0 +1,50 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_CopyEngine_hpp
+#define sw_CopyEngine_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sw
+{
+	// Copies between buffer and image memory. Large copies are split in bands which run
+	// on the ThreadPool. Copies which don't fit in the last level cache use non-temporal
+	// stores, since the start of the destination would be evicted before being used
+	// anyway, and filling the cache with it would evict the renderer's working set.
+	class CopyEngine
+	{
+	public:
+		static void copy(void *dst, const void *src, size_t bytes);
+
+		// Copies rows of rowBytes bytes, which are pitchB bytes apart within a slice
+		// and sliceB bytes apart between slices.
+		static void copy(void *dst, const void *src, size_t rowBytes, int rows, int slices,
+		                 ptrdiff_t dstPitchB, ptrdiff_t srcPitchB, ptrdiff_t dstSliceB, ptrdiff_t srcSliceB);
+
+	private:
+		enum : size_t
+		{
+			PARALLEL_COPY_BYTES = 256 * 1024,                 // Smaller copies run on the calling thread
+			BAND_BYTES = 64 * 1024,                           // Approximate number of bytes copied per ThreadPool task
+			DEFAULT_LAST_LEVEL_CACHE_SIZE = 8 * 1024 * 1024,  // When the cache size can't be queried
+		};
+
+		static size_t getLastLevelCacheSize();
+		static void copySpan(uint8_t *dst, const uint8_t *src, size_t bytes, bool streaming);
+	};
+}
+
+#endif   // sw_CopyEngine_hpp
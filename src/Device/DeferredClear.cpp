@@ -0,0 +1,119 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "DeferredClear.hpp"
+
+#include "System/ThreadPool.hpp"
+#include "Vulkan/VkDebug.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+namespace sw
+{
+	DeferredClear::DeferredClear(int width, int height, int layers, void *memory)
+		: columns(width >> CLEAR_TILE_WIDTH_SHIFT), rows(height >> 1), tiles(reinterpret_cast<uint8_t*>(memory))
+	{
+		memset(tiles, 0, ComputeRequiredSize(width, height, layers));
+	}
+
+	size_t DeferredClear::ComputeRequiredSize(int width, int height, int layers)
+	{
+		return (width >> CLEAR_TILE_WIDTH_SHIFT) * (height >> 1) * layers;
+	}
+
+	VkRect2D DeferredClear::getTileArea(const VkRect2D &area) const
+	{
+		int x0 = std::max(area.offset.x, 0);
+		int y0 = std::max(area.offset.y, 0);
+		int x1 = std::min(area.offset.x + static_cast<int>(area.extent.width), columns << CLEAR_TILE_WIDTH_SHIFT);
+		int y1 = std::min(area.offset.y + static_cast<int>(area.extent.height), rows << 1);
+
+		x0 = (x0 + CLEAR_TILE_WIDTH - 1) & -CLEAR_TILE_WIDTH;
+		y0 = (y0 + 1) & -2;
+		x1 &= -CLEAR_TILE_WIDTH;
+		y1 &= -2;
+
+		if((x0 >= x1) || (y0 >= y1))
+		{
+			return { { 0, 0 }, { 0, 0 } };
+		}
+
+		return { { x0, y0 }, { static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0) } };
+	}
+
+	void DeferredClear::defer(const void *texel, int bytesPerTexel, const VkRect2D &tileArea, int baseLayer, int lastLayer)
+	{
+		ASSERT(!pending && IsSupported(bytesPerTexel));
+
+		for(int i = 0; i < 16; i += bytesPerTexel)
+		{
+			memcpy(reinterpret_cast<uint8_t*>(pattern) + i, texel, bytesPerTexel);
+		}
+
+		int column0 = tileArea.offset.x >> CLEAR_TILE_WIDTH_SHIFT;
+		int column1 = column0 + (tileArea.extent.width >> CLEAR_TILE_WIDTH_SHIFT);
+		int row0 = tileArea.offset.y >> 1;
+		int row1 = row0 + (tileArea.extent.height >> 1);
+
+		for(int layer = baseLayer; layer <= lastLayer; layer++)
+		{
+			uint8_t *layerTiles = getLayer(layer);
+
+			for(int row = row0; row < row1; row++)
+			{
+				memset(layerTiles + row * columns + column0, 1, column1 - column0);
+			}
+		}
+
+		this->baseLayer = baseLayer;
+		this->lastLayer = lastLayer;
+		pending = true;
+	}
+
+	void DeferredClear::resolve(int layer, uint8_t *buffer, int pitchB, int sliceB, int samples, int bytesPerTexel)
+	{
+		uint8_t *layerTiles = getLayer(layer);
+		const int tileBytes = CLEAR_TILE_WIDTH * bytesPerTexel;
+
+		// Each task writes the pending tiles of one row pair
+		ThreadPool::get().parallelFor(rows, [&](int row, int)
+		{
+			uint8_t *rowTiles = layerTiles + row * columns;
+
+			for(int column = 0; column < columns; column++)
+			{
+				if(!rowTiles[column])
+				{
+					continue;
+				}
+
+				for(int sample = 0; sample < samples; sample++)
+				{
+					for(int y = 0; y < 2; y++)
+					{
+						uint8_t *line = buffer + sample * sliceB + (2 * row + y) * pitchB + column * tileBytes;
+
+						for(int i = 0; i < tileBytes; i += sizeof(pattern))
+						{
+							memcpy(line + i, pattern, sizeof(pattern));
+						}
+					}
+				}
+
+				rowTiles[column] = 0;
+			}
+		});
+	}
+}
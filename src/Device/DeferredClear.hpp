@@ -0,0 +1,76 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_DeferredClear_hpp
+#define sw_DeferredClear_hpp
+
+#include "Config.hpp"
+#include "Vulkan/VkConfig.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sw
+{
+	// Tiles of the top mip level of a color attachment which have been cleared by a render
+	// pass's load operation, but not written to memory yet. A tile covers a row pair of
+	// CLEAR_TILE_WIDTH pixels, the unit of work distributed to clusters, so the rasterizer
+	// can write a tile's clear value right before drawing into it for the first time. The
+	// tiles which weren't drawn to get written when the subpass ends. Tiles which straddle
+	// the right or bottom edge of the image aren't tracked, and are cleared immediately.
+	class DeferredClear
+	{
+	public:
+		DeferredClear() = default;
+		DeferredClear(int width, int height, int layers, void *memory);
+
+		static size_t ComputeRequiredSize(int width, int height, int layers);
+
+		// The clear value is replicated to fill a 16 byte pattern
+		static bool IsSupported(int bytesPerTexel) { return (bytesPerTexel > 0) && ((16 % bytesPerTexel) == 0); }
+
+		bool isEnabled() const { return tiles != nullptr; }
+		bool isPending() const { return pending; }
+		uint8_t *getLayer(int layer) const { return tiles + layer * columns * rows; }
+		int getColumns() const { return columns; }
+		int getRows() const { return rows; }
+		int getBaseLayer() const { return baseLayer; }
+		int getLastLayer() const { return lastLayer; }
+		const uint32_t *getPattern() const { return pattern; }
+
+		// The largest area made of whole tracked tiles contained in the given one
+		VkRect2D getTileArea(const VkRect2D &area) const;
+
+		// Records the tiles of an area returned by getTileArea() as cleared to the texel
+		void defer(const void *texel, int bytesPerTexel, const VkRect2D &tileArea, int baseLayer, int lastLayer);
+
+		// Writes the clear value into the pending tiles of a layer, whose samples are sliceB apart
+		void resolve(int layer, uint8_t *buffer, int pitchB, int sliceB, int samples, int bytesPerTexel);
+
+		// All the layers have been resolved
+		void setResolved() { pending = false; }
+
+	private:
+		int columns = 0;
+		int rows = 0;
+		uint8_t *tiles = nullptr;
+
+		uint32_t pattern[4] = {};
+		int baseLayer = 0;
+		int lastLayer = -1;
+		bool pending = false;
+	};
+}
+
+#endif   // sw_DeferredClear_hpp
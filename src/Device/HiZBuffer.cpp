@@ -0,0 +1,82 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "HiZBuffer.hpp"
+
+#include <algorithm>
+#include <float.h>
+
+namespace sw
+{
+	HiZBuffer::HiZBuffer(int width, int height, int layers, void *memory)
+		: columns(width >> HIZ_TILE_WIDTH_SHIFT), rows(height >> 1), tiles(reinterpret_cast<Tile*>(memory))
+	{
+		// The image's contents are undefined until written
+		invalidate(0, layers - 1);
+	}
+
+	size_t HiZBuffer::ComputeRequiredSize(int width, int height, int layers)
+	{
+		return (width >> HIZ_TILE_WIDTH_SHIFT) * (height >> 1) * layers * sizeof(Tile);
+	}
+
+	void HiZBuffer::clear(float depth, const VkRect2D &area, int baseLayer, int lastLayer)
+	{
+		int x0 = std::max(area.offset.x, 0);
+		int y0 = std::max(area.offset.y, 0);
+		int x1 = std::min(area.offset.x + static_cast<int>(area.extent.width), columns << HIZ_TILE_WIDTH_SHIFT);
+		int y1 = std::min(area.offset.y + static_cast<int>(area.extent.height), rows << 1);
+
+		for(int layer = baseLayer; layer <= lastLayer; layer++)
+		{
+			Tile *layerTiles = getLayer(layer);
+
+			for(int y = y0 >> 1; (y << 1) < y1; y++)
+			{
+				bool coveredY = ((y << 1) >= y0) && (((y + 1) << 1) <= y1);
+
+				for(int x = x0 >> HIZ_TILE_WIDTH_SHIFT; (x << HIZ_TILE_WIDTH_SHIFT) < x1; x++)
+				{
+					bool coveredX = ((x << HIZ_TILE_WIDTH_SHIFT) >= x0) && (((x + 1) << HIZ_TILE_WIDTH_SHIFT) <= x1);
+					Tile &tile = layerTiles[y * columns + x];
+
+					if(coveredX && coveredY)
+					{
+						tile.minZ = depth;
+						tile.maxZ = depth;
+					}
+					else   // The rest of the tile keeps its previous depth
+					{
+						tile.minZ = std::min(tile.minZ, depth);
+						tile.maxZ = std::max(tile.maxZ, depth);
+					}
+				}
+			}
+		}
+	}
+
+	void HiZBuffer::invalidate(int baseLayer, int lastLayer)
+	{
+		for(int layer = baseLayer; layer <= lastLayer; layer++)
+		{
+			Tile *layerTiles = getLayer(layer);
+
+			for(int i = 0; i < columns * rows; i++)
+			{
+				layerTiles[i].minZ = -FLT_MAX;
+				layerTiles[i].maxZ = FLT_MAX;
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_HiZBuffer_hpp
+#define sw_HiZBuffer_hpp
+
+#include "Config.hpp"
+#include "Vulkan/VkConfig.h"
+
+#include <stddef.h>
+
+namespace sw
+{
+	// Hierarchical Z: conservative bounds of the depth values in each tile of the top
+	// mip level of a depth image, used by the rasterizer to skip spans of primitives
+	// which can't pass the depth test. A tile covers a row pair of HIZ_TILE_WIDTH pixels,
+	// the unit of work distributed to clusters, so each tile is only updated by one of them.
+	// Tiles which straddle the right or bottom edge of the image aren't tracked.
+	class HiZBuffer
+	{
+	public:
+		struct Tile
+		{
+			float minZ;
+			float maxZ;
+		};
+
+		HiZBuffer() = default;
+		HiZBuffer(int width, int height, int layers, void *memory);
+
+		static size_t ComputeRequiredSize(int width, int height, int layers);
+
+		bool isEnabled() const { return tiles != nullptr; }
+		Tile *getLayer(int layer) const { return tiles + layer * columns * rows; }
+		int getColumns() const { return columns; }
+		int getRows() const { return rows; }
+
+		// Depth of the area has been set to the given value
+		void clear(float depth, const VkRect2D &area, int baseLayer, int lastLayer);
+
+		// Depth of the layers has been modified in ways which aren't tracked
+		void invalidate(int baseLayer, int lastLayer);
+
+	private:
+		int columns = 0;
+		int rows = 0;
+		Tile *tiles = nullptr;
+	};
+}
+
+#endif   // sw_HiZBuffer_hpp
@@ -15,10 +15,12 @@
 #include "PixelProcessor.hpp"
 
 #include "Primitive.hpp"
+#include "RoutineStore.hpp"
 #include "Pipeline/PixelProgram.hpp"
 #include "Pipeline/Constants.hpp"
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkImageView.hpp"
+#include "Vulkan/VkPipelineLayout.hpp"
 
 #include <string.h>
 
@@ -26,6 +28,7 @@ namespace sw
 {
 	extern TransparencyAntialiasing transparencyAntialiasing;
 	extern bool perspectiveCorrection;
+	extern bool tileBinning;
 
 	bool precachePixel = false;
 
@@ -306,9 +309,32 @@ namespace sw
 		}
 
 		state.occlusionEnabled = context->occlusionEnabled;
+		state.statisticsEnabled = context->statisticsEnabled;
 
 		state.perspective = context->perspectiveActive();
 		state.depthClamp = (context->depthBias != 0.0f) || (context->slopeDepthBias != 0.0f);
+		state.tileBinning = tileBinning;
+
+		if(state.depthTestActive && !state.quadLayoutDepthBuffer && context->depthBuffer->getHiZTiles())
+		{
+			// Rejected fragments must not have any side effect other than failing the depth test
+			bool earlyDepthTest = !(context->pixelShader && context->pixelShader->getModes().DepthReplacing) && !state.alphaTestActive();
+
+			switch(state.depthCompareMode)
+			{
+			case VK_COMPARE_OP_LESS:
+			case VK_COMPARE_OP_LESS_OR_EQUAL:
+			case VK_COMPARE_OP_EQUAL:
+			case VK_COMPARE_OP_GREATER:
+			case VK_COMPARE_OP_GREATER_OR_EQUAL:
+				state.hiZTest = earlyDepthTest && !state.stencilActive;
+				break;
+			default:
+				break;
+			}
+
+			state.hiZUpdate = state.depthWriteEnable;
+		}
 
 		if(context->alphaBlendActive())
 		{
@@ -325,6 +351,11 @@ namespace sw
 		{
 			state.colorWriteMask |= context->colorWriteActive(i) << (4 * i);
 			state.targetFormat[i] = context->renderTargetInternalFormat(i);
+
+			if(context->colorWriteActive(i) && context->renderTarget[i]->getDeferredClearTiles())
+			{
+				state.deferredClearMask |= 1 << i;
+			}
 		}
 
 		state.writeSRGB	= context->writeSRGB && context->renderTarget[0] && context->renderTarget[0]->getFormat().isSRGBwritable();
@@ -345,18 +376,32 @@ namespace sw
 
 	Routine *PixelProcessor::routine(const State &state)
 	{
-		Routine *routine = routineCache->query(state);
-
-		if(!routine)
+		auto generate = [&]()
 		{
 			QuadRasterizer *generator = new PixelProgram(state, context->pipelineLayout, context->pixelShader);
 			generator->generate();
-			routine = (*generator)("PixelRoutine_%0.8X", state.shaderID);
+			Routine *routine = (*generator)(AggressiveOptimization, "PixelRoutine_%0.8X", state.shaderID);
 			delete generator;
 
-			routineCache->add(state, routine);
-		}
+			return routine;
+		};
+
+		return routineCache->getOrCreate(state, [&]()
+		{
+			if(!precachePixel)
+			{
+				return generate();
+			}
+
+			States states;
+			memcpy(&states, static_cast<const States*>(&state), sizeof(States));
+			states.shaderID = 0;   // Only meaningful within this process, the shader's code is keyed instead
+
+			RoutineStore::Key key("PixelRoutine");
+			key.add(states);
+			key.addShader(context->pixelShader, context->pipelineLayout);
 
-		return routine;
+			return RoutineStore::getOrGenerate(key, generate);
+		});
 	}
 }
@@ -45,8 +45,12 @@ namespace sw
 
 			bool depthTestActive;
 			bool occlusionEnabled;
+			bool statisticsEnabled;
 			bool perspective;
 			bool depthClamp;
+			bool tileBinning;
+			bool hiZTest;     // Reject spans using the depth bounds of the attachment's tiles
+			bool hiZUpdate;   // Refresh the depth bounds of the tiles written to
 
 			bool alphaBlendActive;
 			VkBlendFactor sourceBlendFactor;
@@ -57,6 +61,7 @@ namespace sw
 			VkBlendOp blendOperationAlpha;
 
 			unsigned int colorWriteMask;
+			unsigned int deferredClearMask;   // Render targets with tiles which haven't received their clear value yet
 			VkFormat targetFormat[RENDERTARGETS];
 			bool writeSRGB;
 			unsigned int multiSample;
@@ -164,7 +169,7 @@ namespace sw
 
 	protected:
 		const State update() const;
-		Routine *routine(const State &state);
+		Routine *routine(const State &state);   // Bound for the caller
 		void setRoutineCacheSize(int routineCacheSize);
 
 		// Other semi-constants
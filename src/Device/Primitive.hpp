@@ -38,6 +38,8 @@ namespace sw
 	{
 		int yMin;
 		int yMax;
+		int xMin;   // Conservative horizontal bounds, used to skip tiles
+		int xMax;
 
 		float4 xQuad;
 		float4 yQuad;
@@ -20,6 +20,8 @@
 #include "System/Math.hpp"
 #include "Vulkan/VkDebug.hpp"
 
+#include <float.h>
+
 namespace sw
 {
 	extern bool fullPixelPositionRegister;
@@ -47,6 +49,7 @@ namespace sw
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
 		occlusion = 0;
+		invocations = 0;
 		int clusterCount = Renderer::getClusterCount();
 
 		Do
@@ -54,14 +57,45 @@ namespace sw
 			Int yMin = *Pointer<Int>(primitive + OFFSET(Primitive,yMin));
 			Int yMax = *Pointer<Int>(primitive + OFFSET(Primitive,yMax));
 
-			Int cluster2 = cluster + cluster;
-			yMin += clusterCount * 2 - 2 - cluster2;
-			yMin &= -clusterCount * 2;
-			yMin += cluster2;
+			if(state.tileBinning)
+			{
+				// The screen is divided into tiles, assigned to clusters diagonally so that each
+				// cluster owns whole regions of the framebuffer. Only the tiles this cluster owns
+				// which overlap the primitive's bounding box get rasterized.
+				Int xMin = *Pointer<Int>(primitive + OFFSET(Primitive,xMin));
+				Int xMax = *Pointer<Int>(primitive + OFFSET(Primitive,xMax));
+
+				For(Int tileY = yMin >> TILE_SIZE_SHIFT, (tileY << TILE_SIZE_SHIFT) < yMax, tileY++)
+				{
+					Int y0 = Max(yMin & 0xFFFFFFFE, tileY << TILE_SIZE_SHIFT);
+					Int y1 = Min(yMax, (tileY + 1) << TILE_SIZE_SHIFT);
+
+					Int tileX = xMin >> TILE_SIZE_SHIFT;
+					tileX += (cluster - tileX - tileY) & (clusterCount - 1);
+
+					For(, (tileX << TILE_SIZE_SHIFT) < xMax, tileX += clusterCount)
+					{
+						Int x0 = tileX << TILE_SIZE_SHIFT;
+						Int x1 = (tileX + 1) << TILE_SIZE_SHIFT;
 
-			If(yMin < yMax)
+						rasterize(y0, y1, x0, x1);
+					}
+				}
+			}
+			else
 			{
-				rasterize(yMin, yMax);
+				Int cluster2 = cluster + cluster;
+				yMin += clusterCount * 2 - 2 - cluster2;
+				yMin &= -clusterCount * 2;
+				yMin += cluster2;
+
+				If(yMin < yMax)
+				{
+					Int xMin = 0;
+					Int xMax = 0;
+
+					rasterize(yMin, yMax, xMin, xMax);
+				}
 			}
 
 			primitive += sizeof(Primitive) * state.multiSample;
@@ -71,9 +105,18 @@ namespace sw
 
 		if(state.occlusionEnabled)
 		{
-			UInt clusterOcclusion = *Pointer<UInt>(data + OFFSET(DrawData,occlusion) + 4 * cluster);
+			Pointer<Byte> occlusionCounters = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,occlusion));
+			UInt clusterOcclusion = *Pointer<UInt>(occlusionCounters + 4 * cluster);
 			clusterOcclusion += occlusion;
-			*Pointer<UInt>(data + OFFSET(DrawData,occlusion) + 4 * cluster) = clusterOcclusion;
+			*Pointer<UInt>(occlusionCounters + 4 * cluster) = clusterOcclusion;
+		}
+
+		if(state.statisticsEnabled)
+		{
+			Pointer<Byte> invocationCounters = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,fragmentInvocations));
+			UInt clusterInvocations = *Pointer<UInt>(invocationCounters + 4 * cluster);
+			clusterInvocations += invocations;
+			*Pointer<UInt>(invocationCounters + 4 * cluster) = clusterInvocations;
 		}
 
 		#if PERF_PROFILE
@@ -81,14 +124,17 @@ namespace sw
 
 			for(int i = 0; i < PERF_TIMERS; i++)
 			{
-				*Pointer<Long>(data + OFFSET(DrawData,cycles[i]) + 8 * cluster) += cycles[i];
+				Pointer<Byte> cycleCounters = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,cycles[i]));
+				*Pointer<Long>(cycleCounters + 8 * cluster) += cycles[i];
 			}
 		#endif
 
 		Return();
 	}
 
-	void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
+	// When tile binning is enabled, rasterization is limited to the [xMin, xMax) tile columns,
+	// and all row pairs of [yMin, yMax) are processed instead of the ones of this cluster.
+	void QuadRasterizer::rasterize(Int &yMin, Int &yMax, Int &xMin, Int &xMax)
 	{
 		Pointer<Byte> cBuffer[RENDERTARGETS];
 		Pointer<Byte> zBuffer;
@@ -112,6 +158,17 @@ namespace sw
 			sBuffer = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,stencilBuffer)) + yMin * *Pointer<Int>(data + OFFSET(DrawData,stencilPitchB));
 		}
 
+		Pointer<Byte> hiZTiles;
+		Int hiZColumns;
+		Int hiZRows;
+
+		if(state.hiZTest || state.hiZUpdate)
+		{
+			hiZTiles = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,hiZTiles));
+			hiZColumns = *Pointer<Int>(data + OFFSET(DrawData,hiZColumns));
+			hiZRows = *Pointer<Int>(data + OFFSET(DrawData,hiZRows));
+		}
+
 		Int y = yMin;
 
 		Do
@@ -129,6 +186,11 @@ namespace sw
 
 			x0 &= 0xFFFFFFFE;
 
+			if(state.tileBinning)
+			{
+				x0 = Max(x0, xMin);
+			}
+
 			Int x1a = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->right) + (y + 0) * sizeof(Primitive::Span)));
 			Int x1b = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->right) + (y + 1) * sizeof(Primitive::Span)));
 			Int x1 = Max(x1a, x1b);
@@ -140,6 +202,11 @@ namespace sw
 				x1 = Max(x1, Max(x1a, x1b));
 			}
 
+			if(state.tileBinning)
+			{
+				x1 = Min(x1, xMax);
+			}
+
 			Float4 yyyy = Float4(Float(y)) + *Pointer<Float4>(primitive + OFFSET(Primitive,yQuad), 16);
 
 			if(interpolateZ())
@@ -188,22 +255,68 @@ namespace sw
 					xRight[q] = Swizzle(xRight[q], 0xF5) - Short4(0, 1, 0, 1);
 				}
 
-				For(Int x = x0, x < x1, x += 2)
+				if(!state.hiZTest && !state.hiZUpdate && !state.deferredClearMask)
+				{
+					rasterizeSpan(cBuffer, zBuffer, sBuffer, xLeft, xRight, x0, x1, y);
+				}
+				else
 				{
-					Short4 xxxx = Short4(x);
-					Int cMask[4];
+					// y is even, so each row pair corresponds to one row of tiles.
+					// Deferred clear tiles have the same size as the Hi-Z ones.
+					Int tileRow = y >> 1;
+					Pointer<Byte> tiles;
 
-					for(unsigned int q = 0; q < state.multiSample; q++)
+					if(state.hiZTest || state.hiZUpdate)
 					{
-						Short4 mask = CmpGT(xxxx, xLeft[q]) & CmpGT(xRight[q], xxxx);
-						cMask[q] = SignMask(PackSigned(mask, mask)) & 0x0000000F;
+						tiles = hiZTiles + tileRow * hiZColumns * Int(sizeof(HiZBuffer::Tile));
 					}
 
-					quad(cBuffer, zBuffer, sBuffer, cMask, x, y);
+					For(Int tileX0 = x0 & -HIZ_TILE_WIDTH, tileX0 < x1, tileX0 += HIZ_TILE_WIDTH)
+					{
+						Int tileColumn = tileX0 >> HIZ_TILE_WIDTH_SHIFT;
+						Pointer<Byte> tile;
+						Bool tracked;
+						Bool hidden = false;
+
+						if(state.hiZTest || state.hiZUpdate)
+						{
+							tile = tiles + tileColumn * Int(sizeof(HiZBuffer::Tile));
+							tracked = (tileRow < hiZRows) && (tileColumn < hiZColumns);
+						}
+
+						if(state.hiZTest)
+						{
+							If(tracked)
+							{
+								hidden = hiZReject(tile, tileX0, y);
+							}
+						}
+
+						If(!hidden)
+						{
+							Int spanX0 = Max(x0, tileX0);
+							Int spanX1 = Min(x1, tileX0 + HIZ_TILE_WIDTH);
+
+							if(state.deferredClearMask)
+							{
+								writeDeferredClear(cBuffer, tileX0, y);
+							}
+
+							rasterizeSpan(cBuffer, zBuffer, sBuffer, xLeft, xRight, spanX0, spanX1, y);
+
+							if(state.hiZUpdate)
+							{
+								If(tracked)
+								{
+									updateHiZ(tile, zBuffer, tileX0);
+								}
+							}
+						}
+					}
 				}
 			}
 
-			int clusterCount = Renderer::getClusterCount();
+			int clusterCount = state.tileBinning ? 1 : Renderer::getClusterCount();
 
 			for(int index = 0; index < RENDERTARGETS; index++)
 			{
@@ -228,6 +341,152 @@ namespace sw
 		Until(y >= yMax)
 	}
 
+	void QuadRasterizer::rasterizeSpan(Pointer<Byte> cBuffer[4], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Short4 xLeft[4], Short4 xRight[4], Int &x0, Int &x1, Int &y)
+	{
+		For(Int x = x0, x < x1, x += 2)
+		{
+			Short4 xxxx = Short4(x);
+			Int cMask[4];
+
+			for(unsigned int q = 0; q < state.multiSample; q++)
+			{
+				Short4 mask = CmpGT(xxxx, xLeft[q]) & CmpGT(xRight[q], xxxx);
+				cMask[q] = SignMask(PackSigned(mask, mask)) & 0x0000000F;
+			}
+
+			quad(cBuffer, zBuffer, sBuffer, cMask, x, y);
+		}
+	}
+
+	Bool QuadRasterizer::hiZReject(Pointer<Byte> &tile, Int &tileX0, Int &y)
+	{
+		// Bounds of the primitive's depth over the tile's row pair, widened by a
+		// pixel on each side to cover all sample positions.
+		Float A = *Pointer<Float>(primitive + OFFSET(Primitive,z.A));
+		Float B = *Pointer<Float>(primitive + OFFSET(Primitive,z.B));
+		Float C = *Pointer<Float>(primitive + OFFSET(Primitive,z.C));
+
+		Float x0 = Float(tileX0 - 1) + *Pointer<Float>(primitive + OFFSET(Primitive,xQuad));
+		Float x1 = x0 + Float(HIZ_TILE_WIDTH + 2);
+		Float y0 = Float(y - 1) + *Pointer<Float>(primitive + OFFSET(Primitive,yQuad));
+		Float y1 = y0 + Float(4.0f);
+
+		Float Ax0 = A * x0;
+		Float Ax1 = A * x1;
+		Float By0 = B * y0;
+		Float By1 = B * y1;
+
+		// The per-pixel interpolation rounds differently, by at most a few ulp of its terms
+		Float margin = (Abs(C) + Max(Abs(Ax0), Abs(Ax1)) + Max(Abs(By0), Abs(By1))) * Float(1.0f / 0x40000);
+
+		Float zMin = C + Min(Ax0, Ax1) + Min(By0, By1) - margin;
+		Float zMax = C + Max(Ax0, Ax1) + Max(By0, By1) + margin;
+
+		if(state.depthClamp)
+		{
+			zMin = Min(Max(zMin, Float(0.0f)), Float(1.0f));
+			zMax = Min(Max(zMax, Float(0.0f)), Float(1.0f));
+		}
+
+		Float tileMin = *Pointer<Float>(tile + OFFSET(HiZBuffer::Tile,minZ));
+		Float tileMax = *Pointer<Float>(tile + OFFSET(HiZBuffer::Tile,maxZ));
+
+		switch(state.depthCompareMode)
+		{
+		case VK_COMPARE_OP_LESS:
+		case VK_COMPARE_OP_LESS_OR_EQUAL:
+			return zMin > tileMax;
+		case VK_COMPARE_OP_GREATER:
+		case VK_COMPARE_OP_GREATER_OR_EQUAL:
+			return zMax < tileMin;
+		case VK_COMPARE_OP_EQUAL:
+			return (zMin > tileMax) || (zMax < tileMin);
+		default:
+			ASSERT(false);
+			return false;
+		}
+	}
+
+	void QuadRasterizer::updateHiZ(Pointer<Byte> &tile, Pointer<Byte> &zBuffer, Int &tileX0)
+	{
+		// Recompute the tile's bounds from the depth buffer, which holds the result of
+		// every depth test and write, so this is exact whatever the draw's state.
+		Int pitch = *Pointer<Int>(data + OFFSET(DrawData,depthPitchB));
+		Float4 minZ = Float4(FLT_MAX);
+		Float4 maxZ = Float4(-FLT_MAX);
+
+		for(unsigned int q = 0; q < state.multiSample; q++)
+		{
+			Pointer<Byte> buffer = zBuffer + tileX0 * 4;
+
+			if(q > 0)
+			{
+				buffer += q * *Pointer<Int>(data + OFFSET(DrawData,depthSliceB));
+			}
+
+			for(int i = 0; i < HIZ_TILE_WIDTH; i += 4)
+			{
+				Float4 z0 = *Pointer<Float4>(buffer + 4 * i);
+				Float4 z1 = *Pointer<Float4>(buffer + pitch + 4 * i);
+
+				minZ = Min(minZ, Min(z0, z1));
+				maxZ = Max(maxZ, Max(z0, z1));
+			}
+		}
+
+		*Pointer<Float>(tile + OFFSET(HiZBuffer::Tile,minZ)) = Min(Min(Float(minZ.x), Float(minZ.y)), Min(Float(minZ.z), Float(minZ.w)));
+		*Pointer<Float>(tile + OFFSET(HiZBuffer::Tile,maxZ)) = Max(Max(Float(maxZ.x), Float(maxZ.y)), Max(Float(maxZ.z), Float(maxZ.w)));
+	}
+
+	void QuadRasterizer::writeDeferredClear(Pointer<Byte> cBuffer[4], Int &tileX0, Int &y)
+	{
+		// The first span drawn into a tile which still holds a deferred clear writes the
+		// clear value into all of the tile's pixels first, while they're brought into cache.
+		Int tileRow = y >> 1;
+		Int tileColumn = tileX0 >> CLEAR_TILE_WIDTH_SHIFT;
+
+		for(int index = 0; index < RENDERTARGETS; index++)
+		{
+			if(!(state.deferredClearMask & (1 << index)))
+			{
+				continue;
+			}
+
+			Int columns = *Pointer<Int>(data + OFFSET(DrawData,clearColumns[index]));
+			Int rows = *Pointer<Int>(data + OFFSET(DrawData,clearRows[index]));
+
+			If((tileRow < rows) && (tileColumn < columns))
+			{
+				Pointer<Byte> tile = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,clearTiles[index])) + tileRow * columns + tileColumn;
+
+				If(Int(*Pointer<Byte>(tile)) != 0)
+				{
+					Int4 pattern = *Pointer<Int4>(data + OFFSET(DrawData,clearPattern[index]));
+					Int pitch = *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index]));
+					int bytes = vk::Format(state.targetFormat[index]).bytes();
+
+					for(unsigned int q = 0; q < state.multiSample; q++)
+					{
+						Pointer<Byte> buffer = cBuffer[index] + tileX0 * bytes;
+
+						if(q > 0)
+						{
+							buffer += q * *Pointer<Int>(data + OFFSET(DrawData,colorSliceB[index]));
+						}
+
+						For(Int i = 0, i < Int(CLEAR_TILE_WIDTH * bytes), i += 16)
+						{
+							*Pointer<Int4>(buffer + i) = pattern;
+							*Pointer<Int4>(buffer + pitch + i) = pattern;
+						}
+					}
+
+					*Pointer<Byte>(tile) = Byte(0);
+				}
+			}
+		}
+	}
+
 	Float4 QuadRasterizer::interpolate(Float4 &x, Float4 &D, Float4 &rhw, Pointer<Byte> planeEquation, bool flat, bool perspective, bool clamp)
 	{
 		Float4 interpolant = D;
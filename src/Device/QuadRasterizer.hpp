@@ -39,6 +39,7 @@ namespace sw
 		Float4 Df;
 
 		UInt occlusion;
+		UInt invocations;
 
 #if PERF_PROFILE
 		Long cycles[PERF_TIMERS];
@@ -54,7 +55,13 @@ namespace sw
 		const SpirvShader *const spirvShader;
 
 	private:
-		void rasterize(Int &yMin, Int &yMax);
+		void rasterize(Int &yMin, Int &yMax, Int &xMin, Int &xMax);
+		void rasterizeSpan(Pointer<Byte> cBuffer[4], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Short4 xLeft[4], Short4 xRight[4], Int &x0, Int &x1, Int &y);
+
+		// Hierarchical Z
+		Bool hiZReject(Pointer<Byte> &tile, Int &tileX0, Int &y);
+		void updateHiZ(Pointer<Byte> &tile, Pointer<Byte> &zBuffer, Int &tileX0);
+		void writeDeferredClear(Pointer<Byte> cBuffer[4], Int &tileX0, Int &y);
 	};
 }
 
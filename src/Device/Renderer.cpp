@@ -17,6 +17,7 @@
 #include "Clipper.hpp"
 #include "Primitive.hpp"
 #include "Polygon.hpp"
+#include "RoutineStore.hpp"
 #include "Device/SwiftConfig.hpp"
 #include "Reactor/Reactor.hpp"
 #include "Pipeline/Constants.hpp"
@@ -53,6 +54,7 @@ namespace sw
 	extern bool exactColorRounding;
 	extern TransparencyAntialiasing transparencyAntialiasing;
 	extern bool forceClearRegisters;
+	extern bool tileBinning;
 
 	extern bool precacheVertex;
 	extern bool precacheSetup;
@@ -69,6 +71,22 @@ namespace sw
 	TranscendentalPrecision rsqPrecision = ACCURATE;
 	bool perspectiveCorrection = true;
 
+	static unsigned int inputVertexCount(DrawType drawType, unsigned int primitiveCount)
+	{
+		switch(drawType & 0xF)
+		{
+		case DRAW_POINTLIST:     return primitiveCount;
+		case DRAW_LINELIST:      return primitiveCount * 2;
+		case DRAW_LINESTRIP:     return primitiveCount + 1;
+		case DRAW_TRIANGLELIST:  return primitiveCount * 3;
+		case DRAW_TRIANGLESTRIP: return primitiveCount + 2;
+		case DRAW_TRIANGLEFAN:   return primitiveCount + 2;
+		default:
+			ASSERT(false);
+			return 0;
+		}
+	}
+
 	static void setGlobalRenderingSettings(Conventions conventions, bool exactColorRounding)
 	{
 		static bool initialized = false;
@@ -87,6 +105,7 @@ namespace sw
 	{
 		Renderer *renderer;
 		int threadIndex;
+		int numaNode;   // -1 when threads aren't placed on a specific node
 	};
 
 	DrawCall::DrawCall()
@@ -97,15 +116,42 @@ namespace sw
 
 		data = (DrawData*)allocate(sizeof(DrawData));
 		data->constants = &constants;
+		data->occlusion = nullptr;
+		data->fragmentInvocations = nullptr;
+
+		#if PERF_PROFILE
+			for(int i = 0; i < PERF_TIMERS; i++)
+			{
+				data->cycles[i] = nullptr;
+			}
+		#endif
 	}
 
 	DrawCall::~DrawCall()
 	{
 		delete queries;
 
+		setClusterCount(0);
 		deallocate(data);
 	}
 
+	void DrawCall::setClusterCount(int clusterCount)
+	{
+		deallocate(data->occlusion);
+		data->occlusion = clusterCount ? (unsigned int*)allocate(clusterCount * sizeof(unsigned int)) : nullptr;
+
+		deallocate(data->fragmentInvocations);
+		data->fragmentInvocations = clusterCount ? (unsigned int*)allocate(clusterCount * sizeof(unsigned int)) : nullptr;
+
+		#if PERF_PROFILE
+			for(int i = 0; i < PERF_TIMERS; i++)
+			{
+				deallocate(data->cycles[i]);
+				data->cycles[i] = clusterCount ? (int64_t*)allocate(clusterCount * sizeof(int64_t)) : nullptr;
+			}
+		#endif
+	}
+
 	Renderer::Renderer(Context *context, Conventions conventions, bool exactColorRounding) : VertexProcessor(context), PixelProcessor(context), SetupProcessor(context), context(context), viewport()
 	{
 		setGlobalRenderingSettings(conventions, exactColorRounding);
@@ -114,18 +160,11 @@ namespace sw
 		clipper = new Clipper;
 		blitter = new Blitter;
 
-		#if PERF_HUD
-			resetTimers();
-		#endif
-
-		for(int i = 0; i < 16; i++)
-		{
-			vertexTask[i] = nullptr;
+		vertexTask = nullptr;
 
-			worker[i] = nullptr;
-			resume[i] = nullptr;
-			suspend[i] = nullptr;
-		}
+		worker = nullptr;
+		resume = nullptr;
+		suspend = nullptr;
 
 		threadsAwake = 0;
 		resumeApp = new Event();
@@ -133,14 +172,21 @@ namespace sw
 		currentDraw = 0;
 		nextDraw = 0;
 
+		taskQueue = nullptr;
+		taskCountBits = 0;
 		qHead = 0;
 		qSize = 0;
 
-		for(int i = 0; i < 16; i++)
-		{
-			triangleBatch[i] = nullptr;
-			primitiveBatch[i] = nullptr;
-		}
+		triangleBatch = nullptr;
+		primitiveBatch = nullptr;
+
+		primitiveProgress = nullptr;
+		pixelProgress = nullptr;
+		task = nullptr;
+
+		vertexRoutine = nullptr;
+		setupRoutine = nullptr;
+		pixelRoutine = nullptr;
 
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
@@ -148,16 +194,6 @@ namespace sw
 			drawList[draw] = drawCall[draw];
 		}
 
-		for(int unit = 0; unit < 16; unit++)
-		{
-			primitiveProgress[unit].init();
-		}
-
-		for(int cluster = 0; cluster < 16; cluster++)
-		{
-			pixelProgress[cluster].init();
-		}
-
 		clipFlags = 0;
 
 		swiftConfig = new SwiftConfig(disableServer);
@@ -173,6 +209,8 @@ namespace sw
 		terminateThreads();
 		sync->unlock();
 
+		releaseRoutines();
+
 		delete clipper;
 		clipper = nullptr;
 
@@ -192,6 +230,22 @@ namespace sw
 		swiftConfig = nullptr;
 	}
 
+	void Renderer::releaseRoutines()
+	{
+		// The routine caches return a reference to the routines, which the draw calls bind again
+		for(Routine *routine : {vertexRoutine, setupRoutine, pixelRoutine})
+		{
+			if(routine)
+			{
+				routine->unbind();
+			}
+		}
+
+		vertexRoutine = nullptr;
+		setupRoutine = nullptr;
+		pixelRoutine = nullptr;
+	}
+
 	// This object has to be mem aligned
 	void* Renderer::operator new(size_t size)
 	{
@@ -217,6 +271,16 @@ namespace sw
 
 		updateConfiguration();
 
+		// Only count what the active queries need
+		context->occlusionEnabled = false;
+		context->statisticsEnabled = false;
+
+		for(auto &query : queries)
+		{
+			context->occlusionEnabled |= (query->type == Query::FRAGMENTS_PASSED);
+			context->statisticsEnabled |= (query->type == Query::PIPELINE_STATISTICS);
+		}
+
 		int ms = context->sampleCount;
 		unsigned int oldMultiSampleMask = context->multiSampleMask;
 		context->multiSampleMask = context->sampleMask & ((unsigned)0xFFFFFFFF >> (32 - ms));
@@ -234,6 +298,8 @@ namespace sw
 			setupState = SetupProcessor::update();
 			pixelState = PixelProcessor::update();
 
+			releaseRoutines();
+
 			vertexRoutine = VertexProcessor::routine(vertexState);
 			setupRoutine = SetupProcessor::routine(setupState);
 			pixelRoutine = PixelProcessor::routine(pixelState);
@@ -287,6 +353,12 @@ namespace sw
 			{
 				++query->reference; // Atomic
 				draw->queries->push_back(query);
+
+				if(query->type == Query::PIPELINE_STATISTICS)
+				{
+					query->statistics[Query::INPUT_ASSEMBLY_VERTICES] += inputVertexCount(drawType, count);
+					query->statistics[Query::INPUT_ASSEMBLY_PRIMITIVES] += count;
+				}
 			}
 		}
 
@@ -305,6 +377,8 @@ namespace sw
 		draw->pixelPointer = (PixelProcessor::RoutinePointer)pixelRoutine->getEntry();
 		draw->setupPrimitives = setupPrimitives;
 		draw->setupState = setupState;
+		draw->vertexCacheSets = 1 << vertexState.vertexCacheSetsLog2;
+		draw->vertexCacheWays = 1 << vertexState.vertexCacheWaysLog2;
 
 		for(int i = 0; i < vk::MAX_BOUND_DESCRIPTOR_SETS; i++)
 		{
@@ -365,7 +439,22 @@ namespace sw
 			}
 		}
 
+		if(pixelState.statisticsEnabled)
+		{
+			for(int cluster = 0; cluster < clusterCount; cluster++)
+			{
+				data->fragmentInvocations[cluster] = 0;
+			}
+		}
+
+		draw->vertexInvocations = 0;
+		draw->clippingInvocations = 0;
+		draw->clippingPrimitives = 0;
+
 		#if PERF_PROFILE
+			draw->vertexCacheHits = 0;
+			draw->vertexCacheMisses = 0;
+
 			for(int cluster = 0; cluster < clusterCount; cluster++)
 			{
 				for(int i = 0; i < PERF_TIMERS; i++)
@@ -414,6 +503,15 @@ namespace sw
 					data->colorBuffer[index] = (unsigned int*)context->renderTarget[index]->getOffsetPointer(offset, VK_IMAGE_ASPECT_COLOR_BIT);
 					data->colorPitchB[index] = context->renderTarget[index]->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT);
 					data->colorSliceB[index] = context->renderTarget[index]->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT);
+
+					if(pixelState.deferredClearMask & (1 << index))
+					{
+						const DeferredClear &deferredClear = context->renderTarget[index]->getDeferredClear();
+						data->clearTiles[index] = context->renderTarget[index]->getDeferredClearTiles();
+						data->clearColumns[index] = deferredClear.getColumns();
+						data->clearRows[index] = deferredClear.getRows();
+						memcpy(data->clearPattern[index], deferredClear.getPattern(), sizeof(data->clearPattern[index]));
+					}
 				}
 			}
 
@@ -426,6 +524,13 @@ namespace sw
 				data->depthBuffer = (float*)context->depthBuffer->getOffsetPointer(offset, VK_IMAGE_ASPECT_DEPTH_BIT);
 				data->depthPitchB = context->depthBuffer->rowPitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT);
 				data->depthSliceB = context->depthBuffer->slicePitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT);
+
+				if(pixelState.hiZTest || pixelState.hiZUpdate)
+				{
+					data->hiZTiles = context->depthBuffer->getHiZTiles();
+					data->hiZColumns = context->depthBuffer->getHiZBuffer().getColumns();
+					data->hiZRows = context->depthBuffer->getHiZBuffer().getRows();
+				}
 			}
 
 			if(draw->stencilBuffer)
@@ -486,6 +591,12 @@ namespace sw
 	{
 		Renderer *renderer = static_cast<Parameters*>(parameters)->renderer;
 		int threadIndex = static_cast<Parameters*>(parameters)->threadIndex;
+		int numaNode = static_cast<Parameters*>(parameters)->numaNode;
+
+		if(numaNode >= 0)
+		{
+			Thread::setNumaNode(numaNode);
+		}
 
 		if(logPrecision < IEEE)
 		{
@@ -493,6 +604,15 @@ namespace sw
 			CPUID::setDenormalsAreZero(true);
 		}
 
+		// Allocated by the worker itself so the memory gets placed on its node.
+		VertexTask *vertexTask = (VertexTask*)allocate(sizeof(VertexTask));
+		vertexTask->vertexCache.vertex = nullptr;
+		vertexTask->vertexCache.tag = nullptr;
+		vertexTask->vertexCache.victim = nullptr;
+		vertexTask->vertexCache.capacity = 0;
+		vertexTask->vertexCache.drawCall = -1;
+		renderer->vertexTask[threadIndex] = vertexTask;
+
 		renderer->threadLoop(threadIndex);
 	}
 
@@ -539,7 +659,7 @@ namespace sw
 								pixelProgress[cluster].executing = true;
 
 								// Commit to the task queue
-								qHead = (qHead + 1) & TASK_COUNT_BITS;
+								qHead = (qHead + 1) & taskCountBits;
 								qSize++;
 
 								break;
@@ -594,7 +714,7 @@ namespace sw
 				primitiveProgress[unit].references = -1;
 
 				// Commit to the task queue
-				qHead = (qHead + 1) & TASK_COUNT_BITS;
+				qHead = (qHead + 1) & taskCountBits;
 				qSize++;
 			}
 		}
@@ -613,7 +733,7 @@ namespace sw
 
 		if(qSize != 0)
 		{
-			task[threadIndex] = taskQueue[(qHead - qSize) & TASK_COUNT_BITS];
+			task[threadIndex] = taskQueue[(qHead - qSize) & taskCountBits];
 			qSize--;
 
 			if(curThreadsAwake != threadCount)
@@ -674,6 +794,9 @@ namespace sw
 				if(!draw->setupState.rasterizerDiscard)
 				{
 					visible = (this->*setupPrimitives)(unit, count);
+
+					draw->clippingInvocations += count;
+					draw->clippingPrimitives += visible;
 				}
 
 				primitiveProgress[unit].visible = visible;
@@ -757,6 +880,9 @@ namespace sw
 							profiler.cycles[i] += data.cycles[i][cluster];
 						}
 					}
+
+					profiler.vertexCacheHits += draw.vertexCacheHits;
+					profiler.vertexCacheMisses += draw.vertexCacheMisses;
 				#endif
 
 				if(draw.queries)
@@ -774,11 +900,20 @@ namespace sw
 						case Query::TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN:
 							query->data += processedPrimitives;
 							break;
+						case Query::PIPELINE_STATISTICS:
+							query->statistics[Query::VERTEX_SHADER_INVOCATIONS] += draw.vertexInvocations;
+							query->statistics[Query::CLIPPING_INVOCATIONS] += draw.clippingInvocations;
+							query->statistics[Query::CLIPPING_PRIMITIVES] += draw.clippingPrimitives;
+							for(int cluster = 0; cluster < clusterCount; cluster++)
+							{
+								query->statistics[Query::FRAGMENT_SHADER_INVOCATIONS] += data.fragmentInvocations[cluster];
+							}
+							break;
 						default:
 							break;
 						}
 
-						--query->reference; // Atomic
+						query->release();
 					}
 
 					delete draw.queries;
@@ -812,6 +947,7 @@ namespace sw
 
 		if(task->vertexCache.drawCall != primitiveDrawCall)
 		{
+			task->vertexCache.resize(draw->vertexCacheSets, draw->vertexCacheWays);
 			task->vertexCache.clear();
 			task->vertexCache.drawCall = primitiveDrawCall;
 		}
@@ -1075,7 +1211,18 @@ namespace sw
 
 		task->primitiveStart = start;
 		task->vertexCount = triangleCount * 3;
+		task->invocations = 0;
+		#if PERF_PROFILE
+			task->cacheHits = 0;
+			task->cacheMisses = 0;
+		#endif
 		vertexRoutine(&triangle->v0, (unsigned int*)&batch, task, data);
+
+		draw->vertexInvocations += task->invocations;
+		#if PERF_PROFILE
+			draw->vertexCacheHits += task->cacheHits;
+			draw->vertexCacheMisses += task->cacheMisses;
+		#endif
 	}
 
 	int Renderer::setupTriangles(int unit, int count)
@@ -1435,16 +1582,55 @@ namespace sw
 		unitCount = ceilPow2(threadCount);
 		clusterCount = ceilPow2(threadCount);
 
+		triangleBatch = new Triangle*[unitCount];
+		primitiveBatch = new Primitive*[unitCount];
+		primitiveProgress = new PrimitiveProgress[unitCount];
+
 		for(int i = 0; i < unitCount; i++)
 		{
 			triangleBatch[i] = (Triangle*)allocate(batchSize * sizeof(Triangle));
 			primitiveBatch[i] = (Primitive*)allocate(batchSize * sizeof(Primitive));
+			primitiveProgress[i].init();
+		}
+
+		pixelProgress = new PixelProgress[clusterCount];
+
+		for(int cluster = 0; cluster < clusterCount; cluster++)
+		{
+			pixelProgress[cluster].init();
+			pixelProgress[cluster].drawCall = nextDraw;   // All previous draws have completed
+		}
+
+		for(int draw = 0; draw < DRAW_COUNT; draw++)
+		{
+			drawCall[draw]->setClusterCount(clusterCount);
 		}
 
+		// Each unit and each cluster can have one task queued at a time.
+		int taskCount = unitCount + clusterCount;   // Sum of equal powers of 2
+		taskQueue = new Task[taskCount];
+		taskCountBits = taskCount - 1;
+		qHead = 0;
+		qSize = 0;
+
+		worker = new Thread*[threadCount];
+		resume = new Event*[threadCount];
+		suspend = new Event*[threadCount];
+		task = new Task[threadCount];
+		vertexTask = new VertexTask*[threadCount];
+
+		#if PERF_HUD
+			vertexTime.assign(threadCount, 0);
+			setupTime.assign(threadCount, 0);
+			pixelTime.assign(threadCount, 0);
+		#endif
+
+		// Spread the threads over the NUMA nodes in contiguous blocks.
+		int numaNodeCount = Thread::numaNodeCount();
+
 		for(int i = 0; i < threadCount; i++)
 		{
-			vertexTask[i] = (VertexTask*)allocate(sizeof(VertexTask));
-			vertexTask[i]->vertexCache.drawCall = -1;
+			vertexTask[i] = nullptr;
 
 			task[i].type = Task::SUSPEND;
 
@@ -1454,6 +1640,7 @@ namespace sw
 			Parameters parameters;
 			parameters.threadIndex = i;
 			parameters.renderer = this;
+			parameters.numaNode = (numaNodeCount > 1) ? (i * numaNodeCount / threadCount) : -1;
 
 			exitThreads = false;
 			worker[i] = new Thread(threadFunction, &parameters);
@@ -1465,6 +1652,11 @@ namespace sw
 
 	void Renderer::terminateThreads()
 	{
+		if(!worker)
+		{
+			return;   // Threads haven't been initialized
+		}
+
 		while(threadsAwake != 0)
 		{
 			Thread::sleep(1);
@@ -1472,32 +1664,45 @@ namespace sw
 
 		for(int thread = 0; thread < threadCount; thread++)
 		{
-			if(worker[thread])
-			{
-				exitThreads = true;
-				resume[thread]->signal();
-				worker[thread]->join();
-
-				delete worker[thread];
-				worker[thread] = 0;
-				delete resume[thread];
-				resume[thread] = 0;
-				delete suspend[thread];
-				suspend[thread] = 0;
-			}
+			exitThreads = true;
+			resume[thread]->signal();
+			worker[thread]->join();
 
+			delete worker[thread];
+			delete resume[thread];
+			delete suspend[thread];
+
+			vertexTask[thread]->vertexCache.free();
 			deallocate(vertexTask[thread]);
-			vertexTask[thread] = 0;
 		}
 
-		for(int i = 0; i < 16; i++)
+		delete[] worker;
+		worker = nullptr;
+		delete[] resume;
+		resume = nullptr;
+		delete[] suspend;
+		suspend = nullptr;
+		delete[] task;
+		task = nullptr;
+		delete[] vertexTask;
+		vertexTask = nullptr;
+
+		for(int i = 0; i < unitCount; i++)
 		{
 			deallocate(triangleBatch[i]);
-			triangleBatch[i] = 0;
-
 			deallocate(primitiveBatch[i]);
-			primitiveBatch[i] = 0;
 		}
+
+		delete[] triangleBatch;
+		triangleBatch = nullptr;
+		delete[] primitiveBatch;
+		primitiveBatch = nullptr;
+		delete[] primitiveProgress;
+		primitiveProgress = nullptr;
+		delete[] pixelProgress;
+		pixelProgress = nullptr;
+		delete[] taskQueue;
+		taskQueue = nullptr;
 	}
 
 	void Renderer::setMultiSampleMask(unsigned int mask)
@@ -1586,7 +1791,7 @@ namespace sw
 
 		void Renderer::resetTimers()
 		{
-			for(int thread = 0; thread < threadCount; thread++)
+			for(size_t thread = 0; thread < vertexTime.size(); thread++)
 			{
 				vertexTime[thread] = 0;
 				setupTime[thread] = 0;
@@ -1621,10 +1826,6 @@ namespace sw
 			SwiftConfig::Configuration configuration = {};
 			swiftConfig->getConfiguration(configuration);
 
-			precacheVertex = !newConfiguration && configuration.precache;
-			precacheSetup = !newConfiguration && configuration.precache;
-			precachePixel = !newConfiguration && configuration.precache;
-
 			VertexProcessor::setRoutineCacheSize(configuration.vertexRoutineCacheSize);
 			PixelProcessor::setRoutineCacheSize(configuration.pixelRoutineCacheSize);
 			SetupProcessor::setRoutineCacheSize(configuration.setupRoutineCacheSize);
@@ -1700,6 +1901,8 @@ namespace sw
 			default: threadCount = configuration.threadCount; break;
 			}
 
+			tileBinning = configuration.tileBinning;
+
 			CPUID::setEnableSSE4_1(configuration.enableSSE4_1);
 			CPUID::setEnableSSSE3(configuration.enableSSSE3);
 			CPUID::setEnableSSE3(configuration.enableSSE3);
@@ -1711,18 +1914,46 @@ namespace sw
 				optimization[pass] = configuration.optimization[pass];
 			}
 
+			tieredCompilation = configuration.tieredCompilation;
+
 			forceWindowed = configuration.forceWindowed;
 			postBlendSRGB = configuration.postBlendSRGB;
 			exactColorRounding = configuration.exactColorRounding;
 			forceClearRegisters = configuration.forceClearRegisters;
 
+			if(!newConfiguration && configuration.precache)
+			{
+				// Settings which get compiled into routines without being part of their state
+				std::vector<int> settings =
+				{
+					configuration.transcendentalPrecision,
+					configuration.perspectiveCorrection,
+					configuration.transparencyAntialiasing,
+					configuration.postBlendSRGB,
+					configuration.exactColorRounding,
+					configuration.forceClearRegisters,
+				};
+
+				settings.insert(settings.end(), configuration.optimization, configuration.optimization + 10);
+
+				RoutineStore::enable(configuration.precacheDirectory, settings.data(), settings.size() * sizeof(int));
+			}
+			else
+			{
+				RoutineStore::disable();
+			}
+
+			precacheVertex = RoutineStore::isEnabled();
+			precacheSetup = RoutineStore::isEnabled();
+			precachePixel = RoutineStore::isEnabled();
+
 		#ifndef NDEBUG
 			minPrimitives = configuration.minPrimitives;
 			maxPrimitives = configuration.maxPrimitives;
 		#endif
 		}
 
-		if(!initialUpdate && !worker[0])
+		if(!initialUpdate && !worker)
 		{
 			initializeThreads();
 		}
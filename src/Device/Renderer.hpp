@@ -20,11 +20,16 @@
 #include "SetupProcessor.hpp"
 #include "Plane.hpp"
 #include "Blitter.hpp"
+#include "HiZBuffer.hpp"
 #include "System/MutexLock.hpp"
 #include "System/Thread.hpp"
 #include "Device/Config.hpp"
 
+#include <atomic>
+#include <condition_variable>
 #include <list>
+#include <mutex>
+#include <vector>
 
 namespace vk
 {
@@ -86,7 +91,18 @@ namespace sw
 
 	struct Query
 	{
-		enum Type { FRAGMENTS_PASSED, TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN };
+		enum Type { FRAGMENTS_PASSED, TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, PIPELINE_STATISTICS };
+
+		enum Statistic
+		{
+			INPUT_ASSEMBLY_VERTICES,
+			INPUT_ASSEMBLY_PRIMITIVES,
+			VERTEX_SHADER_INVOCATIONS,
+			CLIPPING_INVOCATIONS,
+			CLIPPING_PRIMITIVES,
+			FRAGMENT_SHADER_INVOCATIONS,
+			STATISTIC_COUNT
+		};
 
 		Query(Type type) : building(false), reference(0), data(0), type(type)
 		{
@@ -96,6 +112,11 @@ namespace sw
 		{
 			building = true;
 			data = 0;
+
+			for(int i = 0; i < STATISTIC_COUNT; i++)
+			{
+				statistics[i] = 0;
+			}
 		}
 
 		void end()
@@ -103,9 +124,31 @@ namespace sw
 			building = false;
 		}
 
+		// Called by the renderer when a draw which counted into the query has completed
+		void release()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if(reference-- == 0)   // Returns the decremented count
+			{
+				changed.notify_all();
+			}
+		}
+
+		// Wakes the threads waiting for the query's results
+		void signal()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			changed.notify_all();
+		}
+
 		bool building;
 		AtomicInt reference;
-		AtomicInt data;
+		std::atomic<int64_t> data;
+		std::atomic<int64_t> statistics[STATISTIC_COUNT];   // PIPELINE_STATISTICS counters
+
+		std::mutex mutex;
+		std::condition_variable changed;   // Signaled when the last draw releases the query, or its state changes
 
 		const Type type;
 	};
@@ -126,10 +169,11 @@ namespace sw
 
 		PixelProcessor::Stencil stencil[2];   // clockwise, counterclockwise
 		PixelProcessor::Factor factor;
-		unsigned int occlusion[16];   // Number of pixels passing depth test
+		unsigned int *occlusion;   // Number of pixels passing depth test, per cluster
+		unsigned int *fragmentInvocations;   // Number of pixels shaded, per cluster
 
 		#if PERF_PROFILE
-			int64_t cycles[PERF_TIMERS][16];
+			int64_t *cycles[PERF_TIMERS];   // Per cluster
 		#endif
 
 		float4 Wx16;
@@ -150,6 +194,13 @@ namespace sw
 		float *depthBuffer;
 		int depthPitchB;
 		int depthSliceB;
+		HiZBuffer::Tile *hiZTiles;
+		int hiZColumns;
+		int hiZRows;
+		uint8_t *clearTiles[RENDERTARGETS];
+		int clearColumns[RENDERTARGETS];
+		int clearRows[RENDERTARGETS];
+		uint32_t clearPattern[RENDERTARGETS][4];
 		unsigned char *stencilBuffer;
 		int stencilPitchB;
 		int stencilSliceB;
@@ -286,6 +337,7 @@ namespace sw
 		void updateConfiguration(bool initialUpdate = false);
 		void initializeThreads();
 		void terminateThreads();
+		void releaseRoutines();
 
 		Context *context;
 		Clipper *clipper;
@@ -294,19 +346,20 @@ namespace sw
 		VkRect2D scissor;
 		int clipFlags;
 
-		Triangle *triangleBatch[16];
-		Primitive *primitiveBatch[16];
+		// The following are sized by initializeThreads() from the thread count.
+		Triangle **triangleBatch;   // Per unit
+		Primitive **primitiveBatch;   // Per unit
 
 		AtomicInt exitThreads;
 		AtomicInt threadsAwake;
-		Thread *worker[16];
-		Event *resume[16];         // Events for resuming threads
-		Event *suspend[16];        // Events for suspending threads
+		Thread **worker;
+		Event **resume;            // Events for resuming threads
+		Event **suspend;           // Events for suspending threads
 		Event *resumeApp;          // Event for resuming the application thread
 
-		PrimitiveProgress primitiveProgress[16];
-		PixelProgress pixelProgress[16];
-		Task task[16];   // Current tasks for threads
+		PrimitiveProgress *primitiveProgress;   // Per unit
+		PixelProgress *pixelProgress;           // Per cluster
+		Task *task;   // Current tasks for threads
 
 		enum {
 			DRAW_COUNT = 16,   // Number of draw calls buffered (must be power of 2)
@@ -318,11 +371,8 @@ namespace sw
 		AtomicInt currentDraw;
 		AtomicInt nextDraw;
 
-		enum {
-			TASK_COUNT = 32,   // Size of the task queue (must be power of 2)
-			TASK_COUNT_BITS = TASK_COUNT - 1,
-		};
-		Task taskQueue[TASK_COUNT];
+		Task *taskQueue;      // Holds a task for each unit and cluster
+		int taskCountBits;    // Size of the task queue minus one (size must be power of 2)
 		AtomicInt qHead;
 		AtomicInt qSize;
 
@@ -332,12 +382,12 @@ namespace sw
 		MutexLock schedulerMutex;
 
 		#if PERF_HUD
-			int64_t vertexTime[16];
-			int64_t setupTime[16];
-			int64_t pixelTime[16];
+			std::vector<int64_t> vertexTime;
+			std::vector<int64_t> setupTime;
+			std::vector<int64_t> pixelTime;
 		#endif
 
-		VertexTask *vertexTask[16];
+		VertexTask **vertexTask;
 
 		SwiftConfig *swiftConfig;
 
@@ -359,6 +409,9 @@ namespace sw
 
 		~DrawCall();
 
+		// Sizes the per-cluster occlusion, statistics and profiling counters.
+		void setClusterCount(int clusterCount);
+
 		AtomicInt drawType;
 		AtomicInt batchSize;
 
@@ -383,6 +436,18 @@ namespace sw
 		AtomicInt count;        // Number of primitives to render
 		AtomicInt references;   // Remaining references to this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
 
+		AtomicInt vertexInvocations;     // Pipeline statistics, accumulated by the primitive tasks
+		AtomicInt clippingInvocations;
+		AtomicInt clippingPrimitives;
+
+		unsigned int vertexCacheSets;   // Vertex cache geometry of the vertex routine
+		unsigned int vertexCacheWays;
+
+		#if PERF_PROFILE
+			AtomicInt vertexCacheHits;
+			AtomicInt vertexCacheMisses;
+		#endif
+
 		DrawData *data;
 	};
 }
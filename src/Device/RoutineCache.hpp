@@ -12,19 +12,354 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+
 #ifndef sw_RoutineCache_hpp
 #define sw_RoutineCache_hpp
 
-#include "LRUCache.hpp"
-
 #include "Reactor/Reactor.hpp"
+#include "System/Math.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace sw
 {
 	using namespace rr;
 
+	// Hash table of routines, keyed on the state they were generated for. The State
+	// type must provide operator== and a 'hash' member holding its computeHash() value.
+	// Lookups don't take any lock. Misses on the same state are serialized, so a routine
+	// is generated only once, while misses on different states generate concurrently.
+	// Beyond its capacity the cache evicts the least recently used routines, approximated
+	// in clock order. Evicted entries are only reclaimed once no other lookup is in flight.
+	// Failed generations aren't cached, so the next lookup of their state tries again.
+	template<class State>
+	class RoutineCache
+	{
+	public:
+		RoutineCache(int n);
+
+		~RoutineCache();
+
+		// Returns the routine for the given state, calling generate() to create it on a miss.
+		// The routine is bound for the caller, which must unbind it once it's done using it.
+		template<class Generator>
+		Routine *getOrCreate(const State &state, const Generator &generate);
+
+	private:
+		struct Entry
+		{
+			Entry(const State &state) : state(state), routine(nullptr), ready(false), used(true), next(nullptr), newer(nullptr) {}
+
+			const State state;
+			std::atomic<Routine*> routine;
+			std::atomic<bool> ready;   // Set once generation has completed
+			std::atomic<bool> used;    // Set on each hit, cleared by the clock hand
+			std::atomic<Entry*> next;  // Bucket chain
+			Entry *newer;              // Clock or retired list, protected by 'mutex'
+		};
+
+		static unsigned int index(unsigned int hash);
+		Entry *find(const State &state) const;
+		void evict();
+		void retire(Entry *entry);
+		void reclaim(int self);
+
+		int capacity;
+		int count;
+		unsigned int mask;
+		std::atomic<Entry*> *buckets;
+
+		Entry *oldest;
+		Entry *newest;
+		Entry *retired;
+
+		std::atomic<int> readers;
+		std::mutex mutex;
+		std::condition_variable generated;
+	};
+}
+
+namespace sw
+{
 	template<class State>
-	using RoutineCache = LRUCache<State, Routine>;
+	RoutineCache<State>::RoutineCache(int n)
+	{
+		capacity = n;
+		count = 0;
+		mask = ceilPow2(2 * n) - 1;
+		buckets = new std::atomic<Entry*>[mask + 1];
+
+		for(unsigned int i = 0; i <= mask; i++)
+		{
+			buckets[i].store(nullptr, std::memory_order_relaxed);
+		}
+
+		oldest = nullptr;
+		newest = nullptr;
+		retired = nullptr;
+		readers = 0;
+	}
+
+	template<class State>
+	RoutineCache<State>::~RoutineCache()
+	{
+		reclaim(0);
+
+		while(oldest)
+		{
+			Entry *entry = oldest;
+			oldest = entry->newer;
+
+			Routine *routine = entry->routine.load(std::memory_order_relaxed);
+
+			if(routine)
+			{
+				routine->unbind();
+			}
+
+			delete entry;
+		}
+
+		delete[] buckets;
+		buckets = nullptr;
+	}
+
+	template<class State>
+	unsigned int RoutineCache<State>::index(unsigned int hash)
+	{
+		// The states' hashes are XORs of their words, so mix them before masking
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+
+		return hash;
+	}
+
+	template<class State>
+	typename RoutineCache<State>::Entry *RoutineCache<State>::find(const State &state) const
+	{
+		Entry *entry = buckets[index(state.hash) & mask].load(std::memory_order_acquire);
+
+		while(entry && !(entry->state == state))
+		{
+			entry = entry->next.load(std::memory_order_acquire);
+		}
+
+		return entry;
+	}
+
+	template<class State>
+	template<class Generator>
+	Routine *RoutineCache<State>::getOrCreate(const State &state, const Generator &generate)
+	{
+		readers++;
+
+		Entry *entry = find(state);
+
+		if(entry && entry->ready.load(std::memory_order_acquire))
+		{
+			entry->used.store(true, std::memory_order_relaxed);
+			Routine *routine = entry->routine.load(std::memory_order_relaxed);
+
+			if(routine)
+			{
+				routine->bind();   // Before leaving, so it can't be reclaimed in between
+			}
+
+			readers--;
+
+			return routine;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		entry = find(state);
+
+		if(!entry)   // Claim the state and generate its routine outside of the lock
+		{
+			entry = new Entry(state);
+
+			std::atomic<Entry*> &bucket = buckets[index(state.hash) & mask];
+			entry->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			bucket.store(entry, std::memory_order_release);
+
+			if(newest)
+			{
+				newest->newer = entry;
+			}
+			else
+			{
+				oldest = entry;
+			}
+
+			newest = entry;
+			count++;
+
+			lock.unlock();
+
+			Routine *routine = generate();
+
+			if(routine)
+			{
+				routine->bind();   // The cache's reference
+				routine->bind();   // The caller's reference
+			}
+
+			lock.lock();
+
+			entry->routine.store(routine, std::memory_order_relaxed);
+			entry->ready.store(true, std::memory_order_release);
+
+			if(!routine)
+			{
+				// Remove the entry from the clock, so that the next lookup generates it again
+				if(oldest == entry)
+				{
+					oldest = entry->newer;
+				}
+				else
+				{
+					Entry *previous = oldest;
+
+					while(previous->newer != entry)
+					{
+						previous = previous->newer;
+					}
+
+					previous->newer = entry->newer;
+
+					if(newest == entry)
+					{
+						newest = previous;
+					}
+				}
+
+				if(!oldest)
+				{
+					newest = nullptr;
+				}
+
+				entry->newer = nullptr;
+				retire(entry);
+			}
+
+			evict();
+			reclaim(1);
+
+			lock.unlock();
+			generated.notify_all();
+
+			readers--;
+
+			return routine;
+		}
+
+		// Another thread is generating this routine, or just finished doing so
+		generated.wait(lock, [entry]() { return entry->ready.load(std::memory_order_acquire); });
+
+		entry->used.store(true, std::memory_order_relaxed);
+		Routine *routine = entry->routine.load(std::memory_order_relaxed);
+
+		if(routine)
+		{
+			routine->bind();
+		}
+
+		readers--;
+
+		return routine;
+	}
+
+	template<class State>
+	void RoutineCache<State>::evict()
+	{
+		// Each entry gets a second chance if it was used since the clock hand last passed it.
+		// Entries still being generated are skipped, so give up after two full rounds.
+		for(int i = 0; (count > capacity) && (i < 2 * count); i++)
+		{
+			Entry *entry = oldest;
+			oldest = entry->newer;
+			entry->newer = nullptr;
+
+			if(!oldest)
+			{
+				newest = nullptr;
+			}
+
+			bool evictable = entry->ready.load(std::memory_order_relaxed) &&
+			                 !entry->used.exchange(false, std::memory_order_relaxed);
+
+			if(!evictable)
+			{
+				if(newest)
+				{
+					newest->newer = entry;
+				}
+				else
+				{
+					oldest = entry;
+				}
+
+				newest = entry;
+				continue;
+			}
+
+			retire(entry);
+		}
+	}
+
+	template<class State>
+	void RoutineCache<State>::retire(Entry *entry)
+	{
+		// Unlink from its bucket. Lookups which already reached the entry can still follow its chain.
+		std::atomic<Entry*> *link = &buckets[index(entry->state.hash) & mask];
+
+		while(link->load(std::memory_order_relaxed) != entry)
+		{
+			link = &link->load(std::memory_order_relaxed)->next;
+		}
+
+		link->store(entry->next.load(std::memory_order_relaxed), std::memory_order_release);
+
+		entry->newer = retired;
+		retired = entry;
+		count--;
+	}
+
+	template<class State>
+	void RoutineCache<State>::reclaim(int self)
+	{
+		if(!retired)
+		{
+			return;
+		}
+
+		// Lookups started after this fence can no longer reach retired entries.
+		// 'self' counts the lookup in flight on the calling thread.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if(readers.load() != self)
+		{
+			return;
+		}
+
+		while(retired)
+		{
+			Entry *entry = retired;
+			retired = entry->newer;
+
+			Routine *routine = entry->routine.load(std::memory_order_relaxed);
+
+			if(routine)
+			{
+				routine->unbind();
+			}
+
+			delete entry;
+		}
+	}
 }
 
 #endif   // sw_RoutineCache_hpp
@@ -0,0 +1,420 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RoutineStore.hpp"
+
+#include "Reactor/CPUID.hpp"
+
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+	#include <dlfcn.h>
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <link.h>
+	#include <stdlib.h>
+	#include <sys/stat.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	// Written at the start of each file, followed by the full key, the entry symbol and the code
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t keySize;
+		uint64_t entrySize;
+		uint64_t codeSize;
+		uint64_t codeDigest;   // Detects files which got corrupted after being written
+	};
+
+	const uint32_t FILE_MAGIC = 0x53525753;   // "SWRS"
+	const uint32_t FILE_VERSION = 1;
+
+	uint64_t Digest(const void *data, size_t size, uint64_t digest = 0xCBF29CE484222325)
+	{
+		const uint8_t *bytes = static_cast<const uint8_t*>(data);
+
+		for(size_t i = 0; i < size; i++)   // FNV-1a
+		{
+			digest = (digest ^ bytes[i]) * 0x100000001B3;
+		}
+
+		return digest;
+	}
+
+	std::mutex storeMutex;
+	std::string storeDirectory;               // Empty while the store is disabled
+	std::vector<uint8_t> storeEnvironment;    // Prefix of every key
+
+	#if defined(__linux__)
+		// The GNU build ID of the library, or its size and modification time if it wasn't linked with one
+		std::vector<uint8_t> BuildID()
+		{
+			struct Search
+			{
+				uintptr_t address;
+				std::vector<uint8_t> id;
+			};
+
+			Search search = { reinterpret_cast<uintptr_t>(&BuildID), {} };
+
+			dl_iterate_phdr([](dl_phdr_info *module, size_t, void *data) -> int
+			{
+				Search &search = *static_cast<Search*>(data);
+				bool found = false;
+
+				for(int i = 0; i < module->dlpi_phnum; i++)
+				{
+					const ElfW(Phdr) &segment = module->dlpi_phdr[i];
+					uintptr_t start = module->dlpi_addr + segment.p_vaddr;
+
+					if(segment.p_type == PT_LOAD && search.address >= start && search.address < start + segment.p_memsz)
+					{
+						found = true;
+					}
+				}
+
+				if(!found)
+				{
+					return 0;
+				}
+
+				for(int i = 0; i < module->dlpi_phnum; i++)
+				{
+					const ElfW(Phdr) &segment = module->dlpi_phdr[i];
+
+					if(segment.p_type != PT_NOTE)
+					{
+						continue;
+					}
+
+					const uint8_t *note = reinterpret_cast<const uint8_t*>(module->dlpi_addr + segment.p_vaddr);
+					const uint8_t *end = note + segment.p_memsz;
+
+					while(note + sizeof(ElfW(Nhdr)) <= end)
+					{
+						const ElfW(Nhdr) &header = *reinterpret_cast<const ElfW(Nhdr)*>(note);
+						const uint8_t *name = note + sizeof(ElfW(Nhdr));
+						const uint8_t *desc = name + ((header.n_namesz + 3) & ~3);
+
+						if(header.n_type == NT_GNU_BUILD_ID && header.n_namesz == 4 && memcmp(name, "GNU", 4) == 0)
+						{
+							search.id.assign(desc, desc + header.n_descsz);
+							return 1;
+						}
+
+						note = desc + ((header.n_descsz + 3) & ~3);
+					}
+				}
+
+				return 1;
+			}, &search);
+
+			if(search.id.empty())
+			{
+				Dl_info info;
+				struct stat status;
+
+				if(dladdr(reinterpret_cast<void*>(&BuildID), &info) && info.dli_fname && stat(info.dli_fname, &status) == 0)
+				{
+					uint64_t identity[2] = { static_cast<uint64_t>(status.st_size), static_cast<uint64_t>(status.st_mtime) };
+					const uint8_t *bytes = reinterpret_cast<const uint8_t*>(identity);
+					search.id.assign(bytes, bytes + sizeof(identity));
+				}
+			}
+
+			return search.id;
+		}
+
+		std::string CacheDirectory()
+		{
+			const char *cache = getenv("XDG_CACHE_HOME");
+
+			if(cache && cache[0] == '/')
+			{
+				return std::string(cache) + "/swiftshader";
+			}
+
+			const char *home = getenv("HOME");
+
+			if(home && home[0] == '/')
+			{
+				return std::string(home) + "/.cache/swiftshader";
+			}
+
+			return "";
+		}
+
+		// Creates the directory and its missing parents
+		bool MakeDirectory(const std::string &path)
+		{
+			for(size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1))
+			{
+				std::string parent = path.substr(0, slash);
+
+				if(mkdir(parent.c_str(), 0700) != 0 && errno != EEXIST)
+				{
+					return false;
+				}
+
+				if(slash == std::string::npos)
+				{
+					return true;
+				}
+			}
+		}
+
+		bool ReadFile(const std::string &path, std::vector<uint8_t> &contents)
+		{
+			int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+			if(file < 0)
+			{
+				return false;
+			}
+
+			struct stat status;
+			bool success = (fstat(file, &status) == 0);
+
+			if(success)
+			{
+				contents.resize(status.st_size);
+
+				for(size_t offset = 0; success && offset < contents.size(); )
+				{
+					ssize_t bytes = read(file, contents.data() + offset, contents.size() - offset);
+					success = (bytes > 0);
+					offset += success ? bytes : 0;
+				}
+			}
+
+			close(file);
+
+			return success;
+		}
+
+		// Writes to a temporary file first, so that concurrent processes never read partial files
+		bool WriteFile(const std::string &path, const std::vector<uint8_t> &contents)
+		{
+			std::string temporary = path + "." + std::to_string(getpid()) + "." + std::to_string(syscall(SYS_gettid));
+			int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+
+			if(file < 0)
+			{
+				return false;
+			}
+
+			bool success = true;
+
+			for(size_t offset = 0; success && offset < contents.size(); )
+			{
+				ssize_t bytes = write(file, contents.data() + offset, contents.size() - offset);
+				success = (bytes > 0);
+				offset += success ? bytes : 0;
+			}
+
+			success = (close(file) == 0) && success;
+			success = success && (rename(temporary.c_str(), path.c_str()) == 0);
+
+			if(!success)
+			{
+				unlink(temporary.c_str());
+			}
+
+			return success;
+		}
+	#endif
+}
+
+namespace sw
+{
+	RoutineStore::Key::Key(const char *name)
+	{
+		add(name, strlen(name) + 1);
+	}
+
+	void RoutineStore::Key::add(const void *data, size_t size)
+	{
+		const uint8_t *bytes = static_cast<const uint8_t*>(data);
+		this->data.insert(this->data.end(), bytes, bytes + size);
+	}
+
+	void RoutineStore::enable(const std::string &directory, const void *settings, size_t size)
+	{
+		#if defined(__linux__)
+			std::string path = directory.empty() ? CacheDirectory() : directory;
+
+			if(path.empty() || !MakeDirectory(path))
+			{
+				disable();
+				return;
+			}
+
+			// The CPU features which Reactor generates code for
+			uint32_t features = (rr::CPUID::supportsMMX()     << 0) |
+			                    (rr::CPUID::supportsCMOV()    << 1) |
+			                    (rr::CPUID::supportsSSE()     << 2) |
+			                    (rr::CPUID::supportsSSE2()    << 3) |
+			                    (rr::CPUID::supportsSSE3()    << 4) |
+			                    (rr::CPUID::supportsSSSE3()   << 5) |
+			                    (rr::CPUID::supportsSSE4_1()  << 6) |
+			                    (rr::CPUID::supportsAVX()     << 7) |
+			                    (rr::CPUID::supportsAVX2()    << 8) |
+			                    (rr::CPUID::supportsAVX512F() << 9);
+
+			std::vector<uint8_t> buildID = BuildID();
+			uint64_t buildIDSize = buildID.size();
+
+			if(buildID.empty())
+			{
+				disable();   // Routines of other builds can't be told apart
+				return;
+			}
+
+			const uint8_t *settingsBytes = static_cast<const uint8_t*>(settings);
+			uint64_t settingsSize = size;
+
+			std::vector<uint8_t> environment;
+			environment.insert(environment.end(), reinterpret_cast<uint8_t*>(&buildIDSize), reinterpret_cast<uint8_t*>(&buildIDSize + 1));
+			environment.insert(environment.end(), buildID.begin(), buildID.end());
+			environment.insert(environment.end(), reinterpret_cast<uint8_t*>(&features), reinterpret_cast<uint8_t*>(&features + 1));
+			environment.insert(environment.end(), reinterpret_cast<uint8_t*>(&settingsSize), reinterpret_cast<uint8_t*>(&settingsSize + 1));
+			environment.insert(environment.end(), settingsBytes, settingsBytes + size);
+
+			std::unique_lock<std::mutex> lock(storeMutex);
+			storeDirectory = path;
+			storeEnvironment = std::move(environment);
+		#else
+			disable();
+		#endif
+	}
+
+	void RoutineStore::disable()
+	{
+		std::unique_lock<std::mutex> lock(storeMutex);
+		storeDirectory.clear();
+		storeEnvironment.clear();
+	}
+
+	bool RoutineStore::isEnabled()
+	{
+		std::unique_lock<std::mutex> lock(storeMutex);
+		return !storeDirectory.empty();
+	}
+
+	std::string RoutineStore::getPath(const Key &key, std::vector<uint8_t> &environment)
+	{
+		std::string directory;
+
+		{
+			std::unique_lock<std::mutex> lock(storeMutex);
+			directory = storeDirectory;
+			environment = storeEnvironment;
+		}
+
+		if(directory.empty())
+		{
+			return "";
+		}
+
+		uint64_t digest = Digest(key.data.data(), key.data.size(), Digest(environment.data(), environment.size()));
+
+		char name[32];
+		snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(digest));
+
+		return directory + name;
+	}
+
+	Routine *RoutineStore::load(const Key &key)
+	{
+		#if defined(__linux__)
+			std::vector<uint8_t> environment;
+			std::string path = getPath(key, environment);
+			std::vector<uint8_t> file;
+
+			if(path.empty() || !ReadFile(path, file) || file.size() < sizeof(FileHeader))
+			{
+				return nullptr;
+			}
+
+			FileHeader header;
+			memcpy(&header, file.data(), sizeof(FileHeader));
+
+			uint64_t keySize = environment.size() + key.data.size();
+
+			if(header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.keySize != keySize ||
+			   file.size() != sizeof(FileHeader) + header.keySize + header.entrySize + header.codeSize)
+			{
+				return nullptr;
+			}
+
+			const uint8_t *storedKey = file.data() + sizeof(FileHeader);
+			const uint8_t *entry = storedKey + header.keySize;
+			const uint8_t *code = entry + header.entrySize;
+
+			if(memcmp(storedKey, environment.data(), environment.size()) != 0 ||
+			   memcmp(storedKey + environment.size(), key.data.data(), key.data.size()) != 0 ||
+			   Digest(code, header.codeSize) != header.codeDigest)
+			{
+				return nullptr;
+			}
+
+			RoutineObject object;
+			object.entry.assign(reinterpret_cast<const char*>(entry), header.entrySize);
+			object.code.assign(code, code + header.codeSize);
+
+			return Nucleus::loadRoutine(object);
+		#else
+			return nullptr;
+		#endif
+	}
+
+	void RoutineStore::store(const Key &key)
+	{
+		#if defined(__linux__)
+			std::vector<uint8_t> environment;
+			std::string path = getPath(key, environment);
+			RoutineObject object;
+
+			if(path.empty() || !Nucleus::getRoutineObject(object))
+			{
+				return;
+			}
+
+			FileHeader header;
+			header.magic = FILE_MAGIC;
+			header.version = FILE_VERSION;
+			header.keySize = environment.size() + key.data.size();
+			header.entrySize = object.entry.size();
+			header.codeSize = object.code.size();
+			header.codeDigest = Digest(object.code.data(), object.code.size());
+
+			std::vector<uint8_t> file;
+			file.reserve(sizeof(FileHeader) + header.keySize + header.entrySize + header.codeSize);
+			file.insert(file.end(), reinterpret_cast<uint8_t*>(&header), reinterpret_cast<uint8_t*>(&header + 1));
+			file.insert(file.end(), environment.begin(), environment.end());
+			file.insert(file.end(), key.data.begin(), key.data.end());
+			file.insert(file.end(), object.entry.begin(), object.entry.end());
+			file.insert(file.end(), object.code.begin(), object.code.end());
+
+			WriteFile(path, file);   // Failing to store a routine only costs generating it again
+		#endif
+	}
+}
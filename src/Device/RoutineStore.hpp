@@ -0,0 +1,132 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_RoutineStore_hpp
+#define sw_RoutineStore_hpp
+
+#include "Reactor/Reactor.hpp"
+
+#include <string>
+#include <vector>
+
+namespace sw
+{
+	using namespace rr;
+
+	// On-disk store of the object code of routines, so that later processes can load them
+	// instead of generating them again. Each routine is stored in its own file, named after
+	// the digest of its key. Keys hold everything which gets baked into a routine and can
+	// differ between processes: the state it's generated for, the contents of its shader,
+	// the configuration, the CPU features and the build of the library. Files whose key
+	// doesn't match exactly are ignored, and get replaced.
+	class RoutineStore
+	{
+	public:
+		class Key
+		{
+		public:
+			explicit Key(const char *name);
+
+			void add(const void *data, size_t size);
+
+			template<class T>
+			void add(const T &value) { add(&value, sizeof(T)); }
+
+			// The shader's code, and the layout of the descriptors it's compiled against. A template,
+			// so that the store itself doesn't depend on the SpirvShader and vk::PipelineLayout types.
+			template<class Shader, class Layout>
+			void addShader(const Shader *shader, const Layout *layout);
+
+		private:
+			friend class RoutineStore;
+
+			std::vector<uint8_t> data;
+		};
+
+		// Stores routines in the given directory, or in the user's cache directory if it's
+		// empty. The settings are the configuration which routines depend on, beyond their state.
+		static void enable(const std::string &directory, const void *settings, size_t size);
+		static void disable();
+		static bool isEnabled();
+
+		// Loads the routine stored for the key, or calls generate() and stores the routine
+		// it acquired. generate() must acquire at most one routine, on the calling thread.
+		template<class Generator>
+		static Routine *getOrGenerate(const Key &key, const Generator &generate);
+
+	private:
+		// Also returns the prefix of every key, which the file must start with
+		static std::string getPath(const Key &key, std::vector<uint8_t> &environment);
+
+		static Routine *load(const Key &key);
+		static void store(const Key &key);
+	};
+}
+
+namespace sw
+{
+	template<class Shader, class Layout>
+	void RoutineStore::Key::addShader(const Shader *shader, const Layout *layout)
+	{
+		uint64_t words = shader ? shader->insns.size() : 0;
+		add(words);
+
+		if(shader)
+		{
+			add(shader->insns.data(), shader->insns.size() * sizeof(uint32_t));
+		}
+
+		// Descriptor offsets within their set are compiled into the routine
+		uint64_t sets = layout ? layout->getNumDescriptorSets() : 0;
+		add(sets);
+
+		for(size_t set = 0; set < sets; set++)
+		{
+			const auto *setLayout = layout->getDescriptorSetLayout(set);
+			uint32_t bindings = setLayout->getBindingCount();
+			add(bindings);
+
+			for(uint32_t i = 0; i < bindings; i++)
+			{
+				const auto &binding = setLayout->getBinding(i);
+				uint64_t offset = setLayout->getBindingOffset(binding.binding);
+
+				add(binding.binding);
+				add(binding.descriptorType);
+				add(binding.descriptorCount);
+				add(offset);
+			}
+		}
+	}
+
+	template<class Generator>
+	Routine *RoutineStore::getOrGenerate(const Key &key, const Generator &generate)
+	{
+		Routine *routine = load(key);
+
+		if(!routine)
+		{
+			routine = generate();
+
+			if(routine)
+			{
+				store(key);
+			}
+		}
+
+		return routine;
+	}
+}
+
+#endif   // sw_RoutineStore_hpp
@@ -18,6 +18,7 @@
 #include "Polygon.hpp"
 #include "Context.hpp"
 #include "Renderer.hpp"
+#include "RoutineStore.hpp"
 #include "Pipeline/SetupRoutine.hpp"
 #include "Pipeline/Constants.hpp"
 #include "Vulkan/VkDebug.hpp"
@@ -102,19 +103,28 @@ namespace sw
 
 	Routine *SetupProcessor::routine(const State &state)
 	{
-		Routine *routine = routineCache->query(state);
-
-		if(!routine)
+		auto generate = [&]()
 		{
 			SetupRoutine *generator = new SetupRoutine(state);
 			generator->generate();
-			routine = generator->getRoutine();
+			Routine *routine = generator->getRoutine();
 			delete generator;
 
-			routineCache->add(state, routine);
-		}
+			return routine;
+		};
+
+		return routineCache->getOrCreate(state, [&]()
+		{
+			if(!precacheSetup)
+			{
+				return generate();
+			}
+
+			RoutineStore::Key key("SetupRoutine");
+			key.add(static_cast<const States&>(state));
 
-		return routine;
+			return RoutineStore::getOrGenerate(key, generate);
+		});
 	}
 
 	void SetupProcessor::setRoutineCacheSize(int cacheSize)
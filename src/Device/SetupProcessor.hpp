@@ -70,7 +70,7 @@ namespace sw
 
 	protected:
 		State update() const;
-		Routine *routine(const State &state);
+		Routine *routine(const State &state);   // Bound for the caller
 
 		void setRoutineCacheSize(int cacheSize);
 
@@ -43,12 +43,14 @@ namespace sw
 			bool perspectiveCorrection;
 			int transcendentalPrecision;
 			int threadCount;
+			bool tileBinning;
 			bool enableSSE;
 			bool enableSSE2;
 			bool enableSSE3;
 			bool enableSSSE3;
 			bool enableSSE4_1;
 			rr::Optimization optimization[10];
+			bool tieredCompilation;
 			bool disableServer;
 			bool keepSystemCursor;
 			bool forceWindowed;
@@ -59,6 +61,7 @@ namespace sw
 			int transparencyAntialiasing;
 			int frameBufferAPI;
 			bool precache;
+			std::string precacheDirectory;   // Empty for the user's cache directory
 			int shadowMapping;
 			bool forceClearRegisters;
 		#ifndef NDEBUG
@@ -14,10 +14,13 @@
 
 #include "VertexProcessor.hpp"
 
+#include "RoutineStore.hpp"
 #include "Pipeline/VertexProgram.hpp"
 #include "Pipeline/Constants.hpp"
 #include "System/Math.hpp"
+#include "System/Memory.hpp"
 #include "Vulkan/VkDebug.hpp"
+#include "Vulkan/VkPipelineLayout.hpp"
 
 #include <string.h>
 
@@ -25,12 +28,47 @@ namespace sw
 {
 	bool precacheVertex = false;
 
+	void VertexCache::resize(unsigned int sets, unsigned int ways)
+	{
+		unsigned int lines = sets * ways;
+
+		if(lines + sets > capacity)
+		{
+			free();
+
+			// Victim pointers are stored after the tags
+			capacity = lines + sets;
+			vertex = (Vertex(*)[4])allocate(capacity * sizeof(Vertex[4]));
+			tag = (unsigned int*)allocate(capacity * sizeof(unsigned int));
+		}
+
+		victim = tag + lines;
+		this->sets = sets;
+		this->ways = ways;
+	}
+
 	void VertexCache::clear()
 	{
-		for(int i = 0; i < 16; i++)
+		for(unsigned int i = 0; i < sets * ways; i++)
 		{
 			tag[i] = 0x80000000;
 		}
+
+		for(unsigned int i = 0; i < sets; i++)
+		{
+			victim[i] = 0;
+		}
+	}
+
+	void VertexCache::free()
+	{
+		deallocate(vertex);
+		deallocate(tag);
+
+		vertex = nullptr;
+		tag = nullptr;
+		victim = nullptr;
+		capacity = 0;
 	}
 
 	unsigned int VertexProcessor::States::computeHash()
@@ -108,6 +146,25 @@ namespace sw
 		DrawType type = static_cast<DrawType>(static_cast<unsigned int>(drawType) & 0xF);
 		state.verticesPerPrimitive = 1 + (type >= DRAW_LINELIST) + (type >= DRAW_TRIANGLELIST);
 
+		// The vertex cache geometry follows the topology's reuse pattern. Sequential indices only
+		// revisit the most recent lines, except that fans keep returning to their first vertex.
+		// Indexed meshes reuse vertices out of order over a larger window, triangle lists reordered
+		// by mesh optimizers the most, while points, lines and strips only share with neighbours.
+		bool indexed = (drawType & DRAW_INDEXED16) != 0;   // Also set for DRAW_INDEXED32
+		int ways = 1;
+
+		if(type == DRAW_TRIANGLELIST || type == DRAW_TRIANGLEFAN)
+		{
+			ways = indexed ? INDEXED_VERTEX_CACHE_WAYS : (type == DRAW_TRIANGLEFAN) ? 2 : 1;
+		}
+		else
+		{
+			ways = indexed ? 2 : 1;
+		}
+
+		state.vertexCacheSetsLog2 = log2(indexed ? INDEXED_VERTEX_CACHE_SETS : VERTEX_CACHE_SETS);
+		state.vertexCacheWaysLog2 = log2(ways);
+
 		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
 		{
 			state.input[i].type = context->input[i].type;
@@ -125,18 +182,32 @@ namespace sw
 
 	Routine *VertexProcessor::routine(const State &state)
 	{
-		Routine *routine = routineCache->query(state);
-
-		if(!routine)   // Create one
+		auto generate = [&]()
 		{
 			VertexRoutine *generator = new VertexProgram(state, context->pipelineLayout, context->vertexShader);
 			generator->generate();
-			routine = (*generator)("VertexRoutine_%0.8X", state.shaderID);
+			Routine *routine = (*generator)("VertexRoutine_%0.8X", state.shaderID);
 			delete generator;
 
-			routineCache->add(state, routine);
-		}
+			return routine;
+		};
+
+		return routineCache->getOrCreate(state, [&]()
+		{
+			if(!precacheVertex)
+			{
+				return generate();
+			}
+
+			States states;
+			memcpy(&states, static_cast<const States*>(&state), sizeof(States));
+			states.shaderID = 0;   // Only meaningful within this process, the shader's code is keyed instead
+
+			RoutineStore::Key key("VertexRoutine");
+			key.add(states);
+			key.addShader(context->vertexShader, context->pipelineLayout);
 
-		return routine;
+			return RoutineStore::getOrGenerate(key, generate);
+		});
 	}
 }
@@ -24,12 +24,22 @@ namespace sw
 {
 	struct DrawData;
 
-	struct VertexCache   // FIXME: Variable size
+	// Set-associative cache of shaded vertices. Each line holds the four vertices
+	// of a SIMD batch, tagged with the index of the first one. The geometry is
+	// chosen per vertex routine state, and the storage grows to fit it on demand.
+	struct VertexCache
 	{
+		void resize(unsigned int sets, unsigned int ways);
 		void clear();
+		void free();
 
-		Vertex vertex[16][4];
-		unsigned int tag[16];
+		Vertex (*vertex)[4];    // sets * ways lines
+		unsigned int *tag;      // sets * ways tags
+		unsigned int *victim;   // Per set, next way to replace (FIFO)
+
+		unsigned int sets;
+		unsigned int ways;
+		unsigned int capacity;   // Allocated lines
 
 		int drawCall;
 	};
@@ -38,6 +48,11 @@ namespace sw
 	{
 		unsigned int vertexCount;
 		unsigned int primitiveStart;
+		unsigned int invocations;   // Number of vertices shaded, incremented by the vertex routine
+		#if PERF_PROFILE
+			unsigned int cacheHits;     // Vertex cache lookups, counted by the vertex routine
+			unsigned int cacheMisses;
+		#endif
 		VertexCache vertexCache;
 	};
 
@@ -52,6 +67,8 @@ namespace sw
 
 			bool textureSampling           : 1;   // TODO: Eliminate by querying shader.
 			unsigned char verticesPerPrimitive                : 2; // 1 (points), 2 (lines) or 3 (triangles)
+			unsigned char vertexCacheSetsLog2 : 3;
+			unsigned char vertexCacheWaysLog2 : 2;
 
 			Sampler::State sampler[VERTEX_TEXTURE_IMAGE_UNITS];
 
@@ -93,7 +110,7 @@ namespace sw
 
 	protected:
 		const State update(DrawType drawType);
-		Routine *routine(const State &state);
+		Routine *routine(const State &state);   // Bound for the caller
 
 		void setRoutineCacheSize(int cacheSize);
 
@@ -14,9 +14,13 @@
 
 #include "ComputeProgram.hpp"
 
+#include "System/ThreadPool.hpp"
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace
 {
 	enum { X, Y, Z };
@@ -110,13 +114,12 @@ namespace sw
 		setInputBuiltin(spv::BuiltInSubgroupLocalInvocationId, [&](const SpirvShader::BuiltinMapping& builtin, Array<SIMD::Float>& value)
 		{
 			ASSERT(builtin.SizeInComponents == 1);
-			value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 1, 2, 3));
+			value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::LaneIndices());
 		});
 
 		For(Int subgroupIndex = 0, subgroupIndex < numSubgroups, subgroupIndex++)
 		{
-			// TODO: Replace SIMD::Int(0, 1, 2, 3) with SIMD-width equivalent
-			auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::Int(0, 1, 2, 3);
+			auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::LaneIndices();
 
 			// Disable lanes where (invocationIDs >= numInvocations)
 			auto activeLaneMask = CmpLT(localInvocationIndex, SIMD::Int(numInvocations));
@@ -179,31 +182,47 @@ namespace sw
 
 	void ComputeProgram::run(
 		Routine *routine, void** descriptorSets, PushConstantStorage const &pushConstants,
+		uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
 		uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 	{
 		auto runWorkgroup = (void(*)(void*))(routine->getEntry());
 
-		Data data;
-		data.descriptorSets = descriptorSets;
-		data.numWorkgroups[X] = groupCountX;
-		data.numWorkgroups[Y] = groupCountY;
-		data.numWorkgroups[Z] = groupCountZ;
-		data.numWorkgroups[3] = 0;
-		data.pushConstants = pushConstants;
+		ThreadPool &pool = ThreadPool::get();
+
+		// Each thread gets its own Data block, as workgroupID differs per invocation.
+		std::vector<Data> threadData(pool.getThreadCount());
+		for(auto &data : threadData)
+		{
+			data.descriptorSets = descriptorSets;
+			data.numWorkgroups[X] = groupCountX;
+			data.numWorkgroups[Y] = groupCountY;
+			data.numWorkgroups[Z] = groupCountZ;
+			data.numWorkgroups[3] = 0;
+			data.workgroupID[3] = 0;
+			data.pushConstants = pushConstants;
+		}
+
+		// Workgroups are independent of each other, so they are split into contiguous
+		// chunks of the linearized X, Y, Z order. A few chunks per thread balance the load
+		// without making the per-chunk scheduling overhead noticeable.
+		const uint64_t groupCount = uint64_t(groupCountX) * groupCountY * groupCountZ;
+		const uint64_t chunkCount = std::min<uint64_t>(groupCount, pool.getThreadCount() * 4);
+		const uint64_t chunkSize = (chunkCount > 0) ? (groupCount + chunkCount - 1) / chunkCount : 0;
 
-		// TODO(bclayton): Split work across threads.
-		for (uint32_t groupZ = 0; groupZ < groupCountZ; groupZ++)
+		pool.parallelFor(static_cast<int>(chunkCount), [&](int chunk, int thread)
 		{
-			data.workgroupID[Z] = groupZ;
-			for (uint32_t groupY = 0; groupY < groupCountY; groupY++)
+			Data &data = threadData[thread];
+
+			const uint64_t begin = chunk * chunkSize;
+			const uint64_t end = std::min(begin + chunkSize, groupCount);
+
+			for(uint64_t group = begin; group < end; group++)
 			{
-				data.workgroupID[Y] = groupY;
-				for (uint32_t groupX = 0; groupX < groupCountX; groupX++)
-				{
-					data.workgroupID[X] = groupX;
-					runWorkgroup(&data);
-				}
+				data.workgroupID[X] = baseGroupX + static_cast<uint32_t>(group % groupCountX);
+				data.workgroupID[Y] = baseGroupY + static_cast<uint32_t>((group / groupCountX) % groupCountY);
+				data.workgroupID[Z] = baseGroupZ + static_cast<uint32_t>(group / (uint64_t(groupCountX) * groupCountY));
+				runWorkgroup(&data);
 			}
-		}
+		});
 	}
 }
@@ -45,10 +45,12 @@ namespace sw
 		// generate builds the shader program.
 		void generate();
 
-		// run executes the compute shader routine for all workgroups.
+		// run executes the compute shader routine for all workgroups,
+		// spreading them across the threads of the ThreadPool.
 		// TODO(bclayton): This probably does not belong here. Consider moving.
 		static void run(
 			Routine *routine, void** descriptorSets, PushConstantStorage const &pushConstants,
+			uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
 			uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
 
 	protected:
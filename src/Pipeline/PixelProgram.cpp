@@ -33,16 +33,16 @@ namespace sw
 
 		routine.pushConstants = data + OFFSET(DrawData, pushConstants);
 
-		auto activeLaneMask = SIMD::Int(0xFFFFFFFF); // TODO: Control this.
+		auto activeLaneMask = SIMD::QuadLaneMask(); // TODO: Control this.
 		spirvShader->emit(&routine, activeLaneMask);
 		spirvShader->emitEpilog(&routine);
 
 		for(int i = 0; i < RENDERTARGETS; i++)
 		{
-			c[i].x = routine.outputs[i * 4];
-			c[i].y = routine.outputs[i * 4 + 1];
-			c[i].z = routine.outputs[i * 4 + 2];
-			c[i].w = routine.outputs[i * 4 + 3];
+			c[i].x = SIMD::ToQuad(routine.outputs[i * 4]);
+			c[i].y = SIMD::ToQuad(routine.outputs[i * 4 + 1]);
+			c[i].z = SIMD::ToQuad(routine.outputs[i * 4 + 2]);
+			c[i].w = SIMD::ToQuad(routine.outputs[i * 4 + 3]);
 		}
 
 		clampColor(c);
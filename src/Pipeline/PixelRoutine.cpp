@@ -45,7 +45,7 @@ namespace sw
 		{
 			for (int i = 0; i < MAX_INTERFACE_COMPONENTS; i++)
 			{
-				routine.inputs[i] = Float4(0.0f);
+				routine.inputs[i] = SIMD::Float(0.0f);
 			}
 		}
 	}
@@ -167,23 +167,43 @@ namespace sw
 				{
 					if (input.Centroid)
 					{
-						routine.inputs[interpolant] =
+						routine.inputs[interpolant] = SIMD::FromQuad(
 								interpolateCentroid(XXXX, YYYY, rhwCentroid,
 													primitive + OFFSET(Primitive, V[interpolant]),
-													input.Flat, state.perspective);
+													input.Flat, state.perspective));
 					}
 					else
 					{
-						routine.inputs[interpolant] =
+						routine.inputs[interpolant] = SIMD::FromQuad(
 								interpolate(xxxx, Dv[interpolant], rhw,
 											primitive + OFFSET(Primitive, V[interpolant]),
-											input.Flat, state.perspective, false);
+											input.Flat, state.perspective, false));
 					}
 				}
 			}
 
 			setBuiltins(x, y, z, w);
 
+			if(state.statisticsEnabled)
+			{
+				// Count the pixels which have at least one sample left to shade
+				Int pixelMask = 0;
+
+				for(unsigned int q = 0; q < state.multiSample; q++)
+				{
+					if(earlyDepthTest)
+					{
+						pixelMask |= zMask[q] & sMask[q];
+					}
+					else
+					{
+						pixelMask |= cMask[q];
+					}
+				}
+
+				invocations += *Pointer<UInt>(constants + OFFSET(Constants,occlusionCount) + 4 * pixelMask);
+			}
+
 			#if PERF_PROFILE
 				cycles[PERF_INTERP] += Ticks() - interpTime;
 			#endif
@@ -163,6 +163,8 @@ namespace sw
 			// Vertical range
 			Int yMin = Y[0];
 			Int yMax = Y[0];
+			Int xMin = X[0];
+			Int xMax = X[0];
 
 			Int i = 1;
 
@@ -170,11 +172,17 @@ namespace sw
 			{
 				yMin = Min(Y[i], yMin);
 				yMax = Max(Y[i], yMax);
+				xMin = Min(X[i], xMin);
+				xMax = Max(X[i], xMax);
 
 				i++;
 			}
 			Until(i >= n)
 
+			// Horizontal range, widened by a pixel on each side to cover multisample offsets
+			xMin = Max((xMin >> 4) - 1, *Pointer<Int>(data + OFFSET(DrawData,scissorX0)));
+			xMax = Min((xMax >> 4) + 2, *Pointer<Int>(data + OFFSET(DrawData,scissorX1)));
+
 			if(state.multiSample > 1)
 			{
 				yMin = (yMin + 0x0A) >> 4;
@@ -274,6 +282,8 @@ namespace sw
 
 			*Pointer<Int>(primitive + OFFSET(Primitive,yMin)) = yMin;
 			*Pointer<Int>(primitive + OFFSET(Primitive,yMax)) = yMax;
+			*Pointer<Int>(primitive + OFFSET(Primitive,xMin)) = xMin;
+			*Pointer<Int>(primitive + OFFSET(Primitive,xMax)) = xMax;
 
 			// Sort by minimum y
 			if(triangle)
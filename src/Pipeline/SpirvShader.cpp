@@ -2267,7 +2267,8 @@ namespace sw
 				// Derivative instructions: FS invocations are laid out like so:
 				//    0 1
 				//    2 3
-				static_assert(SIMD::Width == 4, "All cross-lane instructions will need care when using a different width");
+				// Wider vectors still hold a single quad, in the first four lanes.
+				static_assert(SIMD::Width >= 4, "All cross-lane instructions will need care when using a different width");
 				dst.move(i, SIMD::Float(Extract(src.Float(i), 1) - Extract(src.Float(i), 0)));
 				break;
 			case spv::OpDPdy:
@@ -2638,7 +2639,7 @@ namespace sw
 				auto x = Round(src.Float(i));
 				// dst = round(src) + ((round(src) < src) * 2 - 1) * (fract(src) == 0.5) * isOdd(round(src));
 				dst.move(i, x + ((SIMD::Float(CmpLT(x, src.Float(i)) & SIMD::Int(1)) * SIMD::Float(2.0f)) - SIMD::Float(1.0f)) *
-						SIMD::Float(CmpEQ(Frac(src.Float(i)), SIMD::Float(0.5f)) & SIMD::Int(1)) * SIMD::Float(Int4(x) & SIMD::Int(1)));
+						SIMD::Float(CmpEQ(Frac(src.Float(i)), SIMD::Float(0.5f)) & SIMD::Int(1)) * SIMD::Float(SIMD::Int(x) & SIMD::Int(1)));
 			}
 			break;
 		}
@@ -2721,7 +2722,7 @@ namespace sw
 			{
 				auto tx = Min(Max((x.Float(i) - edge0.Float(i)) /
 						(edge1.Float(i) - edge0.Float(i)), SIMD::Float(0.0f)), SIMD::Float(1.0f));
-				dst.move(i, tx * tx * (Float4(3.0f) - Float4(2.0f) * tx));
+				dst.move(i, tx * tx * (SIMD::Float(3.0f) - SIMD::Float(2.0f) * tx));
 			}
 			break;
 		}
@@ -36,6 +36,10 @@
 #include <memory>
 #include <queue>
 
+#ifndef SIMD_WIDTH
+#define SIMD_WIDTH 4
+#endif
+
 namespace vk
 {
 	class PipelineLayout;
@@ -54,11 +58,67 @@ namespace sw
 	namespace SIMD
 	{
 		// Width is the number of per-lane scalars packed into each SIMD vector.
-		static constexpr int Width = 4;
+		// It is chosen per target by the build. Widths of 8 and 16 use AVX and
+		// AVX-512 sized vectors, which only Reactor's LLVM back-end implements.
+		static constexpr int Width = SIMD_WIDTH;
 
+#if SIMD_WIDTH == 4
 		using Float = rr::Float4;
 		using Int = rr::Int4;
 		using UInt = rr::UInt4;
+#elif SIMD_WIDTH == 8
+		using Float = rr::Float8;
+		using Int = rr::Int8;
+		using UInt = rr::UInt8;
+#elif SIMD_WIDTH == 16
+		using Float = rr::Float16;
+		using Int = rr::Int16;
+		using UInt = rr::UInt16;
+#else
+#error "SIMD_WIDTH must be 4, 8 or 16"
+#endif
+
+		// Returns the index of each lane: (0, 1, ..., Width - 1).
+		inline Int LaneIndices()
+		{
+#if SIMD_WIDTH == 4
+			return Int(0, 1, 2, 3);
+#elif SIMD_WIDTH == 8
+			return Int(rr::Int4(0, 1, 2, 3), rr::Int4(4, 5, 6, 7));
+#else
+			return Int(rr::Int8(rr::Int4(0, 1, 2, 3), rr::Int4(4, 5, 6, 7)),
+			           rr::Int8(rr::Int4(8, 9, 10, 11), rr::Int4(12, 13, 14, 15)));
+#endif
+		}
+
+		// The vertex and pixel routines process four vertices, or a 2x2 quad of
+		// pixels, at a time. Their shaders only use the first four lanes.
+		inline RValue<Float> FromQuad(RValue<rr::Float4> quad)
+		{
+#if SIMD_WIDTH == 4
+			return quad;
+#elif SIMD_WIDTH == 8
+			return Float(quad, quad);
+#else
+			return Float(rr::Float8(quad, quad), rr::Float8(quad, quad));
+#endif
+		}
+
+		inline RValue<rr::Float4> ToQuad(RValue<Float> v)
+		{
+#if SIMD_WIDTH == 4
+			return v;
+#elif SIMD_WIDTH == 8
+			return rr::Float4(v);
+#else
+			return rr::Float4(rr::Float8(v));
+#endif
+		}
+
+		inline RValue<Int> QuadLaneMask()
+		{
+			return CmpLT(LaneIndices(), Int(4));
+		}
 	}
 
 	// Incrementally constructed complex bundle of rvalues
@@ -43,7 +43,7 @@ namespace sw
 			// TODO: we could do better here; we know InstanceIndex is uniform across all lanes
 			assert(it->second.SizeInComponents == 1);
 			routine.getValue(it->second.Id)[it->second.FirstComponent] =
-					As<Float4>(Int4((*Pointer<Int>(data + OFFSET(DrawData, instanceID)))));
+					As<SIMD::Float>(SIMD::Int((*Pointer<Int>(data + OFFSET(DrawData, instanceID)))));
 		}
 
 		routine.pushConstants = data + OFFSET(DrawData, pushConstants);
@@ -71,10 +71,10 @@ namespace sw
 		{
 			assert(it->second.SizeInComponents == 1);
 			routine.getValue(it->second.Id)[it->second.FirstComponent] =
-					As<Float4>(Int4(index) + Int4(0, 1, 2, 3));
+					As<SIMD::Float>(SIMD::Int(index) + SIMD::LaneIndices());
 		}
 
-		auto activeLaneMask = SIMD::Int(0xFFFFFFFF); // TODO: Control this.
+		auto activeLaneMask = SIMD::QuadLaneMask(); // TODO: Control this.
 		spirvShader->emit(&routine, activeLaneMask);
 
 		if(currentLabel != -1)
@@ -43,9 +43,13 @@ namespace sw
 	{
 		const bool textureSampling = state.textureSampling;
 
+		const unsigned int sets = 1 << state.vertexCacheSetsLog2;
+		const unsigned int ways = 1 << state.vertexCacheWaysLog2;
+
 		Pointer<Byte> cache = task + OFFSET(VertexTask,vertexCache);
-		Pointer<Byte> vertexCache = cache + OFFSET(VertexCache,vertex);
-		Pointer<Byte> tagCache = cache + OFFSET(VertexCache,tag);
+		Pointer<Byte> vertexCache = *Pointer<Pointer<Byte>>(cache + OFFSET(VertexCache,vertex));
+		Pointer<Byte> tagCache = *Pointer<Pointer<Byte>>(cache + OFFSET(VertexCache,tag));
+		Pointer<Byte> victimCache = *Pointer<Pointer<Byte>>(cache + OFFSET(VertexCache,victim));
 
 		UInt vertexCount = *Pointer<UInt>(task + OFFSET(VertexTask,vertexCount));
 
@@ -54,22 +58,54 @@ namespace sw
 		Do
 		{
 			UInt index = *Pointer<UInt>(batch);
-			UInt tagIndex = index & 0x0000003C;
+			UInt set = (index >> UInt(2)) & UInt(sets - 1);
 			UInt indexQ = !textureSampling ? UInt(index & 0xFFFFFFFC) : index;   // FIXME: TEXLDL hack to have independent LODs, hurts performance.
 
-			If(*Pointer<UInt>(tagCache + tagIndex) != indexQ)
+			// The ways of a set occupy consecutive lines
+			UInt firstLine = set * UInt(ways);
+			UInt line = firstLine;
+			Bool hit = false;
+
+			for(unsigned int way = 0; way < ways; way++)
 			{
-				*Pointer<UInt>(tagCache + tagIndex) = indexQ;
+				If(*Pointer<UInt>(tagCache + (firstLine + UInt(way)) * UInt((int)sizeof(unsigned int))) == indexQ)
+				{
+					line = firstLine + UInt(way);
+					hit = Bool(true);
+				}
+			}
+
+			#if PERF_PROFILE
+				If(hit)
+				{
+					*Pointer<UInt>(task + OFFSET(VertexTask,cacheHits)) += UInt(1);
+				}
+			#endif
+
+			If(!hit)
+			{
+				#if PERF_PROFILE
+					*Pointer<UInt>(task + OFFSET(VertexTask,cacheMisses)) += UInt(1);
+				#endif
+
+				Pointer<Byte> victim = victimCache + set * UInt((int)sizeof(unsigned int));
+				UInt way = *Pointer<UInt>(victim);
+				*Pointer<UInt>(victim) = (way + UInt(1)) & UInt(ways - 1);
+
+				line = firstLine + way;
+				*Pointer<UInt>(tagCache + line * UInt((int)sizeof(unsigned int))) = indexQ;
 
 				readInput(indexQ);
 				program(indexQ);
 				computeClipFlags();
 
-				Pointer<Byte> cacheLine0 = vertexCache + tagIndex * UInt((int)sizeof(Vertex));
+				*Pointer<UInt>(task + OFFSET(VertexTask,invocations)) += UInt(4);
+
+				Pointer<Byte> cacheLine0 = vertexCache + line * UInt((int)sizeof(Vertex[4]));
 				writeCache(cacheLine0);
 			}
 
-			UInt cacheIndex = index & 0x0000003F;
+			UInt cacheIndex = line * UInt(4) + (index & UInt(3));
 			Pointer<Byte> cacheLine = vertexCache + cacheIndex * UInt((int)sizeof(Vertex));
 			writeVertex(vertex, cacheLine);
 
@@ -96,10 +132,10 @@ namespace sw
 				UInt stride = *Pointer<UInt>(data + OFFSET(DrawData, stride) + sizeof(unsigned int) * (i/4));
 
 				auto value = readStream(input, stride, state.input[i/4], index);
-				routine.inputs[i] = value.x;
-				routine.inputs[i+1] = value.y;
-				routine.inputs[i+2] = value.z;
-				routine.inputs[i+3] = value.w;
+				routine.inputs[i] = SIMD::FromQuad(value.x);
+				routine.inputs[i+1] = SIMD::FromQuad(value.y);
+				routine.inputs[i+2] = SIMD::FromQuad(value.z);
+				routine.inputs[i+3] = SIMD::FromQuad(value.w);
 			}
 		}
 	}
@@ -110,10 +146,10 @@ namespace sw
 		assert(it != spirvShader->outputBuiltins.end());
 		assert(it->second.SizeInComponents == 4);
 		auto &pos = routine.getValue(it->second.Id);
-		auto posX = pos[it->second.FirstComponent];
-		auto posY = pos[it->second.FirstComponent + 1];
-		auto posZ = pos[it->second.FirstComponent + 2];
-		auto posW = pos[it->second.FirstComponent + 3];
+		Float4 posX = SIMD::ToQuad(pos[it->second.FirstComponent]);
+		Float4 posY = SIMD::ToQuad(pos[it->second.FirstComponent + 1]);
+		Float4 posZ = SIMD::ToQuad(pos[it->second.FirstComponent + 2]);
+		Float4 posW = SIMD::ToQuad(pos[it->second.FirstComponent + 3]);
 
 		Int4 maxX = CmpLT(posW, posX);
 		Int4 maxY = CmpLT(posW, posY);
@@ -502,10 +538,10 @@ namespace sw
 				spirvShader->outputs[i+2].Type != SpirvShader::ATTRIBTYPE_UNUSED ||
 				spirvShader->outputs[i+3].Type != SpirvShader::ATTRIBTYPE_UNUSED)
 			{
-				v.x = routine.outputs[i];
-				v.y = routine.outputs[i+1];
-				v.z = routine.outputs[i+2];
-				v.w = routine.outputs[i+3];
+				v.x = SIMD::ToQuad(routine.outputs[i]);
+				v.y = SIMD::ToQuad(routine.outputs[i+1]);
+				v.z = SIMD::ToQuad(routine.outputs[i+2]);
+				v.w = SIMD::ToQuad(routine.outputs[i+3]);
 
 				transpose4x4(v.x, v.y, v.z, v.w);
 
@@ -526,10 +562,10 @@ namespace sw
 		assert(it != spirvShader->outputBuiltins.end());
 		assert(it->second.SizeInComponents == 4);
 		auto &pos = routine.getValue(it->second.Id);
-		auto posX = pos[it->second.FirstComponent];
-		auto posY = pos[it->second.FirstComponent + 1];
-		auto posZ = pos[it->second.FirstComponent + 2];
-		auto posW = pos[it->second.FirstComponent + 3];
+		Float4 posX = SIMD::ToQuad(pos[it->second.FirstComponent]);
+		Float4 posY = SIMD::ToQuad(pos[it->second.FirstComponent + 1]);
+		Float4 posZ = SIMD::ToQuad(pos[it->second.FirstComponent + 2]);
+		Float4 posW = SIMD::ToQuad(pos[it->second.FirstComponent + 3]);
 
 		v.x = posX;
 		v.y = posY;
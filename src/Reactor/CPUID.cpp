@@ -14,6 +14,8 @@
 
 #include "CPUID.hpp"
 
+#include <stdint.h>
+
 #if defined(_WIN32)
 	#ifndef WIN32_LEAN_AND_MEAN
 		#define WIN32_LEAN_AND_MEAN
@@ -36,6 +38,9 @@ namespace rr
 	bool CPUID::SSE3 = detectSSE3();
 	bool CPUID::SSSE3 = detectSSSE3();
 	bool CPUID::SSE4_1 = detectSSE4_1();
+	bool CPUID::AVX = detectAVX();
+	bool CPUID::AVX2 = detectAVX2();
+	bool CPUID::AVX512F = detectAVX512F();
 
 	bool CPUID::enableMMX = true;
 	bool CPUID::enableCMOV = true;
@@ -44,6 +49,9 @@ namespace rr
 	bool CPUID::enableSSE3 = true;
 	bool CPUID::enableSSSE3 = true;
 	bool CPUID::enableSSE4_1 = true;
+	bool CPUID::enableAVX = true;
+	bool CPUID::enableAVX2 = true;
+	bool CPUID::enableAVX512F = true;
 
 	void CPUID::setEnableMMX(bool enable)
 	{
@@ -56,6 +64,9 @@ namespace rr
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
 		}
 	}
 
@@ -70,6 +81,9 @@ namespace rr
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
 		}
 	}
 
@@ -88,6 +102,9 @@ namespace rr
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
 		}
 	}
 
@@ -106,6 +123,9 @@ namespace rr
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
 		}
 	}
 
@@ -124,6 +144,9 @@ namespace rr
 		{
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
 		}
 	}
 
@@ -142,6 +165,9 @@ namespace rr
 		else
 		{
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
 		}
 	}
 
@@ -158,6 +184,54 @@ namespace rr
 			enableSSE3 = true;
 			enableSSSE3 = true;
 		}
+		else
+		{
+			enableAVX = false;
+			enableAVX2 = false;
+			enableAVX512F = false;
+		}
+	}
+
+	void CPUID::setEnableAVX(bool enable)
+	{
+		enableAVX = enable;
+
+		if(enableAVX)
+		{
+			setEnableSSE4_1(true);
+		}
+		else
+		{
+			enableAVX2 = false;
+			enableAVX512F = false;
+		}
+	}
+
+	void CPUID::setEnableAVX2(bool enable)
+	{
+		enableAVX2 = enable;
+
+		if(enableAVX2)
+		{
+			setEnableSSE4_1(true);
+			enableAVX = true;
+		}
+		else
+		{
+			enableAVX512F = false;
+		}
+	}
+
+	void CPUID::setEnableAVX512F(bool enable)
+	{
+		enableAVX512F = enable;
+
+		if(enableAVX512F)
+		{
+			setEnableSSE4_1(true);
+			enableAVX = true;
+			enableAVX2 = true;
+		}
 	}
 
 	static void cpuid(int registers[4], int info)
@@ -176,6 +250,22 @@ namespace rr
 		#endif
 	}
 
+	static void cpuidex(int registers[4], int info, int subleaf)
+	{
+		#if defined(__i386__) || defined(__x86_64__)
+			#if defined(_WIN32)
+				__cpuidex(registers, info, subleaf);
+			#else
+				__asm volatile("cpuid": "=a" (registers[0]), "=b" (registers[1]), "=c" (registers[2]), "=d" (registers[3]): "a" (info), "c" (subleaf));
+			#endif
+		#else
+			registers[0] = 0;
+			registers[1] = 0;
+			registers[2] = 0;
+			registers[3] = 0;
+		#endif
+	}
+
 	bool CPUID::detectMMX()
 	{
 		int registers[4];
@@ -224,4 +314,65 @@ namespace rr
 		cpuid(registers, 1);
 		return SSE4_1 = (registers[2] & 0x00080000) != 0;
 	}
+
+	// Returns the OS-enabled state components of the XCR0 register, or 0 if XGETBV is unavailable.
+	static uint64_t xgetbv()
+	{
+		int registers[4];
+		cpuid(registers, 1);
+
+		if((registers[2] & 0x08000000) == 0)   // OSXSAVE
+		{
+			return 0;
+		}
+
+		#if defined(__i386__) || defined(__x86_64__)
+			#if defined(_WIN32)
+				return _xgetbv(0);
+			#else
+				uint32_t eax, edx;
+				__asm volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+				return (static_cast<uint64_t>(edx) << 32) | eax;
+			#endif
+		#else
+			return 0;
+		#endif
+	}
+
+	bool CPUID::detectAVX()
+	{
+		int registers[4];
+		cpuid(registers, 1);
+		bool osSupport = (xgetbv() & 0x06) == 0x06;   // XMM and YMM state
+		return AVX = osSupport && (registers[2] & 0x10000000) != 0;
+	}
+
+	bool CPUID::detectAVX2()
+	{
+		int registers[4];
+		cpuid(registers, 0);
+
+		if(registers[0] < 7)
+		{
+			return AVX2 = false;
+		}
+
+		cpuidex(registers, 7, 0);
+		return AVX2 = detectAVX() && (registers[1] & 0x00000020) != 0;
+	}
+
+	bool CPUID::detectAVX512F()
+	{
+		int registers[4];
+		cpuid(registers, 0);
+
+		if(registers[0] < 7)
+		{
+			return AVX512F = false;
+		}
+
+		cpuidex(registers, 7, 0);
+		bool osSupport = (xgetbv() & 0xE6) == 0xE6;   // XMM, YMM, opmask and ZMM state
+		return AVX512F = osSupport && (registers[1] & 0x00010000) != 0;
+	}
 }
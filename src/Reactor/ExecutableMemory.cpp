@@ -33,7 +33,12 @@
 	#include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <iterator>
+#include <map>
 #include <memory.h>
+#include <mutex>
+#include <set>
 
 #undef allocate
 #undef deallocate
@@ -89,7 +94,7 @@ void *allocateRaw(size_t bytes, size_t alignment)
 	#endif
 }
 
-#if defined(LINUX_ENABLE_NAMED_MMAP)
+#if defined(__linux__)
 // Create a file descriptor for anonymous memory with the given
 // name. Returns -1 on failure.
 // TODO: remove once libc wrapper exists.
@@ -111,10 +116,13 @@ int memfd_create(const char* name, unsigned int flags)
 		// as ENOSYS.
 		return syscall(__NR_memfd_create, name, flags);
 	#else
+		errno = ENOSYS;
 		return -1;
 	#endif
 }
+#endif  // defined(__linux__)
 
+#if defined(LINUX_ENABLE_NAMED_MMAP)
 // Returns a file descriptor for use with an anonymous mmap, if
 // memfd_create fails, -1 is returned. Note, the mappings should be
 // MAP_PRIVATE so that underlying pages aren't shared.
@@ -127,6 +135,11 @@ int anonymousFd()
 // Ensure there is enough space in the "anonymous" fd for length.
 void ensureAnonFileSize(int anonFd, size_t length)
 {
+	// Routines can be generated concurrently. Don't let a smaller request
+	// truncate the file after a larger one grew it.
+	static std::mutex mutex;
+	std::unique_lock<std::mutex> lock(mutex);
+
 	static size_t fileSize = 0;
 	if(length > fileSize)
 	{
@@ -136,6 +149,243 @@ void ensureAnonFileSize(int anonFd, size_t length)
 }
 #endif  // defined(LINUX_ENABLE_NAMED_MMAP)
 
+#if defined(__linux__)
+// Packs routines into arenas made of a memfd which is mapped twice: read/write, immediately
+// followed by read/execute. Freed blocks are kept in a map ordered by address, so that neighbours
+// get merged, and in free lists by size class to find one that fits. Since each writable view is
+// followed by its own executable view, the blocks of different arenas are never adjacent.
+class CodeHeap
+{
+public:
+	static CodeHeap &get()
+	{
+		static CodeHeap heap;
+		return heap;
+	}
+
+	// Returns nullptr when no arena can be created. Failures are only permanent when memfd isn't
+	// supported, otherwise the next allocation tries again.
+	void *allocate(size_t bytes)
+	{
+		size_t size = blockSize(bytes);
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if(unavailable)
+		{
+			return nullptr;
+		}
+
+		auto block = findFreeBlock(size);
+
+		if(block == freeBlocks.end())
+		{
+			int error = createArena(std::max(size, size_t(ARENA_SIZE)));
+
+			if(error != 0)
+			{
+				unavailable = (error == ENOSYS) || (error == EINVAL);
+				return nullptr;
+			}
+
+			block = findFreeBlock(size);
+		}
+
+		uint8_t *memory = block->first;
+		size_t remainder = block->second - size;
+		eraseFreeBlock(block);
+
+		if(remainder > 0)
+		{
+			insertFreeBlock(memory + size, remainder);
+		}
+
+		return memory;
+	}
+
+	// Returns false when the memory isn't part of an arena
+	bool deallocate(void *memory, size_t bytes)
+	{
+		uint8_t *block = static_cast<uint8_t*>(memory);
+		size_t size = blockSize(bytes);
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if(!findArena(block))
+		{
+			return false;
+		}
+
+		auto next = freeBlocks.lower_bound(block);
+
+		if(next != freeBlocks.end() && next->first == block + size)
+		{
+			size += next->second;
+			next = eraseFreeBlock(next);
+		}
+
+		if(next != freeBlocks.begin())
+		{
+			auto previous = std::prev(next);
+
+			if(previous->first + previous->second == block)
+			{
+				block = previous->first;
+				size += previous->second;
+				eraseFreeBlock(previous);
+			}
+		}
+
+		insertFreeBlock(block, size);
+
+		return true;
+	}
+
+	// Returns nullptr when the memory isn't part of an arena
+	const void *getExecutableAddress(const void *memory)
+	{
+		const uint8_t *block = static_cast<const uint8_t*>(memory);
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		const Arena *arena = findArena(block);
+
+		return arena ? arena->executable + (block - arena->writable) : nullptr;
+	}
+
+private:
+	struct Arena
+	{
+		uint8_t *writable;
+		uint8_t *executable;
+		size_t size;
+	};
+
+	enum : size_t
+	{
+		ARENA_SIZE = 4 * 1024 * 1024,   // Pages only get committed once written
+		BLOCK_ALIGNMENT = 64,           // Cache line alignment for routine entries
+		SIZE_CLASSES = 16,              // Powers of two of the alignment, the last one holds all larger blocks
+	};
+
+	static size_t blockSize(size_t bytes)
+	{
+		return (std::max(bytes, size_t(1)) + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+	}
+
+	static int sizeClass(size_t size)
+	{
+		int sizeClass = 0;
+
+		for(size_t units = size / BLOCK_ALIGNMENT; units > 1 && sizeClass < SIZE_CLASSES - 1; units >>= 1)
+		{
+			sizeClass++;
+		}
+
+		return sizeClass;
+	}
+
+	// Any block of a larger size class fits, only the requested one needs searching
+	std::map<uint8_t*, size_t>::iterator findFreeBlock(size_t size)
+	{
+		for(int i = sizeClass(size); i < SIZE_CLASSES; i++)
+		{
+			for(uint8_t *block : freeLists[i])
+			{
+				auto freeBlock = freeBlocks.find(block);
+
+				if(freeBlock->second >= size)
+				{
+					return freeBlock;
+				}
+			}
+		}
+
+		return freeBlocks.end();
+	}
+
+	void insertFreeBlock(uint8_t *block, size_t size)
+	{
+		freeBlocks[block] = size;
+		freeLists[sizeClass(size)].insert(block);
+	}
+
+	std::map<uint8_t*, size_t>::iterator eraseFreeBlock(std::map<uint8_t*, size_t>::iterator block)
+	{
+		freeLists[sizeClass(block->second)].erase(block->first);
+		return freeBlocks.erase(block);
+	}
+
+	const Arena *findArena(const uint8_t *memory) const
+	{
+		auto arena = arenas.upper_bound(const_cast<uint8_t*>(memory));
+
+		if(arena == arenas.begin())
+		{
+			return nullptr;
+		}
+
+		arena--;
+
+		return (memory < arena->second.writable + arena->second.size) ? &arena->second : nullptr;
+	}
+
+	// Returns 0 on success, or the errno of the call that failed
+	int createArena(size_t bytes)
+	{
+		size_t pageSize = memoryPageSize();
+		size_t size = (bytes + pageSize - 1) & ~(pageSize - 1);
+
+		int fd = memfd_create("SwiftShader JIT", 1 /* MFD_CLOEXEC */);
+		if(fd == -1)
+		{
+			return errno;
+		}
+
+		// Reserve the space of both views, so the executable view is right after the writable one
+		void *reservation = MAP_FAILED;
+		if(ftruncate(fd, size) == 0)
+		{
+			reservation = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		}
+
+		void *writable = MAP_FAILED;
+		void *executable = MAP_FAILED;
+		if(reservation != MAP_FAILED)
+		{
+			uint8_t *base = static_cast<uint8_t*>(reservation);
+			writable = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+			executable = mmap(base + size, size, PROT_READ | PROT_EXEC, MAP_SHARED | MAP_FIXED, fd, 0);
+		}
+
+		int error = errno;
+		close(fd);   // The mappings keep the memory alive
+
+		if(writable == MAP_FAILED || executable == MAP_FAILED)
+		{
+			if(reservation != MAP_FAILED)
+			{
+				munmap(reservation, 2 * size);
+			}
+
+			return error;
+		}
+
+		Arena arena = { static_cast<uint8_t*>(writable), static_cast<uint8_t*>(executable), size };
+		arenas[arena.writable] = arena;
+		insertFreeBlock(arena.writable, size);
+
+		return 0;
+	}
+
+	std::mutex mutex;
+	std::map<uint8_t*, Arena> arenas;       // By writable address
+	std::map<uint8_t*, size_t> freeBlocks;  // By writable address
+	std::set<uint8_t*> freeLists[SIZE_CLASSES];   // By size class, in address order
+	bool unavailable = false;
+};
+#endif  // defined(__linux__)
+
 }  // anonymous namespace
 
 size_t memoryPageSize()
@@ -292,4 +542,61 @@ void deallocateExecutable(void *memory, size_t bytes)
 		deallocate(memory);
 	#endif
 }
+
+void *allocateCode(size_t bytes)
+{
+	#if defined(__linux__)
+		void *memory = CodeHeap::get().allocate(bytes);
+
+		if(memory)
+		{
+			return memory;
+		}
+	#endif
+
+	return allocateExecutable(bytes);
+}
+
+const void *getExecutableAddress(const void *code)
+{
+	#if defined(__linux__)
+		const void *executable = CodeHeap::get().getExecutableAddress(code);
+
+		if(executable)
+		{
+			return executable;
+		}
+	#endif
+
+	return code;
+}
+
+void markCodeExecutable(void *code, size_t bytes)
+{
+	const void *executable = getExecutableAddress(code);
+
+	if(executable == code)
+	{
+		markExecutable(code, bytes);
+	}
+
+	#if defined(_WIN32)
+		FlushInstructionCache(GetCurrentProcess(), executable, bytes);
+	#else
+		char *begin = const_cast<char*>(static_cast<const char*>(executable));
+		__builtin___clear_cache(begin, begin + bytes);
+	#endif
+}
+
+void deallocateCode(void *code, size_t bytes)
+{
+	#if defined(__linux__)
+		if(CodeHeap::get().deallocate(code, bytes))
+		{
+			return;
+		}
+	#endif
+
+	deallocateExecutable(code, bytes);
+}
 }
@@ -27,6 +27,16 @@ void *allocateExecutable(size_t bytes);   // Allocates memory that can be made e
 void markExecutable(void *memory, size_t bytes);
 void deallocateExecutable(void *memory, size_t bytes);
 
+// Code heap, which packs the code of many routines into shared arenas. On Linux each arena is
+// mapped twice, once writable and once executable, so no page ever needs to be both or change
+// protection. Code gets written through the writable view, and must be relocated for the address
+// it runs at in the executable view. Where this isn't supported, the functions fall back to the
+// ones above and both addresses are the same.
+void *allocateCode(size_t bytes);   // Returns the address of the writable view
+const void *getExecutableAddress(const void *code);
+void markCodeExecutable(void *code, size_t bytes);
+void deallocateCode(void *code, size_t bytes);   // The memory gets reused by later allocations
+
 template<typename P>
 P unaligned_read(P *address)
 {
@@ -45,14 +45,17 @@
 	#define ARGS(...) __VA_ARGS__
 #else
 	#include "llvm/Analysis/LoopPass.h"
+	#include "llvm/Analysis/TargetTransformInfo.h"
+	#include "llvm/Bitcode/BitcodeReader.h"
+	#include "llvm/Bitcode/BitcodeWriter.h"
 	#include "llvm/ExecutionEngine/ExecutionEngine.h"
 	#include "llvm/ExecutionEngine/JITSymbol.h"
+	#include "llvm/ExecutionEngine/ObjectCache.h"
 	#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 	#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 	#include "llvm/ExecutionEngine/Orc/LambdaResolver.h"
 	#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 	#include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
-	#include "llvm/ExecutionEngine/SectionMemoryManager.h"
 	#include "llvm/IR/Constants.h"
 	#include "llvm/IR/DataLayout.h"
 	#include "llvm/IR/Function.h"
@@ -69,6 +72,7 @@
 	#include "llvm/Transforms/InstCombine/InstCombine.h"
 	#include "llvm/Transforms/Scalar.h"
 	#include "llvm/Transforms/Scalar/GVN.h"
+	#include "llvm/Transforms/Vectorize.h"
 
 	#include "LLVMRoutine.hpp"
 
@@ -79,9 +83,13 @@
 	#include <unordered_map>
 #endif
 
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <mutex>
 #include <numeric>
 #include <thread>
+#include <vector>
 
 #if defined(__i386__) || defined(__x86_64__)
 #include <xmmintrin.h>
@@ -110,13 +118,34 @@ namespace rr
 
 namespace
 {
-	rr::LLVMReactorJIT *reactorJIT = nullptr;
-	llvm::IRBuilder<> *builder = nullptr;
-	llvm::LLVMContext *context = nullptr;
-	llvm::Module *module = nullptr;
-	llvm::Function *function = nullptr;
+	// State of the Nucleus which is generating code on the current thread.
+	thread_local rr::LLVMReactorJIT *reactorJIT = nullptr;
+	thread_local llvm::IRBuilder<> *builder = nullptr;
+	thread_local llvm::LLVMContext *context = nullptr;
+	thread_local llvm::Module *module = nullptr;
+	thread_local llvm::Function *function = nullptr;
+
+	// Object code of the last routine acquired on this thread
+	thread_local rr::RoutineObject routineObject;
+
+	// Each Nucleus builds its routine with its own LLVM context, IR builder and JIT,
+	// so that multiple threads can generate code concurrently. These are recycled
+	// through a pool instead of being created for each routine.
+	struct CodegenState
+	{
+		rr::LLVMReactorJIT *reactorJIT;
+		llvm::IRBuilder<> *builder;
+		llvm::LLVMContext *context;
+	};
+
+	std::mutex codegenPoolMutex;
+	std::vector<CodegenState> codegenPool;
 
-	rr::MutexLock codegenMutex;
+	std::once_flag llvmInitialized;
+
+#if REACTOR_LLVM_VERSION < 7
+	rr::MutexLock codegenMutex;   // The legacy JIT has process-wide state, so it is not thread safe
+#endif
 
 #ifdef ENABLE_RR_PRINT
 	std::string replace(std::string str, const std::string& substr, const std::string& replacement)
@@ -184,7 +213,6 @@ namespace
 	}
 #endif  // defined(__i386__) || defined(__x86_64__)
 
-#if !defined(__i386__) && !defined(__x86_64__)
 	llvm::Value *lowerPFMINMAX(llvm::Value *x, llvm::Value *y,
 	                           llvm::FCmpInst::Predicate pred)
 	{
@@ -217,6 +245,42 @@ namespace
 		return ::builder->CreateCall(trunc, ARGS(x));
 	}
 
+	llvm::Value *lowerSQRT(llvm::Value *x)
+	{
+		llvm::Function *sqrt = llvm::Intrinsic::getDeclaration(
+			::module, llvm::Intrinsic::sqrt, {x->getType()});
+		return ::builder->CreateCall(sqrt, ARGS(x));
+	}
+
+	// Concatenates two vectors of the same type into one of twice the width
+	llvm::Value *lowerConcat(llvm::Value *lo, llvm::Value *hi)
+	{
+		llvm::VectorType *ty = llvm::cast<llvm::VectorType>(lo->getType());
+		llvm::SmallVector<uint32_t, 32> mask(2 * ty->getNumElements());
+		std::iota(mask.begin(), mask.end(), 0);
+		return ::builder->CreateShuffleVector(lo, hi, mask);
+	}
+
+	llvm::Value *lowerLowHalf(llvm::Value *v)
+	{
+		llvm::VectorType *ty = llvm::cast<llvm::VectorType>(v->getType());
+		llvm::Value *undef = llvm::UndefValue::get(ty);
+		llvm::SmallVector<uint32_t, 16> mask(ty->getNumElements() / 2);
+		std::iota(mask.begin(), mask.end(), 0);
+		return ::builder->CreateShuffleVector(v, undef, mask);
+	}
+
+	// Unlike lowerSignMask(), this bitcasts the lanes' sign bits to an integer
+	// instead of extracting them one by one, which x86 selects as (v)movmskps.
+	llvm::Value *lowerVectorSignMask(llvm::Value *x, llvm::Type *retTy)
+	{
+		llvm::VectorType *ty = llvm::cast<llvm::VectorType>(x->getType());
+		llvm::Value *cmp = ::builder->CreateICmpSLT(x, llvm::Constant::getNullValue(ty));
+		llvm::Type *bitsTy = llvm::IntegerType::get(*::context, ty->getNumElements());
+		return ::builder->CreateZExt(::builder->CreateBitCast(cmp, bitsTy), retTy);
+	}
+
+#if !defined(__i386__) && !defined(__x86_64__)
 	// Packed add/sub saturatation
 	llvm::Value *lowerPSAT(llvm::Value *x, llvm::Value *y, bool isAdd, bool isSigned)
 	{
@@ -272,13 +336,6 @@ namespace
 		return lowerPSAT(x, y, false, true);
 	}
 
-	llvm::Value *lowerSQRT(llvm::Value *x)
-	{
-		llvm::Function *sqrt = llvm::Intrinsic::getDeclaration(
-			::module, llvm::Intrinsic::sqrt, {x->getType()});
-		return ::builder->CreateCall(sqrt, ARGS(x));
-	}
-
 	llvm::Value *lowerRCP(llvm::Value *x)
 	{
 		llvm::Type *ty = x->getType();
@@ -504,9 +561,10 @@ namespace rr
 			return routineManager->acquireRoutine(entry);
 		}
 
-		void optimize(llvm::Module *module)
+		void optimize(llvm::Module *module, OptimizationProfile profile)
 		{
-			static llvm::PassManager *passManager = nullptr;
+			static llvm::PassManager *passManagers[AggressiveOptimization + 1] = {};
+			llvm::PassManager *&passManager = passManagers[profile];
 
 			if(!passManager)
 			{
@@ -515,27 +573,50 @@ namespace rr
 				passManager->add(new llvm::TargetData(*executionEngine->getTargetData()));
 				passManager->add(llvm::createScalarReplAggregatesPass());
 
-				for(int pass = 0; pass < 10 && optimization[pass] != Disabled; pass++)
+				switch(profile)
 				{
-					switch(optimization[pass])
+				case NoOptimization:
+				case MinimalOptimization:
+					break;
+				case DefaultOptimization:
+					for(int pass = 0; pass < 10 && optimization[pass] != Disabled; pass++)
 					{
-					case Disabled:                                                                       break;
-					case CFGSimplification:    passManager->add(llvm::createCFGSimplificationPass());    break;
-					case LICM:                 passManager->add(llvm::createLICMPass());                 break;
-					case AggressiveDCE:        passManager->add(llvm::createAggressiveDCEPass());        break;
-					case GVN:                  passManager->add(llvm::createGVNPass());                  break;
-					case InstructionCombining: passManager->add(llvm::createInstructionCombiningPass()); break;
-					case Reassociate:          passManager->add(llvm::createReassociatePass());          break;
-					case DeadStoreElimination: passManager->add(llvm::createDeadStoreEliminationPass()); break;
-					case SCCP:                 passManager->add(llvm::createSCCPPass());                 break;
-					case ScalarReplAggregates: passManager->add(llvm::createScalarReplAggregatesPass()); break;
-					default:
-						assert(false);
+						switch(optimization[pass])
+						{
+						case Disabled:                                                                       break;
+						case CFGSimplification:    passManager->add(llvm::createCFGSimplificationPass());    break;
+						case LICM:                 passManager->add(llvm::createLICMPass());                 break;
+						case AggressiveDCE:        passManager->add(llvm::createAggressiveDCEPass());        break;
+						case GVN:                  passManager->add(llvm::createGVNPass());                  break;
+						case InstructionCombining: passManager->add(llvm::createInstructionCombiningPass()); break;
+						case Reassociate:          passManager->add(llvm::createReassociatePass());          break;
+						case DeadStoreElimination: passManager->add(llvm::createDeadStoreEliminationPass()); break;
+						case SCCP:                 passManager->add(llvm::createSCCPPass());                 break;
+						case ScalarReplAggregates: passManager->add(llvm::createScalarReplAggregatesPass()); break;
+						default:
+							assert(false);
+						}
 					}
+					break;
+				case AggressiveOptimization:
+					passManager->add(llvm::createEarlyCSEPass());
+					passManager->add(llvm::createInstructionCombiningPass());
+					passManager->add(llvm::createCFGSimplificationPass());
+					passManager->add(llvm::createReassociatePass());
+					passManager->add(llvm::createLoopRotatePass());
+					passManager->add(llvm::createLICMPass());
+					passManager->add(llvm::createLoopUnrollPass());
+					passManager->add(llvm::createGVNPass());
+					passManager->add(llvm::createInstructionCombiningPass());
+					passManager->add(llvm::createAggressiveDCEPass());
+					passManager->add(llvm::createCFGSimplificationPass());
+					break;
+				default:
+					assert(false);
 				}
 			}
 
-			passManager->run(*::module);
+			passManager->run(*module);
 		}
 	};
 #else
@@ -569,6 +650,100 @@ namespace rr
 		}
 	};
 
+	// Allocates the sections of a module from the code heap, so that routines share pages
+	// instead of each getting its own. Code runs from the heap's executable view, so the code
+	// sections get loaded at that address. Data sections are accessed through the writable view.
+	class CodeHeapMemoryManager : public llvm::RTDyldMemoryManager
+	{
+	public:
+		~CodeHeapMemoryManager() override
+		{
+			for(const Allocation &allocation : allocations)
+			{
+				deallocateCode(allocation.memory, allocation.bytes);
+			}
+		}
+
+		uint8_t *allocateCodeSection(uintptr_t size, unsigned alignment, unsigned sectionID, llvm::StringRef sectionName) override
+		{
+			return allocate(size, alignment, true);
+		}
+
+		uint8_t *allocateDataSection(uintptr_t size, unsigned alignment, unsigned sectionID, llvm::StringRef sectionName, bool isReadOnly) override
+		{
+			return allocate(size, alignment, false);
+		}
+
+		void notifyObjectLoaded(llvm::RuntimeDyld &dyld, const llvm::object::ObjectFile &object) override
+		{
+			for(const Allocation &allocation : allocations)
+			{
+				if(allocation.code)
+				{
+					dyld.mapSectionAddress(allocation.section, reinterpret_cast<uintptr_t>(getExecutableAddress(allocation.section)));
+				}
+			}
+		}
+
+		bool finalizeMemory(std::string *errorMessage) override
+		{
+			for(const Allocation &allocation : allocations)
+			{
+				if(allocation.code)
+				{
+					markCodeExecutable(allocation.section, allocation.size);
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		struct Allocation
+		{
+			void *memory;
+			size_t bytes;
+			uint8_t *section;
+			size_t size;
+			bool code;
+		};
+
+		uint8_t *allocate(uintptr_t size, unsigned alignment, bool code)
+		{
+			alignment = std::max(alignment, 1u);
+			size_t bytes = size + alignment - 1;
+
+			void *memory = allocateCode(bytes);
+			if(!memory)
+			{
+				return nullptr;
+			}
+
+			uint8_t *section = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(memory) + alignment - 1) & ~uintptr_t(alignment - 1));
+			allocations.push_back({memory, bytes, section, size, code});
+
+			return section;
+		}
+
+		std::vector<Allocation> allocations;
+	};
+
+	// Keeps a copy of the object code compiled on the current thread, which only
+	// references external functions by name, so it can be loaded by another process.
+	class RoutineObjectCache : public llvm::ObjectCache
+	{
+	public:
+		void notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef object) override
+		{
+			::routineObject.code.assign(object.getBufferStart(), object.getBufferEnd());
+		}
+
+		std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *module) override
+		{
+			return nullptr;   // Loading is done by Nucleus::loadRoutine()
+		}
+	};
+
 	class LLVMReactorJIT
 	{
 	private:
@@ -579,10 +754,14 @@ namespace rr
 		ExternalFunctionSymbolResolver externalSymbolResolver;
 		std::shared_ptr<llvm::orc::SymbolResolver> resolver;
 		std::unique_ptr<llvm::TargetMachine> targetMachine;
+		std::unique_ptr<llvm::TargetMachine> baselineTargetMachine;   // Fast instruction selection, for tiered compilation
 		const llvm::DataLayout dataLayout;
+		RoutineObjectCache objectCache;
 		ObjLayer objLayer;
 		CompileLayer compileLayer;
+		CompileLayer baselineCompileLayer;
 		size_t emittedFunctionsNum;
+		std::mutex mutex;   // Routines can be released on any thread, while this JIT is in use by another
 
 	public:
 		LLVMReactorJIT(const char *arch, const llvm::SmallVectorImpl<std::string>& mattrs,
@@ -611,15 +790,22 @@ namespace rr
 				.setMAttrs(mattrs)
 				.setTargetOptions(targetOpts)
 				.selectTarget()),
+			baselineTargetMachine(llvm::EngineBuilder()
+				.setMArch(arch)
+				.setMAttrs(mattrs)
+				.setTargetOptions(targetOpts)
+				.setOptLevel(llvm::CodeGenOpt::None)
+				.selectTarget()),
 			dataLayout(targetMachine->createDataLayout()),
 			objLayer(
 				session,
 				[this](llvm::orc::VModuleKey) {
 					return ObjLayer::Resources{
-						std::make_shared<llvm::SectionMemoryManager>(),
+						std::make_shared<CodeHeapMemoryManager>(),
 						resolver};
 				}),
-			compileLayer(objLayer, llvm::orc::SimpleCompiler(*targetMachine)),
+			compileLayer(objLayer, llvm::orc::SimpleCompiler(*targetMachine, &objectCache)),
+			baselineCompileLayer(objLayer, llvm::orc::SimpleCompiler(*baselineTargetMachine, &objectCache)),
 			emittedFunctionsNum(0)
 		{
 		}
@@ -635,7 +821,7 @@ namespace rr
 			::module = nullptr;
 		}
 
-		LLVMRoutine *acquireRoutine(llvm::Function *func)
+		LLVMRoutine *acquireRoutine(llvm::Function *func, bool baseline, OptimizationProfile profile)
 		{
 			std::string name = "f" + llvm::Twine(emittedFunctionsNum++).str();
 			func->setName(name);
@@ -646,8 +832,19 @@ namespace rr
 			::module = nullptr;
 			mod->setDataLayout(dataLayout);
 
+			// The optimizer thread recompiles baseline routines from their IR, in its own context
+			std::string bitcode;
+
+			if(baseline)
+			{
+				llvm::raw_string_ostream bitcodeStream(bitcode);
+				llvm::WriteBitcodeToFile(*mod, bitcodeStream);
+			}
+
+			std::unique_lock<std::mutex> lock(mutex);
+
 			auto moduleKey = session.allocateVModule();
-			llvm::cantFail(compileLayer.addModule(moduleKey, std::move(mod)));
+			llvm::cantFail((baseline ? baselineCompileLayer : compileLayer).addModule(moduleKey, std::move(mod)));
 
 			std::string mangledName;
 			{
@@ -655,50 +852,179 @@ namespace rr
 				llvm::Mangler::getNameWithPrefix(mangledNameStream, name, dataLayout);
 			}
 
+			::routineObject.entry = mangledName;
+			::routineObject.code.clear();   // Filled in by objectCache when the module gets compiled
+
 			llvm::JITSymbol symbol = compileLayer.findSymbolIn(moduleKey, mangledName, false);
 
 			llvm::Expected<llvm::JITTargetAddress> expectAddr = symbol.getAddress();
 			if(!expectAddr)
 			{
+				::routineObject.code.clear();
 				return nullptr;
 			}
 
 			void *addr = reinterpret_cast<void *>(static_cast<intptr_t>(expectAddr.get()));
+			LLVMRoutine *routine = new LLVMRoutine(addr, releaseRoutineCallback, this, moduleKey);
+
+			if(baseline)
+			{
+				// Unoptimized code shouldn't outlive this process
+				::routineObject.code.clear();
+
+				routine->setBaseline(std::move(bitcode), std::move(mangledName), profile);
+			}
+
+			return routine;
+		}
+
+		// Compiles an optimized version of a baseline routine, from its IR
+		bool recompileRoutine(std::unique_ptr<llvm::Module> mod, const std::string &symbol, OptimizationProfile profile, void *&entry, uint64_t &key)
+		{
+			mod->setDataLayout(dataLayout);
+			optimize(mod.get(), profile);
+
+			std::unique_lock<std::mutex> lock(mutex);
+
+			auto moduleKey = session.allocateVModule();
+			llvm::cantFail(compileLayer.addModule(moduleKey, std::move(mod)));
+
+			llvm::JITSymbol symbolAddress = compileLayer.findSymbolIn(moduleKey, symbol, false);
+			void *addr = nullptr;
+
+			if(symbolAddress)
+			{
+				llvm::Expected<llvm::JITTargetAddress> expectAddr = symbolAddress.getAddress();
+
+				if(expectAddr)
+				{
+					addr = reinterpret_cast<void *>(static_cast<intptr_t>(expectAddr.get()));
+				}
+				else
+				{
+					llvm::consumeError(expectAddr.takeError());
+				}
+			}
+			else
+			{
+				llvm::consumeError(symbolAddress.takeError());
+			}
+
+			if(!addr)
+			{
+				llvm::cantFail(compileLayer.removeModule(moduleKey));
+				return false;
+			}
+
+			entry = addr;
+			key = moduleKey;
+
+			return true;
+		}
+
+		LLVMRoutine *loadRoutine(const RoutineObject &object)
+		{
+			llvm::StringRef code(reinterpret_cast<const char*>(object.code.data()), object.code.size());
+
+			std::unique_lock<std::mutex> lock(mutex);
+
+			auto moduleKey = session.allocateVModule();
+
+			if(llvm::Error error = objLayer.addObject(moduleKey, llvm::MemoryBuffer::getMemBufferCopy(code)))
+			{
+				llvm::consumeError(std::move(error));
+				return nullptr;
+			}
+
+			llvm::JITSymbol symbol = objLayer.findSymbolIn(moduleKey, object.entry, false);
+			void *addr = nullptr;
+
+			if(symbol)
+			{
+				llvm::Expected<llvm::JITTargetAddress> expectAddr = symbol.getAddress();
+
+				if(expectAddr)
+				{
+					addr = reinterpret_cast<void *>(static_cast<intptr_t>(expectAddr.get()));
+				}
+				else
+				{
+					llvm::consumeError(expectAddr.takeError());
+				}
+			}
+			else
+			{
+				llvm::consumeError(symbol.takeError());
+			}
+
+			if(!addr)
+			{
+				llvm::cantFail(objLayer.removeObject(moduleKey));
+				return nullptr;
+			}
+
 			return new LLVMRoutine(addr, releaseRoutineCallback, this, moduleKey);
 		}
 
-		void optimize(llvm::Module *module)
+		void optimize(llvm::Module *module, OptimizationProfile profile)
 		{
 			std::unique_ptr<llvm::legacy::PassManager> passManager(
 				new llvm::legacy::PassManager());
 
+			// Lets the loop and vectorization passes use the target's costs
+			passManager->add(llvm::createTargetTransformInfoWrapperPass(targetMachine->getTargetIRAnalysis()));
 			passManager->add(llvm::createSROAPass());
 
-			for(int pass = 0; pass < 10 && optimization[pass] != Disabled; pass++)
+			switch(profile)
 			{
-				switch(optimization[pass])
+			case NoOptimization:
+			case MinimalOptimization:
+				break;
+			case DefaultOptimization:
+				for(int pass = 0; pass < 10 && optimization[pass] != Disabled; pass++)
 				{
-				case Disabled:                                                                       break;
-				case CFGSimplification:    passManager->add(llvm::createCFGSimplificationPass());    break;
-				case LICM:                 passManager->add(llvm::createLICMPass());                 break;
-				case AggressiveDCE:        passManager->add(llvm::createAggressiveDCEPass());        break;
-				case GVN:                  passManager->add(llvm::createGVNPass());                  break;
-				case InstructionCombining: passManager->add(llvm::createInstructionCombiningPass()); break;
-				case Reassociate:          passManager->add(llvm::createReassociatePass());          break;
-				case DeadStoreElimination: passManager->add(llvm::createDeadStoreEliminationPass()); break;
-				case SCCP:                 passManager->add(llvm::createSCCPPass());                 break;
-				case ScalarReplAggregates: passManager->add(llvm::createSROAPass());                 break;
-				default:
-				                           assert(false);
+					switch(optimization[pass])
+					{
+					case Disabled:                                                                       break;
+					case CFGSimplification:    passManager->add(llvm::createCFGSimplificationPass());    break;
+					case LICM:                 passManager->add(llvm::createLICMPass());                 break;
+					case AggressiveDCE:        passManager->add(llvm::createAggressiveDCEPass());        break;
+					case GVN:                  passManager->add(llvm::createGVNPass());                  break;
+					case InstructionCombining: passManager->add(llvm::createInstructionCombiningPass()); break;
+					case Reassociate:          passManager->add(llvm::createReassociatePass());          break;
+					case DeadStoreElimination: passManager->add(llvm::createDeadStoreEliminationPass()); break;
+					case SCCP:                 passManager->add(llvm::createSCCPPass());                 break;
+					case ScalarReplAggregates: passManager->add(llvm::createSROAPass());                 break;
+					default:
+					                           assert(false);
+					}
 				}
+				break;
+			case AggressiveOptimization:
+				passManager->add(llvm::createEarlyCSEPass());
+				passManager->add(llvm::createInstructionCombiningPass());
+				passManager->add(llvm::createCFGSimplificationPass());
+				passManager->add(llvm::createReassociatePass());
+				passManager->add(llvm::createLoopRotatePass());
+				passManager->add(llvm::createLICMPass());
+				passManager->add(llvm::createLoopUnrollPass(3));
+				passManager->add(llvm::createGVNPass());
+				passManager->add(llvm::createSLPVectorizerPass());
+				passManager->add(llvm::createInstructionCombiningPass());
+				passManager->add(llvm::createAggressiveDCEPass());
+				passManager->add(llvm::createCFGSimplificationPass());
+				break;
+			default:
+				assert(false);
 			}
 
-			passManager->run(*::module);
+			passManager->run(*module);
 		}
 
 	private:
 		void releaseRoutineModule(llvm::orc::VModuleKey moduleKey)
 		{
+			std::unique_lock<std::mutex> lock(mutex);
 			llvm::cantFail(compileLayer.removeModule(moduleKey));
 		}
 
@@ -710,6 +1036,7 @@ namespace rr
 #endif
 
 	Optimization optimization[10] = {InstructionCombining, Disabled};
+	bool tieredCompilation = false;
 
 	// The abstract Type* types are implemented as LLVM types, except that
 	// 64-bit vectors are emulated using 128-bit ones to avoid use of MMX in x86
@@ -861,22 +1188,8 @@ namespace rr
 		}
 	}
 
-	Nucleus::Nucleus()
+	static CodegenState createCodegenState()
 	{
-		::codegenMutex.lock();   // Reactor and LLVM are currently not thread safe
-
-		llvm::InitializeNativeTarget();
-
-#if REACTOR_LLVM_VERSION >= 7
-		llvm::InitializeNativeTargetAsmPrinter();
-		llvm::InitializeNativeTargetAsmParser();
-#endif
-
-		if(!::context)
-		{
-			::context = new llvm::LLVMContext();
-		}
-
 		#if defined(__x86_64__)
 			static const char arch[] = "x86-64";
 		#elif defined(__i386__)
@@ -907,6 +1220,10 @@ namespace rr
 		mattrs.push_back(CPUID::supportsSSE4_1() ? "+sse41"  : "-sse41");
 #else
 		mattrs.push_back(CPUID::supportsSSE4_1() ? "+sse4.1" : "-sse4.1");
+		// VEX/EVEX encodings, and the 256- and 512-bit registers used by the 8- and 16-wide vector types.
+		mattrs.push_back(CPUID::supportsAVX()     ? "+avx"     : "-avx");
+		mattrs.push_back(CPUID::supportsAVX2()    ? "+avx2"    : "-avx2");
+		mattrs.push_back(CPUID::supportsAVX512F() ? "+avx512f" : "-avx512f");
 #endif
 #elif defined(__arm__)
 #if __ARM_ARCH >= 8
@@ -929,85 +1246,287 @@ namespace rr
 		// targetOpts.NoNaNsFPMath = true;
 #endif
 
-		if(!::reactorJIT)
-		{
+		CodegenState state;
+		state.context = new llvm::LLVMContext();
+		state.builder = new llvm::IRBuilder<>(*state.context);
 #if REACTOR_LLVM_VERSION < 7
-			::reactorJIT = new LLVMReactorJIT(arch, mattrs);
+		state.reactorJIT = new LLVMReactorJIT(arch, mattrs);
 #else
-			::reactorJIT = new LLVMReactorJIT(arch, mattrs, targetOpts);
+		state.reactorJIT = new LLVMReactorJIT(arch, mattrs, targetOpts);
 #endif
-		}
 
-		::reactorJIT->startSession();
+		return state;
+	}
+
+	static CodegenState acquireCodegenState()
+	{
+		CodegenState state = {};
+
+		{
+			std::unique_lock<std::mutex> lock(::codegenPoolMutex);
+
+			if(!::codegenPool.empty())
+			{
+				state = ::codegenPool.back();
+				::codegenPool.pop_back();
+			}
+		}
 
-		if(!::builder)
+		if(!state.reactorJIT)
 		{
-			::builder = new llvm::IRBuilder<>(*::context);
+			std::call_once(::llvmInitialized, []()
+			{
+				llvm::InitializeNativeTarget();
+
+#if REACTOR_LLVM_VERSION >= 7
+				llvm::InitializeNativeTargetAsmPrinter();
+				llvm::InitializeNativeTargetAsmParser();
+#endif
+			});
+
+			state = createCodegenState();
 		}
+
+		return state;
 	}
 
-	Nucleus::~Nucleus()
+	static void releaseCodegenState(const CodegenState &state)
 	{
-		::reactorJIT->endSession();
-
-		::codegenMutex.unlock();
+		std::unique_lock<std::mutex> lock(::codegenPoolMutex);
+		::codegenPool.push_back(state);
 	}
 
-	Routine *Nucleus::acquireRoutine(const char *name, bool runOptimizations)
+#if REACTOR_LLVM_VERSION >= 7
+	// Recompiles hot baseline routines with optimizations, one at a time on a background
+	// thread, so that rendering keeps running the baseline code in the meantime.
+	class RoutineOptimizer
 	{
-		if(::builder->GetInsertBlock()->empty() || !::builder->GetInsertBlock()->back().isTerminator())
+	public:
+		~RoutineOptimizer()
 		{
-			llvm::Type *type = ::function->getReturnType();
-
-			if(type->isVoidTy())
 			{
-				createRetVoid();
+				std::unique_lock<std::mutex> lock(mutex);
+				terminate = true;
 			}
-			else
+
+			condition.notify_one();
+
+			if(thread.joinable())
 			{
-				createRet(V(llvm::UndefValue::get(type)));
+				thread.join();
 			}
 		}
 
-		if(false)
+		void schedule(LLVMRoutine *routine)
 		{
-			#if REACTOR_LLVM_VERSION < 7
-				std::string error;
-				llvm::raw_fd_ostream file((std::string(name) + "-llvm-dump-unopt.txt").c_str(), error);
-			#else
-				std::error_code error;
-				llvm::raw_fd_ostream file(std::string(name) + "-llvm-dump-unopt.txt", error);
-			#endif
+			routine->bind();   // Released once recompiled
 
-			::module->print(file, 0);
-		}
+			{
+				std::unique_lock<std::mutex> lock(mutex);
 
-		if(runOptimizations)
-		{
-			optimize();
-		}
+				if(!thread.joinable())
+				{
+					thread = std::thread([this]() { run(); });
+				}
 
-		if(false)
-		{
-			#if REACTOR_LLVM_VERSION < 7
-				std::string error;
-				llvm::raw_fd_ostream file((std::string(name) + "-llvm-dump-opt.txt").c_str(), error);
-			#else
-				std::error_code error;
-				llvm::raw_fd_ostream file(std::string(name) + "-llvm-dump-opt.txt", error);
-			#endif
+				queue.push_back(routine);
+			}
 
-			::module->print(file, 0);
+			condition.notify_one();
 		}
 
-		LLVMRoutine *routine = ::reactorJIT->acquireRoutine(::function);
+	private:
+		void run()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
 
-		return routine;
-	}
+			while(true)
+			{
+				condition.wait(lock, [this]() { return terminate || !queue.empty(); });
 
-	void Nucleus::optimize()
+				if(terminate)
+				{
+					break;
+				}
+
+				LLVMRoutine *routine = queue.front();
+				queue.pop_front();
+
+				lock.unlock();
+				recompile(routine);
+				routine->unbind();
+				lock.lock();
+			}
+		}
+
+		static void recompile(LLVMRoutine *routine)
+		{
+			CodegenState state = acquireCodegenState();
+
+			llvm::MemoryBufferRef bitcode(routine->getBitcode(), "");
+			llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(bitcode, *state.context);
+
+			if(module)
+			{
+				void *entry = nullptr;
+				uint64_t key = 0;
+
+				if(state.reactorJIT->recompileRoutine(std::move(module.get()), routine->getSymbol(), routine->getProfile(), entry, key))
+				{
+					routine->setOptimized(entry, state.reactorJIT, key);
+				}
+			}
+			else
+			{
+				llvm::consumeError(module.takeError());
+			}
+
+			routine->releaseBitcode();
+			releaseCodegenState(state);
+		}
+
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<LLVMRoutine*> queue;
+		bool terminate = false;
+	};
+
+	static RoutineOptimizer routineOptimizer;
+
+	void scheduleOptimization(LLVMRoutine *routine)
+	{
+		routineOptimizer.schedule(routine);
+	}
+#endif
+
+	Nucleus::Nucleus()
+	{
+#if REACTOR_LLVM_VERSION < 7
+		::codegenMutex.lock();
+#endif
+
+		CodegenState state = acquireCodegenState();
+
+		assert(!::reactorJIT);   // Only one Nucleus can be active per thread
+
+		::reactorJIT = state.reactorJIT;
+		::builder = state.builder;
+		::context = state.context;
+
+		::reactorJIT->startSession();
+	}
+
+	Nucleus::~Nucleus()
+	{
+		::reactorJIT->endSession();
+
+		releaseCodegenState({::reactorJIT, ::builder, ::context});
+
+		::reactorJIT = nullptr;
+		::builder = nullptr;
+		::context = nullptr;
+
+#if REACTOR_LLVM_VERSION < 7
+		::codegenMutex.unlock();
+#endif
+	}
+
+	Routine *Nucleus::acquireRoutine(const char *name, OptimizationProfile profile)
+	{
+		if(::builder->GetInsertBlock()->empty() || !::builder->GetInsertBlock()->back().isTerminator())
+		{
+			llvm::Type *type = ::function->getReturnType();
+
+			if(type->isVoidTy())
+			{
+				createRetVoid();
+			}
+			else
+			{
+				createRet(V(llvm::UndefValue::get(type)));
+			}
+		}
+
+		if(false)
+		{
+			#if REACTOR_LLVM_VERSION < 7
+				std::string error;
+				llvm::raw_fd_ostream file((std::string(name) + "-llvm-dump-unopt.txt").c_str(), error);
+			#else
+				std::error_code error;
+				llvm::raw_fd_ostream file(std::string(name) + "-llvm-dump-unopt.txt", error);
+			#endif
+
+			::module->print(file, 0);
+		}
+
+#if REACTOR_LLVM_VERSION < 7
+		const bool baseline = false;
+#else
+		// Tiered compilation only optimizes the routines which turn out to be hot
+		const bool baseline = (profile >= DefaultOptimization) && tieredCompilation;
+#endif
+
+		if(profile != NoOptimization && !baseline)
+		{
+			optimize(profile);
+		}
+
+		if(false)
+		{
+			#if REACTOR_LLVM_VERSION < 7
+				std::string error;
+				llvm::raw_fd_ostream file((std::string(name) + "-llvm-dump-opt.txt").c_str(), error);
+			#else
+				std::error_code error;
+				llvm::raw_fd_ostream file(std::string(name) + "-llvm-dump-opt.txt", error);
+			#endif
+
+			::module->print(file, 0);
+		}
+
+#if REACTOR_LLVM_VERSION < 7
+		LLVMRoutine *routine = ::reactorJIT->acquireRoutine(::function);
+#else
+		LLVMRoutine *routine = ::reactorJIT->acquireRoutine(::function, baseline, profile);
+#endif
+
+		return routine;
+	}
+
+	bool Nucleus::getRoutineObject(RoutineObject &object)
+	{
+#if REACTOR_LLVM_VERSION < 7
+		return false;   // The legacy JIT emits code directly into executable memory
+#else
+		if(::routineObject.code.empty())
+		{
+			return false;
+		}
+
+		object = ::routineObject;
+
+		return true;
+#endif
+	}
+
+	Routine *Nucleus::loadRoutine(const RoutineObject &object)
+	{
+#if REACTOR_LLVM_VERSION < 7
+		return nullptr;
+#else
+		CodegenState state = acquireCodegenState();
+		Routine *routine = state.reactorJIT->loadRoutine(object);
+		releaseCodegenState(state);
+
+		return routine;
+#endif
+	}
+
+	void Nucleus::optimize(OptimizationProfile profile)
 	{
-		::reactorJIT->optimize(::module);
+		::reactorJIT->optimize(::module, profile);
 	}
 
 	Value *Nucleus::allocateStackVariable(Type *type, int arraySize)
@@ -1646,8 +2165,8 @@ namespace rr
 		assert(llvm::isa<llvm::VectorType>(T(type)));
 		const int numConstants = elementCount(type);                                       // Number of provided constants for the (emulated) type.
 		const int numElements = llvm::cast<llvm::VectorType>(T(type))->getNumElements();   // Number of elements of the underlying vector type.
-		assert(numElements <= 8 && numConstants <= numElements);
-		llvm::Constant *constantVector[8];
+		assert(numElements <= 16 && numConstants <= numElements);
+		llvm::Constant *constantVector[16];
 
 		for(int i = 0; i < numElements; i++)
 		{
@@ -3051,6 +3570,1660 @@ namespace rr
 		return T(llvm::VectorType::get(T(Float::getType()), 4));
 	}
 
+#if REACTOR_LLVM_VERSION >= 7
+	Float4::Float4(RValue<Float8> cast) : XYZW(this)
+	{
+		storeValue(V(lowerLowHalf(V(cast.value))));
+	}
+
+	Int8::Int8(RValue<Float8> cast)
+	{
+		Value *vector = Nucleus::createFPToSI(cast.value, Int8::getType());
+
+		storeValue(vector);
+	}
+
+	Int8::Int8()
+	{
+	}
+
+	Int8::Int8(int replicate)
+	{
+		storeValue(V(::builder->CreateVectorSplat(8, V(Nucleus::createConstantInt(replicate)))));
+	}
+
+	Int8::Int8(RValue<Int8> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	Int8::Int8(const Int8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int8::Int8(const Reference<Int8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int8::Int8(RValue<UInt8> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	Int8::Int8(const UInt8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int8::Int8(const Reference<UInt8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int8::Int8(RValue<Int4> lo, RValue<Int4> hi)
+	{
+		storeValue(V(lowerConcat(V(lo.value), V(hi.value))));
+	}
+
+	Int8::Int8(RValue<Int> rhs)
+	{
+		storeValue(V(::builder->CreateVectorSplat(8, V(rhs.value))));
+	}
+
+	Int8::Int8(const Int &rhs)
+	{
+		*this = RValue<Int>(rhs.loadValue());
+	}
+
+	Int8::Int8(const Reference<Int> &rhs)
+	{
+		*this = RValue<Int>(rhs.loadValue());
+	}
+
+	RValue<Int8> Int8::operator=(RValue<Int8> rhs)
+	{
+		storeValue(rhs.value);
+
+		return rhs;
+	}
+
+	RValue<Int8> Int8::operator=(const Int8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Int8>(value);
+	}
+
+	RValue<Int8> Int8::operator=(const Reference<Int8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Int8>(value);
+	}
+
+	RValue<Int8> operator+(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createAdd(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator-(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createSub(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator*(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createMul(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator/(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createSDiv(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator%(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createSRem(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator&(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createAnd(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator|(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createOr(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator^(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createXor(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator<<(RValue<Int8> lhs, unsigned char rhs)
+	{
+		return lhs << Int8(rhs);
+	}
+
+	RValue<Int8> operator>>(RValue<Int8> lhs, unsigned char rhs)
+	{
+		return lhs >> Int8(rhs);
+	}
+
+	RValue<Int8> operator<<(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createShl(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator>>(RValue<Int8> lhs, RValue<Int8> rhs)
+	{
+		return RValue<Int8>(Nucleus::createAShr(lhs.value, rhs.value));
+	}
+
+	RValue<Int8> operator+=(Int8 &lhs, RValue<Int8> rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+
+	RValue<Int8> operator-=(Int8 &lhs, RValue<Int8> rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+
+	RValue<Int8> operator*=(Int8 &lhs, RValue<Int8> rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+
+	RValue<Int8> operator&=(Int8 &lhs, RValue<Int8> rhs)
+	{
+		return lhs = lhs & rhs;
+	}
+
+	RValue<Int8> operator|=(Int8 &lhs, RValue<Int8> rhs)
+	{
+		return lhs = lhs | rhs;
+	}
+
+	RValue<Int8> operator^=(Int8 &lhs, RValue<Int8> rhs)
+	{
+		return lhs = lhs ^ rhs;
+	}
+
+	RValue<Int8> operator<<=(Int8 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs << rhs;
+	}
+
+	RValue<Int8> operator>>=(Int8 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs >> rhs;
+	}
+
+	RValue<Int8> operator+(RValue<Int8> val)
+	{
+		return val;
+	}
+
+	RValue<Int8> operator-(RValue<Int8> val)
+	{
+		return RValue<Int8>(Nucleus::createNeg(val.value));
+	}
+
+	RValue<Int8> operator~(RValue<Int8> val)
+	{
+		return RValue<Int8>(Nucleus::createNot(val.value));
+	}
+
+	RValue<Int8> CmpEQ(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createICmpEQ(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpLT(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createICmpSLT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpLE(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createICmpSLE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpNEQ(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createICmpNE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpNLT(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createICmpSGE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpNLE(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createICmpSGT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> Max(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_SGT)));
+	}
+
+	RValue<Int8> Min(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_SLT)));
+	}
+
+	RValue<Int8> RoundInt(RValue<Float8> cast)
+	{
+		return RValue<Int8>(V(lowerRoundInt(V(cast.value), T(Int8::getType()))));
+	}
+
+	RValue<Int> Extract(RValue<Int8> x, int i)
+	{
+		return RValue<Int>(Nucleus::createExtractElement(x.value, Int::getType(), i));
+	}
+
+	RValue<Int8> Insert(RValue<Int8> x, RValue<Int> element, int i)
+	{
+		return RValue<Int8>(Nucleus::createInsertElement(x.value, element.value, i));
+	}
+
+	RValue<Int> SignMask(RValue<Int8> x)
+	{
+		return RValue<Int>(V(lowerVectorSignMask(V(x.value), T(Int::getType()))));
+	}
+
+	RValue<Int8> Abs(RValue<Int8> x)
+	{
+		auto negative = x >> 31;
+		return (x ^ negative) - negative;
+	}
+
+	RValue<Int8> MulHigh(RValue<Int8> x, RValue<Int8> y)
+	{
+		return RValue<Int8>(V(lowerMulHigh(V(x.value), V(y.value), true)));
+	}
+
+	Type *Int8::getType()
+	{
+		return T(llvm::VectorType::get(T(Int::getType()), 8));
+	}
+
+	UInt8::UInt8(RValue<Float8> cast)
+	{
+		// Note: createFPToUI is broken, must perform conversion using createFPtoSI
+
+		// Smallest positive value representable in UInt, but not in Int
+		const unsigned int ustart = 0x80000000u;
+		const float ustartf = float(ustart);
+
+		// Check if the value can be represented as an Int
+		Int8 uiValue = CmpNLT(cast, Float8(ustartf));
+		// If the value is too large, subtract ustart and re-add it after conversion.
+		uiValue = (uiValue & As<Int8>(As<UInt8>(Int8(cast - Float8(ustartf))) + UInt8(ustart))) |
+		// Otherwise, just convert normally
+		          (~uiValue & Int8(cast));
+		// If the value is negative, store 0, otherwise store the result of the conversion
+		storeValue((~(As<Int8>(cast) >> 31) & uiValue).value);
+	}
+
+	UInt8::UInt8()
+	{
+	}
+
+	UInt8::UInt8(int replicate)
+	{
+		storeValue(V(::builder->CreateVectorSplat(8, V(Nucleus::createConstantInt(replicate)))));
+	}
+
+	UInt8::UInt8(RValue<UInt8> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	UInt8::UInt8(const UInt8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt8::UInt8(const Reference<UInt8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt8::UInt8(RValue<Int8> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	UInt8::UInt8(const Int8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt8::UInt8(const Reference<Int8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt8::UInt8(RValue<UInt4> lo, RValue<UInt4> hi)
+	{
+		storeValue(V(lowerConcat(V(lo.value), V(hi.value))));
+	}
+
+	RValue<UInt8> UInt8::operator=(RValue<UInt8> rhs)
+	{
+		storeValue(rhs.value);
+
+		return rhs;
+	}
+
+	RValue<UInt8> UInt8::operator=(const UInt8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<UInt8>(value);
+	}
+
+	RValue<UInt8> UInt8::operator=(const Reference<UInt8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<UInt8>(value);
+	}
+
+	RValue<UInt8> operator+(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createAdd(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator-(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createSub(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator*(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createMul(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator/(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createUDiv(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator%(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createURem(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator&(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createAnd(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator|(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createOr(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator^(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createXor(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator<<(RValue<UInt8> lhs, unsigned char rhs)
+	{
+		return lhs << UInt8(rhs);
+	}
+
+	RValue<UInt8> operator>>(RValue<UInt8> lhs, unsigned char rhs)
+	{
+		return lhs >> UInt8(rhs);
+	}
+
+	RValue<UInt8> operator<<(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createShl(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator>>(RValue<UInt8> lhs, RValue<UInt8> rhs)
+	{
+		return RValue<UInt8>(Nucleus::createLShr(lhs.value, rhs.value));
+	}
+
+	RValue<UInt8> operator+=(UInt8 &lhs, RValue<UInt8> rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+
+	RValue<UInt8> operator-=(UInt8 &lhs, RValue<UInt8> rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+
+	RValue<UInt8> operator*=(UInt8 &lhs, RValue<UInt8> rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+
+	RValue<UInt8> operator&=(UInt8 &lhs, RValue<UInt8> rhs)
+	{
+		return lhs = lhs & rhs;
+	}
+
+	RValue<UInt8> operator|=(UInt8 &lhs, RValue<UInt8> rhs)
+	{
+		return lhs = lhs | rhs;
+	}
+
+	RValue<UInt8> operator^=(UInt8 &lhs, RValue<UInt8> rhs)
+	{
+		return lhs = lhs ^ rhs;
+	}
+
+	RValue<UInt8> operator<<=(UInt8 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs << rhs;
+	}
+
+	RValue<UInt8> operator>>=(UInt8 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs >> rhs;
+	}
+
+	RValue<UInt8> operator+(RValue<UInt8> val)
+	{
+		return val;
+	}
+
+	RValue<UInt8> operator-(RValue<UInt8> val)
+	{
+		return RValue<UInt8>(Nucleus::createNeg(val.value));
+	}
+
+	RValue<UInt8> operator~(RValue<UInt8> val)
+	{
+		return RValue<UInt8>(Nucleus::createNot(val.value));
+	}
+
+	RValue<UInt8> CmpEQ(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(Nucleus::createSExt(Nucleus::createICmpEQ(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<UInt8> CmpLT(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(Nucleus::createSExt(Nucleus::createICmpULT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<UInt8> CmpLE(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(Nucleus::createSExt(Nucleus::createICmpULE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<UInt8> CmpNEQ(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(Nucleus::createSExt(Nucleus::createICmpNE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<UInt8> CmpNLT(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(Nucleus::createSExt(Nucleus::createICmpUGE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<UInt8> CmpNLE(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(Nucleus::createSExt(Nucleus::createICmpUGT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<UInt8> Max(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_UGT)));
+	}
+
+	RValue<UInt8> Min(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_ULT)));
+	}
+
+	RValue<UInt8> MulHigh(RValue<UInt8> x, RValue<UInt8> y)
+	{
+		return RValue<UInt8>(V(lowerMulHigh(V(x.value), V(y.value), false)));
+	}
+
+	Type *UInt8::getType()
+	{
+		return T(llvm::VectorType::get(T(UInt::getType()), 8));
+	}
+
+	Float8::Float8(RValue<Int8> cast)
+	{
+		Value *vector = Nucleus::createSIToFP(cast.value, Float8::getType());
+
+		storeValue(vector);
+	}
+
+	Float8::Float8(RValue<UInt8> cast)
+	{
+		RValue<Float8> result = Float8(Int8(cast & UInt8(0x7FFFFFFF))) +
+		                        As<Float8>((As<Int8>(cast) >> 31) & As<Int8>(Float8(0x80000000u)));
+
+		storeValue(result.value);
+	}
+
+	Float8::Float8(RValue<Float16> cast)
+	{
+		storeValue(V(lowerLowHalf(V(cast.value))));
+	}
+
+	Float8::Float8()
+	{
+	}
+
+	Float8::Float8(float replicate)
+	{
+		storeValue(V(::builder->CreateVectorSplat(8, V(Nucleus::createConstantFloat(replicate)))));
+	}
+
+	Float8::Float8(RValue<Float8> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	Float8::Float8(const Float8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Float8::Float8(const Reference<Float8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Float8::Float8(RValue<Float4> lo, RValue<Float4> hi)
+	{
+		storeValue(V(lowerConcat(V(lo.value), V(hi.value))));
+	}
+
+	Float8::Float8(RValue<Float> rhs)
+	{
+		storeValue(V(::builder->CreateVectorSplat(8, V(rhs.value))));
+	}
+
+	Float8::Float8(const Float &rhs)
+	{
+		*this = RValue<Float>(rhs.loadValue());
+	}
+
+	Float8::Float8(const Reference<Float> &rhs)
+	{
+		*this = RValue<Float>(rhs.loadValue());
+	}
+
+	RValue<Float8> Float8::operator=(RValue<Float8> rhs)
+	{
+		storeValue(rhs.value);
+
+		return rhs;
+	}
+
+	RValue<Float8> Float8::operator=(const Float8 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Float8>(value);
+	}
+
+	RValue<Float8> Float8::operator=(const Reference<Float8> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Float8>(value);
+	}
+
+	RValue<Float8> operator+(RValue<Float8> lhs, RValue<Float8> rhs)
+	{
+		return RValue<Float8>(Nucleus::createFAdd(lhs.value, rhs.value));
+	}
+
+	RValue<Float8> operator-(RValue<Float8> lhs, RValue<Float8> rhs)
+	{
+		return RValue<Float8>(Nucleus::createFSub(lhs.value, rhs.value));
+	}
+
+	RValue<Float8> operator*(RValue<Float8> lhs, RValue<Float8> rhs)
+	{
+		return RValue<Float8>(Nucleus::createFMul(lhs.value, rhs.value));
+	}
+
+	RValue<Float8> operator/(RValue<Float8> lhs, RValue<Float8> rhs)
+	{
+		return RValue<Float8>(Nucleus::createFDiv(lhs.value, rhs.value));
+	}
+
+	RValue<Float8> operator%(RValue<Float8> lhs, RValue<Float8> rhs)
+	{
+		return RValue<Float8>(Nucleus::createFRem(lhs.value, rhs.value));
+	}
+
+	RValue<Float8> operator+=(Float8 &lhs, RValue<Float8> rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+
+	RValue<Float8> operator-=(Float8 &lhs, RValue<Float8> rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+
+	RValue<Float8> operator*=(Float8 &lhs, RValue<Float8> rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+
+	RValue<Float8> operator/=(Float8 &lhs, RValue<Float8> rhs)
+	{
+		return lhs = lhs / rhs;
+	}
+
+	RValue<Float8> operator%=(Float8 &lhs, RValue<Float8> rhs)
+	{
+		return lhs = lhs % rhs;
+	}
+
+	RValue<Float8> operator+(RValue<Float8> val)
+	{
+		return val;
+	}
+
+	RValue<Float8> operator-(RValue<Float8> val)
+	{
+		return RValue<Float8>(Nucleus::createFNeg(val.value));
+	}
+
+	RValue<Float8> Abs(RValue<Float8> x)
+	{
+		return As<Float8>(As<Int8>(x) & Int8(0x7FFFFFFF));
+	}
+
+	RValue<Float8> Max(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Float8>(V(lowerPFMINMAX(V(x.value), V(y.value), llvm::FCmpInst::FCMP_OGT)));
+	}
+
+	RValue<Float8> Min(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Float8>(V(lowerPFMINMAX(V(x.value), V(y.value), llvm::FCmpInst::FCMP_OLT)));
+	}
+
+	RValue<Float8> Sqrt(RValue<Float8> x)
+	{
+		return RValue<Float8>(V(lowerSQRT(V(x.value))));
+	}
+
+	RValue<Float8> Insert(RValue<Float8> x, RValue<Float> element, int i)
+	{
+		return RValue<Float8>(Nucleus::createInsertElement(x.value, element.value, i));
+	}
+
+	RValue<Float> Extract(RValue<Float8> x, int i)
+	{
+		return RValue<Float>(Nucleus::createExtractElement(x.value, Float::getType(), i));
+	}
+
+	RValue<Int> SignMask(RValue<Float8> x)
+	{
+		return SignMask(As<Int8>(x));
+	}
+
+	RValue<Int8> CmpEQ(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpOEQ(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpLT(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpOLT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpLE(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpOLE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpNEQ(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpONE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpNLT(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpOGE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpNLE(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpOGT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpUEQ(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpUEQ(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpULT(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpULT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpULE(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpULE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpUNEQ(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpUNE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpUNLT(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpUGE(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> CmpUNLE(RValue<Float8> x, RValue<Float8> y)
+	{
+		return RValue<Int8>(Nucleus::createSExt(Nucleus::createFCmpUGT(x.value, y.value), Int8::getType()));
+	}
+
+	RValue<Int8> IsInf(RValue<Float8> x)
+	{
+		return CmpEQ(As<Int8>(x) & Int8(0x7FFFFFFF), Int8(0x7F800000));
+	}
+
+	RValue<Int8> IsNan(RValue<Float8> x)
+	{
+		return ~CmpEQ(x, x);
+	}
+
+	RValue<Float8> Round(RValue<Float8> x)
+	{
+		return RValue<Float8>(V(lowerRound(V(x.value))));
+	}
+
+	RValue<Float8> Trunc(RValue<Float8> x)
+	{
+		return RValue<Float8>(V(lowerTrunc(V(x.value))));
+	}
+
+	RValue<Float8> Frac(RValue<Float8> x)
+	{
+		Float8 frc = x - Floor(x);
+
+		// x - floor(x) can be 1.0 for very small negative x.
+		// Clamp against the value just below 1.0.
+		return Min(frc, As<Float8>(Int8(0x3F7FFFFF)));
+	}
+
+	RValue<Float8> Floor(RValue<Float8> x)
+	{
+		return RValue<Float8>(V(lowerFloor(V(x.value))));
+	}
+
+	RValue<Float8> Ceil(RValue<Float8> x)
+	{
+		return -Floor(-x);
+	}
+
+	Type *Float8::getType()
+	{
+		return T(llvm::VectorType::get(T(Float::getType()), 8));
+	}
+
+	Int16::Int16(RValue<Float16> cast)
+	{
+		Value *vector = Nucleus::createFPToSI(cast.value, Int16::getType());
+
+		storeValue(vector);
+	}
+
+	Int16::Int16()
+	{
+	}
+
+	Int16::Int16(int replicate)
+	{
+		storeValue(V(::builder->CreateVectorSplat(16, V(Nucleus::createConstantInt(replicate)))));
+	}
+
+	Int16::Int16(RValue<Int16> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	Int16::Int16(const Int16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int16::Int16(const Reference<Int16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int16::Int16(RValue<UInt16> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	Int16::Int16(const UInt16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int16::Int16(const Reference<UInt16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Int16::Int16(RValue<Int8> lo, RValue<Int8> hi)
+	{
+		storeValue(V(lowerConcat(V(lo.value), V(hi.value))));
+	}
+
+	Int16::Int16(RValue<Int> rhs)
+	{
+		storeValue(V(::builder->CreateVectorSplat(16, V(rhs.value))));
+	}
+
+	Int16::Int16(const Int &rhs)
+	{
+		*this = RValue<Int>(rhs.loadValue());
+	}
+
+	Int16::Int16(const Reference<Int> &rhs)
+	{
+		*this = RValue<Int>(rhs.loadValue());
+	}
+
+	RValue<Int16> Int16::operator=(RValue<Int16> rhs)
+	{
+		storeValue(rhs.value);
+
+		return rhs;
+	}
+
+	RValue<Int16> Int16::operator=(const Int16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Int16>(value);
+	}
+
+	RValue<Int16> Int16::operator=(const Reference<Int16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Int16>(value);
+	}
+
+	RValue<Int16> operator+(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createAdd(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator-(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createSub(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator*(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createMul(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator/(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createSDiv(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator%(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createSRem(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator&(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createAnd(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator|(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createOr(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator^(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createXor(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator<<(RValue<Int16> lhs, unsigned char rhs)
+	{
+		return lhs << Int16(rhs);
+	}
+
+	RValue<Int16> operator>>(RValue<Int16> lhs, unsigned char rhs)
+	{
+		return lhs >> Int16(rhs);
+	}
+
+	RValue<Int16> operator<<(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createShl(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator>>(RValue<Int16> lhs, RValue<Int16> rhs)
+	{
+		return RValue<Int16>(Nucleus::createAShr(lhs.value, rhs.value));
+	}
+
+	RValue<Int16> operator+=(Int16 &lhs, RValue<Int16> rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+
+	RValue<Int16> operator-=(Int16 &lhs, RValue<Int16> rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+
+	RValue<Int16> operator*=(Int16 &lhs, RValue<Int16> rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+
+	RValue<Int16> operator&=(Int16 &lhs, RValue<Int16> rhs)
+	{
+		return lhs = lhs & rhs;
+	}
+
+	RValue<Int16> operator|=(Int16 &lhs, RValue<Int16> rhs)
+	{
+		return lhs = lhs | rhs;
+	}
+
+	RValue<Int16> operator^=(Int16 &lhs, RValue<Int16> rhs)
+	{
+		return lhs = lhs ^ rhs;
+	}
+
+	RValue<Int16> operator<<=(Int16 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs << rhs;
+	}
+
+	RValue<Int16> operator>>=(Int16 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs >> rhs;
+	}
+
+	RValue<Int16> operator+(RValue<Int16> val)
+	{
+		return val;
+	}
+
+	RValue<Int16> operator-(RValue<Int16> val)
+	{
+		return RValue<Int16>(Nucleus::createNeg(val.value));
+	}
+
+	RValue<Int16> operator~(RValue<Int16> val)
+	{
+		return RValue<Int16>(Nucleus::createNot(val.value));
+	}
+
+	RValue<Int16> CmpEQ(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createICmpEQ(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpLT(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createICmpSLT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpLE(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createICmpSLE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpNEQ(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createICmpNE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpNLT(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createICmpSGE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpNLE(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createICmpSGT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> Max(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_SGT)));
+	}
+
+	RValue<Int16> Min(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_SLT)));
+	}
+
+	RValue<Int16> RoundInt(RValue<Float16> cast)
+	{
+		return RValue<Int16>(V(lowerRoundInt(V(cast.value), T(Int16::getType()))));
+	}
+
+	RValue<Int> Extract(RValue<Int16> x, int i)
+	{
+		return RValue<Int>(Nucleus::createExtractElement(x.value, Int::getType(), i));
+	}
+
+	RValue<Int16> Insert(RValue<Int16> x, RValue<Int> element, int i)
+	{
+		return RValue<Int16>(Nucleus::createInsertElement(x.value, element.value, i));
+	}
+
+	RValue<Int> SignMask(RValue<Int16> x)
+	{
+		return RValue<Int>(V(lowerVectorSignMask(V(x.value), T(Int::getType()))));
+	}
+
+	RValue<Int16> Abs(RValue<Int16> x)
+	{
+		auto negative = x >> 31;
+		return (x ^ negative) - negative;
+	}
+
+	RValue<Int16> MulHigh(RValue<Int16> x, RValue<Int16> y)
+	{
+		return RValue<Int16>(V(lowerMulHigh(V(x.value), V(y.value), true)));
+	}
+
+	Type *Int16::getType()
+	{
+		return T(llvm::VectorType::get(T(Int::getType()), 16));
+	}
+
+	UInt16::UInt16(RValue<Float16> cast)
+	{
+		// Note: createFPToUI is broken, must perform conversion using createFPtoSI
+
+		// Smallest positive value representable in UInt, but not in Int
+		const unsigned int ustart = 0x80000000u;
+		const float ustartf = float(ustart);
+
+		// Check if the value can be represented as an Int
+		Int16 uiValue = CmpNLT(cast, Float16(ustartf));
+		// If the value is too large, subtract ustart and re-add it after conversion.
+		uiValue = (uiValue & As<Int16>(As<UInt16>(Int16(cast - Float16(ustartf))) + UInt16(ustart))) |
+		// Otherwise, just convert normally
+		          (~uiValue & Int16(cast));
+		// If the value is negative, store 0, otherwise store the result of the conversion
+		storeValue((~(As<Int16>(cast) >> 31) & uiValue).value);
+	}
+
+	UInt16::UInt16()
+	{
+	}
+
+	UInt16::UInt16(int replicate)
+	{
+		storeValue(V(::builder->CreateVectorSplat(16, V(Nucleus::createConstantInt(replicate)))));
+	}
+
+	UInt16::UInt16(RValue<UInt16> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	UInt16::UInt16(const UInt16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt16::UInt16(const Reference<UInt16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt16::UInt16(RValue<Int16> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	UInt16::UInt16(const Int16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt16::UInt16(const Reference<Int16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	UInt16::UInt16(RValue<UInt8> lo, RValue<UInt8> hi)
+	{
+		storeValue(V(lowerConcat(V(lo.value), V(hi.value))));
+	}
+
+	RValue<UInt16> UInt16::operator=(RValue<UInt16> rhs)
+	{
+		storeValue(rhs.value);
+
+		return rhs;
+	}
+
+	RValue<UInt16> UInt16::operator=(const UInt16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<UInt16>(value);
+	}
+
+	RValue<UInt16> UInt16::operator=(const Reference<UInt16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<UInt16>(value);
+	}
+
+	RValue<UInt16> operator+(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createAdd(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator-(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createSub(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator*(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createMul(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator/(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createUDiv(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator%(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createURem(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator&(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createAnd(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator|(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createOr(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator^(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createXor(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator<<(RValue<UInt16> lhs, unsigned char rhs)
+	{
+		return lhs << UInt16(rhs);
+	}
+
+	RValue<UInt16> operator>>(RValue<UInt16> lhs, unsigned char rhs)
+	{
+		return lhs >> UInt16(rhs);
+	}
+
+	RValue<UInt16> operator<<(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createShl(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator>>(RValue<UInt16> lhs, RValue<UInt16> rhs)
+	{
+		return RValue<UInt16>(Nucleus::createLShr(lhs.value, rhs.value));
+	}
+
+	RValue<UInt16> operator+=(UInt16 &lhs, RValue<UInt16> rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+
+	RValue<UInt16> operator-=(UInt16 &lhs, RValue<UInt16> rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+
+	RValue<UInt16> operator*=(UInt16 &lhs, RValue<UInt16> rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+
+	RValue<UInt16> operator&=(UInt16 &lhs, RValue<UInt16> rhs)
+	{
+		return lhs = lhs & rhs;
+	}
+
+	RValue<UInt16> operator|=(UInt16 &lhs, RValue<UInt16> rhs)
+	{
+		return lhs = lhs | rhs;
+	}
+
+	RValue<UInt16> operator^=(UInt16 &lhs, RValue<UInt16> rhs)
+	{
+		return lhs = lhs ^ rhs;
+	}
+
+	RValue<UInt16> operator<<=(UInt16 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs << rhs;
+	}
+
+	RValue<UInt16> operator>>=(UInt16 &lhs, unsigned char rhs)
+	{
+		return lhs = lhs >> rhs;
+	}
+
+	RValue<UInt16> operator+(RValue<UInt16> val)
+	{
+		return val;
+	}
+
+	RValue<UInt16> operator-(RValue<UInt16> val)
+	{
+		return RValue<UInt16>(Nucleus::createNeg(val.value));
+	}
+
+	RValue<UInt16> operator~(RValue<UInt16> val)
+	{
+		return RValue<UInt16>(Nucleus::createNot(val.value));
+	}
+
+	RValue<UInt16> CmpEQ(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(Nucleus::createSExt(Nucleus::createICmpEQ(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<UInt16> CmpLT(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(Nucleus::createSExt(Nucleus::createICmpULT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<UInt16> CmpLE(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(Nucleus::createSExt(Nucleus::createICmpULE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<UInt16> CmpNEQ(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(Nucleus::createSExt(Nucleus::createICmpNE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<UInt16> CmpNLT(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(Nucleus::createSExt(Nucleus::createICmpUGE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<UInt16> CmpNLE(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(Nucleus::createSExt(Nucleus::createICmpUGT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<UInt16> Max(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_UGT)));
+	}
+
+	RValue<UInt16> Min(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(V(lowerPMINMAX(V(x.value), V(y.value), llvm::ICmpInst::ICMP_ULT)));
+	}
+
+	RValue<UInt16> MulHigh(RValue<UInt16> x, RValue<UInt16> y)
+	{
+		return RValue<UInt16>(V(lowerMulHigh(V(x.value), V(y.value), false)));
+	}
+
+	Type *UInt16::getType()
+	{
+		return T(llvm::VectorType::get(T(UInt::getType()), 16));
+	}
+
+	Float16::Float16(RValue<Int16> cast)
+	{
+		Value *vector = Nucleus::createSIToFP(cast.value, Float16::getType());
+
+		storeValue(vector);
+	}
+
+	Float16::Float16(RValue<UInt16> cast)
+	{
+		RValue<Float16> result = Float16(Int16(cast & UInt16(0x7FFFFFFF))) +
+		                         As<Float16>((As<Int16>(cast) >> 31) & As<Int16>(Float16(0x80000000u)));
+
+		storeValue(result.value);
+	}
+
+	Float16::Float16()
+	{
+	}
+
+	Float16::Float16(float replicate)
+	{
+		storeValue(V(::builder->CreateVectorSplat(16, V(Nucleus::createConstantFloat(replicate)))));
+	}
+
+	Float16::Float16(RValue<Float16> rhs)
+	{
+		storeValue(rhs.value);
+	}
+
+	Float16::Float16(const Float16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Float16::Float16(const Reference<Float16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+	}
+
+	Float16::Float16(RValue<Float8> lo, RValue<Float8> hi)
+	{
+		storeValue(V(lowerConcat(V(lo.value), V(hi.value))));
+	}
+
+	Float16::Float16(RValue<Float> rhs)
+	{
+		storeValue(V(::builder->CreateVectorSplat(16, V(rhs.value))));
+	}
+
+	Float16::Float16(const Float &rhs)
+	{
+		*this = RValue<Float>(rhs.loadValue());
+	}
+
+	Float16::Float16(const Reference<Float> &rhs)
+	{
+		*this = RValue<Float>(rhs.loadValue());
+	}
+
+	RValue<Float16> Float16::operator=(RValue<Float16> rhs)
+	{
+		storeValue(rhs.value);
+
+		return rhs;
+	}
+
+	RValue<Float16> Float16::operator=(const Float16 &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Float16>(value);
+	}
+
+	RValue<Float16> Float16::operator=(const Reference<Float16> &rhs)
+	{
+		Value *value = rhs.loadValue();
+		storeValue(value);
+
+		return RValue<Float16>(value);
+	}
+
+	RValue<Float16> operator+(RValue<Float16> lhs, RValue<Float16> rhs)
+	{
+		return RValue<Float16>(Nucleus::createFAdd(lhs.value, rhs.value));
+	}
+
+	RValue<Float16> operator-(RValue<Float16> lhs, RValue<Float16> rhs)
+	{
+		return RValue<Float16>(Nucleus::createFSub(lhs.value, rhs.value));
+	}
+
+	RValue<Float16> operator*(RValue<Float16> lhs, RValue<Float16> rhs)
+	{
+		return RValue<Float16>(Nucleus::createFMul(lhs.value, rhs.value));
+	}
+
+	RValue<Float16> operator/(RValue<Float16> lhs, RValue<Float16> rhs)
+	{
+		return RValue<Float16>(Nucleus::createFDiv(lhs.value, rhs.value));
+	}
+
+	RValue<Float16> operator%(RValue<Float16> lhs, RValue<Float16> rhs)
+	{
+		return RValue<Float16>(Nucleus::createFRem(lhs.value, rhs.value));
+	}
+
+	RValue<Float16> operator+=(Float16 &lhs, RValue<Float16> rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+
+	RValue<Float16> operator-=(Float16 &lhs, RValue<Float16> rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+
+	RValue<Float16> operator*=(Float16 &lhs, RValue<Float16> rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+
+	RValue<Float16> operator/=(Float16 &lhs, RValue<Float16> rhs)
+	{
+		return lhs = lhs / rhs;
+	}
+
+	RValue<Float16> operator%=(Float16 &lhs, RValue<Float16> rhs)
+	{
+		return lhs = lhs % rhs;
+	}
+
+	RValue<Float16> operator+(RValue<Float16> val)
+	{
+		return val;
+	}
+
+	RValue<Float16> operator-(RValue<Float16> val)
+	{
+		return RValue<Float16>(Nucleus::createFNeg(val.value));
+	}
+
+	RValue<Float16> Abs(RValue<Float16> x)
+	{
+		return As<Float16>(As<Int16>(x) & Int16(0x7FFFFFFF));
+	}
+
+	RValue<Float16> Max(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Float16>(V(lowerPFMINMAX(V(x.value), V(y.value), llvm::FCmpInst::FCMP_OGT)));
+	}
+
+	RValue<Float16> Min(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Float16>(V(lowerPFMINMAX(V(x.value), V(y.value), llvm::FCmpInst::FCMP_OLT)));
+	}
+
+	RValue<Float16> Sqrt(RValue<Float16> x)
+	{
+		return RValue<Float16>(V(lowerSQRT(V(x.value))));
+	}
+
+	RValue<Float16> Insert(RValue<Float16> x, RValue<Float> element, int i)
+	{
+		return RValue<Float16>(Nucleus::createInsertElement(x.value, element.value, i));
+	}
+
+	RValue<Float> Extract(RValue<Float16> x, int i)
+	{
+		return RValue<Float>(Nucleus::createExtractElement(x.value, Float::getType(), i));
+	}
+
+	RValue<Int> SignMask(RValue<Float16> x)
+	{
+		return SignMask(As<Int16>(x));
+	}
+
+	RValue<Int16> CmpEQ(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpOEQ(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpLT(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpOLT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpLE(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpOLE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpNEQ(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpONE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpNLT(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpOGE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpNLE(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpOGT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpUEQ(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpUEQ(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpULT(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpULT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpULE(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpULE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpUNEQ(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpUNE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpUNLT(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpUGE(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> CmpUNLE(RValue<Float16> x, RValue<Float16> y)
+	{
+		return RValue<Int16>(Nucleus::createSExt(Nucleus::createFCmpUGT(x.value, y.value), Int16::getType()));
+	}
+
+	RValue<Int16> IsInf(RValue<Float16> x)
+	{
+		return CmpEQ(As<Int16>(x) & Int16(0x7FFFFFFF), Int16(0x7F800000));
+	}
+
+	RValue<Int16> IsNan(RValue<Float16> x)
+	{
+		return ~CmpEQ(x, x);
+	}
+
+	RValue<Float16> Round(RValue<Float16> x)
+	{
+		return RValue<Float16>(V(lowerRound(V(x.value))));
+	}
+
+	RValue<Float16> Trunc(RValue<Float16> x)
+	{
+		return RValue<Float16>(V(lowerTrunc(V(x.value))));
+	}
+
+	RValue<Float16> Frac(RValue<Float16> x)
+	{
+		Float16 frc = x - Floor(x);
+
+		// x - floor(x) can be 1.0 for very small negative x.
+		// Clamp against the value just below 1.0.
+		return Min(frc, As<Float16>(Int16(0x3F7FFFFF)));
+	}
+
+	RValue<Float16> Floor(RValue<Float16> x)
+	{
+		return RValue<Float16>(V(lowerFloor(V(x.value))));
+	}
+
+	RValue<Float16> Ceil(RValue<Float16> x)
+	{
+		return -Floor(-x);
+	}
+
+	Type *Float16::getType()
+	{
+		return T(llvm::VectorType::get(T(Float::getType()), 16));
+	}
+#endif  // REACTOR_LLVM_VERSION >= 7
+
 	RValue<Long> Ticks()
 	{
 		llvm::Function *rdtsc = llvm::Intrinsic::getDeclaration(::module, llvm::Intrinsic::readcyclecounter);
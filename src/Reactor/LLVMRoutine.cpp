@@ -44,9 +44,50 @@ namespace rr
 		return functionSize - static_cast<int>((uintptr_t)entry - (uintptr_t)buffer);
 	}
 #else
+	// Number of times a baseline routine's entry gets requested before it's recompiled with
+	// optimizations. Renderers request it once per draw, so this skips one-off routines.
+	static const int TIER_UP_THRESHOLD = 32;
+
 	LLVMRoutine::~LLVMRoutine()
 	{
 		dtor(reactorJIT, moduleKey);
+
+		if(optimizedJIT)
+		{
+			dtor(optimizedJIT, optimizedModuleKey);
+		}
+	}
+
+	const void *LLVMRoutine::getEntry()
+	{
+		if(baseline.load(std::memory_order_relaxed) &&
+		   uses.fetch_add(1, std::memory_order_relaxed) == TIER_UP_THRESHOLD - 1)
+		{
+			baseline.store(false, std::memory_order_relaxed);
+			scheduleOptimization(this);
+		}
+
+		return entry.load(std::memory_order_acquire);
+	}
+
+	void LLVMRoutine::setBaseline(std::string &&bitcode, std::string &&symbol, OptimizationProfile profile)
+	{
+		this->bitcode = std::move(bitcode);
+		this->symbol = std::move(symbol);
+		this->profile = profile;
+		baseline.store(true, std::memory_order_relaxed);
+	}
+
+	void LLVMRoutine::setOptimized(void *ent, LLVMReactorJIT *jit, uint64_t key)
+	{
+		optimizedJIT = jit;
+		optimizedModuleKey = key;
+		entry.store(ent, std::memory_order_release);
+	}
+
+	void LLVMRoutine::releaseBitcode()
+	{
+		std::string().swap(bitcode);
 	}
 #endif
 }
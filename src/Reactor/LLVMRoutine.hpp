@@ -15,9 +15,12 @@
 #ifndef rr_LLVMRoutine_hpp
 #define rr_LLVMRoutine_hpp
 
+#include "Nucleus.hpp"
 #include "Routine.hpp"
 
+#include <atomic>
 #include <cstdint>
+#include <string>
 
 namespace rr
 {
@@ -64,18 +67,39 @@ namespace rr
 
 		virtual ~LLVMRoutine();
 
-		const void *getEntry()
-		{
-			return entry;
-		}
+		const void *getEntry();
+
+		// Keeps the unoptimized IR of a baseline routine, to recompile it once it's hot
+		void setBaseline(std::string &&bitcode, std::string &&symbol, OptimizationProfile profile);
+
+		// Called on the optimizer thread. The baseline code remains valid until the routine
+		// is destroyed, since calls obtained from getEntry() earlier may still be running it.
+		void setOptimized(void *ent, LLVMReactorJIT *jit, uint64_t key);
+
+		const std::string &getBitcode() const { return bitcode; }
+		const std::string &getSymbol() const { return symbol; }
+		OptimizationProfile getProfile() const { return profile; }
+		void releaseBitcode();
 
 	private:
-		const void *entry;
+		std::atomic<const void*> entry;
 
 		void (*dtor)(LLVMReactorJIT *, uint64_t);
 		LLVMReactorJIT *reactorJIT;
 		uint64_t moduleKey;
+
+		// Tiered compilation state
+		std::atomic<bool> baseline = {false};
+		std::atomic<int> uses = {0};
+		std::string bitcode;
+		std::string symbol;
+		OptimizationProfile profile = DefaultOptimization;   // To recompile with
+		LLVMReactorJIT *optimizedJIT = nullptr;
+		uint64_t optimizedModuleKey = 0;
 	};
+
+	// Queues a hot baseline routine for recompilation on the optimizer thread
+	void scheduleOptimization(LLVMRoutine *routine);
 #endif  // REACTOR_LLVM_VERSION < 7
 }
 
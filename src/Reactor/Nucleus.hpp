@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cstdarg>
 #include <cstdint>
+#include <string>
 #include <vector>
 #include <atomic>
 
@@ -47,6 +48,27 @@ namespace rr
 
 	extern Optimization optimization[10];
 
+	// How much effort goes into optimizing a routine, which should match how much it runs
+	enum OptimizationProfile
+	{
+		NoOptimization,           // For debugging generated code
+		MinimalOptimization,      // Routines which barely run, like the ones for one-off copies
+		DefaultOptimization,      // The passes listed in rr::optimization
+		AggressiveOptimization,   // Routines which run per pixel or per invocation, with loop optimizations and vectorization
+	};
+
+	// Compiles routines without optimizations at first, and recompiles the ones which get
+	// used often with optimizations on a background thread. Only supported by LLVM 7.
+	extern bool tieredCompilation;
+
+	// Relocatable object code of a routine, which a later process running the same
+	// build on the same CPU features can load instead of generating the routine again.
+	struct RoutineObject
+	{
+		std::string entry;           // Symbol of the entry point, if the back-end needs it
+		std::vector<uint8_t> code;   // Object file
+	};
+
 	class Nucleus
 	{
 	public:
@@ -54,7 +76,12 @@ namespace rr
 
 		virtual ~Nucleus();
 
-		Routine *acquireRoutine(const char *name, bool runOptimizations = true);
+		Routine *acquireRoutine(const char *name, OptimizationProfile profile = DefaultOptimization);
+
+		// Object code of the last routine acquired on the calling thread. Returns false
+		// if the back-end can't produce relocatable object code.
+		static bool getRoutineObject(RoutineObject &object);
+		static Routine *loadRoutine(const RoutineObject &object);
 
 		static Value *allocateStackVariable(Type *type, int arraySize = 0);
 		static BasicBlock *createBasicBlock();
@@ -168,7 +195,7 @@ namespace rr
 		static Type *getPointerType(Type *elementType);
 
 	private:
-		void optimize();
+		void optimize(OptimizationProfile profile);
 	};
 }
 
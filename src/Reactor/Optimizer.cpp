@@ -17,6 +17,9 @@
 #include "src/IceCfg.h"
 #include "src/IceCfgNode.h"
 
+#include <algorithm>
+#include <map>
+#include <unordered_set>
 #include <vector>
 
 namespace
@@ -24,7 +27,7 @@ namespace
 	class Optimizer
 	{
 	public:
-		void run(Ice::Cfg *function);
+		void run(Ice::Cfg *function, rr::OptimizationProfile profile);
 
 	private:
 		void analyzeUses(Ice::Cfg *function);
@@ -33,6 +36,13 @@ namespace
 		void eliminateLoadsFollowingSingleStore();
 		void optimizeStoresInSingleBasicBlock();
 
+		// Passes across basic blocks, which need analyzeControlFlow()
+		void analyzeControlFlow();
+		void eliminateLoadsDominatedBySingleStore();
+		void hoistLoopInvariantCode();
+		void eliminateCommonSubexpressions();
+		void eliminateRedundantLoads();
+
 		void replace(Ice::Inst *instruction, Ice::Operand *newValue);
 		void deleteInstruction(Ice::Inst *instruction);
 		bool isDead(Ice::Inst *instruction);
@@ -47,6 +57,16 @@ namespace
 		static std::size_t storeSize(const Ice::Inst *instruction);
 		static bool loadTypeMatchesStore(const Ice::Inst *load, const Ice::Inst *store);
 
+		static Ice::Inst *getTerminator(Ice::CfgNode *node);
+		static bool isPure(const Ice::Inst *instruction);
+		static bool isSpeculatable(const Ice::Inst *instruction);
+		bool getExpression(const Ice::Inst *instruction, std::vector<uintptr_t> &expression);
+		bool hasSingleDefinition(Ice::Operand *value) const;
+		bool isStackAddress(Ice::Operand *address);
+		bool isRedundantLoadCandidate(const Ice::Inst *instruction);
+		bool mayClobber(const Ice::Inst *instruction);
+		bool dominates(Ice::CfgNode *dominator, Ice::CfgNode *node) const;
+
 		Ice::Cfg *function;
 		Ice::GlobalContext *context;
 
@@ -89,9 +109,17 @@ namespace
 		bool hasLoadStoreInsts(Ice::CfgNode* node) const;
 
 		std::vector<Optimizer::Uses*> allocatedUses;
+		std::unordered_set<Ice::Variable*> redefinedVariables;
+
+		// Control flow of the reachable nodes, indexed by node index
+		std::vector<Ice::CfgNode*> reversePostOrder;
+		std::vector<int> postOrderNumber;   // -1 for unreachable nodes
+		std::vector<std::vector<Ice::CfgNode*>> successors;
+		std::vector<std::vector<Ice::CfgNode*>> predecessors;
+		std::vector<Ice::CfgNode*> immediateDominator;
 	};
 
-	void Optimizer::run(Ice::Cfg *function)
+	void Optimizer::run(Ice::Cfg *function, rr::OptimizationProfile profile)
 	{
 		this->function = function;
 		this->context = function->getContext();
@@ -104,6 +132,17 @@ namespace
 		optimizeStoresInSingleBasicBlock();
 		eliminateDeadCode();
 
+		if(profile >= rr::DefaultOptimization)
+		{
+			analyzeControlFlow();
+
+			eliminateLoadsDominatedBySingleStore();
+			hoistLoopInvariantCode();
+			eliminateCommonSubexpressions();
+			eliminateRedundantLoads();
+			eliminateDeadCode();
+		}
+
 		for(auto uses : allocatedUses)
 		{
 			delete uses;
@@ -427,6 +466,518 @@ namespace
 		}
 	}
 
+	void Optimizer::analyzeControlFlow()
+	{
+		const Ice::SizeT nodeCount = function->getNumNodes();
+
+		successors.assign(nodeCount, {});
+		predecessors.assign(nodeCount, {});
+
+		for(Ice::CfgNode *node : function->getNodes())
+		{
+			Ice::Inst *terminator = getTerminator(node);
+
+			if(terminator && (llvm::isa<Ice::InstBr>(terminator) || llvm::isa<Ice::InstSwitch>(terminator)))
+			{
+				for(Ice::CfgNode *successor : terminator->getTerminatorEdges())
+				{
+					successors[node->getIndex()].push_back(successor);
+					predecessors[successor->getIndex()].push_back(node);
+				}
+			}
+		}
+
+		// Depth-first traversal from the entry node, which leaves out unreachable nodes
+		postOrderNumber.assign(nodeCount, -1);
+		reversePostOrder.clear();
+
+		std::vector<bool> visited(nodeCount, false);
+		std::vector<std::pair<Ice::CfgNode*, size_t>> stack;
+
+		stack.push_back({function->getEntryNode(), 0});
+		visited[function->getEntryNode()->getIndex()] = true;
+
+		while(!stack.empty())
+		{
+			Ice::CfgNode *node = stack.back().first;
+			size_t &next = stack.back().second;
+			const auto &nodeSuccessors = successors[node->getIndex()];
+
+			if(next < nodeSuccessors.size())
+			{
+				Ice::CfgNode *successor = nodeSuccessors[next++];
+
+				if(!visited[successor->getIndex()])
+				{
+					visited[successor->getIndex()] = true;
+					stack.push_back({successor, 0});
+				}
+			}
+			else
+			{
+				postOrderNumber[node->getIndex()] = static_cast<int>(reversePostOrder.size());
+				reversePostOrder.push_back(node);
+				stack.pop_back();
+			}
+		}
+
+		std::reverse(reversePostOrder.begin(), reversePostOrder.end());
+
+		// Cooper, Harvey and Kennedy's "A Simple, Fast Dominance Algorithm"
+		Ice::CfgNode *entry = function->getEntryNode();
+		immediateDominator.assign(nodeCount, nullptr);
+		immediateDominator[entry->getIndex()] = entry;
+
+		bool modified;
+		do
+		{
+			modified = false;
+
+			for(Ice::CfgNode *node : reversePostOrder)
+			{
+				if(node == entry)
+				{
+					continue;
+				}
+
+				Ice::CfgNode *dominator = nullptr;
+
+				for(Ice::CfgNode *predecessor : predecessors[node->getIndex()])
+				{
+					if(!immediateDominator[predecessor->getIndex()])
+					{
+						continue;   // Unreachable, or not processed yet
+					}
+
+					if(!dominator)
+					{
+						dominator = predecessor;
+						continue;
+					}
+
+					Ice::CfgNode *other = predecessor;
+
+					while(dominator != other)
+					{
+						while(postOrderNumber[dominator->getIndex()] < postOrderNumber[other->getIndex()])
+						{
+							dominator = immediateDominator[dominator->getIndex()];
+						}
+
+						while(postOrderNumber[other->getIndex()] < postOrderNumber[dominator->getIndex()])
+						{
+							other = immediateDominator[other->getIndex()];
+						}
+					}
+				}
+
+				if(immediateDominator[node->getIndex()] != dominator)
+				{
+					immediateDominator[node->getIndex()] = dominator;
+					modified = true;
+				}
+			}
+		}
+		while(modified);
+	}
+
+	void Optimizer::eliminateLoadsDominatedBySingleStore()
+	{
+		Ice::CfgNode *entryBlock = function->getEntryNode();
+
+		for(Ice::Inst &alloca : entryBlock->getInsts())
+		{
+			if(alloca.isDeleted())
+			{
+				continue;
+			}
+
+			if(!llvm::isa<Ice::InstAlloca>(alloca))
+			{
+				break;   // Allocas are all at the top
+			}
+
+			Ice::Operand *address = alloca.getDest();
+
+			if(!hasUses(address))
+			{
+				continue;
+			}
+
+			auto &addressUses = *getUses(address);
+
+			if(!addressUses.areOnlyLoadStore() || addressUses.stores.size() != 1)
+			{
+				continue;
+			}
+
+			Ice::Inst *store = addressUses.stores[0];
+			Ice::Operand *storeValue = storeData(store);
+			Ice::CfgNode *storeBlock = getNode(store);
+
+			if(!llvm::isa<Ice::Constant>(storeValue) && !hasSingleDefinition(storeValue))
+			{
+				continue;
+			}
+
+			// Every path to a load in a dominated block passes through the only store. Loads in
+			// the store's own block were already handled by eliminateLoadsFollowingSingleStore().
+			std::vector<Ice::Inst*> dominatedLoads;
+
+			for(Ice::Inst *load : addressUses.loads)
+			{
+				Ice::CfgNode *loadBlock = getNode(load);
+
+				if(loadBlock != storeBlock && dominates(storeBlock, loadBlock) && loadTypeMatchesStore(load, store))
+				{
+					dominatedLoads.push_back(load);
+				}
+			}
+
+			for(Ice::Inst *load : dominatedLoads)
+			{
+				replace(load, storeValue);
+			}
+		}
+	}
+
+	void Optimizer::hoistLoopInvariantCode()
+	{
+		struct Loop
+		{
+			Ice::CfgNode *header;
+			std::vector<bool> body;   // Indexed by node index
+			size_t size;
+		};
+
+		std::vector<Loop> loops;
+
+		// Natural loops, formed by the back edges to a node which dominates their source
+		for(Ice::CfgNode *latch : reversePostOrder)
+		{
+			for(Ice::CfgNode *header : successors[latch->getIndex()])
+			{
+				if(!dominates(header, latch))
+				{
+					continue;
+				}
+
+				auto loop = std::find_if(loops.begin(), loops.end(), [header](const Loop &loop) { return loop.header == header; });
+
+				if(loop == loops.end())
+				{
+					loops.push_back({header, std::vector<bool>(function->getNumNodes(), false), 1});
+					loop = loops.end() - 1;
+					loop->body[header->getIndex()] = true;
+				}
+
+				std::vector<Ice::CfgNode*> worklist = {latch};
+
+				while(!worklist.empty())
+				{
+					Ice::CfgNode *node = worklist.back();
+					worklist.pop_back();
+
+					if(loop->body[node->getIndex()])
+					{
+						continue;
+					}
+
+					loop->body[node->getIndex()] = true;
+					loop->size++;
+
+					for(Ice::CfgNode *predecessor : predecessors[node->getIndex()])
+					{
+						if(postOrderNumber[predecessor->getIndex()] >= 0)
+						{
+							worklist.push_back(predecessor);
+						}
+					}
+				}
+			}
+		}
+
+		// Inner loops first, so their invariants can be hoisted further out of the outer loops
+		std::sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b) { return a.size < b.size; });
+
+		for(const Loop &loop : loops)
+		{
+			// The preheader must be the only way into the loop, and always branch to it
+			Ice::CfgNode *preheader = nullptr;
+			bool singleEntry = true;
+
+			for(Ice::CfgNode *predecessor : predecessors[loop.header->getIndex()])
+			{
+				if(loop.body[predecessor->getIndex()] || postOrderNumber[predecessor->getIndex()] < 0)
+				{
+					continue;
+				}
+
+				singleEntry = !preheader;
+				preheader = predecessor;
+			}
+
+			if(!preheader || !singleEntry)
+			{
+				continue;
+			}
+
+			Ice::Inst *preheaderTerminator = getTerminator(preheader);
+
+			if(!preheaderTerminator || !preheaderTerminator->isUnconditionalBranch())
+			{
+				continue;
+			}
+
+			std::vector<Ice::Inst*> instructions;
+			bool clobbersMemory = false;
+
+			for(Ice::CfgNode *node : reversePostOrder)
+			{
+				if(!loop.body[node->getIndex()])
+				{
+					continue;
+				}
+
+				for(Ice::Inst &instruction : node->getInsts())
+				{
+					if(instruction.isDeleted())
+					{
+						continue;
+					}
+
+					clobbersMemory = clobbersMemory || mayClobber(&instruction);
+					instructions.push_back(&instruction);
+				}
+			}
+
+			for(Ice::Inst *instruction : instructions)
+			{
+				Ice::CfgNode *node = getNode(instruction);
+				Ice::Variable *dest = instruction->getDest();
+
+				if(!dest || !hasSingleDefinition(dest))
+				{
+					continue;
+				}
+
+				// Loads can't be executed speculatively, but the header's always execute when entering the loop
+				bool hoistable = isSpeculatable(instruction) ||
+				                 (node == loop.header && !clobbersMemory && isRedundantLoadCandidate(instruction));
+
+				for(Ice::SizeT i = 0; hoistable && i < instruction->getSrcSize(); i++)
+				{
+					Ice::Operand *src = instruction->getSrc(i);
+
+					if(llvm::isa<Ice::Constant>(src))
+					{
+						continue;
+					}
+
+					Ice::Variable *variable = llvm::dyn_cast<Ice::Variable>(src);
+					Ice::Inst *definition = variable ? getDefinition(variable) : nullptr;
+
+					hoistable = variable && hasSingleDefinition(variable) &&
+					            (!definition || !loop.body[getNode(definition)->getIndex()]);
+				}
+
+				if(hoistable)
+				{
+					preheader->getInsts().splice(Ice::instToIterator(preheaderTerminator), node->getInsts(), instruction);
+					setNode(instruction, preheader);
+				}
+			}
+		}
+	}
+
+	void Optimizer::eliminateCommonSubexpressions()
+	{
+		// Walks the dominator tree, with the expressions computed by the dominating nodes available
+		std::vector<std::vector<Ice::CfgNode*>> dominated(function->getNumNodes());
+
+		for(Ice::CfgNode *node : reversePostOrder)
+		{
+			if(node != function->getEntryNode())
+			{
+				dominated[immediateDominator[node->getIndex()]->getIndex()].push_back(node);
+			}
+		}
+
+		std::map<std::vector<uintptr_t>, Ice::Inst*> available;
+
+		struct Scope
+		{
+			Ice::CfgNode *node;
+			size_t next;
+			std::vector<std::map<std::vector<uintptr_t>, Ice::Inst*>::iterator> expressions;
+		};
+
+		std::vector<Scope> stack;
+		stack.push_back({function->getEntryNode(), 0, {}});
+
+		std::vector<uintptr_t> expression;
+		bool enter = true;
+
+		while(!stack.empty())
+		{
+			Scope &scope = stack.back();
+
+			if(enter)
+			{
+				for(Ice::Inst &instruction : scope.node->getInsts())
+				{
+					if(instruction.isDeleted() || !getExpression(&instruction, expression))
+					{
+						continue;
+					}
+
+					auto existing = available.find(expression);
+
+					if(existing == available.end())
+					{
+						scope.expressions.push_back(available.insert({expression, &instruction}).first);
+					}
+					else if(!existing->second->isDeleted())
+					{
+						replace(&instruction, existing->second->getDest());
+					}
+				}
+			}
+
+			const auto &children = dominated[scope.node->getIndex()];
+
+			if(scope.next < children.size())
+			{
+				Ice::CfgNode *child = children[scope.next++];
+				stack.push_back({child, 0, {}});
+				enter = true;
+			}
+			else
+			{
+				for(auto expression : scope.expressions)
+				{
+					available.erase(expression);
+				}
+
+				stack.pop_back();
+				enter = false;
+			}
+		}
+	}
+
+	void Optimizer::eliminateRedundantLoads()
+	{
+		// Forward data-flow analysis of the loads available at the start of each node. A load is
+		// only available if the same instruction executed on every path, with no possible store to
+		// its address since, so its result can replace later loads.
+		using AvailableLoads = std::map<std::pair<Ice::Operand*, Ice::Type>, Ice::Inst*>;
+
+		const Ice::SizeT nodeCount = function->getNumNodes();
+		std::vector<AvailableLoads> availableOut(nodeCount);
+		std::vector<bool> computed(nodeCount, false);
+
+		auto availableIn = [&](Ice::CfgNode *node)
+		{
+			AvailableLoads loads;
+			bool first = true;
+
+			if(node == function->getEntryNode())
+			{
+				return loads;
+			}
+
+			for(Ice::CfgNode *predecessor : predecessors[node->getIndex()])
+			{
+				if(!computed[predecessor->getIndex()])
+				{
+					continue;   // Unreachable, or a back edge not processed yet
+				}
+
+				const AvailableLoads &out = availableOut[predecessor->getIndex()];
+
+				if(first)
+				{
+					loads = out;
+					first = false;
+					continue;
+				}
+
+				for(auto load = loads.begin(); load != loads.end();)
+				{
+					auto other = out.find(load->first);
+
+					if(other == out.end() || other->second != load->second)
+					{
+						load = loads.erase(load);
+					}
+					else
+					{
+						load++;
+					}
+				}
+			}
+
+			return loads;
+		};
+
+		// Replaces redundant loads when 'eliminate' is set, otherwise only computes the available loads
+		auto process = [&](Ice::CfgNode *node, AvailableLoads &loads, bool eliminate)
+		{
+			for(Ice::Inst &instruction : node->getInsts())
+			{
+				if(instruction.isDeleted())
+				{
+					continue;
+				}
+
+				if(isRedundantLoadCandidate(&instruction))
+				{
+					auto key = std::make_pair(loadAddress(&instruction), instruction.getDest()->getType());
+					auto available = loads.find(key);
+
+					if(available == loads.end())
+					{
+						loads[key] = &instruction;
+					}
+					else if(eliminate)
+					{
+						replace(&instruction, available->second->getDest());
+					}
+				}
+				else if(mayClobber(&instruction))
+				{
+					loads.clear();
+				}
+			}
+		};
+
+		bool modified;
+		do
+		{
+			modified = false;
+
+			for(Ice::CfgNode *node : reversePostOrder)
+			{
+				AvailableLoads loads = availableIn(node);
+				process(node, loads, false);
+
+				if(!computed[node->getIndex()] || loads != availableOut[node->getIndex()])
+				{
+					availableOut[node->getIndex()] = std::move(loads);
+					computed[node->getIndex()] = true;
+					modified = true;
+				}
+			}
+		}
+		while(modified);
+
+		for(Ice::CfgNode *node : reversePostOrder)
+		{
+			AvailableLoads loads = availableIn(node);
+			process(node, loads, true);
+		}
+	}
+
 	void Optimizer::analyzeUses(Ice::Cfg *function)
 	{
 		for(Ice::CfgNode *basicBlock : function->getNodes())
@@ -441,6 +992,11 @@ namespace
 				setNode(&instruction, basicBlock);
 				if(instruction.getDest())
 				{
+					if(getDefinition(instruction.getDest()))
+					{
+						redefinedVariables.insert(instruction.getDest());
+					}
+
 					setDefinition(instruction.getDest(), &instruction);
 				}
 
@@ -707,6 +1263,224 @@ namespace
 		return false;
 	}
 
+	Ice::Inst *Optimizer::getTerminator(Ice::CfgNode *node)
+	{
+		for(Ice::Inst &instruction : Ice::reverse_range(node->getInsts()))
+		{
+			if(!instruction.isDeleted())
+			{
+				return &instruction;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool Optimizer::isPure(const Ice::Inst *instruction)
+	{
+		if(instruction->hasSideEffects())
+		{
+			return false;
+		}
+
+		switch(instruction->getKind())
+		{
+		case Ice::Inst::Arithmetic:
+		case Ice::Inst::Cast:
+		case Ice::Inst::ExtractElement:
+		case Ice::Inst::InsertElement:
+		case Ice::Inst::Icmp:
+		case Ice::Inst::Fcmp:
+		case Ice::Inst::Select:
+		case Ice::Inst::ShuffleVector:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool Optimizer::isSpeculatable(const Ice::Inst *instruction)
+	{
+		if(!isPure(instruction))
+		{
+			return false;
+		}
+
+		if(auto *arithmetic = llvm::dyn_cast<Ice::InstArithmetic>(instruction))
+		{
+			switch(arithmetic->getOp())
+			{
+			case Ice::InstArithmetic::Udiv:
+			case Ice::InstArithmetic::Sdiv:
+			case Ice::InstArithmetic::Urem:
+			case Ice::InstArithmetic::Srem:
+				return false;   // Can trap
+			default:
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	bool Optimizer::getExpression(const Ice::Inst *instruction, std::vector<uintptr_t> &expression)
+	{
+		Ice::Variable *dest = instruction->getDest();
+
+		if(!dest || !isPure(instruction) || !hasSingleDefinition(dest))
+		{
+			return false;
+		}
+
+		uintptr_t operation = 0;
+
+		if(auto *arithmetic = llvm::dyn_cast<Ice::InstArithmetic>(instruction)) operation = arithmetic->getOp();
+		else if(auto *cast = llvm::dyn_cast<Ice::InstCast>(instruction))        operation = cast->getCastKind();
+		else if(auto *icmp = llvm::dyn_cast<Ice::InstIcmp>(instruction))        operation = icmp->getCondition();
+		else if(auto *fcmp = llvm::dyn_cast<Ice::InstFcmp>(instruction))        operation = fcmp->getCondition();
+
+		expression.clear();
+		expression.push_back(instruction->getKind());
+		expression.push_back(operation);
+		expression.push_back(dest->getType());
+
+		for(Ice::SizeT i = 0; i < instruction->getSrcSize(); i++)
+		{
+			Ice::Operand *src = instruction->getSrc(i);
+
+			if(!llvm::isa<Ice::Constant>(src) && !hasSingleDefinition(src))
+			{
+				return false;
+			}
+
+			expression.push_back(reinterpret_cast<uintptr_t>(src));   // Constants are pooled
+		}
+
+		if(auto *arithmetic = llvm::dyn_cast<Ice::InstArithmetic>(instruction))
+		{
+			if(arithmetic->isCommutative() && expression[3] > expression[4])
+			{
+				std::swap(expression[3], expression[4]);
+			}
+		}
+
+		if(auto *shuffle = llvm::dyn_cast<Ice::InstShuffleVector>(instruction))
+		{
+			for(Ice::SizeT i = 0; i < shuffle->getNumIndexes(); i++)
+			{
+				expression.push_back(shuffle->getIndex(i)->getValue());
+			}
+		}
+
+		return true;
+	}
+
+	bool Optimizer::hasSingleDefinition(Ice::Operand *value) const
+	{
+		Ice::Variable *variable = llvm::dyn_cast<Ice::Variable>(value);
+
+		return variable && redefinedVariables.find(variable) == redefinedVariables.end();
+	}
+
+	bool Optimizer::isStackAddress(Ice::Operand *address)
+	{
+		Ice::Variable *variable = llvm::dyn_cast<Ice::Variable>(address);
+
+		if(!variable || !hasSingleDefinition(variable))
+		{
+			return false;
+		}
+
+		Ice::Inst *definition = getDefinition(variable);
+
+		// The address must not escape, so it can't be aliased by other pointers
+		return definition && llvm::isa<Ice::InstAlloca>(definition) &&
+		       (!hasUses(variable) || getUses(variable)->areOnlyLoadStore());
+	}
+
+	bool Optimizer::isRedundantLoadCandidate(const Ice::Inst *instruction)
+	{
+		if(!llvm::isa<Ice::InstLoad>(instruction) || !hasSingleDefinition(instruction->getDest()))
+		{
+			return false;
+		}
+
+		// Loads from allocas are handled by the passes above, and stores to them don't clobber
+		Ice::Operand *address = loadAddress(instruction);
+
+		if(llvm::isa<Ice::Constant>(address))
+		{
+			return true;
+		}
+
+		if(!hasSingleDefinition(address))
+		{
+			return false;
+		}
+
+		Ice::Inst *definition = getDefinition(llvm::cast<Ice::Variable>(address));
+
+		return !definition || !llvm::isa<Ice::InstAlloca>(definition);
+	}
+
+	bool Optimizer::mayClobber(const Ice::Inst *instruction)
+	{
+		if(isStore(*instruction))
+		{
+			return !isStackAddress(storeAddress(instruction));
+		}
+
+		switch(instruction->getKind())
+		{
+		case Ice::Inst::Call:
+			return true;
+		case Ice::Inst::IntrinsicCall:
+			{
+				auto info = llvm::cast<Ice::InstIntrinsicCall>(instruction)->getIntrinsicInfo();
+				return info.IsMemoryWrite || info.HasSideEffects;
+			}
+		case Ice::Inst::Unreachable:
+		case Ice::Inst::Alloca:
+		case Ice::Inst::Arithmetic:
+		case Ice::Inst::Br:
+		case Ice::Inst::Cast:
+		case Ice::Inst::ExtractElement:
+		case Ice::Inst::Fcmp:
+		case Ice::Inst::Icmp:
+		case Ice::Inst::InsertElement:
+		case Ice::Inst::Load:
+		case Ice::Inst::Phi:
+		case Ice::Inst::Ret:
+		case Ice::Inst::Select:
+		case Ice::Inst::Switch:
+		case Ice::Inst::Assign:
+		case Ice::Inst::ShuffleVector:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	bool Optimizer::dominates(Ice::CfgNode *dominator, Ice::CfgNode *node) const
+	{
+		if(postOrderNumber[dominator->getIndex()] < 0 || postOrderNumber[node->getIndex()] < 0)
+		{
+			return false;
+		}
+
+		while(node != dominator)
+		{
+			if(node == function->getEntryNode())
+			{
+				return false;
+			}
+
+			node = immediateDominator[node->getIndex()];
+		}
+
+		return true;
+	}
+
 	Optimizer::Uses* Optimizer::getUses(Ice::Operand* operand)
 	{
 		Optimizer::Uses* uses = (Optimizer::Uses*)operand->Ice::Operand::getExternalData();
@@ -828,10 +1602,10 @@ namespace
 
 namespace rr
 {
-	void optimize(Ice::Cfg *function)
+	void optimize(Ice::Cfg *function, OptimizationProfile profile)
 	{
 		Optimizer optimizer;
 
-		optimizer.run(function);
+		optimizer.run(function, profile);
 	}
 }
\ No newline at end of file
@@ -15,11 +15,15 @@
 #ifndef rr_Optimizer_hpp
 #define rr_Optimizer_hpp
 
+#include "Nucleus.hpp"
+
 #include "src/IceCfg.h"
 
 namespace rr
 {
-	void optimize(Ice::Cfg *function);
+	// Stack variable promotion and dead code elimination. Profiles from DefaultOptimization
+	// on also hoist loop invariants, and eliminate common subexpressions and redundant loads.
+	void optimize(Ice::Cfg *function, OptimizationProfile profile);
 }
 
 #endif   // rr_Optimizer_hpp
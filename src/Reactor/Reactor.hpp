@@ -61,6 +61,12 @@ namespace rr
 	class Float;
 	class Float2;
 	class Float4;
+	class Int8;
+	class UInt8;
+	class Float8;
+	class Int16;
+	class UInt16;
+	class Float16;
 
 	class Void
 	{
@@ -2078,6 +2084,7 @@ namespace rr
 		explicit Float4(RValue<UShort4> cast);
 		explicit Float4(RValue<Int4> cast);
 		explicit Float4(RValue<UInt4> cast);
+		explicit Float4(RValue<Float8> cast);   // Lower half
 
 		Float4();
 		Float4(float xyzw);
@@ -2179,6 +2186,401 @@ namespace rr
 	RValue<Float4> Floor(RValue<Float4> x);
 	RValue<Float4> Ceil(RValue<Float4> x);
 
+	// 8- and 16-wide vectors, for targets with 256-bit AVX or 512-bit AVX-512 registers.
+	// Subzero only supports 128-bit vectors, so these are implemented by the LLVM backend only.
+	class Int8 : public LValue<Int8>
+	{
+	public:
+		explicit Int8(RValue<Float8> cast);
+
+		Int8();
+		Int8(int replicate);
+		Int8(RValue<Int8> rhs);
+		Int8(const Int8 &rhs);
+		Int8(const Reference<Int8> &rhs);
+		Int8(RValue<UInt8> rhs);
+		Int8(const UInt8 &rhs);
+		Int8(const Reference<UInt8> &rhs);
+		Int8(RValue<Int4> lo, RValue<Int4> hi);
+		Int8(RValue<Int> rhs);
+		Int8(const Int &rhs);
+		Int8(const Reference<Int> &rhs);
+
+		RValue<Int8> operator=(RValue<Int8> rhs);
+		RValue<Int8> operator=(const Int8 &rhs);
+		RValue<Int8> operator=(const Reference<Int8> &rhs);
+
+		static Type *getType();
+	};
+
+	RValue<Int8> operator+(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator-(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator*(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator/(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator%(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator&(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator|(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator^(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator<<(RValue<Int8> lhs, unsigned char rhs);
+	RValue<Int8> operator>>(RValue<Int8> lhs, unsigned char rhs);
+	RValue<Int8> operator<<(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator>>(RValue<Int8> lhs, RValue<Int8> rhs);
+	RValue<Int8> operator+=(Int8 &lhs, RValue<Int8> rhs);
+	RValue<Int8> operator-=(Int8 &lhs, RValue<Int8> rhs);
+	RValue<Int8> operator*=(Int8 &lhs, RValue<Int8> rhs);
+	RValue<Int8> operator&=(Int8 &lhs, RValue<Int8> rhs);
+	RValue<Int8> operator|=(Int8 &lhs, RValue<Int8> rhs);
+	RValue<Int8> operator^=(Int8 &lhs, RValue<Int8> rhs);
+	RValue<Int8> operator<<=(Int8 &lhs, unsigned char rhs);
+	RValue<Int8> operator>>=(Int8 &lhs, unsigned char rhs);
+	RValue<Int8> operator+(RValue<Int8> val);
+	RValue<Int8> operator-(RValue<Int8> val);
+	RValue<Int8> operator~(RValue<Int8> val);
+
+	RValue<Int8> CmpEQ(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> CmpLT(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> CmpLE(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> CmpNEQ(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> CmpNLT(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> CmpNLE(RValue<Int8> x, RValue<Int8> y);
+	inline RValue<Int8> CmpGT(RValue<Int8> x, RValue<Int8> y) { return CmpNLE(x, y); }
+	inline RValue<Int8> CmpGE(RValue<Int8> x, RValue<Int8> y) { return CmpNLT(x, y); }
+	RValue<Int8> Max(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> Min(RValue<Int8> x, RValue<Int8> y);
+	RValue<Int8> RoundInt(RValue<Float8> cast);
+	RValue<Int> Extract(RValue<Int8> val, int i);
+	RValue<Int8> Insert(RValue<Int8> val, RValue<Int> element, int i);
+	RValue<Int> SignMask(RValue<Int8> x);
+	RValue<Int8> Abs(RValue<Int8> x);
+	RValue<Int8> MulHigh(RValue<Int8> x, RValue<Int8> y);
+
+	class UInt8 : public LValue<UInt8>
+	{
+	public:
+		explicit UInt8(RValue<Float8> cast);
+
+		UInt8();
+		UInt8(int replicate);
+		UInt8(RValue<UInt8> rhs);
+		UInt8(const UInt8 &rhs);
+		UInt8(const Reference<UInt8> &rhs);
+		UInt8(RValue<Int8> rhs);
+		UInt8(const Int8 &rhs);
+		UInt8(const Reference<Int8> &rhs);
+		UInt8(RValue<UInt4> lo, RValue<UInt4> hi);
+
+		RValue<UInt8> operator=(RValue<UInt8> rhs);
+		RValue<UInt8> operator=(const UInt8 &rhs);
+		RValue<UInt8> operator=(const Reference<UInt8> &rhs);
+
+		static Type *getType();
+	};
+
+	RValue<UInt8> operator+(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator-(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator*(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator/(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator%(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator&(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator|(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator^(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator<<(RValue<UInt8> lhs, unsigned char rhs);
+	RValue<UInt8> operator>>(RValue<UInt8> lhs, unsigned char rhs);
+	RValue<UInt8> operator<<(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator>>(RValue<UInt8> lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator+=(UInt8 &lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator-=(UInt8 &lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator*=(UInt8 &lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator&=(UInt8 &lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator|=(UInt8 &lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator^=(UInt8 &lhs, RValue<UInt8> rhs);
+	RValue<UInt8> operator<<=(UInt8 &lhs, unsigned char rhs);
+	RValue<UInt8> operator>>=(UInt8 &lhs, unsigned char rhs);
+	RValue<UInt8> operator+(RValue<UInt8> val);
+	RValue<UInt8> operator-(RValue<UInt8> val);
+	RValue<UInt8> operator~(RValue<UInt8> val);
+
+	RValue<UInt8> CmpEQ(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> CmpLT(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> CmpLE(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> CmpNEQ(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> CmpNLT(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> CmpNLE(RValue<UInt8> x, RValue<UInt8> y);
+	inline RValue<UInt8> CmpGT(RValue<UInt8> x, RValue<UInt8> y) { return CmpNLE(x, y); }
+	inline RValue<UInt8> CmpGE(RValue<UInt8> x, RValue<UInt8> y) { return CmpNLT(x, y); }
+	RValue<UInt8> Max(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> Min(RValue<UInt8> x, RValue<UInt8> y);
+	RValue<UInt8> MulHigh(RValue<UInt8> x, RValue<UInt8> y);
+
+	class Float8 : public LValue<Float8>
+	{
+	public:
+		explicit Float8(RValue<Int8> cast);
+		explicit Float8(RValue<UInt8> cast);
+		explicit Float8(RValue<Float16> cast);   // Lower half
+
+		Float8();
+		Float8(float replicate);
+		Float8(RValue<Float8> rhs);
+		Float8(const Float8 &rhs);
+		Float8(const Reference<Float8> &rhs);
+		Float8(RValue<Float4> lo, RValue<Float4> hi);
+		Float8(RValue<Float> rhs);
+		Float8(const Float &rhs);
+		Float8(const Reference<Float> &rhs);
+
+		RValue<Float8> operator=(RValue<Float8> rhs);
+		RValue<Float8> operator=(const Float8 &rhs);
+		RValue<Float8> operator=(const Reference<Float8> &rhs);
+
+		static Type *getType();
+	};
+
+	RValue<Float8> operator+(RValue<Float8> lhs, RValue<Float8> rhs);
+	RValue<Float8> operator-(RValue<Float8> lhs, RValue<Float8> rhs);
+	RValue<Float8> operator*(RValue<Float8> lhs, RValue<Float8> rhs);
+	RValue<Float8> operator/(RValue<Float8> lhs, RValue<Float8> rhs);
+	RValue<Float8> operator%(RValue<Float8> lhs, RValue<Float8> rhs);
+	RValue<Float8> operator+=(Float8 &lhs, RValue<Float8> rhs);
+	RValue<Float8> operator-=(Float8 &lhs, RValue<Float8> rhs);
+	RValue<Float8> operator*=(Float8 &lhs, RValue<Float8> rhs);
+	RValue<Float8> operator/=(Float8 &lhs, RValue<Float8> rhs);
+	RValue<Float8> operator%=(Float8 &lhs, RValue<Float8> rhs);
+	RValue<Float8> operator+(RValue<Float8> val);
+	RValue<Float8> operator-(RValue<Float8> val);
+
+	RValue<Float8> Abs(RValue<Float8> x);
+	RValue<Float8> Max(RValue<Float8> x, RValue<Float8> y);
+	RValue<Float8> Min(RValue<Float8> x, RValue<Float8> y);
+	RValue<Float8> Sqrt(RValue<Float8> x);
+	RValue<Float8> Insert(RValue<Float8> val, RValue<Float> element, int i);
+	RValue<Float> Extract(RValue<Float8> x, int i);
+	RValue<Int> SignMask(RValue<Float8> x);
+
+	// Ordered comparison functions
+	RValue<Int8> CmpEQ(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpLT(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpLE(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpNEQ(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpNLT(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpNLE(RValue<Float8> x, RValue<Float8> y);
+	inline RValue<Int8> CmpGT(RValue<Float8> x, RValue<Float8> y) { return CmpNLE(x, y); }
+	inline RValue<Int8> CmpGE(RValue<Float8> x, RValue<Float8> y) { return CmpNLT(x, y); }
+
+	// Unordered comparison functions
+	RValue<Int8> CmpUEQ(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpULT(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpULE(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpUNEQ(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpUNLT(RValue<Float8> x, RValue<Float8> y);
+	RValue<Int8> CmpUNLE(RValue<Float8> x, RValue<Float8> y);
+	inline RValue<Int8> CmpUGT(RValue<Float8> x, RValue<Float8> y) { return CmpUNLE(x, y); }
+	inline RValue<Int8> CmpUGE(RValue<Float8> x, RValue<Float8> y) { return CmpUNLT(x, y); }
+
+	RValue<Int8> IsInf(RValue<Float8> x);
+	RValue<Int8> IsNan(RValue<Float8> x);
+	RValue<Float8> Round(RValue<Float8> x);
+	RValue<Float8> Trunc(RValue<Float8> x);
+	RValue<Float8> Frac(RValue<Float8> x);
+	RValue<Float8> Floor(RValue<Float8> x);
+	RValue<Float8> Ceil(RValue<Float8> x);
+
+	class Int16 : public LValue<Int16>
+	{
+	public:
+		explicit Int16(RValue<Float16> cast);
+
+		Int16();
+		Int16(int replicate);
+		Int16(RValue<Int16> rhs);
+		Int16(const Int16 &rhs);
+		Int16(const Reference<Int16> &rhs);
+		Int16(RValue<UInt16> rhs);
+		Int16(const UInt16 &rhs);
+		Int16(const Reference<UInt16> &rhs);
+		Int16(RValue<Int8> lo, RValue<Int8> hi);
+		Int16(RValue<Int> rhs);
+		Int16(const Int &rhs);
+		Int16(const Reference<Int> &rhs);
+
+		RValue<Int16> operator=(RValue<Int16> rhs);
+		RValue<Int16> operator=(const Int16 &rhs);
+		RValue<Int16> operator=(const Reference<Int16> &rhs);
+
+		static Type *getType();
+	};
+
+	RValue<Int16> operator+(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator-(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator*(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator/(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator%(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator&(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator|(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator^(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator<<(RValue<Int16> lhs, unsigned char rhs);
+	RValue<Int16> operator>>(RValue<Int16> lhs, unsigned char rhs);
+	RValue<Int16> operator<<(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator>>(RValue<Int16> lhs, RValue<Int16> rhs);
+	RValue<Int16> operator+=(Int16 &lhs, RValue<Int16> rhs);
+	RValue<Int16> operator-=(Int16 &lhs, RValue<Int16> rhs);
+	RValue<Int16> operator*=(Int16 &lhs, RValue<Int16> rhs);
+	RValue<Int16> operator&=(Int16 &lhs, RValue<Int16> rhs);
+	RValue<Int16> operator|=(Int16 &lhs, RValue<Int16> rhs);
+	RValue<Int16> operator^=(Int16 &lhs, RValue<Int16> rhs);
+	RValue<Int16> operator<<=(Int16 &lhs, unsigned char rhs);
+	RValue<Int16> operator>>=(Int16 &lhs, unsigned char rhs);
+	RValue<Int16> operator+(RValue<Int16> val);
+	RValue<Int16> operator-(RValue<Int16> val);
+	RValue<Int16> operator~(RValue<Int16> val);
+
+	RValue<Int16> CmpEQ(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> CmpLT(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> CmpLE(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> CmpNEQ(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> CmpNLT(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> CmpNLE(RValue<Int16> x, RValue<Int16> y);
+	inline RValue<Int16> CmpGT(RValue<Int16> x, RValue<Int16> y) { return CmpNLE(x, y); }
+	inline RValue<Int16> CmpGE(RValue<Int16> x, RValue<Int16> y) { return CmpNLT(x, y); }
+	RValue<Int16> Max(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> Min(RValue<Int16> x, RValue<Int16> y);
+	RValue<Int16> RoundInt(RValue<Float16> cast);
+	RValue<Int> Extract(RValue<Int16> val, int i);
+	RValue<Int16> Insert(RValue<Int16> val, RValue<Int> element, int i);
+	RValue<Int> SignMask(RValue<Int16> x);
+	RValue<Int16> Abs(RValue<Int16> x);
+	RValue<Int16> MulHigh(RValue<Int16> x, RValue<Int16> y);
+
+	class UInt16 : public LValue<UInt16>
+	{
+	public:
+		explicit UInt16(RValue<Float16> cast);
+
+		UInt16();
+		UInt16(int replicate);
+		UInt16(RValue<UInt16> rhs);
+		UInt16(const UInt16 &rhs);
+		UInt16(const Reference<UInt16> &rhs);
+		UInt16(RValue<Int16> rhs);
+		UInt16(const Int16 &rhs);
+		UInt16(const Reference<Int16> &rhs);
+		UInt16(RValue<UInt8> lo, RValue<UInt8> hi);
+
+		RValue<UInt16> operator=(RValue<UInt16> rhs);
+		RValue<UInt16> operator=(const UInt16 &rhs);
+		RValue<UInt16> operator=(const Reference<UInt16> &rhs);
+
+		static Type *getType();
+	};
+
+	RValue<UInt16> operator+(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator-(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator*(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator/(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator%(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator&(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator|(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator^(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator<<(RValue<UInt16> lhs, unsigned char rhs);
+	RValue<UInt16> operator>>(RValue<UInt16> lhs, unsigned char rhs);
+	RValue<UInt16> operator<<(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator>>(RValue<UInt16> lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator+=(UInt16 &lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator-=(UInt16 &lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator*=(UInt16 &lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator&=(UInt16 &lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator|=(UInt16 &lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator^=(UInt16 &lhs, RValue<UInt16> rhs);
+	RValue<UInt16> operator<<=(UInt16 &lhs, unsigned char rhs);
+	RValue<UInt16> operator>>=(UInt16 &lhs, unsigned char rhs);
+	RValue<UInt16> operator+(RValue<UInt16> val);
+	RValue<UInt16> operator-(RValue<UInt16> val);
+	RValue<UInt16> operator~(RValue<UInt16> val);
+
+	RValue<UInt16> CmpEQ(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> CmpLT(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> CmpLE(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> CmpNEQ(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> CmpNLT(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> CmpNLE(RValue<UInt16> x, RValue<UInt16> y);
+	inline RValue<UInt16> CmpGT(RValue<UInt16> x, RValue<UInt16> y) { return CmpNLE(x, y); }
+	inline RValue<UInt16> CmpGE(RValue<UInt16> x, RValue<UInt16> y) { return CmpNLT(x, y); }
+	RValue<UInt16> Max(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> Min(RValue<UInt16> x, RValue<UInt16> y);
+	RValue<UInt16> MulHigh(RValue<UInt16> x, RValue<UInt16> y);
+
+	class Float16 : public LValue<Float16>
+	{
+	public:
+		explicit Float16(RValue<Int16> cast);
+		explicit Float16(RValue<UInt16> cast);
+
+		Float16();
+		Float16(float replicate);
+		Float16(RValue<Float16> rhs);
+		Float16(const Float16 &rhs);
+		Float16(const Reference<Float16> &rhs);
+		Float16(RValue<Float8> lo, RValue<Float8> hi);
+		Float16(RValue<Float> rhs);
+		Float16(const Float &rhs);
+		Float16(const Reference<Float> &rhs);
+
+		RValue<Float16> operator=(RValue<Float16> rhs);
+		RValue<Float16> operator=(const Float16 &rhs);
+		RValue<Float16> operator=(const Reference<Float16> &rhs);
+
+		static Type *getType();
+	};
+
+	RValue<Float16> operator+(RValue<Float16> lhs, RValue<Float16> rhs);
+	RValue<Float16> operator-(RValue<Float16> lhs, RValue<Float16> rhs);
+	RValue<Float16> operator*(RValue<Float16> lhs, RValue<Float16> rhs);
+	RValue<Float16> operator/(RValue<Float16> lhs, RValue<Float16> rhs);
+	RValue<Float16> operator%(RValue<Float16> lhs, RValue<Float16> rhs);
+	RValue<Float16> operator+=(Float16 &lhs, RValue<Float16> rhs);
+	RValue<Float16> operator-=(Float16 &lhs, RValue<Float16> rhs);
+	RValue<Float16> operator*=(Float16 &lhs, RValue<Float16> rhs);
+	RValue<Float16> operator/=(Float16 &lhs, RValue<Float16> rhs);
+	RValue<Float16> operator%=(Float16 &lhs, RValue<Float16> rhs);
+	RValue<Float16> operator+(RValue<Float16> val);
+	RValue<Float16> operator-(RValue<Float16> val);
+
+	RValue<Float16> Abs(RValue<Float16> x);
+	RValue<Float16> Max(RValue<Float16> x, RValue<Float16> y);
+	RValue<Float16> Min(RValue<Float16> x, RValue<Float16> y);
+	RValue<Float16> Sqrt(RValue<Float16> x);
+	RValue<Float16> Insert(RValue<Float16> val, RValue<Float> element, int i);
+	RValue<Float> Extract(RValue<Float16> x, int i);
+	RValue<Int> SignMask(RValue<Float16> x);
+
+	// Ordered comparison functions
+	RValue<Int16> CmpEQ(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpLT(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpLE(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpNEQ(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpNLT(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpNLE(RValue<Float16> x, RValue<Float16> y);
+	inline RValue<Int16> CmpGT(RValue<Float16> x, RValue<Float16> y) { return CmpNLE(x, y); }
+	inline RValue<Int16> CmpGE(RValue<Float16> x, RValue<Float16> y) { return CmpNLT(x, y); }
+
+	// Unordered comparison functions
+	RValue<Int16> CmpUEQ(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpULT(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpULE(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpUNEQ(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpUNLT(RValue<Float16> x, RValue<Float16> y);
+	RValue<Int16> CmpUNLE(RValue<Float16> x, RValue<Float16> y);
+	inline RValue<Int16> CmpUGT(RValue<Float16> x, RValue<Float16> y) { return CmpUNLE(x, y); }
+	inline RValue<Int16> CmpUGE(RValue<Float16> x, RValue<Float16> y) { return CmpUNLT(x, y); }
+
+	RValue<Int16> IsInf(RValue<Float16> x);
+	RValue<Int16> IsNan(RValue<Float16> x);
+	RValue<Float16> Round(RValue<Float16> x);
+	RValue<Float16> Trunc(RValue<Float16> x);
+	RValue<Float16> Frac(RValue<Float16> x);
+	RValue<Float16> Floor(RValue<Float16> x);
+	RValue<Float16> Ceil(RValue<Float16> x);
+
 	template<class T>
 	class Pointer : public LValue<Pointer<T>>
 	{
@@ -2296,6 +2698,7 @@ namespace rr
 		}
 
 		Routine *operator()(const char *name, ...);
+		Routine *operator()(OptimizationProfile profile, const char *name, ...);
 
 	protected:
 		Nucleus *core;
@@ -2806,7 +3209,20 @@ namespace rr
 		vsnprintf(fullName, 1024, name, vararg);
 		va_end(vararg);
 
-		return core->acquireRoutine(fullName, true);
+		return core->acquireRoutine(fullName, DefaultOptimization);
+	}
+
+	template<typename Return, typename... Arguments>
+	Routine *Function<Return(Arguments...)>::operator()(OptimizationProfile profile, const char *name, ...)
+	{
+		char fullName[1024 + 1];
+
+		va_list vararg;
+		va_start(vararg, name);
+		vsnprintf(fullName, 1024, name, vararg);
+		va_end(vararg);
+
+		return core->acquireRoutine(fullName, profile);
 	}
 
 	template<class T, class S>
@@ -13,9 +13,11 @@
 // limitations under the License.
 
 #include "Reactor.hpp"
+#include "ExecutableMemory.hpp"
 
 #include "gtest/gtest.h"
 
+#include <cstring>
 #include <tuple>
 
 using namespace rr;
@@ -1029,6 +1031,173 @@ TEST(ReactorUnitTests, MulAdd)
 	delete routine;
 }
 
+#if defined(REACTOR_BACKEND_LLVM) && REACTOR_LLVM_VERSION >= 7
+// The 8- and 16-wide vector types are only implemented by the LLVM back-end.
+TEST(ReactorUnitTests, WideIntVectors)
+{
+	Routine *routine = nullptr;
+
+	{
+		Function<Int(Pointer<Byte>)> function;
+		{
+			Pointer<Byte> out = function.Arg<0>();
+
+			Int8 a = Int8(Int4(1, -2, 3, -4), Int4(5, -6, 7, -8));
+			Int8 b = Int8(3);
+			Int16 c = Int16(a, Int8(Int4(9), Int4(-10)));
+
+			*Pointer<Int8>(out + 32 * 0) = a + b;
+			*Pointer<Int8>(out + 32 * 1) = a * b;
+			*Pointer<Int8>(out + 32 * 2) = CmpLT(a, b);
+			*Pointer<Int8>(out + 32 * 3) = Max(a, b);
+			*Pointer<Int8>(out + 32 * 4) = Abs(a) >> 1;
+			*Pointer<UInt8>(out + 32 * 5) = As<UInt8>(a) >> 28;
+			*Pointer<Int>(out + 32 * 6 + 0) = SignMask(a);
+			*Pointer<Int>(out + 32 * 6 + 4) = Extract(a, 6);
+			*Pointer<Int>(out + 32 * 6 + 8) = SignMask(c);
+			*Pointer<Int16>(out + 32 * 7) = c + Int16(1);
+
+			Return(0);
+		}
+
+		routine = function("one");
+
+		if(routine)
+		{
+			int out[9][8];
+
+			memset(&out, 0, sizeof(out));
+
+			int(*callable)(void*) = (int(*)(void*))routine->getEntry();
+			callable(&out);
+
+			int ref[6][8] =
+			{
+				{4, 1, 6, -1, 8, -3, 10, -5},
+				{3, -6, 9, -12, 15, -18, 21, -24},
+				{-1, -1, 0, -1, 0, -1, 0, -1},
+				{3, 3, 3, 3, 5, 3, 7, 3},
+				{0, 1, 1, 2, 2, 3, 3, 4},
+				{0, 15, 0, 15, 0, 15, 0, 15},
+			};
+
+			for(int row = 0; row < 6; row++)
+			{
+				for(int col = 0; col < 8; col++)
+				{
+					EXPECT_EQ(out[row][col], ref[row][col]) << "Row " << row << " column " << col << " not equal to reference.";
+				}
+			}
+
+			EXPECT_EQ(out[6][0], 0xAA);
+			EXPECT_EQ(out[6][1], 7);
+			EXPECT_EQ(out[6][2], 0xF0AA);
+
+			int ref16[16] = {2, -1, 4, -3, 6, -5, 8, -7, 10, 10, 10, 10, -9, -9, -9, -9};
+
+			for(int i = 0; i < 16; i++)
+			{
+				EXPECT_EQ(out[7 + i / 8][i % 8], ref16[i]) << "Element " << i << " not equal to reference.";
+			}
+		}
+	}
+
+	delete routine;
+}
+
+TEST(ReactorUnitTests, WideFloatVectors)
+{
+	Routine *routine = nullptr;
+
+	{
+		Function<Int(Pointer<Byte>, Pointer<Byte>)> function;
+		{
+			Pointer<Byte> out = function.Arg<0>();
+			Pointer<Byte> outInt = function.Arg<1>();
+
+			Float8 x = Float8(Float4(1.5f, -1.5f, 2.5f, -0.25f), Float4(4.0f, 9.0f, -3.75f, 0.0f));
+			Float16 y = Float16(x, x * Float8(2.0f));
+
+			*Pointer<Float8>(out + 32 * 0) = Floor(x);
+			*Pointer<Float8>(out + 32 * 1) = Round(x);
+			*Pointer<Float8>(out + 32 * 2) = Min(x, Float8(1.0f));
+			*Pointer<Float8>(out + 32 * 3) = Sqrt(Float8(Float4(4.0f), Float4(9.0f)));
+			*Pointer<Float8>(out + 32 * 4) = Float8(UInt8(Int8(Int4(-2), Int4(5))));
+			*Pointer<Float4>(out + 32 * 5) = Float4(x);
+			*Pointer<Float4>(out + 32 * 5 + 16) = Float4(Float8(y * Float16(Float(2.0f))));
+			*Pointer<Float16>(out + 32 * 6) = Ceil(y);
+
+			*Pointer<Int8>(outInt + 32 * 0) = CmpLT(x, Float8(0.0f));
+			*Pointer<Int8>(outInt + 32 * 1) = Int8(x);
+			*Pointer<UInt8>(outInt + 32 * 2) = UInt8(Float8(Float4(3.0e9f), Float4(7.0f)));
+			*Pointer<Int>(outInt + 32 * 3 + 0) = SignMask(x);
+			*Pointer<Int>(outInt + 32 * 3 + 4) = SignMask(y);
+			*Pointer<Float>(outInt + 32 * 3 + 8) = Extract(x, 6);
+
+			Return(0);
+		}
+
+		routine = function("one");
+
+		if(routine)
+		{
+			float out[8][8];
+			unsigned int outInt[4][8];
+
+			memset(&out, 0, sizeof(out));
+			memset(&outInt, 0, sizeof(outInt));
+
+			int(*callable)(void*, void*) = (int(*)(void*, void*))routine->getEntry();
+			callable(&out, &outInt);
+
+			float ref[8][8] =
+			{
+				{1.0f, -2.0f, 2.0f, -1.0f, 4.0f, 9.0f, -4.0f, 0.0f},
+				{2.0f, -2.0f, 2.0f, 0.0f, 4.0f, 9.0f, -4.0f, 0.0f},
+				{1.0f, -1.5f, 1.0f, -0.25f, 1.0f, 1.0f, -3.75f, 0.0f},
+				{2.0f, 2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f, 3.0f},
+				{4294967296.0f, 4294967296.0f, 4294967296.0f, 4294967296.0f, 5.0f, 5.0f, 5.0f, 5.0f},
+				{1.5f, -1.5f, 2.5f, -0.25f, 3.0f, -3.0f, 5.0f, -0.5f},
+				{2.0f, -1.0f, 3.0f, 0.0f, 4.0f, 9.0f, -3.0f, 0.0f},
+				{3.0f, -3.0f, 5.0f, 0.0f, 8.0f, 18.0f, -7.0f, 0.0f},
+			};
+
+			for(int row = 0; row < 8; row++)
+			{
+				for(int col = 0; col < 8; col++)
+				{
+					EXPECT_EQ(out[row][col], ref[row][col]) << "Row " << row << " column " << col << " not equal to reference.";
+				}
+			}
+
+			unsigned int refInt[3][8] =
+			{
+				{0x00000000u, 0xFFFFFFFFu, 0x00000000u, 0xFFFFFFFFu, 0x00000000u, 0x00000000u, 0xFFFFFFFFu, 0x00000000u},
+				{1u, 0xFFFFFFFFu, 2u, 0u, 4u, 9u, 0xFFFFFFFDu, 0u},
+				{3000000000u, 3000000000u, 3000000000u, 3000000000u, 7u, 7u, 7u, 7u},
+			};
+
+			for(int row = 0; row < 3; row++)
+			{
+				for(int col = 0; col < 8; col++)
+				{
+					EXPECT_EQ(outInt[row][col], refInt[row][col]) << "Row " << row << " column " << col << " not equal to reference.";
+				}
+			}
+
+			float extracted;
+			memcpy(&extracted, &outInt[3][2], sizeof(float));
+
+			EXPECT_EQ(outInt[3][0], 0x4Au);
+			EXPECT_EQ(outInt[3][1], 0x4A4Au);
+			EXPECT_EQ(extracted, -3.75f);
+		}
+	}
+
+	delete routine;
+}
+#endif
+
 // Check that a complex generated function which utilizes all 8 or 16 XMM
 // registers computes the correct result.
 // (Note that due to MSC's lack of support for inline assembly in x64,
@@ -1117,6 +1286,226 @@ TEST(ReactorUnitTests, PreserveXMMRegisters)
     delete routine;
 }
 
+TEST(ReactorUnitTests, LoopInvariantLoadWithClobberingStore)
+{
+	Routine *routine = nullptr;
+
+	{
+		Function<Int(Pointer<Int>)> function;
+		{
+			Pointer<Int> p = function.Arg<0>();
+			Int count = 0;
+
+			// The condition's load looks loop invariant, but the body stores to its address
+			For(Int i = 0, i < *p, i++)
+			{
+				*p = *p - 1;
+				count += 1;
+			}
+
+			Return(count);
+		}
+
+		routine = function("one");
+
+		if(routine)
+		{
+			int (*callable)(int*) = (int(*)(int*))routine->getEntry();
+			int n = 10;
+			int result = callable(&n);
+
+			EXPECT_EQ(result, 5);
+			EXPECT_EQ(n, 5);
+		}
+	}
+
+	delete routine;
+}
+
+TEST(ReactorUnitTests, LoopWithZeroTripCount)
+{
+	Routine *routine = nullptr;
+
+	{
+		Function<Int(Pointer<Int>, Int, Int)> function;
+		{
+			Pointer<Int> p = function.Arg<0>();
+			Int n = function.Arg<1>();
+			Int d = function.Arg<2>();
+			Int sum = 0;
+
+			// Loop invariant, but faults when executed with a null pointer or zero divisor
+			For(Int i = 0, i < n, i++)
+			{
+				sum += *p / d;
+			}
+
+			Return(sum);
+		}
+
+		routine = function("one");
+
+		if(routine)
+		{
+			int (*callable)(int*, int, int) = (int(*)(int*,int,int))routine->getEntry();
+			int x = 12;
+
+			EXPECT_EQ(callable(nullptr, 0, 0), 0);
+			EXPECT_EQ(callable(&x, 3, 4), 9);
+		}
+	}
+
+	delete routine;
+}
+
+TEST(ReactorUnitTests, CommonSubexpressionInSuccessors)
+{
+	Routine *routine = nullptr;
+
+	{
+		Function<Int(Int, Int, Int)> function;
+		{
+			Int a = function.Arg<0>();
+			Int b = function.Arg<1>();
+			Int c = function.Arg<2>();
+			Int x = a * b + 3;
+			Int r;
+
+			If(c > 0)
+			{
+				r = (a * b + 3) + x;
+			}
+			Else
+			{
+				r = (a * b + 3) - 1;
+			}
+
+			Return(r * 10 + x);
+		}
+
+		routine = function("one");
+
+		if(routine)
+		{
+			int (*callable)(int, int, int) = (int(*)(int,int,int))routine->getEntry();
+
+			EXPECT_EQ(callable(2, 5, 1), 273);
+			EXPECT_EQ(callable(2, 5, -1), 133);
+		}
+	}
+
+	delete routine;
+}
+
+TEST(ReactorUnitTests, LoadAfterIntrinsicStore)
+{
+	Routine *routine = nullptr;
+
+	{
+		Function<Void(Pointer<Byte>, Pointer<Int>, Int)> function;
+		{
+			Pointer<Byte> p = function.Arg<0>();
+			Pointer<Int> out = function.Arg<1>();
+			Int c = function.Arg<2>();
+
+			out[0] = *Pointer<Int>(p);
+			out[1] = *Pointer<Int>(p + 4);
+
+			// Narrow vectors are stored with an intrinsic, which must not be assumed to leave memory unchanged
+			*Pointer<Short4>(p) = Short4(5, 6, 7, 8);
+
+			out[2] = *Pointer<Int>(p);
+
+			If(c > 0)
+			{
+				out[3] = *Pointer<Int>(p + 4);
+			}
+
+			Return();
+		}
+
+		routine = function("one");
+
+		if(routine)
+		{
+			void (*callable)(void*, int*, int) = (void(*)(void*,int*,int))routine->getEntry();
+			int data[2] = {1, 2};
+			int out[4] = {0, 0, 0, 0};
+			callable(data, out, 1);
+
+			short stored[4] = {5, 6, 7, 8};
+			int expected[2];
+			memcpy(expected, stored, sizeof(expected));
+
+			EXPECT_EQ(out[0], 1);
+			EXPECT_EQ(out[1], 2);
+			EXPECT_EQ(out[2], expected[0]);
+			EXPECT_EQ(out[3], expected[1]);
+		}
+	}
+
+	delete routine;
+}
+
+TEST(ReactorUnitTests, CodeAllocation)
+{
+	const size_t bytes = 100;
+	uint8_t *code = static_cast<uint8_t*>(allocateCode(bytes));
+	ASSERT_NE(code, nullptr);
+
+	for(size_t i = 0; i < bytes; i++)
+	{
+		code[i] = static_cast<uint8_t>(i);
+	}
+
+	markCodeExecutable(code, bytes);
+
+	// The executable view maps the same memory
+	const void *executable = getExecutableAddress(code);
+	EXPECT_EQ(memcmp(executable, code, bytes), 0);
+
+	deallocateCode(code, bytes);
+}
+
+TEST(ReactorUnitTests, CodeReuse)
+{
+	const size_t bytes = 1000;
+	void *code = allocateCode(bytes);
+	ASSERT_NE(code, nullptr);
+
+	bool codeHeap = (getExecutableAddress(code) != code);
+	deallocateCode(code, bytes);
+
+	if(codeHeap)   // Separately mapped code isn't reused
+	{
+		// Freeing the block restored the free space it was taken from
+		void *reused = allocateCode(bytes);
+		EXPECT_EQ(reused, code);
+		deallocateCode(reused, bytes);
+	}
+}
+
+TEST(ReactorUnitTests, CodeCoalescing)
+{
+	const size_t bytes = 1024 * 1024;
+	void *first = allocateCode(bytes);
+	void *second = allocateCode(bytes);
+	ASSERT_NE(first, nullptr);
+	ASSERT_NE(second, nullptr);
+
+	bool codeHeap = (getExecutableAddress(first) != first);
+	deallocateCode(second, bytes);
+	deallocateCode(first, bytes);
+
+	if(codeHeap)
+	{
+		// Only fits in the first block after it got merged with the second one and the rest
+		void *merged = allocateCode(2 * bytes);
+		EXPECT_EQ(merged, first);
+		deallocateCode(merged, 2 * bytes);
+	}
+}
+
 template <typename T>
 class CToReactorCastTest : public ::testing::Test
 {
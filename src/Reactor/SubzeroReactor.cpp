@@ -55,16 +55,26 @@
 
 namespace
 {
-	Ice::GlobalContext *context = nullptr;
-	Ice::Cfg *function = nullptr;
-	Ice::CfgNode *basicBlock = nullptr;
-	Ice::CfgLocalAllocatorScope *allocator = nullptr;
-	rr::Routine *routine = nullptr;
-
-	std::mutex codegenMutex;
-
-	Ice::ELFFileStreamer *elfFile = nullptr;
-	Ice::Fdstream *out = nullptr;
+	// State of the Nucleus which is generating code on the current thread.
+	// Each Nucleus owns its own Subzero GlobalContext, so routines can be
+	// built concurrently on multiple threads.
+	thread_local Ice::GlobalContext *context = nullptr;
+	thread_local Ice::Cfg *function = nullptr;
+	thread_local Ice::CfgNode *basicBlock = nullptr;
+	thread_local Ice::CfgLocalAllocatorScope *allocator = nullptr;
+	thread_local rr::Routine *routine = nullptr;
+
+	// ELF image of the last routine acquired on this thread, before relocation
+	thread_local std::vector<uint8_t> routineObject;
+
+	thread_local Ice::ELFFileStreamer *elfFile = nullptr;
+	thread_local Ice::Fdstream *out = nullptr;
+
+	std::once_flag flagsInitialized;
+
+	// Constructing a GlobalContext performs Subzero's one-time initialization
+	// of thread-local storage keys and target register tables, which is not thread safe.
+	std::mutex contextCreationMutex;
 }
 
 namespace
@@ -199,6 +209,7 @@ namespace rr
 	}
 
 	Optimization optimization[10] = {InstructionCombining, Disabled};
+	bool tieredCompilation = false;   // Not supported, routines are always optimized
 
 	using ElfHeader = std::conditional<sizeof(void*) == 8, Elf64_Ehdr, Elf32_Ehdr>::type;
 	using SectionHeader = std::conditional<sizeof(void*) == 8, Elf64_Shdr, Elf32_Shdr>::type;
@@ -213,7 +224,7 @@ namespace rr
 		return &sectionHeader(elfHeader)[index];
 	}
 
-	static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocation, const SectionHeader &relocationTable)
+	static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocation, const SectionHeader &relocationTable, intptr_t executableOffset)
 	{
 		const SectionHeader *target = elfSection(elfHeader, relocationTable.sh_info);
 
@@ -240,7 +251,7 @@ namespace rr
 			if(section != SHN_UNDEF && section < SHN_LORESERVE)
 			{
 				const SectionHeader *target = elfSection(elfHeader, symbol.st_shndx);
-				symbolValue = reinterpret_cast<void*>((intptr_t)elfHeader + symbol.st_value + target->sh_offset);
+				symbolValue = reinterpret_cast<void*>((intptr_t)elfHeader + symbol.st_value + target->sh_offset + executableOffset);
 			}
 			else
 			{
@@ -298,7 +309,7 @@ namespace rr
 		return symbolValue;
 	}
 
-	static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &relocation, const SectionHeader &relocationTable)
+	static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &relocation, const SectionHeader &relocationTable, intptr_t executableOffset)
 	{
 		const SectionHeader *target = elfSection(elfHeader, relocationTable.sh_info);
 
@@ -325,7 +336,7 @@ namespace rr
 			if(section != SHN_UNDEF && section < SHN_LORESERVE)
 			{
 				const SectionHeader *target = elfSection(elfHeader, symbol.st_shndx);
-				symbolValue = reinterpret_cast<void*>((intptr_t)elfHeader + symbol.st_value + target->sh_offset);
+				symbolValue = reinterpret_cast<void*>((intptr_t)elfHeader + symbol.st_value + target->sh_offset + executableOffset);
 			}
 			else
 			{
@@ -346,7 +357,7 @@ namespace rr
 			*patchSite64 = (int64_t)((intptr_t)symbolValue + *patchSite64 + relocation.r_addend);
 			break;
 		case R_X86_64_PC32:
-			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 - (intptr_t)patchSite32 + relocation.r_addend);
+			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 - ((intptr_t)patchSite32 + executableOffset) + relocation.r_addend);
 			break;
 		case R_X86_64_32S:
 			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 + relocation.r_addend);
@@ -359,7 +370,8 @@ namespace rr
 		return symbolValue;
 	}
 
-	void *loadImage(uint8_t *const elfImage, size_t &codeSize)
+	// The image is written at elfImage, and runs executableOffset bytes further
+	void *loadImage(uint8_t *const elfImage, intptr_t executableOffset, size_t &codeSize)
 	{
 		ElfHeader *elfHeader = (ElfHeader*)elfImage;
 
@@ -393,7 +405,7 @@ namespace rr
 			{
 				if(sectionHeader[i].sh_flags & SHF_EXECINSTR)
 				{
-					entry = elfImage + sectionHeader[i].sh_offset;
+					entry = elfImage + sectionHeader[i].sh_offset + executableOffset;
 					codeSize = sectionHeader[i].sh_size;
 				}
 			}
@@ -404,7 +416,7 @@ namespace rr
 				for(Elf32_Word index = 0; index < sectionHeader[i].sh_size / sectionHeader[i].sh_entsize; index++)
 				{
 					const Elf32_Rel &relocation = ((const Elf32_Rel*)(elfImage + sectionHeader[i].sh_offset))[index];
-					relocateSymbol(elfHeader, relocation, sectionHeader[i]);
+					relocateSymbol(elfHeader, relocation, sectionHeader[i], executableOffset);
 				}
 			}
 			else if(sectionHeader[i].sh_type == SHT_RELA)
@@ -414,7 +426,7 @@ namespace rr
 				for(Elf32_Word index = 0; index < sectionHeader[i].sh_size / sectionHeader[i].sh_entsize; index++)
 				{
 					const Elf64_Rela &relocation = ((const Elf64_Rela*)(elfImage + sectionHeader[i].sh_offset))[index];
-					relocateSymbol(elfHeader, relocation, sectionHeader[i]);
+					relocateSymbol(elfHeader, relocation, sectionHeader[i], executableOffset);
 				}
 			}
 		}
@@ -433,12 +445,12 @@ namespace rr
 
 		T *allocate(size_type n)
 		{
-			return (T*)allocateExecutable(sizeof(T) * n);
+			return (T*)allocateCode(sizeof(T) * n);
 		}
 
 		void deallocate(T *p, size_type n)
 		{
-			deallocateExecutable(p, sizeof(T) * n);
+			deallocateCode(p, sizeof(T) * n);
 		}
 	};
 
@@ -454,17 +466,6 @@ namespace rr
 			buffer.reserve(0x1000);
 		}
 
-		~ELFMemoryStreamer() override
-		{
-			#if defined(_WIN32)
-				if(buffer.size() != 0)
-				{
-					DWORD exeProtection;
-					VirtualProtect(&buffer[0], buffer.size(), oldProtection, &exeProtection);
-				}
-			#endif
-		}
-
 		void write8(uint8_t Value) override
 		{
 			if(position == (uint64_t)buffer.size())
@@ -490,6 +491,9 @@ namespace rr
 
 		uint64_t tell() const override { return position; }
 
+		const uint8_t *data() const { return buffer.data(); }
+		size_t size() const { return buffer.size(); }
+
 		void seek(uint64_t Off) override { position = Off; }
 
 		const void *getEntry() override
@@ -498,16 +502,13 @@ namespace rr
 			{
 				position = std::numeric_limits<std::size_t>::max();   // Can't stream more data after this
 
+				// The image runs from the code heap's executable view of the buffer
+				intptr_t executableOffset = (intptr_t)getExecutableAddress(&buffer[0]) - (intptr_t)&buffer[0];
+
 				size_t codeSize = 0;
-				entry = loadImage(&buffer[0], codeSize);
+				entry = loadImage(&buffer[0], executableOffset, codeSize);
 
-				#if defined(_WIN32)
-					VirtualProtect(&buffer[0], buffer.size(), PAGE_EXECUTE_READ, &oldProtection);
-					FlushInstructionCache(GetCurrentProcess(), NULL, 0);
-				#else
-					mprotect(&buffer[0], buffer.size(), PROT_READ | PROT_EXEC);
-					__builtin___clear_cache((char*)entry, (char*)entry + codeSize);
-				#endif
+				markCodeExecutable(&buffer[0], buffer.size());
 			}
 
 			return entry;
@@ -517,38 +518,40 @@ namespace rr
 		void *entry;
 		std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
 		std::size_t position;
-
-		#if defined(_WIN32)
-		DWORD oldProtection;
-		#endif
 	};
 
 	Nucleus::Nucleus()
 	{
-		::codegenMutex.lock();   // Reactor is currently not thread safe
+		assert(!::context);   // Only one Nucleus can be active per thread
 
-		Ice::ClFlags &Flags = Ice::ClFlags::Flags;
-		Ice::ClFlags::getParsedClFlags(Flags);
+		// The flags are process-wide, and identical for all routines.
+		std::call_once(::flagsInitialized, []()
+		{
+			Ice::ClFlags &Flags = Ice::ClFlags::Flags;
+			Ice::ClFlags::getParsedClFlags(Flags);
 
-		#if defined(__arm__)
-			Flags.setTargetArch(Ice::Target_ARM32);
-			Flags.setTargetInstructionSet(Ice::ARM32InstructionSet_HWDivArm);
-		#elif defined(__mips__)
-			Flags.setTargetArch(Ice::Target_MIPS32);
-			Flags.setTargetInstructionSet(Ice::BaseInstructionSet);
-		#else   // x86
-			Flags.setTargetArch(sizeof(void*) == 8 ? Ice::Target_X8664 : Ice::Target_X8632);
-			Flags.setTargetInstructionSet(CPUID::SSE4_1 ? Ice::X86InstructionSet_SSE4_1 : Ice::X86InstructionSet_SSE2);
-		#endif
-		Flags.setOutFileType(Ice::FT_Elf);
-		Flags.setOptLevel(Ice::Opt_2);
-		Flags.setApplicationBinaryInterface(Ice::ABI_Platform);
-		Flags.setVerbose(false ? Ice::IceV_Most : Ice::IceV_None);
-		Flags.setDisableHybridAssembly(true);
+			#if defined(__arm__)
+				Flags.setTargetArch(Ice::Target_ARM32);
+				Flags.setTargetInstructionSet(Ice::ARM32InstructionSet_HWDivArm);
+			#elif defined(__mips__)
+				Flags.setTargetArch(Ice::Target_MIPS32);
+				Flags.setTargetInstructionSet(Ice::BaseInstructionSet);
+			#else   // x86
+				Flags.setTargetArch(sizeof(void*) == 8 ? Ice::Target_X8664 : Ice::Target_X8632);
+				Flags.setTargetInstructionSet(CPUID::SSE4_1 ? Ice::X86InstructionSet_SSE4_1 : Ice::X86InstructionSet_SSE2);
+			#endif
+			Flags.setOutFileType(Ice::FT_Elf);
+			Flags.setOptLevel(Ice::Opt_2);
+			Flags.setApplicationBinaryInterface(Ice::ABI_Platform);
+			Flags.setVerbose(false ? Ice::IceV_Most : Ice::IceV_None);
+			Flags.setDisableHybridAssembly(true);
+		});
 
 		static llvm::raw_os_ostream cout(std::cout);
 		static llvm::raw_os_ostream cerr(std::cerr);
 
+		std::unique_lock<std::mutex> lock(::contextCreationMutex);
+
 		if(false)   // Write out to a file
 		{
 			std::error_code errorCode;
@@ -575,10 +578,16 @@ namespace rr
 		delete ::elfFile;
 		delete ::out;
 
-		::codegenMutex.unlock();
+		::routine = nullptr;
+		::allocator = nullptr;
+		::function = nullptr;
+		::basicBlock = nullptr;
+		::context = nullptr;
+		::elfFile = nullptr;
+		::out = nullptr;
 	}
 
-	Routine *Nucleus::acquireRoutine(const char *name, bool runOptimizations)
+	Routine *Nucleus::acquireRoutine(const char *name, OptimizationProfile profile)
 	{
 		if(basicBlock->getInsts().empty() || basicBlock->getInsts().back().getKind() != Ice::Inst::Ret)
 		{
@@ -587,8 +596,10 @@ namespace rr
 
 		::function->setFunctionName(Ice::GlobalString::createWithString(::context, name));
 
-		optimize();
+		optimize(profile);
 
+		// The optimizer leaves values live across basic blocks, which liveness analysis needs the edges for
+		::function->computeInOutEdges();
 		::function->translate();
 		assert(!::function->hasError());
 
@@ -611,15 +622,50 @@ namespace rr
 		objectWriter->setUndefinedSyms(::context->getConstantExternSyms());
 		objectWriter->writeNonUserSections();
 
+		ELFMemoryStreamer *elfMemory = static_cast<ELFMemoryStreamer*>(::routine);
+
+		if(elfMemory)
+		{
+			::routineObject.assign(elfMemory->data(), elfMemory->data() + elfMemory->size());
+		}
+
 		Routine *handoffRoutine = ::routine;
 		::routine = nullptr;
 
 		return handoffRoutine;
 	}
 
-	void Nucleus::optimize()
+	bool Nucleus::getRoutineObject(RoutineObject &object)
+	{
+		if(::routineObject.empty())
+		{
+			return false;
+		}
+
+		object.entry.clear();   // The image has a single code section
+		object.code = ::routineObject;
+
+		return true;
+	}
+
+	Routine *Nucleus::loadRoutine(const RoutineObject &object)
+	{
+		ELFMemoryStreamer *routine = new ELFMemoryStreamer();
+		routine->writeBytes(llvm::StringRef(reinterpret_cast<const char*>(object.code.data()), object.code.size()));
+
+		if(!routine->getEntry())
+		{
+			delete routine;
+			return nullptr;
+		}
+
+		return routine;
+	}
+
+	void Nucleus::optimize(OptimizationProfile profile)
 	{
-		rr::optimize(::function);
+		// Subzero's own optimization level is process-wide
+		rr::optimize(::function, profile);
 	}
 
 	Value *Nucleus::allocateStackVariable(Type *t, int arraySize)
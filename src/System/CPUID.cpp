@@ -251,7 +251,6 @@ namespace sw
 		#endif
 
 		if(cores < 1)  cores = 1;
-		if(cores > 16) cores = 16;
 
 		return cores;   // FIXME: Number of physical cores
 	}
@@ -275,12 +274,22 @@ namespace sw
 
 				processAffinityMask >>= 1;
 			}
+		#elif defined(__linux__)
+			cpu_set_t affinity;
+
+			if(sched_getaffinity(0, sizeof(affinity), &affinity) == 0)
+			{
+				cores = CPU_COUNT(&affinity);
+			}
+			else
+			{
+				return detectCoreCount();
+			}
 		#else
 			return detectCoreCount();   // FIXME: Assumes no affinity limitation
 		#endif
 
 		if(cores < 1)  cores = 1;
-		if(cores > 16) cores = 16;
 
 		return cores;
 	}
@@ -14,8 +14,150 @@
 
 #include "Thread.hpp"
 
+#if defined(__linux__)
+	#include <stdio.h>
+	#include <vector>
+#endif
+
 namespace sw
 {
+#if defined(__linux__)
+	namespace
+	{
+		// Parses a sysfs list of CPUs or NUMA nodes, such as "0-7,16-23", into a set.
+		bool readList(const char *path, cpu_set_t *cpus)
+		{
+			FILE *file = fopen(path, "r");
+
+			if(!file)
+			{
+				return false;
+			}
+
+			CPU_ZERO(cpus);
+			bool any = false;
+			int first = 0;
+
+			while(fscanf(file, "%d", &first) == 1)
+			{
+				int last = first;
+				int c = fgetc(file);
+
+				if(c == '-')
+				{
+					if(fscanf(file, "%d", &last) != 1)
+					{
+						break;
+					}
+
+					c = fgetc(file);
+				}
+
+				for(int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+				{
+					CPU_SET(cpu, cpus);
+					any = true;
+				}
+
+				if(c != ',')
+				{
+					break;
+				}
+			}
+
+			fclose(file);
+
+			return any;
+		}
+
+		// Returns the processors of each NUMA node, restricted to the process affinity.
+		const std::vector<cpu_set_t> &numaNodes()
+		{
+			static const std::vector<cpu_set_t> nodes = []()
+			{
+				std::vector<cpu_set_t> nodes;
+
+				cpu_set_t affinity;
+				if(sched_getaffinity(0, sizeof(affinity), &affinity) != 0)
+				{
+					return nodes;
+				}
+
+				// Node numbers can have gaps, so only the online ones are enumerated
+				cpu_set_t online;
+				if(!readList("/sys/devices/system/node/online", &online))
+				{
+					return nodes;
+				}
+
+				for(int node = 0; node < CPU_SETSIZE; node++)
+				{
+					if(!CPU_ISSET(node, &online))
+					{
+						continue;
+					}
+
+					char path[64];
+					snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+					cpu_set_t cpus;
+					if(!readList(path, &cpus))
+					{
+						continue;
+					}
+
+					CPU_AND(&cpus, &cpus, &affinity);
+
+					if(CPU_COUNT(&cpus) > 0)
+					{
+						nodes.push_back(cpus);
+					}
+				}
+
+				return nodes;
+			}();
+
+			return nodes;
+		}
+	}
+#endif
+
+	int Thread::numaNodeCount()
+	{
+		#if defined(__linux__)
+			int count = static_cast<int>(numaNodes().size());
+			return (count > 0) ? count : 1;
+		#elif defined(_WIN32)
+			ULONG highestNode = 0;
+			if(!GetNumaHighestNodeNumber(&highestNode))
+			{
+				return 1;
+			}
+
+			return static_cast<int>(highestNode) + 1;
+		#else
+			return 1;
+		#endif
+	}
+
+	void Thread::setNumaNode(int node)
+	{
+		#if defined(__linux__)
+			const std::vector<cpu_set_t> &nodes = numaNodes();
+
+			if(node >= 0 && node < static_cast<int>(nodes.size()))
+			{
+				sched_setaffinity(0, sizeof(cpu_set_t), &nodes[node]);   // Affects the calling thread only
+			}
+		#elif defined(_WIN32)
+			GROUP_AFFINITY affinity = {};
+			if(GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) && affinity.Mask != 0)
+			{
+				SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+			}
+		#endif
+	}
+
 	Thread::Thread(void (*threadFunction)(void *parameters), void *parameters)
 	{
 		Event init;
@@ -59,6 +59,12 @@ namespace sw
 		static void yield();
 		static void sleep(int milliseconds);
 
+		// Number of NUMA nodes which the process can run on, or 1 when unknown.
+		static int numaNodeCount();
+
+		// Restricts the calling thread to the processors of the given NUMA node.
+		static void setNumaNode(int node);
+
 		#if defined(_WIN32)
 			typedef DWORD LocalStorageKey;
 		#else
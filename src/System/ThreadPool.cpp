@@ -0,0 +1,128 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ThreadPool.hpp"
+
+#include "CPUID.hpp"
+
+namespace sw
+{
+	ThreadPool::ThreadPool(int threadCount) : nextTask(0)
+	{
+		for(int thread = 1; thread < threadCount; thread++)
+		{
+			workers.emplace_back(&ThreadPool::workerLoop, this, thread);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			terminate = true;
+			workCondition.notify_all();
+		}
+
+		for(auto &worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	ThreadPool &ThreadPool::get()
+	{
+		static ThreadPool pool(CPUID::processAffinity());
+
+		return pool;
+	}
+
+	void ThreadPool::parallelFor(int count, const Task &task)
+	{
+		if(count <= 0)
+		{
+			return;
+		}
+
+		if(workers.empty() || count == 1)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				task(i, 0);
+			}
+
+			return;
+		}
+
+		std::unique_lock<std::mutex> submitLock(submitMutex);
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			this->task = &task;
+			taskCount = count;
+			nextTask = 0;
+			pendingWorkers = static_cast<int>(workers.size());
+			generation++;
+			workCondition.notify_all();
+		}
+
+		runTasks(0);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this] { return pendingWorkers == 0; });
+		this->task = nullptr;
+	}
+
+	void ThreadPool::workerLoop(int thread)
+	{
+		unsigned int seenGeneration = 0;
+
+		while(true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workCondition.wait(lock, [&] { return terminate || (generation != seenGeneration); });
+
+				if(terminate)
+				{
+					return;
+				}
+
+				seenGeneration = generation;
+			}
+
+			runTasks(thread);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			if(--pendingWorkers == 0)
+			{
+				doneCondition.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::runTasks(int thread)
+	{
+		while(true)
+		{
+			int index = nextTask++;
+
+			if(index >= taskCount)
+			{
+				break;
+			}
+
+			(*task)(index, thread);
+		}
+	}
+}
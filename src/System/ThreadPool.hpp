@@ -0,0 +1,68 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_ThreadPool_hpp
+#define sw_ThreadPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sw
+{
+	// ThreadPool runs batches of independent tasks on a fixed set of worker threads.
+	class ThreadPool
+	{
+	public:
+		// Task receives the index of the task in [0, count), and the index of the
+		// thread running it in [0, getThreadCount()), for per-thread scratch data.
+		using Task = std::function<void(int index, int thread)>;
+
+		explicit ThreadPool(int threadCount);
+		~ThreadPool();
+
+		// Runs task for every index in [0, count) and returns once they have all completed.
+		// The calling thread participates, as thread 0.
+		void parallelFor(int count, const Task &task);
+
+		// Number of threads executing tasks, including the calling thread.
+		int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+		// Process-wide pool, sized to the process affinity.
+		static ThreadPool &get();
+
+	private:
+		void workerLoop(int thread);
+		void runTasks(int thread);
+
+		std::vector<std::thread> workers;
+
+		std::mutex submitMutex;   // Serializes parallelFor() calls from different threads
+		std::mutex mutex;
+		std::condition_variable workCondition;
+		std::condition_variable doneCondition;
+		unsigned int generation = 0;
+		int pendingWorkers = 0;
+		bool terminate = false;
+
+		const Task *task = nullptr;
+		int taskCount = 0;
+		std::atomic<int> nextTask;
+	};
+}
+
+#endif   // sw_ThreadPool_hpp
@@ -15,6 +15,7 @@
 #include "VkBuffer.hpp"
 #include "VkConfig.h"
 #include "VkDeviceMemory.hpp"
+#include "Device/CopyEngine.hpp"
 
 #include <cstring>
 
@@ -76,14 +77,14 @@ void Buffer::copyFrom(const void* srcMemory, VkDeviceSize pSize, VkDeviceSize pO
 {
 	ASSERT((pSize + pOffset) <= size);
 
-	memcpy(getOffsetPointer(pOffset), srcMemory, pSize);
+	sw::CopyEngine::copy(getOffsetPointer(pOffset), srcMemory, pSize);
 }
 
 void Buffer::copyTo(void* dstMemory, VkDeviceSize pSize, VkDeviceSize pOffset) const
 {
 	ASSERT((pSize + pOffset) <= size);
 
-	memcpy(dstMemory, getOffsetPointer(pOffset), pSize);
+	sw::CopyEngine::copy(dstMemory, getOffsetPointer(pOffset), pSize);
 }
 
 void Buffer::copyTo(Buffer* dstBuffer, const VkBufferCopy& pRegion) const
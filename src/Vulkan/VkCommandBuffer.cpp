@@ -14,16 +14,19 @@
 
 #include "VkCommandBuffer.hpp"
 #include "VkBuffer.hpp"
+#include "VkCommandPool.hpp"
 #include "VkEvent.hpp"
 #include "VkFramebuffer.hpp"
 #include "VkImage.hpp"
 #include "VkImageView.hpp"
 #include "VkPipeline.hpp"
 #include "VkPipelineLayout.hpp"
+#include "VkQueryPool.hpp"
 #include "VkRenderPass.hpp"
 #include "Device/Renderer.hpp"
 
 #include <cstring>
+#include <type_traits>
 
 namespace vk
 {
@@ -33,25 +36,32 @@ class CommandBuffer::Command
 public:
 	// FIXME (b/119421344): change the commandBuffer argument to a CommandBuffer state
 	virtual void play(CommandBuffer::ExecutionState& executionState) = 0;
-	virtual ~Command() {}
+
+	// Called in recording order when a secondary command buffer is ended, on the recording
+	// thread. Work which doesn't depend on the primary command buffer can be done here once,
+	// instead of each time the secondary command buffer is executed.
+	virtual void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) {}
+
+	Command* next = nullptr;
+
+protected:
+	// Commands live in the command buffer's chunks and are never destroyed individually.
+	~Command() = default;
+
+	static void* allocate(CommandBuffer& commandBuffer, size_t size, size_t alignment)
+	{
+		return commandBuffer.allocate(size, alignment);
+	}
 };
 
 class BeginRenderPass : public CommandBuffer::Command
 {
 public:
 	BeginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkRect2D renderArea,
-	                uint32_t clearValueCount, const VkClearValue* pClearValues) :
+	                uint32_t clearValueCount, const VkClearValue* clearValues) :
 		renderPass(Cast(renderPass)), framebuffer(Cast(framebuffer)), renderArea(renderArea),
-		clearValueCount(clearValueCount)
+		clearValueCount(clearValueCount), clearValues(clearValues)
 	{
-		// FIXME (b/119409619): use an allocator here so we can control all memory allocations
-		clearValues = new VkClearValue[clearValueCount];
-		memcpy(clearValues, pClearValues, clearValueCount * sizeof(VkClearValue));
-	}
-
-	~BeginRenderPass() override
-	{
-		delete [] clearValues;
 	}
 
 protected:
@@ -68,7 +78,7 @@ private:
 	Framebuffer* framebuffer;
 	VkRect2D renderArea;
 	uint32_t clearValueCount;
-	VkClearValue* clearValues;
+	const VkClearValue* clearValues;  // Copy owned by the command buffer
 };
 
 class NextSubpass : public CommandBuffer::Command
@@ -81,6 +91,13 @@ public:
 protected:
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
+		// The next subpass may read the attachments as input attachments
+		if(executionState.renderPassFramebuffer->hasDeferredClears())
+		{
+			executionState.renderer->synchronize();
+			executionState.renderPassFramebuffer->resolveDeferredClears();
+		}
+
 		bool hasResolveAttachments = (executionState.renderPass->getCurrentSubpass().pResolveAttachments != nullptr);
 		if(hasResolveAttachments)
 		{
@@ -111,6 +128,9 @@ protected:
 		// This is somewhat heavier than the actual ordering required.
 		executionState.renderer->synchronize();
 
+		// Tiles which haven't been drawn to still have to receive their clear value
+		executionState.renderPassFramebuffer->resolveDeferredClears();
+
 		// FIXME(sugoi): remove the following line and resolve in Renderer::finishRendering()
 		//               for a Draw command or after the last command of the current subpass
 		//               which modifies pixels.
@@ -155,6 +175,11 @@ protected:
 		executionState.pipelines[pipelineBindPoint] = Cast(pipeline);
 	}
 
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		play(executionState);
+	}
+
 private:
 	VkPipelineBindPoint pipelineBindPoint;
 	VkPipeline pipeline;
@@ -163,7 +188,9 @@ private:
 class Dispatch : public CommandBuffer::Command
 {
 public:
-	Dispatch(uint32_t pGroupCountX, uint32_t pGroupCountY, uint32_t pGroupCountZ) :
+	Dispatch(uint32_t pBaseGroupX, uint32_t pBaseGroupY, uint32_t pBaseGroupZ,
+	         uint32_t pGroupCountX, uint32_t pGroupCountY, uint32_t pGroupCountZ) :
+			baseGroupX(pBaseGroupX), baseGroupY(pBaseGroupY), baseGroupZ(pBaseGroupZ),
 			groupCountX(pGroupCountX), groupCountY(pGroupCountY), groupCountZ(pGroupCountZ)
 	{
 	}
@@ -173,13 +200,17 @@ protected:
 	{
 		ComputePipeline* pipeline = static_cast<ComputePipeline*>(
 			executionState.pipelines[VK_PIPELINE_BIND_POINT_COMPUTE]);
-		pipeline->run(groupCountX, groupCountY, groupCountZ,
+		pipeline->run(baseGroupX, baseGroupY, baseGroupZ,
+			groupCountX, groupCountY, groupCountZ,
 			MAX_BOUND_DESCRIPTOR_SETS,
 			executionState.boundDescriptorSets[VK_PIPELINE_BIND_POINT_COMPUTE],
 			executionState.pushConstants);
 	}
 
 private:
+	uint32_t baseGroupX;
+	uint32_t baseGroupY;
+	uint32_t baseGroupZ;
 	uint32_t groupCountX;
 	uint32_t groupCountY;
 	uint32_t groupCountZ;
@@ -200,7 +231,7 @@ protected:
 
 		ComputePipeline* pipeline = static_cast<ComputePipeline*>(
 				executionState.pipelines[VK_PIPELINE_BIND_POINT_COMPUTE]);
-		pipeline->run(cmd->x, cmd->y, cmd->z,
+		pipeline->run(0, 0, 0, cmd->x, cmd->y, cmd->z,
 					  MAX_BOUND_DESCRIPTOR_SETS,
 					  executionState.boundDescriptorSets[VK_PIPELINE_BIND_POINT_COMPUTE],
 					  executionState.pushConstants);
@@ -223,6 +254,11 @@ struct VertexBufferBind : public CommandBuffer::Command
 		executionState.vertexInputBindings[binding] = { buffer, offset };
 	}
 
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		play(executionState);
+	}
+
 	uint32_t binding;
 	const VkBuffer buffer;
 	const VkDeviceSize offset;
@@ -242,6 +278,11 @@ struct IndexBufferBind : public CommandBuffer::Command
 		executionState.indexType = indexType;
 	}
 
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		play(executionState);
+	}
+
 	const VkBuffer buffer;
 	const VkDeviceSize offset;
 	const VkIndexType indexType;
@@ -294,6 +335,18 @@ void CommandBuffer::ExecutionState::bindAttachments()
 	}
 }
 
+// A draw with its state resolved from the bound pipeline and resources, which only
+// needs the current subpass's attachments to be executed.
+struct DrawPacket
+{
+	sw::Context context;
+	GraphicsPipeline* pipeline;
+	sw::DrawType drawType;
+	uint32_t primitiveCount;
+};
+
+static_assert(std::is_trivially_destructible<DrawPacket>::value, "Draw packets live in the command buffer's chunks");
+
 struct DrawBase : public CommandBuffer::Command
 {
 	int bytesPerIndex(CommandBuffer::ExecutionState const& executionState)
@@ -301,13 +354,10 @@ struct DrawBase : public CommandBuffer::Command
 		return executionState.indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4;
 	}
 
-	void draw(CommandBuffer::ExecutionState& executionState, bool indexed,
-			uint32_t count, uint32_t instanceCount, uint32_t first, int32_t vertexOffset, uint32_t firstInstance)
+	void bindResources(CommandBuffer::ExecutionState& executionState, DrawPacket& packet, bool indexed,
+			uint32_t first, int32_t vertexOffset, uint32_t firstInstance)
 	{
-		GraphicsPipeline* pipeline = static_cast<GraphicsPipeline*>(
-				executionState.pipelines[VK_PIPELINE_BIND_POINT_GRAPHICS]);
-
-		sw::Context context = pipeline->getContext();
+		sw::Context& context = packet.context;
 
 		executionState.bindVertexInputs(context, vertexOffset, firstInstance);
 
@@ -318,32 +368,69 @@ struct DrawBase : public CommandBuffer::Command
 		}
 
 		context.pushConstants = executionState.pushConstants;
-		auto drawType = context.drawType;
 
 		if (indexed)
 		{
 			context.indexBuffer = Cast(executionState.indexBufferBinding.buffer)->getOffsetPointer(
 					executionState.indexBufferBinding.offset + first * bytesPerIndex(executionState));
 
-			drawType = static_cast<sw::DrawType>(executionState.indexType == VK_INDEX_TYPE_UINT16
+			packet.drawType = static_cast<sw::DrawType>(executionState.indexType == VK_INDEX_TYPE_UINT16
 					   ? (context.drawType | sw::DRAW_INDEXED16) : (context.drawType | sw::DRAW_INDEXED32));
 		}
+	}
 
-		executionState.renderer->setContext(context);
-		executionState.renderer->setScissor(pipeline->getScissor());
-		executionState.renderer->setViewport(pipeline->getViewport());
-		executionState.renderer->setBlendConstant(pipeline->getBlendConstants());
+	void submit(CommandBuffer::ExecutionState& executionState, const DrawPacket& packet, uint32_t instanceCount, uint32_t firstInstance)
+	{
+		executionState.renderer->setContext(packet.context);
+		executionState.renderer->setScissor(packet.pipeline->getScissor());
+		executionState.renderer->setViewport(packet.pipeline->getViewport());
+		executionState.renderer->setBlendConstant(packet.pipeline->getBlendConstants());
 
 		executionState.bindAttachments();
 
-		const uint32_t primitiveCount = pipeline->computePrimitiveCount(count);
 		for(uint32_t instance = firstInstance; instance != firstInstance + instanceCount; instance++)
 		{
 			executionState.renderer->setInstanceID(instance);
-			executionState.renderer->draw(drawType, primitiveCount);
+			executionState.renderer->draw(packet.drawType, packet.primitiveCount);
 			executionState.renderer->advanceInstanceAttributes();
 		}
 	}
+
+	void draw(CommandBuffer::ExecutionState& executionState, bool indexed,
+			uint32_t count, uint32_t instanceCount, uint32_t first, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		GraphicsPipeline* pipeline = static_cast<GraphicsPipeline*>(
+				executionState.pipelines[VK_PIPELINE_BIND_POINT_GRAPHICS]);
+
+		const sw::Context& context = pipeline->getContext();
+		DrawPacket packet = { context, pipeline, context.drawType, pipeline->computePrimitiveCount(count) };
+
+		bindResources(executionState, packet, indexed, first, vertexOffset, firstInstance);
+		submit(executionState, packet, instanceCount, firstInstance);
+	}
+
+	// Secondary command buffers only inherit the render pass, so the draws they record can
+	// be resolved when they're ended, rather than each time they're executed.
+	const DrawPacket* bakeDraw(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer, bool indexed,
+			uint32_t count, uint32_t first, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		GraphicsPipeline* pipeline = static_cast<GraphicsPipeline*>(
+				executionState.pipelines[VK_PIPELINE_BIND_POINT_GRAPHICS]);
+
+		void* memory = pipeline ? allocate(commandBuffer, sizeof(DrawPacket), alignof(DrawPacket)) : nullptr;
+
+		if(!memory)
+		{
+			return nullptr;   // Resolved at execution instead
+		}
+
+		const sw::Context& context = pipeline->getContext();
+		DrawPacket* packet = new (memory) DrawPacket{ context, pipeline, context.drawType, pipeline->computePrimitiveCount(count) };
+
+		bindResources(executionState, *packet, indexed, first, vertexOffset, firstInstance);
+
+		return packet;
+	}
 };
 
 struct Draw : public DrawBase
@@ -355,13 +442,26 @@ struct Draw : public DrawBase
 
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
-		draw(executionState, false, vertexCount, instanceCount, 0, firstVertex, firstInstance);
+		if(packet)
+		{
+			submit(executionState, *packet, instanceCount, firstInstance);
+		}
+		else
+		{
+			draw(executionState, false, vertexCount, instanceCount, 0, firstVertex, firstInstance);
+		}
+	}
+
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		packet = bakeDraw(executionState, commandBuffer, false, vertexCount, 0, firstVertex, firstInstance);
 	}
 
 	uint32_t vertexCount;
 	uint32_t instanceCount;
 	uint32_t firstVertex;
 	uint32_t firstInstance;
+	const DrawPacket* packet = nullptr;
 };
 
 struct DrawIndexed : public DrawBase
@@ -373,7 +473,19 @@ struct DrawIndexed : public DrawBase
 
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
-		draw(executionState, true, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+		if(packet)
+		{
+			submit(executionState, *packet, instanceCount, firstInstance);
+		}
+		else
+		{
+			draw(executionState, true, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+		}
+	}
+
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		packet = bakeDraw(executionState, commandBuffer, true, indexCount, firstIndex, vertexOffset, firstInstance);
 	}
 
 	uint32_t indexCount;
@@ -381,6 +493,7 @@ struct DrawIndexed : public DrawBase
 	uint32_t firstIndex;
 	int32_t vertexOffset;
 	uint32_t firstInstance;
+	const DrawPacket* packet = nullptr;
 };
 
 struct DrawIndirect : public DrawBase
@@ -520,21 +633,21 @@ private:
 
 struct UpdateBuffer : public CommandBuffer::Command
 {
-	UpdateBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize dataSize, const void* pData) :
-		dstBuffer(dstBuffer), dstOffset(dstOffset), dataSize(dataSize), pData(pData)
+	UpdateBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize dataSize, const uint8_t* data) :
+		dstBuffer(dstBuffer), dstOffset(dstOffset), dataSize(dataSize), data(data)
 	{
 	}
 
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
-		Cast(dstBuffer)->update(dstOffset, dataSize, pData);
+		Cast(dstBuffer)->update(dstOffset, dataSize, data);
 	}
 
 private:
 	VkBuffer dstBuffer;
 	VkDeviceSize dstOffset;
 	VkDeviceSize dataSize;
-	const void* pData;
+	const uint8_t* data;  // Copy owned by the command buffer
 };
 
 struct ClearColorImage : public CommandBuffer::Command
@@ -582,6 +695,13 @@ struct ClearAttachment : public CommandBuffer::Command
 
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
+		// Deferred clears are written by the draws in flight, and must precede the new clear
+		if(executionState.renderPassFramebuffer->hasDeferredClears())
+		{
+			executionState.renderer->synchronize();
+			executionState.renderPassFramebuffer->resolveDeferredClears();
+		}
+
 		executionState.renderPassFramebuffer->clear(executionState.renderPass, attachment, rect);
 	}
 
@@ -611,16 +731,35 @@ private:
 
 struct PipelineBarrier : public CommandBuffer::Command
 {
-	PipelineBarrier()
+	PipelineBarrier(VkPipelineStageFlags srcStageMask) : srcStageMask(srcStageMask)
 	{
 	}
 
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
-		// This is a very simple implementation that simply calls sw::Renderer::synchronize(),
-		// since the driver is free to move the source stage towards the bottom of the pipe
-		// and the target stage towards the top, so a full pipeline sync is spec compliant.
-		executionState.renderer->synchronize();
+		// Draws are the only commands still executing once they've been played, on the
+		// renderer's threads. Barriers which don't wait for any graphics stage, like the
+		// ones between transfers, let copies overlap with the rasterization in flight.
+		// Otherwise the driver is free to move the source stage towards the bottom of the
+		// pipe and the target stage towards the top, so a full pipeline sync is spec compliant.
+		const VkPipelineStageFlags renderingStages =
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+			VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+			VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
+			VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT |
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT |
+			VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT |
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		if(srcStageMask & renderingStages)
+		{
+			executionState.renderer->synchronize();
+		}
 
 		// Right now all buffers are read-only in drawcalls but a similar mechanism will be required once we support SSBOs.
 
@@ -628,6 +767,7 @@ struct PipelineBarrier : public CommandBuffer::Command
 	}
 
 private:
+	const VkPipelineStageFlags srcStageMask;
 };
 
 struct SignalEvent : public CommandBuffer::Command
@@ -698,6 +838,11 @@ struct BindDescriptorSet : public CommandBuffer::Command
 		executionState.boundDescriptorSets[pipelineBindPoint][set] = descriptorSet;
 	}
 
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		play(executionState);
+	}
+
 private:
 	VkPipelineBindPoint pipelineBindPoint;
 	uint32_t set;
@@ -720,27 +865,147 @@ struct SetPushConstants : public CommandBuffer::Command
 		memcpy(&executionState.pushConstants.data[offset], data, size);
 	}
 
+	void bake(CommandBuffer::ExecutionState& executionState, CommandBuffer& commandBuffer) override
+	{
+		play(executionState);
+	}
+
 private:
 	uint32_t offset;
 	uint32_t size;
 	unsigned char data[MAX_PUSH_CONSTANT_SIZE];
 };
 
-CommandBuffer::CommandBuffer(VkCommandBufferLevel pLevel) : level(pLevel)
+struct BeginQuery : public CommandBuffer::Command
+{
+	BeginQuery(VkQueryPool queryPool, uint32_t query, VkQueryControlFlags flags)
+		: queryPool(queryPool), query(query), flags(flags)
+	{
+	}
+
+	void play(CommandBuffer::ExecutionState& executionState) override
+	{
+		Cast(queryPool)->begin(query, flags, executionState.renderer);
+	}
+
+private:
+	VkQueryPool queryPool;
+	uint32_t query;
+	VkQueryControlFlags flags;
+};
+
+struct EndQuery : public CommandBuffer::Command
+{
+	EndQuery(VkQueryPool queryPool, uint32_t query)
+		: queryPool(queryPool), query(query)
+	{
+	}
+
+	void play(CommandBuffer::ExecutionState& executionState) override
+	{
+		Cast(queryPool)->end(query, executionState.renderer);
+	}
+
+private:
+	VkQueryPool queryPool;
+	uint32_t query;
+};
+
+struct ResetQueryPool : public CommandBuffer::Command
+{
+	ResetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+		: queryPool(queryPool), firstQuery(firstQuery), queryCount(queryCount)
+	{
+	}
+
+	void play(CommandBuffer::ExecutionState& executionState) override
+	{
+		Cast(queryPool)->reset(firstQuery, queryCount);
+	}
+
+private:
+	VkQueryPool queryPool;
+	uint32_t firstQuery;
+	uint32_t queryCount;
+};
+
+struct WriteTimeStamp : public CommandBuffer::Command
+{
+	WriteTimeStamp(VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+		: pipelineStage(pipelineStage), queryPool(queryPool), query(query)
+	{
+	}
+
+	void play(CommandBuffer::ExecutionState& executionState) override
+	{
+		if(pipelineStage != VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT)
+		{
+			// All later stages are only reached once previously submitted work completes
+			executionState.renderer->synchronize();
+		}
+
+		Cast(queryPool)->writeTimestamp(query);
+	}
+
+private:
+	VkPipelineStageFlagBits pipelineStage;
+	VkQueryPool queryPool;
+	uint32_t query;
+};
+
+struct CopyQueryPoolResults : public CommandBuffer::Command
+{
+	CopyQueryPoolResults(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount,
+	                     VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize stride, VkQueryResultFlags flags)
+		: queryPool(queryPool), firstQuery(firstQuery), queryCount(queryCount),
+		  dstBuffer(dstBuffer), dstOffset(dstOffset), stride(stride), flags(flags)
+	{
+	}
+
+	void play(CommandBuffer::ExecutionState& executionState) override
+	{
+		// Results of queries ended earlier in the queue are only available once their draws complete
+		executionState.renderer->synchronize();
+
+		Cast(queryPool)->getResults(firstQuery, queryCount, static_cast<size_t>(stride * queryCount),
+		                            Cast(dstBuffer)->getOffsetPointer(dstOffset), stride, flags);
+	}
+
+private:
+	VkQueryPool queryPool;
+	uint32_t firstQuery;
+	uint32_t queryCount;
+	VkBuffer dstBuffer;
+	VkDeviceSize dstOffset;
+	VkDeviceSize stride;
+	VkQueryResultFlags flags;
+};
+
+CommandBuffer::CommandBuffer(VkCommandBufferLevel pLevel, CommandPool* pPool) : level(pLevel), pool(pPool)
 {
-	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
-	commands = new std::vector<std::unique_ptr<Command> >();
 }
 
 void CommandBuffer::destroy(const VkAllocationCallbacks* pAllocator)
 {
-	delete commands;
+	resetState(true);
 }
 
-void CommandBuffer::resetState()
+void CommandBuffer::resetState(bool releaseResources)
 {
-	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
-	commands->clear();
+	// Commands are trivially destructible, so dropping them only takes rewinding
+	// the allocator, or handing the chunk list back to the pool as a whole.
+	if(releaseResources)
+	{
+		pool->releaseChunks(firstChunk, lastChunk);
+		firstChunk = nullptr;
+		lastChunk = nullptr;
+	}
+
+	currentChunk = firstChunk;
+	cursor = firstChunk ? firstChunk->begin() : nullptr;
+	firstCommand = nullptr;
+	lastCommand = nullptr;
+	outOfMemory = false;
 
 	state = INITIAL;
 }
@@ -758,8 +1023,8 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const VkCommandBu
 
 	if(state != INITIAL)
 	{
-		// Implicit reset
-		resetState();
+		// Implicit reset, which keeps the storage for reuse
+		resetState(false);
 	}
 
 	state = RECORDING;
@@ -771,24 +1036,124 @@ VkResult CommandBuffer::end()
 {
 	ASSERT(state == RECORDING);
 
+	if(level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+	{
+		bake();
+	}
+
+	if(outOfMemory)
+	{
+		state = INVALID;
+		return VK_ERROR_OUT_OF_HOST_MEMORY;
+	}
+
 	state = EXECUTABLE;
 
 	return VK_SUCCESS;
 }
 
-VkResult CommandBuffer::reset(VkCommandPoolResetFlags flags)
+void CommandBuffer::bake()
+{
+	// Only the state set by the secondary command buffer's own commands is known here
+	ExecutionState executionState;
+
+	for(Command* command = firstCommand; command; command = command->next)
+	{
+		command->bake(executionState, *this);
+	}
+}
+
+VkResult CommandBuffer::reset(VkCommandBufferResetFlags flags)
 {
 	ASSERT(state != PENDING);
 
-	resetState();
+	resetState((flags & VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT) != 0);
 
 	return VK_SUCCESS;
 }
 
+void* CommandBuffer::allocate(size_t size, size_t alignment)
+{
+	uint8_t* data = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1));
+
+	if(!currentChunk || (data + size > currentChunk->end()))
+	{
+		// Reuse the storage retained from previous recordings before asking the pool for more.
+		CommandChunk* chunk = currentChunk ? currentChunk->next : firstChunk;
+
+		if(!chunk || (chunk->size < size + alignment))
+		{
+			chunk = pool->acquireChunk(size + alignment);
+
+			if(!chunk)
+			{
+				outOfMemory = true;
+				return nullptr;
+			}
+
+			if(currentChunk)
+			{
+				chunk->next = currentChunk->next;
+				currentChunk->next = chunk;
+			}
+			else
+			{
+				chunk->next = firstChunk;
+				firstChunk = chunk;
+			}
+
+			if(!chunk->next)
+			{
+				lastChunk = chunk;
+			}
+		}
+
+		currentChunk = chunk;
+		data = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(chunk->begin()) + alignment - 1) & ~(alignment - 1));
+	}
+
+	cursor = data + size;
+
+	return data;
+}
+
+template<typename T>
+T* CommandBuffer::copy(const T* data, size_t count)
+{
+	T* copy = reinterpret_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+
+	if(copy)
+	{
+		memcpy(copy, data, count * sizeof(T));
+	}
+
+	return copy;
+}
+
 template<typename T, typename... Args>
 void CommandBuffer::addCommand(Args&&... args)
 {
-	commands->push_back(std::unique_ptr<T>(new T(std::forward<Args>(args)...)));
+	static_assert(std::is_trivially_destructible<T>::value, "Commands are never destroyed individually");
+
+	void* memory = allocate(sizeof(T), alignof(T));
+
+	if(!memory)
+	{
+		return;
+	}
+
+	T* command = new (memory) T(std::forward<Args>(args)...);
+
+	if(lastCommand)
+	{
+		lastCommand->next = command;
+	}
+	else
+	{
+		firstCommand = command;
+	}
+
+	lastCommand = command;
 }
 
 void CommandBuffer::beginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkRect2D renderArea,
@@ -796,7 +1161,7 @@ void CommandBuffer::beginRenderPass(VkRenderPass renderPass, VkFramebuffer frame
 {
 	ASSERT(state == RECORDING);
 
-	addCommand<BeginRenderPass>(renderPass, framebuffer, renderArea, clearValueCount, clearValues);
+	addCommand<BeginRenderPass>(renderPass, framebuffer, renderArea, clearValueCount, copy(clearValues, clearValueCount));
 }
 
 void CommandBuffer::nextSubpass(VkSubpassContents contents)
@@ -829,7 +1194,7 @@ void CommandBuffer::setDeviceMask(uint32_t deviceMask)
 void CommandBuffer::dispatchBase(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
                                  uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
-	UNIMPLEMENTED("dispatchBase");
+	addCommand<Dispatch>(baseGroupX, baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ);
 }
 
 void CommandBuffer::pipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
@@ -838,7 +1203,7 @@ void CommandBuffer::pipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelin
                                     uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers,
                                     uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers)
 {
-	addCommand<PipelineBarrier>();
+	addCommand<PipelineBarrier>(srcStageMask);
 }
 
 void CommandBuffer::bindPipeline(VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
@@ -865,28 +1230,38 @@ void CommandBuffer::bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCou
 
 void CommandBuffer::beginQuery(VkQueryPool queryPool, uint32_t query, VkQueryControlFlags flags)
 {
-	UNIMPLEMENTED("beginQuery");
+	ASSERT(state == RECORDING);
+
+	addCommand<BeginQuery>(queryPool, query, flags);
 }
 
 void CommandBuffer::endQuery(VkQueryPool queryPool, uint32_t query)
 {
-	UNIMPLEMENTED("endQuery");
+	ASSERT(state == RECORDING);
+
+	addCommand<EndQuery>(queryPool, query);
 }
 
 void CommandBuffer::resetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
 {
-	UNIMPLEMENTED("resetQueryPool");
+	ASSERT(state == RECORDING);
+
+	addCommand<ResetQueryPool>(queryPool, firstQuery, queryCount);
 }
 
 void CommandBuffer::writeTimestamp(VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
 {
-	UNIMPLEMENTED("writeTimestamp");
+	ASSERT(state == RECORDING);
+
+	addCommand<WriteTimeStamp>(pipelineStage, queryPool, query);
 }
 
 void CommandBuffer::copyQueryPoolResults(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount,
 	VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize stride, VkQueryResultFlags flags)
 {
-	UNIMPLEMENTED("copyQueryPoolResults");
+	ASSERT(state == RECORDING);
+
+	addCommand<CopyQueryPoolResults>(queryPool, firstQuery, queryCount, dstBuffer, dstOffset, stride, flags);
 }
 
 void CommandBuffer::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags,
@@ -1002,7 +1377,7 @@ void CommandBuffer::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkInde
 
 void CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
-	addCommand<Dispatch>(groupCountX, groupCountY, groupCountZ);
+	addCommand<Dispatch>(0, 0, 0, groupCountX, groupCountY, groupCountZ);
 }
 
 void CommandBuffer::dispatchIndirect(VkBuffer buffer, VkDeviceSize offset)
@@ -1077,7 +1452,9 @@ void CommandBuffer::updateBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkD
 {
 	ASSERT(state == RECORDING);
 
-	addCommand<UpdateBuffer>(dstBuffer, dstOffset, dataSize, pData);
+	// The application may free pData as soon as vkCmdUpdateBuffer() returns, and the
+	// command only executes on the queue thread at submit time, so keep a copy.
+	addCommand<UpdateBuffer>(dstBuffer, dstOffset, dataSize, copy(static_cast<const uint8_t*>(pData), dataSize));
 }
 
 void CommandBuffer::fillBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
@@ -1184,7 +1561,7 @@ void CommandBuffer::submit(CommandBuffer::ExecutionState& executionState)
 	// Perform recorded work
 	state = PENDING;
 
-	for(auto& command : *commands)
+	for(Command* command = firstCommand; command; command = command->next)
 	{
 		command->play(executionState);
 	}
@@ -1195,7 +1572,7 @@ void CommandBuffer::submit(CommandBuffer::ExecutionState& executionState)
 
 void CommandBuffer::submitSecondary(CommandBuffer::ExecutionState& executionState) const
 {
-	for(auto& command : *commands)
+	for(Command* command = firstCommand; command; command = command->next)
 	{
 		command->play(executionState);
 	}
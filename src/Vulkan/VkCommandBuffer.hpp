@@ -18,8 +18,6 @@
 #include "VkConfig.h"
 #include "VkObject.hpp"
 #include "Device/Context.hpp"
-#include <memory>
-#include <vector>
 
 namespace sw
 {
@@ -30,6 +28,8 @@ namespace sw
 namespace vk
 {
 
+struct CommandChunk;
+class CommandPool;
 class Framebuffer;
 class Pipeline;
 class RenderPass;
@@ -39,13 +39,13 @@ class CommandBuffer
 public:
 	static constexpr VkSystemAllocationScope GetAllocationScope() { return VK_SYSTEM_ALLOCATION_SCOPE_OBJECT; }
 
-	CommandBuffer(VkCommandBufferLevel pLevel);
+	CommandBuffer(VkCommandBufferLevel pLevel, CommandPool* pPool);
 
 	void destroy(const VkAllocationCallbacks* pAllocator);
 
 	VkResult begin(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo* pInheritanceInfo);
 	VkResult end();
-	VkResult reset(VkCommandPoolResetFlags flags);
+	VkResult reset(VkCommandBufferResetFlags flags);
 
 	void beginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkRect2D renderArea,
 	                     uint32_t clearValueCount, const VkClearValue* pClearValues, VkSubpassContents contents);
@@ -148,15 +148,27 @@ public:
 
 	class Command;
 private:
-	void resetState();
+	void resetState(bool releaseResources);
+	void bake();
 	template<typename T, typename... Args> void addCommand(Args&&... args);
+	void* allocate(size_t size, size_t alignment);
+	template<typename T> T* copy(const T* data, size_t count);
 
 	enum State { INITIAL, RECORDING, EXECUTABLE, PENDING, INVALID };
 	State state = INITIAL;
 	VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
-	std::vector<std::unique_ptr<Command>>* commands;
+	// Commands, and any data they reference, are bump-allocated from a list of chunks
+	// obtained from the command pool. They are linked in recording order, and must be
+	// trivially destructible so the storage can be recycled without visiting them.
+	CommandPool* pool;
+	CommandChunk* firstChunk = nullptr;
+	CommandChunk* lastChunk = nullptr;
+	CommandChunk* currentChunk = nullptr;
+	uint8_t* cursor = nullptr;
+	Command* firstCommand = nullptr;
+	Command* lastCommand = nullptr;
+	bool outOfMemory = false;
 };
 
 using DispatchableCommandBuffer = DispatchableObject<CommandBuffer, VkCommandBuffer>;
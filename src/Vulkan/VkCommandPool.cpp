@@ -14,7 +14,9 @@
 
 #include "VkCommandPool.hpp"
 #include "VkCommandBuffer.hpp"
+#include "VkConfig.h"
 #include "VkDestroy.h"
+#include "VkMemory.h"
 #include <algorithm>
 
 namespace vk
@@ -36,6 +38,8 @@ void CommandPool::destroy(const VkAllocationCallbacks* pAllocator)
 
 	// FIXME (b/119409619): use an allocator here so we can control all memory allocations
 	delete commandBuffers;
+
+	freeChunks();
 }
 
 size_t CommandPool::ComputeRequiredAllocationSize(const VkCommandPoolCreateInfo* pCreateInfo)
@@ -47,7 +51,7 @@ VkResult CommandPool::allocateCommandBuffers(VkCommandBufferLevel level, uint32_
 {
 	for(uint32_t i = 0; i < commandBufferCount; i++)
 	{
-		DispatchableCommandBuffer* commandBuffer = new (DEVICE_MEMORY) DispatchableCommandBuffer(level);
+		DispatchableCommandBuffer* commandBuffer = new (DEVICE_MEMORY) DispatchableCommandBuffer(level, this);
 		if(commandBuffer)
 		{
 			pCommandBuffers[i] = *commandBuffer;
@@ -85,23 +89,69 @@ VkResult CommandPool::reset(VkCommandPoolResetFlags flags)
 	// According the Vulkan 1.1 spec:
 	// "All command buffers that have been allocated from
 	//  the command pool are put in the initial state."
+	// "Resetting a command pool recycles all of the
+	//  resources from all of the command buffers allocated
+	//  from the command pool back to the command pool."
+	// Each command buffer returns its whole chunk list in constant time.
 	for(auto commandBuffer : *commandBuffers)
 	{
-		Cast(commandBuffer)->reset(flags);
+		Cast(commandBuffer)->reset(VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
 	}
 
-	// According the Vulkan 1.1 spec:
-	// "Resetting a command pool recycles all of the
-	//  resources from all of the command buffers allocated
-	//  from the command pool back to the command pool."
-	commandBuffers->clear();
+	if(flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT)
+	{
+		freeChunks();
+	}
 
 	return VK_SUCCESS;
 }
 
 void CommandPool::trim(VkCommandPoolTrimFlags flags)
 {
-	// TODO (b/119827933): Optimize memory usage here
+	// Recycled command storage is the only memory the pool holds on to.
+	freeChunks();
+}
+
+CommandChunk* CommandPool::acquireChunk(size_t minSize)
+{
+	if(freeList && (freeList->size >= minSize))
+	{
+		CommandChunk* chunk = freeList;
+		freeList = chunk->next;
+		chunk->next = nullptr;
+		return chunk;
+	}
+
+	size_t size = std::max(minSize, static_cast<size_t>(COMMAND_CHUNK_SIZE));
+	CommandChunk* chunk = reinterpret_cast<CommandChunk*>(
+		vk::allocate(sizeof(CommandChunk) + size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY));
+
+	if(chunk)
+	{
+		chunk->next = nullptr;
+		chunk->size = size;
+	}
+
+	return chunk;
+}
+
+void CommandPool::releaseChunks(CommandChunk* first, CommandChunk* last)
+{
+	if(first)
+	{
+		last->next = freeList;
+		freeList = first;
+	}
+}
+
+void CommandPool::freeChunks()
+{
+	while(freeList)
+	{
+		CommandChunk* next = freeList->next;
+		vk::deallocate(freeList, DEVICE_MEMORY);
+		freeList = next;
+	}
 }
 
 } // namespace vk
@@ -21,6 +21,17 @@
 namespace vk
 {
 
+// Block of memory from which a command buffer sub-allocates its recorded commands.
+// The command data immediately follows this header.
+struct CommandChunk
+{
+	CommandChunk* next;
+	size_t size;  // Capacity of the data following the header, in bytes
+
+	uint8_t* begin() { return reinterpret_cast<uint8_t*>(this + 1); }
+	uint8_t* end() { return begin() + size; }
+};
+
 class CommandPool : public Object<CommandPool, VkCommandPool>
 {
 public:
@@ -35,8 +46,17 @@ public:
 	VkResult reset(VkCommandPoolResetFlags flags);
 	void trim(VkCommandPoolTrimFlags flags);
 
+	// Command buffers obtain their storage from the pool, and hand it back on reset or
+	// destruction. Recycled chunks are kept on a free list until the pool is trimmed,
+	// reset with VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT, or destroyed.
+	CommandChunk* acquireChunk(size_t minSize);
+	void releaseChunks(CommandChunk* first, CommandChunk* last);
+
 private:
+	void freeChunks();
+
 	std::set<VkCommandBuffer>* commandBuffers;
+	CommandChunk* freeList = nullptr;
 };
 
 static inline CommandPool* Cast(VkCommandPool object)
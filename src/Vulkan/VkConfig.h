@@ -65,6 +65,19 @@ enum
 	MAX_POINT_SIZE = 1,		// Large points are not supported. If/when we turn this on, must be >= 64.
 };
 
+enum
+{
+	COMMAND_CHUNK_SIZE = 64 * 1024, // Default size of the blocks command buffers record into
+};
+
 }
 
+// Device memory is backed by memfd_create() file descriptors, which can be
+// exported and imported through VK_KHR_external_memory_fd.
+#if defined(__linux__)
+#define SWIFTSHADER_EXTERNAL_MEMORY_FD 1
+#else
+#define SWIFTSHADER_EXTERNAL_MEMORY_FD 0
+#endif
+
 #endif // VK_CONFIG_HPP_
@@ -14,15 +14,17 @@
 
 #include "VkDescriptorPool.hpp"
 #include "VkDescriptorSetLayout.hpp"
+
 #include <algorithm>
-#include <memory>
+#include <iterator>
 
 namespace vk
 {
 
 DescriptorPool::DescriptorPool(const VkDescriptorPoolCreateInfo* pCreateInfo, void* mem) :
-	pool(reinterpret_cast<VkDescriptorSet>(mem)),
-	poolSize(ComputeRequiredAllocationSize(pCreateInfo))
+	pool(reinterpret_cast<uint8_t*>(mem)),
+	poolSize(ComputeRequiredAllocationSize(pCreateInfo)),
+	freeable((pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) != 0)
 {
 }
 
@@ -42,170 +44,222 @@ size_t DescriptorPool::ComputeRequiredAllocationSize(const VkDescriptorPoolCreat
 		         DescriptorSetLayout::GetDescriptorSize(pCreateInfo->pPoolSizes[i].type));
 	}
 
+	if(pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+	{
+		size += pCreateInfo->maxSets * sizeof(SetHeader);
+	}
+
 	return size;
 }
 
 VkResult DescriptorPool::allocateSets(uint32_t descriptorSetCount, const VkDescriptorSetLayout* pSetLayouts, VkDescriptorSet* pDescriptorSets)
 {
-	std::unique_ptr<size_t[]> layoutSizes(new size_t[descriptorSetCount]);
+	size_t totalSize = 0;
+	size_t startOffset = offset;
+
 	for(uint32_t i = 0; i < descriptorSetCount; i++)
 	{
-		pDescriptorSets[i] = VK_NULL_HANDLE;
-		layoutSizes[i] = Cast(pSetLayouts[i])->getDescriptorSetAllocationSize();
+		totalSize += Cast(pSetLayouts[i])->getDescriptorSetAllocationSize() + (freeable ? sizeof(SetHeader) : 0);
 	}
 
-	VkResult result = allocateSets(&(layoutSizes[0]), descriptorSetCount, pDescriptorSets);
-	if(result == VK_SUCCESS)
+	// Fragmentation only applies if all of the sets would fit in the memory still available
+	size_t available = (poolSize - offset) + freeSize;
+	VkResult failure = (freeable && (available >= totalSize)) ? VK_ERROR_FRAGMENTED_POOL : VK_ERROR_OUT_OF_POOL_MEMORY;
+
+	for(uint32_t i = 0; i < descriptorSetCount; i++)
 	{
-		for(uint32_t i = 0; i < descriptorSetCount; i++)
+		pDescriptorSets[i] = allocateSet(Cast(pSetLayouts[i])->getDescriptorSetAllocationSize());
+
+		if(pDescriptorSets[i] == VK_NULL_HANDLE)
 		{
-			Cast(pSetLayouts[i])->initialize(pDescriptorSets[i]);
+			// vkAllocateDescriptorSets can be used to create multiple descriptor sets. If the
+			// creation of any of those descriptor sets fails, then the implementation must
+			// destroy all successfully created descriptor set objects from this command, set
+			// all entries of the pDescriptorSets array to VK_NULL_HANDLE and return the error.
+			for(uint32_t j = 0; j < i; j++)
+			{
+				if(freeable)
+				{
+					freeSet(pDescriptorSets[j]);
+				}
+				else
+				{
+					setCount--;
+				}
+
+				pDescriptorSets[j] = VK_NULL_HANDLE;
+			}
+
+			if(!freeable)
+			{
+				offset = startOffset;
+			}
+
+			for(uint32_t j = i; j < descriptorSetCount; j++)
+			{
+				pDescriptorSets[j] = VK_NULL_HANDLE;
+			}
+
+			return failure;
 		}
 	}
-	return result;
+
+	for(uint32_t i = 0; i < descriptorSetCount; i++)
+	{
+		Cast(pSetLayouts[i])->initialize(pDescriptorSets[i]);
+	}
+
+	return VK_SUCCESS;
 }
 
-VkDescriptorSet DescriptorPool::findAvailableMemory(size_t size)
+VkDescriptorSet DescriptorPool::allocateSet(size_t size)
 {
-	if(nodes.empty())
+	if(!freeable)
 	{
-		return pool;
+		if(size > poolSize - offset)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		uint8_t* set = pool + offset;
+		offset += size;
+		setCount++;
+
+		return reinterpret_cast<VkDescriptorSet>(set);
 	}
 
-	// First, look for space at the end of the pool
-	const auto itLast = nodes.rbegin();
-	ptrdiff_t itemStart = reinterpret_cast<char*>(itLast->set) - reinterpret_cast<char*>(pool);
-	ptrdiff_t nextItemStart = itemStart + itLast->size;
-	size_t freeSpace = poolSize - nextItemStart;
-	if(freeSpace >= size)
+	uint8_t* set = nullptr;
+
+	// Sets are typically freed and reallocated with the same layouts, so the best fit is
+	// usually exact. Otherwise never allocated memory is used before splitting a free set.
+	uint8_t** freeSet = findFreeSet(size);
+	if(freeSet && (SetSize(*freeSet) == size))
 	{
-		return reinterpret_cast<VkDescriptorSet>(reinterpret_cast<char*>(pool) + nextItemStart);
+		set = *freeSet;
+		*freeSet = *reinterpret_cast<uint8_t**>(set);
+		freeSize -= size;
 	}
-
-	// Second, look for space at the beginning of the pool
-	const auto itBegin = nodes.end();
-	freeSpace = reinterpret_cast<char*>(itBegin->set) - reinterpret_cast<char*>(pool);
-	if(freeSpace >= size)
+	else if(sizeof(SetHeader) + size <= poolSize - offset)
 	{
-		return pool;
+		SetHeader* header = reinterpret_cast<SetHeader*>(pool + offset);
+		header->size = size;
+		set = reinterpret_cast<uint8_t*>(header + 1);
+		offset += sizeof(SetHeader) + size;
 	}
-
-	// Finally, look between existing pool items
-	const auto itEnd = nodes.end();
-	auto nextIt = itBegin;
-	++nextIt;
-	for(auto it = itBegin; nextIt != itEnd; ++it, ++nextIt)
+	else if(freeSet)
 	{
-		VkDescriptorSet freeSpaceStart = reinterpret_cast<VkDescriptorSet>(reinterpret_cast<char*>(it->set) + it->size);
-		freeSpace = reinterpret_cast<char*>(nextIt->set) - reinterpret_cast<char*>(freeSpaceStart);
-		if(freeSpace >= size)
+		// Carve the set out of a larger free one, returning what's left to the free lists
+		set = *freeSet;
+		*freeSet = *reinterpret_cast<uint8_t**>(set);
+
+		size_t freeSetSize = SetSize(set);
+		freeSize -= freeSetSize;
+
+		size_t remainder = freeSetSize - size;
+		if(remainder >= sizeof(SetHeader) + sizeof(DescriptorSet))
 		{
-			return freeSpaceStart;
+			reinterpret_cast<SetHeader*>(set)[-1].size = size;
+
+			SetHeader* header = reinterpret_cast<SetHeader*>(set + size);
+			header->size = remainder - sizeof(SetHeader);
+			addToFreeList(reinterpret_cast<uint8_t*>(header + 1), header->size);
 		}
 	}
+	else
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	setCount++;
 
-	return VK_NULL_HANDLE;
+	return reinterpret_cast<VkDescriptorSet>(set);
 }
 
-VkResult DescriptorPool::allocateSets(size_t* sizes, uint32_t numAllocs, VkDescriptorSet* pDescriptorSets)
+// Returns the link to the smallest free set of at least the given size, or nullptr
+uint8_t** DescriptorPool::findFreeSet(size_t size)
 {
-	size_t totalSize = 0;
-	for(uint32_t i = 0; i < numAllocs; i++)
-	{
-		totalSize += sizes[i];
-	}
+	uint8_t** best = nullptr;
 
-	if(totalSize > poolSize)
+	// Every set of a larger size class fits, so the search ends with the first class that has one
+	for(int i = SizeClass(size); (i < SIZE_CLASSES) && !best; i++)
 	{
-		return VK_ERROR_OUT_OF_POOL_MEMORY;
-	}
-
-	// Attempt to allocate single chunk of memory
-	{
-		VkDescriptorSet memory = findAvailableMemory(totalSize);
-		if(memory != VK_NULL_HANDLE)
+		for(uint8_t** link = &freeLists[i]; *link; link = reinterpret_cast<uint8_t**>(*link))
 		{
-			for(uint32_t i = 0; i < numAllocs; i++)
+			size_t freeSetSize = SetSize(*link);
+
+			if((freeSetSize >= size) && (!best || (freeSetSize < SetSize(*best))))
 			{
-				pDescriptorSets[i] = memory;
-				nodes.insert(Node(pDescriptorSets[i], sizes[i]));
-				memory = reinterpret_cast<VkDescriptorSet>(reinterpret_cast<char*>(memory) + sizes[i]);
-			}
+				best = link;
 
-			return VK_SUCCESS;
+				if(freeSetSize == size)
+				{
+					break;
+				}
+			}
 		}
 	}
 
-	// Atttempt to allocate each descriptor set separately
-	for(uint32_t i = 0; i < numAllocs; i++)
+	return best;
+}
+
+int DescriptorPool::SizeClass(size_t size)
+{
+	int sizeClass = 0;
+
+	while(size > 1)
 	{
-		pDescriptorSets[i] = findAvailableMemory(sizes[i]);
-		if(pDescriptorSets[i] == VK_NULL_HANDLE)
-		{
-			// vkAllocateDescriptorSets can be used to create multiple descriptor sets. If the
-			// creation of any of those descriptor sets fails, then the implementation must
-			// destroy all successfully created descriptor set objects from this command, set
-			// all entries of the pDescriptorSets array to VK_NULL_HANDLE and return the error.
-			for(uint32_t j = 0; j < i; j++)
-			{
-				freeSet(pDescriptorSets[j]);
-				pDescriptorSets[j] = VK_NULL_HANDLE;
-			}
-			return (computeTotalFreeSize() > totalSize) ? VK_ERROR_FRAGMENTED_POOL : VK_ERROR_OUT_OF_POOL_MEMORY;
-		}
-		nodes.insert(Node(pDescriptorSets[i], sizes[i]));
+		size >>= 1;
+		sizeClass++;
 	}
 
-	return VK_SUCCESS;
+	return sizeClass;
 }
 
 void DescriptorPool::freeSets(uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets)
 {
 	for(uint32_t i = 0; i < descriptorSetCount; i++)
 	{
-		freeSet(pDescriptorSets[i]);
+		if(pDescriptorSets[i] != VK_NULL_HANDLE)
+		{
+			freeSet(pDescriptorSets[i]);
+		}
 	}
 }
 
 void DescriptorPool::freeSet(const VkDescriptorSet descriptorSet)
 {
-	const auto itEnd = nodes.end();
-	auto it = std::find(nodes.begin(), itEnd, descriptorSet);
-	if(it != itEnd)
+	// vkFreeDescriptorSets requires VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+	ASSERT(freeable);
+
+	setCount--;
+
+	if(setCount == 0)
 	{
-		nodes.erase(it);
+		// Nothing is allocated anymore, which also undoes any fragmentation
+		reset();
+		return;
 	}
+
+	uint8_t* set = reinterpret_cast<uint8_t*>(descriptorSet);
+	addToFreeList(set, reinterpret_cast<SetHeader*>(set)[-1].size);
 }
 
-VkResult DescriptorPool::reset()
+void DescriptorPool::addToFreeList(uint8_t* set, size_t size)
 {
-	nodes.clear();
-
-	return VK_SUCCESS;
+	uint8_t*& head = freeLists[SizeClass(size)];
+	*reinterpret_cast<uint8_t**>(set) = head;
+	head = set;
+	freeSize += size;
 }
 
-size_t DescriptorPool::computeTotalFreeSize() const
+VkResult DescriptorPool::reset()
 {
-	size_t totalFreeSize = 0;
-
-	// Compute space at the end of the pool
-	const auto itLast = nodes.rbegin();
-	totalFreeSize += poolSize - ((reinterpret_cast<char*>(itLast->set) - reinterpret_cast<char*>(pool)) + itLast->size);
+	offset = 0;
+	setCount = 0;
+	freeSize = 0;
+	std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
 
-	// Compute space at the beginning of the pool
-	const auto itBegin = nodes.end();
-	totalFreeSize += reinterpret_cast<char*>(itBegin->set) - reinterpret_cast<char*>(pool);
-
-	// Finally, look between existing pool items
-	const auto itEnd = nodes.end();
-	auto nextIt = itBegin;
-	++nextIt;
-	for(auto it = itBegin; nextIt != itEnd; ++it, ++nextIt)
-	{
-		totalFreeSize += (reinterpret_cast<char*>(nextIt->set) - reinterpret_cast<char*>(it->set)) - it->size;
-	}
-
-	return totalFreeSize;
+	return VK_SUCCESS;
 }
 
-} // namespace vk
\ No newline at end of file
+} // namespace vk
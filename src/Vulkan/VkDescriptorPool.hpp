@@ -16,7 +16,6 @@
 #define VK_DESCRIPTOR_POOL_HPP_
 
 #include "VkObject.hpp"
-#include <set>
 
 namespace vk
 {
@@ -34,24 +33,32 @@ namespace vk
 		VkResult reset();
 
 	private:
-		VkResult allocateSets(size_t* sizes, uint32_t numAllocs, VkDescriptorSet* pDescriptorSets);
-		VkDescriptorSet findAvailableMemory(size_t size);
+		VkDescriptorSet allocateSet(size_t size);
 		void freeSet(const VkDescriptorSet descriptorSet);
-		size_t computeTotalFreeSize() const;
+		void addToFreeList(uint8_t* set, size_t size);
+		uint8_t** findFreeSet(size_t size);
 
-		struct Node
+		// Pools created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT precede each set
+		// with its size, so that freed sets can be recycled through free lists without depending
+		// on the set's layout still existing. Other pools only bump-allocate.
+		struct SetHeader
 		{
-			Node(VkDescriptorSet set, size_t size) : set(set), size(size) {}
-			bool operator<(const Node& node) const { return this->set < node.set; }
-			bool operator==(VkDescriptorSet set) const { return this->set == set; }
-
-			VkDescriptorSet set;
 			size_t size;
 		};
-		std::set<Node> nodes;
 
-		VkDescriptorSet pool = nullptr;
+		static size_t SetSize(const uint8_t* set) { return reinterpret_cast<const SetHeader*>(set)[-1].size; }
+		static int SizeClass(size_t size);
+
+		static constexpr int SIZE_CLASSES = sizeof(size_t) * 8;   // Sizes in [2^i, 2^(i+1))
+
+		uint8_t* pool = nullptr;
 		size_t poolSize = 0;
+		size_t offset = 0;           // Start of the never allocated part of the pool
+		const bool freeable;
+
+		uint8_t* freeLists[SIZE_CLASSES] = {};   // Freed sets by size class, linked through their first bytes
+		size_t freeSize = 0;         // Total size of the sets in the free lists
+		uint32_t setCount = 0;       // Number of allocated sets
 	};
 
 	static inline DescriptorPool* Cast(VkDescriptorPool object)
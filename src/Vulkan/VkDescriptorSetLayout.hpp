@@ -50,6 +50,8 @@ public:
 	size_t getDescriptorSetAllocationSize() const;
 
 	size_t getBindingOffset(uint32_t binding) const;
+	uint32_t getBindingCount() const { return bindingCount; }
+	const VkDescriptorSetLayoutBinding& getBinding(uint32_t index) const { return bindings[index]; }
 	uint8_t* getOffsetPointer(DescriptorSet *descriptorSet, uint32_t binding, uint32_t arrayElement, uint32_t count, size_t* typeSize) const;
 
 private:
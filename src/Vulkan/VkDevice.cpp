@@ -17,10 +17,13 @@
 #include "VkConfig.h"
 #include "VkDebug.hpp"
 #include "VkDescriptorSetLayout.hpp"
+#include "VkFence.hpp"
 #include "VkQueue.hpp"
 #include "Device/Blitter.hpp"
 
+#include <chrono>
 #include <new> // Must #include this to use "placement new"
+#include <thread>
 
 namespace vk
 {
@@ -85,9 +88,51 @@ VkQueue Device::getQueue(uint32_t queueFamilyIndex, uint32_t queueIndex) const
 	return queues[queueIndex];
 }
 
-void Device::waitForFences(uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout)
+VkResult Device::waitForFences(uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout)
 {
-	// FIXME(b/117835459) : noop
+	using time_point = std::chrono::steady_clock::time_point;
+
+	const time_point start = std::chrono::steady_clock::now();
+	const bool infiniteTimeout = (timeout > static_cast<uint64_t>(std::chrono::nanoseconds::max().count())) ||
+	                             (start > time_point::max() - std::chrono::nanoseconds(timeout));
+	const time_point deadline = infiniteTimeout ? time_point::max() : start + std::chrono::nanoseconds(timeout);
+
+	if(waitAll)
+	{
+		for(uint32_t i = 0; i < fenceCount; i++)
+		{
+			if(infiniteTimeout)
+			{
+				Cast(pFences[i])->wait();
+			}
+			else if(Cast(pFences[i])->wait(deadline) != VK_SUCCESS)
+			{
+				return VK_TIMEOUT;
+			}
+		}
+
+		return VK_SUCCESS;
+	}
+
+	// Wait for any of the fences. Fences have no common condition to block on,
+	// so poll them, yielding the processor between attempts.
+	while(true)
+	{
+		for(uint32_t i = 0; i < fenceCount; i++)
+		{
+			if(Cast(pFences[i])->getStatus() == VK_SUCCESS)
+			{
+				return VK_SUCCESS;
+			}
+		}
+
+		if(std::chrono::steady_clock::now() >= deadline)
+		{
+			return VK_TIMEOUT;
+		}
+
+		std::this_thread::yield();
+	}
 }
 
 void Device::waitIdle()
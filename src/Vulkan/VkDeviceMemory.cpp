@@ -16,17 +16,109 @@
 
 #include "VkConfig.h"
 
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#endif
+
 namespace vk
 {
 
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+namespace
+{
+
+// Creates an anonymous, shareable file. Returns -1 on failure.
+// Calls the system call directly, like ExecutableMemory.cpp, since older
+// libc versions lack a memfd_create() wrapper.
+int memfdCreate(const char* name)
+{
+	#ifdef __NR_memfd_create
+		const unsigned int MFD_CLOEXEC_FLAG = 0x0001U;
+		// Returns -1 with errno set to ENOSYS on kernels without memfd support.
+		return static_cast<int>(syscall(__NR_memfd_create, name, MFD_CLOEXEC_FLAG));
+	#else
+		return -1;
+	#endif
+}
+
+// Maps the whole file shared, so that writes are visible to all processes which
+// map the same file. Pages are only committed when first touched.
+void* mapFd(int fd, VkDeviceSize size)
+{
+	void* mapping = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	return (mapping == MAP_FAILED) ? nullptr : mapping;
+}
+
+} // anonymous namespace
+#endif
+
 DeviceMemory::DeviceMemory(const VkMemoryAllocateInfo* pCreateInfo, void* mem) :
 	size(pCreateInfo->allocationSize), memoryTypeIndex(pCreateInfo->memoryTypeIndex)
 {
 	ASSERT(size);
+
+	const VkBaseInStructure* extensionInfo = reinterpret_cast<const VkBaseInStructure*>(pCreateInfo->pNext);
+	while(extensionInfo)
+	{
+		switch(extensionInfo->sType)
+		{
+		case VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT:
+			{
+				const auto* importInfo = reinterpret_cast<const VkImportMemoryHostPointerInfoEXT*>(extensionInfo);
+				ASSERT(importInfo->handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT);
+				buffer = importInfo->pHostPointer;
+				hostPointer = true;
+			}
+			break;
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+		case VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR:
+			{
+				const auto* importInfo = reinterpret_cast<const VkImportMemoryFdInfoKHR*>(extensionInfo);
+				ASSERT(importInfo->handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT);
+				importFd = importInfo->fd;
+			}
+			break;
+		case VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO:
+			{
+				const auto* exportInfo = reinterpret_cast<const VkExportMemoryAllocateInfo*>(extensionInfo);
+				exportable = (exportInfo->handleTypes & VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT) != 0;
+			}
+			break;
+#endif
+		default:
+			break;
+		}
+
+		extensionInfo = extensionInfo->pNext;
+	}
 }
 
 void DeviceMemory::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	if(hostPointer)
+	{
+		return;
+	}
+
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+
+	if(mapped)
+	{
+		munmap(buffer, static_cast<size_t>(size));
+		return;
+	}
+#endif
+
 	vk::deallocate(buffer, DEVICE_MEMORY);
 }
 
@@ -38,6 +130,63 @@ size_t DeviceMemory::ComputeRequiredAllocationSize(const VkMemoryAllocateInfo* p
 
 VkResult DeviceMemory::allocate()
 {
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	if(!buffer && (importFd >= 0))
+	{
+		// The application keeps ownership of the file descriptor if the import fails.
+		struct stat fileStat;
+		if((fstat(importFd, &fileStat) != 0) || (static_cast<VkDeviceSize>(fileStat.st_size) < size))
+		{
+			return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+		}
+
+		buffer = mapFd(importFd, size);
+		if(!buffer)
+		{
+			return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+		}
+
+		mapped = true;
+		fd = importFd;
+		importFd = -1;
+	}
+
+	if(!buffer)
+	{
+		// memfd pages are zero-filled on first access, so unlike vk::allocate()
+		// nothing is committed up front.
+		int memfd = memfdCreate("SwiftShader DeviceMemory");
+		if(memfd >= 0)
+		{
+			if(ftruncate(memfd, static_cast<off_t>(size)) == 0)
+			{
+				buffer = mapFd(memfd, size);
+			}
+
+			mapped = (buffer != nullptr);
+			fd = mapped ? memfd : -1;
+
+			if(!mapped)
+			{
+				close(memfd);
+			}
+		}
+
+		// Only memory exported as a file has to be backed by one
+		if(!buffer && exportable)
+		{
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		}
+	}
+
+	// The mapping keeps the memory alive, so the file is only needed for exporting it
+	if(!exportable && (fd >= 0))
+	{
+		close(fd);
+		fd = -1;
+	}
+#endif
+
 	if(!buffer)
 	{
 		buffer = vk::allocate(size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY);
@@ -60,6 +209,35 @@ VkResult DeviceMemory::map(VkDeviceSize pOffset, VkDeviceSize pSize, void** ppDa
 
 VkDeviceSize DeviceMemory::getCommittedMemoryInBytes() const
 {
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	if(mapped)
+	{
+		// Only count the pages which have been touched so far, a chunk of pages at a time
+		const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t pageCount = (static_cast<size_t>(size) + pageSize - 1) / pageSize;
+		unsigned char residency[256];
+		VkDeviceSize committed = 0;
+
+		for(size_t page = 0; page < pageCount; page += sizeof(residency))
+		{
+			size_t chunkPages = std::min(pageCount - page, sizeof(residency));
+			char* chunk = reinterpret_cast<char*>(buffer) + page * pageSize;
+
+			if(mincore(chunk, chunkPages * pageSize, residency) != 0)
+			{
+				return size;
+			}
+
+			for(size_t i = 0; i < chunkPages; i++)
+			{
+				committed += (residency[i] & 1) ? pageSize : 0;
+			}
+		}
+
+		return (committed < size) ? committed : size;
+	}
+#endif
+
 	return size;
 }
 
@@ -70,4 +248,17 @@ void* DeviceMemory::getOffsetPointer(VkDeviceSize pOffset)
 	return reinterpret_cast<char*>(buffer) + pOffset;
 }
 
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+VkResult DeviceMemory::exportFd(int* pFd) const
+{
+	// Exportable allocations fail rather than be created without a file
+	ASSERT(exportable && (fd >= 0));
+
+	// Each export yields a new file descriptor, owned by the caller
+	*pFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+	return (*pFd >= 0) ? VK_SUCCESS : VK_ERROR_OUT_OF_HOST_MEMORY;
+}
+#endif
+
 } // namespace vk
@@ -34,11 +34,21 @@ public:
 	VkDeviceSize getCommittedMemoryInBytes() const;
 	void* getOffsetPointer(VkDeviceSize pOffset);
 	uint32_t getMemoryTypeIndex() const { return memoryTypeIndex; }
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	VkResult exportFd(int* pFd) const;
+#endif
 
 private:
 	void*        buffer = nullptr;
 	VkDeviceSize size = 0;
 	uint32_t     memoryTypeIndex = 0;
+	bool         hostPointer = false;  // buffer is owned by whoever imported it
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	bool         mapped = false;      // buffer is a file mapping rather than from vk::allocate()
+	bool         exportable = false;  // The file stays open for vkGetMemoryFdKHR()
+	int          fd = -1;             // Backing file, only kept open when exportable
+	int          importFd = -1;       // Imported file descriptor, owned by this object once allocate() succeeds
+#endif
 };
 
 static inline DeviceMemory* Cast(VkDeviceMemory object)
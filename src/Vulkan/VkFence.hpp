@@ -17,6 +17,10 @@
 
 #include "VkObject.hpp"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 namespace vk
 {
 
@@ -24,7 +28,7 @@ class Fence : public Object<Fence, VkFence>
 {
 public:
 	Fence(const VkFenceCreateInfo* pCreateInfo, void* mem) :
-		status((pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) ? VK_SUCCESS : VK_NOT_READY)
+		signaled((pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0)
 	{
 	}
 
@@ -37,21 +41,40 @@ public:
 
 	void signal()
 	{
-		status = VK_SUCCESS;
+		std::unique_lock<std::mutex> lock(mutex);
+		signaled = true;
+		condition.notify_all();
 	}
 
 	void reset()
 	{
-		status = VK_NOT_READY;
+		std::unique_lock<std::mutex> lock(mutex);
+		signaled = false;
+	}
+
+	VkResult getStatus()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return signaled ? VK_SUCCESS : VK_NOT_READY;
+	}
+
+	// Blocks until the fence is signaled or the deadline has passed.
+	VkResult wait(const std::chrono::steady_clock::time_point& deadline)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return condition.wait_until(lock, deadline, [this] { return signaled; }) ? VK_SUCCESS : VK_TIMEOUT;
 	}
 
-	VkResult getStatus() const
+	void wait()
 	{
-		return status;
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this] { return signaled; });
 	}
 
 private:
-	VkResult status = VK_NOT_READY;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool signaled = false;
 };
 
 static inline Fence* Cast(VkFence object)
@@ -18,6 +18,22 @@
 #include <algorithm>
 #include <memory.h>
 
+namespace
+{
+	bool IsInputAttachment(const VkSubpassDescription& subpass, uint32_t attachment)
+	{
+		for(uint32_t i = 0; i < subpass.inputAttachmentCount; i++)
+		{
+			if(subpass.pInputAttachments[i].attachment == attachment)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
 namespace vk
 {
 
@@ -63,7 +79,15 @@ void Framebuffer::clear(const RenderPass* renderPass, uint32_t clearValueCount,
 		}
 		else if(attachment.loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
 		{
-			attachments[i]->clear(pClearValues[i], VK_IMAGE_ASPECT_COLOR_BIT, renderArea);
+			if(IsInputAttachment(renderPass->getCurrentSubpass(), i))
+			{
+				// Input attachments are read without resolving the deferred clear first
+				attachments[i]->clear(pClearValues[i], VK_IMAGE_ASPECT_COLOR_BIT, renderArea);
+			}
+			else
+			{
+				attachments[i]->deferClear(pClearValues[i], renderArea);
+			}
 		}
 	}
 }
@@ -93,6 +117,27 @@ void Framebuffer::clear(const RenderPass* renderPass, const VkClearAttachment& a
 	}
 }
 
+bool Framebuffer::hasDeferredClears() const
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		if(attachments[i]->hasDeferredClear())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Framebuffer::resolveDeferredClears()
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		attachments[i]->resolveDeferredClear();
+	}
+}
+
 ImageView *Framebuffer::getAttachment(uint32_t index) const
 {
 	return attachments[index];
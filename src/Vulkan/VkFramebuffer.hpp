@@ -32,6 +32,8 @@ public:
 
 	void clear(const RenderPass* renderPass, uint32_t clearValueCount, const VkClearValue* pClearValues, const VkRect2D& renderArea);
 	void clear(const RenderPass* renderPass, const VkClearAttachment& attachment, const VkClearRect& rect);
+	bool hasDeferredClears() const;
+	void resolveDeferredClears();
 
 	static size_t ComputeRequiredAllocationSize(const VkFramebufferCreateInfo* pCreateInfo);
 	ImageView *getAttachment(uint32_t index) const;
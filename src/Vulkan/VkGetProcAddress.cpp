@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "VkGetProcAddress.h"
+#include "VkConfig.h"
+#include "WSI/HeadlessSurfaceKHR.hpp"
 
 #include <unordered_map>
 #include <string>
@@ -78,6 +80,8 @@ static const std::unordered_map<std::string, PFN_vkVoidFunction> instanceFunctio
 #ifdef VK_USE_PLATFORM_XLIB_KHR
 	MAKE_VULKAN_INSTANCE_ENTRY(vkCreateXlibSurfaceKHR),
 #endif
+	// VK_EXT_headless_surface
+	MAKE_VULKAN_INSTANCE_ENTRY(vkCreateHeadlessSurfaceEXT),
 	MAKE_VULKAN_INSTANCE_ENTRY(vkGetPhysicalDeviceSurfaceSupportKHR),
 	MAKE_VULKAN_INSTANCE_ENTRY(vkGetPhysicalDeviceSurfaceCapabilitiesKHR),
 	MAKE_VULKAN_INSTANCE_ENTRY(vkGetPhysicalDeviceSurfaceFormatsKHR),
@@ -248,6 +252,11 @@ static const std::unordered_map<std::string, PFN_vkVoidFunction> deviceFunctionP
 	MAKE_VULKAN_DEVICE_ENTRY(vkGetImageSparseMemoryRequirements2KHR),
 	// VK_KHR_maintenance3
 	MAKE_VULKAN_DEVICE_ENTRY(vkGetDescriptorSetLayoutSupportKHR),
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	// VK_KHR_external_memory_fd
+	MAKE_VULKAN_DEVICE_ENTRY(vkGetMemoryFdKHR),
+	MAKE_VULKAN_DEVICE_ENTRY(vkGetMemoryFdPropertiesKHR),
+#endif
 	MAKE_VULKAN_DEVICE_ENTRY(vkCreateSwapchainKHR),
 	MAKE_VULKAN_DEVICE_ENTRY(vkDestroySwapchainKHR),
 	MAKE_VULKAN_DEVICE_ENTRY(vkGetSwapchainImagesKHR),
@@ -17,6 +17,7 @@
 #include "VkDevice.hpp"
 #include "VkImage.hpp"
 #include "Device/Blitter.hpp"
+#include "Device/CopyEngine.hpp"
 #include <cstring>
 
 namespace
@@ -36,6 +37,60 @@ namespace
 		if (!aspects) aspects |= VK_IMAGE_ASPECT_COLOR_BIT;
 		return aspects;
 	}
+
+	bool HasExternalMemory(const VkImageCreateInfo* pCreateInfo)
+	{
+		const VkBaseInStructure* extensionCreateInfo = reinterpret_cast<const VkBaseInStructure*>(pCreateInfo->pNext);
+		while(extensionCreateInfo)
+		{
+			if(extensionCreateInfo->sType == VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO)
+			{
+				return true;
+			}
+
+			extensionCreateInfo = extensionCreateInfo->pNext;
+		}
+
+		return false;
+	}
+
+	bool HasHiZBuffer(const VkImageCreateInfo* pCreateInfo)
+	{
+		// Depth bounds are tracked for float depth attachments rendered to by this device only
+		if((pCreateInfo->imageType != VK_IMAGE_TYPE_2D) ||
+		   (pCreateInfo->tiling != VK_IMAGE_TILING_OPTIMAL) ||
+		   !(pCreateInfo->usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+		{
+			return false;
+		}
+
+		if((pCreateInfo->format != VK_FORMAT_D32_SFLOAT) &&
+		   (pCreateInfo->format != VK_FORMAT_D32_SFLOAT_S8_UINT))
+		{
+			return false;
+		}
+
+		return !HasExternalMemory(pCreateInfo);
+	}
+
+	bool HasDeferredClear(const VkImageCreateInfo* pCreateInfo)
+	{
+		// Clears are deferred for color attachments rendered to by this device only
+		if((pCreateInfo->imageType != VK_IMAGE_TYPE_2D) ||
+		   (pCreateInfo->tiling != VK_IMAGE_TILING_OPTIMAL) ||
+		   !(pCreateInfo->usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT))
+		{
+			return false;
+		}
+
+		const vk::Format format(pCreateInfo->format);
+		if(format.isCompressed() || format.hasQuadLayout() || !sw::DeferredClear::IsSupported(format.bytes()))
+		{
+			return false;
+		}
+
+		return !HasExternalMemory(pCreateInfo);
+	}
 }
 
 namespace vk
@@ -52,14 +107,51 @@ Image::Image(const Image::CreateInfo* pCreateInfo, void* mem) :
 	samples(pCreateInfo->pCreateInfo->samples),
 	tiling(pCreateInfo->pCreateInfo->tiling)
 {
+	if(mem)
+	{
+		if(HasHiZBuffer(pCreateInfo->pCreateInfo))
+		{
+			hiZ = sw::HiZBuffer(extent.width, extent.height, arrayLayers, mem);
+		}
+		else
+		{
+			deferredClear = sw::DeferredClear(extent.width, extent.height, arrayLayers, mem);
+		}
+	}
 }
 
 void Image::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	if(hiZ.isEnabled())
+	{
+		vk::deallocate(hiZ.getLayer(0), pAllocator);
+	}
+
+	if(deferredClear.isEnabled())
+	{
+		vk::deallocate(deferredClear.getLayer(0), pAllocator);
+	}
 }
 
 size_t Image::ComputeRequiredAllocationSize(const Image::CreateInfo* pCreateInfo)
 {
+	const VkImageCreateInfo* pImageCreateInfo = pCreateInfo->pCreateInfo;
+
+	// Depth formats can have a HiZBuffer, and color formats a DeferredClear, but not both
+	if(HasHiZBuffer(pImageCreateInfo))
+	{
+		return sw::HiZBuffer::ComputeRequiredSize(pImageCreateInfo->extent.width,
+		                                          pImageCreateInfo->extent.height,
+		                                          pImageCreateInfo->arrayLayers);
+	}
+
+	if(HasDeferredClear(pImageCreateInfo))
+	{
+		return sw::DeferredClear::ComputeRequiredSize(pImageCreateInfo->extent.width,
+		                                              pImageCreateInfo->extent.height,
+		                                              pImageCreateInfo->arrayLayers);
+	}
+
 	return 0;
 }
 
@@ -119,6 +211,8 @@ void Image::copyTo(VkImage dstImage, const VkImageCopy& pRegion)
 		UNIMPLEMENTED("dstSubresource");
 	}
 
+	dst->invalidateHiZ(pRegion.dstSubresource);
+
 	if((samples > VK_SAMPLE_COUNT_1_BIT) && (imageType == VK_IMAGE_TYPE_2D) && !format.isNonNormalizedInteger())
 	{
 		// Requires multisampling resolve
@@ -187,46 +281,40 @@ void Image::copyTo(VkImage dstImage, const VkImageCopy& pRegion)
 		size_t copySize = copyExtent.width * srcBytesPerBlock;
 		ASSERT((srcMem + copySize) < end());
 		ASSERT((dstMem + copySize) < dst->end());
-		memcpy(dstMem, srcMem, copySize);
+		sw::CopyEngine::copy(dstMem, srcMem, copySize);
 	}
 	else if(isEntireLine && isSinglePlane) // Copy one plane
 	{
 		size_t copySize = copyExtent.height * srcRowPitchBytes;
 		ASSERT((srcMem + copySize) < end());
 		ASSERT((dstMem + copySize) < dst->end());
-		memcpy(dstMem, srcMem, copySize);
+		sw::CopyEngine::copy(dstMem, srcMem, copySize);
 	}
 	else if(isEntirePlane) // Copy multiple planes
 	{
 		size_t copySize = copyExtent.depth * srcSlicePitchBytes;
 		ASSERT((srcMem + copySize) < end());
 		ASSERT((dstMem + copySize) < dst->end());
-		memcpy(dstMem, srcMem, copySize);
+		sw::CopyEngine::copy(dstMem, srcMem, copySize);
 	}
 	else if(isEntireLine) // Copy plane by plane
 	{
 		size_t copySize = copyExtent.height * srcRowPitchBytes;
-
-		for(uint32_t z = 0; z < copyExtent.depth; z++, dstMem += dstSlicePitchBytes, srcMem += srcSlicePitchBytes)
-		{
-			ASSERT((srcMem + copySize) < end());
-			ASSERT((dstMem + copySize) < dst->end());
-			memcpy(dstMem, srcMem, copySize);
-		}
+		ASSERT((srcMem + (copyExtent.depth - 1) * srcSlicePitchBytes + copySize) < end());
+		ASSERT((dstMem + (copyExtent.depth - 1) * dstSlicePitchBytes + copySize) < dst->end());
+		sw::CopyEngine::copy(dstMem, srcMem, copySize, 1, copyExtent.depth,
+		                     0, 0, dstSlicePitchBytes, srcSlicePitchBytes);
 	}
 	else // Copy line by line
 	{
 		size_t copySize = copyExtent.width * srcBytesPerBlock;
+		ASSERT((srcMem + ((copyExtent.depth * copyExtent.height) - 1) * srcRowPitchBytes + copySize) < end());
+		ASSERT((dstMem + ((copyExtent.depth * copyExtent.height) - 1) * dstRowPitchBytes + copySize) < dst->end());
 
-		for(uint32_t z = 0; z < copyExtent.depth; z++)
-		{
-			for(uint32_t y = 0; y < copyExtent.height; y++, dstMem += dstRowPitchBytes, srcMem += srcRowPitchBytes)
-			{
-				ASSERT((srcMem + copySize) < end());
-				ASSERT((dstMem + copySize) < dst->end());
-				memcpy(dstMem, srcMem, copySize);
-			}
-		}
+		// The lines of consecutive planes are copied as a single sequence of lines
+		sw::CopyEngine::copy(dstMem, srcMem, copySize, copyExtent.height, copyExtent.depth,
+		                     dstRowPitchBytes, srcRowPitchBytes,
+		                     copyExtent.height * dstRowPitchBytes, copyExtent.height * srcRowPitchBytes);
 	}
 }
 
@@ -307,40 +395,21 @@ void Image::copy(VkBuffer buf, const VkBufferImageCopy& region, bool bufferIsSou
 		{
 			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + copySize) < end());
 			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + copySize) < buffer->end());
-			memcpy(dstMemory, srcMemory, copySize);
+			sw::CopyEngine::copy(dstMemory, srcMemory, copySize);
 		}
 		else if(isEntireLine) // Copy plane by plane
 		{
-			uint8_t* srcPlaneMemory = srcMemory;
-			uint8_t* dstPlaneMemory = dstMemory;
-			for(uint32_t z = 0; z < imageExtent.depth; z++)
-			{
-				ASSERT(((bufferIsSource ? dstPlaneMemory : srcPlaneMemory) + copySize) < end());
-				ASSERT(((bufferIsSource ? srcPlaneMemory : dstPlaneMemory) + copySize) < buffer->end());
-				memcpy(dstPlaneMemory, srcPlaneMemory, copySize);
-				srcPlaneMemory += srcSlicePitchBytes;
-				dstPlaneMemory += dstSlicePitchBytes;
-			}
+			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + (imageExtent.depth - 1) * imageSlicePitchBytes + copySize) < end());
+			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + (imageExtent.depth - 1) * bufferSlicePitchBytes + copySize) < buffer->end());
+			sw::CopyEngine::copy(dstMemory, srcMemory, copySize, 1, imageExtent.depth,
+			                     0, 0, dstSlicePitchBytes, srcSlicePitchBytes);
 		}
 		else // Copy line by line
 		{
-			uint8_t* srcLayerMemory = srcMemory;
-			uint8_t* dstLayerMemory = dstMemory;
-			for(uint32_t z = 0; z < imageExtent.depth; z++)
-			{
-				uint8_t* srcPlaneMemory = srcLayerMemory;
-				uint8_t* dstPlaneMemory = dstLayerMemory;
-				for(uint32_t y = 0; y < imageExtent.height; y++)
-				{
-					ASSERT(((bufferIsSource ? dstPlaneMemory : srcPlaneMemory) + copySize) < end());
-					ASSERT(((bufferIsSource ? srcPlaneMemory : dstPlaneMemory) + copySize) < buffer->end());
-					memcpy(dstPlaneMemory, srcPlaneMemory, copySize);
-					srcPlaneMemory += srcRowPitchBytes;
-					dstPlaneMemory += dstRowPitchBytes;
-				}
-				srcLayerMemory += srcSlicePitchBytes;
-				dstLayerMemory += dstSlicePitchBytes;
-			}
+			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + (imageExtent.depth - 1) * imageSlicePitchBytes + (imageExtent.height - 1) * imageRowPitchBytes + copySize) < end());
+			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + (imageExtent.depth - 1) * bufferSlicePitchBytes + (imageExtent.height - 1) * bufferRowPitchBytes + copySize) < buffer->end());
+			sw::CopyEngine::copy(dstMemory, srcMemory, copySize, imageExtent.height, imageExtent.depth,
+			                     dstRowPitchBytes, srcRowPitchBytes, dstSlicePitchBytes, srcSlicePitchBytes);
 		}
 
 		srcMemory += srcLayerSize;
@@ -355,6 +424,7 @@ void Image::copyTo(VkBuffer dstBuffer, const VkBufferImageCopy& region)
 
 void Image::copyFrom(VkBuffer srcBuffer, const VkBufferImageCopy& region)
 {
+	invalidateHiZ(region.imageSubresource);
 	copy(srcBuffer, region, true);
 }
 
@@ -605,6 +675,7 @@ VkDeviceSize Image::getStorageSize(VkImageAspectFlags aspectMask) const
 
 void Image::blit(VkImage dstImage, const VkImageBlit& region, VkFilter filter)
 {
+	Cast(dstImage)->invalidateHiZ(region.dstSubresource);
 	device->getBlitter()->blit(this, Cast(dstImage), region, filter);
 }
 
@@ -644,7 +715,18 @@ void Image::clear(void* pixelData, VkFormat format, const VkImageSubresourceRang
 		UNIMPLEMENTED("subresourceRange");
 	}
 
+	if(subresourceRange.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT)
+	{
+		// The area may contain tiles which haven't received an earlier clear value yet
+		resolveDeferredClear();
+	}
+
 	device->getBlitter()->clear(pixelData, format, this, subresourceRange, &renderArea);
+
+	if(subresourceRange.aspectMask == VK_IMAGE_ASPECT_DEPTH_BIT)
+	{
+		clearHiZ(*static_cast<float*>(pixelData), subresourceRange, renderArea);
+	}
 }
 
 void Image::clear(const VkClearColorValue& color, const VkImageSubresourceRange& subresourceRange)
@@ -670,6 +752,9 @@ void Image::clear(const VkClearDepthStencilValue& color, const VkImageSubresourc
 		VkImageSubresourceRange depthSubresourceRange = subresourceRange;
 		depthSubresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
 		device->getBlitter()->clear((void*)(&color.depth), VK_FORMAT_D32_SFLOAT, this, depthSubresourceRange);
+
+		VkRect2D area = { { 0, 0 }, { extent.width, extent.height } };
+		clearHiZ(color.depth, depthSubresourceRange, area);
 	}
 
 	if(subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
@@ -713,4 +798,88 @@ void Image::clear(const VkClearValue& clearValue, const VkRect2D& renderArea, co
 	}
 }
 
+void Image::deferClear(const VkClearColorValue& color, const VkRect2D& renderArea, const VkImageSubresourceRange& subresourceRange)
+{
+	resolveDeferredClear();
+
+	VkRect2D tileArea = { { 0, 0 }, { 0, 0 } };
+	if(deferredClear.isEnabled() &&
+	   (subresourceRange.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT) &&
+	   (subresourceRange.baseMipLevel == 0))
+	{
+		tileArea = deferredClear.getTileArea(renderArea);
+	}
+
+	uint8_t texel[16];
+	if((tileArea.extent.width == 0) ||
+	   !device->getBlitter()->packClearValue((void*)color.float32, getClearFormat(), format, texel))
+	{
+		clear((void*)color.float32, getClearFormat(), subresourceRange, renderArea);
+		return;
+	}
+
+	// The parts of the render area which aren't made of whole tiles get cleared immediately
+	int x0 = renderArea.offset.x;
+	int y0 = renderArea.offset.y;
+	int x1 = renderArea.offset.x + static_cast<int>(renderArea.extent.width);
+	int y1 = renderArea.offset.y + static_cast<int>(renderArea.extent.height);
+	int tileX0 = tileArea.offset.x;
+	int tileY0 = tileArea.offset.y;
+	int tileX1 = tileArea.offset.x + static_cast<int>(tileArea.extent.width);
+	int tileY1 = tileArea.offset.y + static_cast<int>(tileArea.extent.height);
+
+	const VkRect2D borders[4] =
+	{
+		{ { x0, y0 }, { renderArea.extent.width, static_cast<uint32_t>(tileY0 - y0) } },         // Above the tiles
+		{ { x0, tileY1 }, { renderArea.extent.width, static_cast<uint32_t>(y1 - tileY1) } },     // Below the tiles
+		{ { x0, tileY0 }, { static_cast<uint32_t>(tileX0 - x0), tileArea.extent.height } },      // Left of the tiles
+		{ { tileX1, tileY0 }, { static_cast<uint32_t>(x1 - tileX1), tileArea.extent.height } },  // Right of the tiles
+	};
+
+	for(const VkRect2D& border : borders)
+	{
+		if((border.extent.width > 0) && (border.extent.height > 0))
+		{
+			clear((void*)color.float32, getClearFormat(), subresourceRange, border);
+		}
+	}
+
+	deferredClear.defer(texel, format.bytes(), tileArea, subresourceRange.baseArrayLayer, getLastLayerIndex(subresourceRange));
+}
+
+void Image::resolveDeferredClear()
+{
+	if(!deferredClear.isPending())
+	{
+		return;
+	}
+
+	for(int layer = deferredClear.getBaseLayer(); layer <= deferredClear.getLastLayer(); layer++)
+	{
+		VkImageSubresourceLayers subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, static_cast<uint32_t>(layer), 1 };
+
+		deferredClear.resolve(layer, static_cast<uint8_t*>(getTexelPointer({ 0, 0, 0 }, subresource)),
+		                      rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0), slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0),
+		                      samples, format.bytes());
+	}
+
+	deferredClear.setResolved();
+}
+
+void Image::clearHiZ(float depth, const VkImageSubresourceRange& subresourceRange, const VkRect2D& renderArea)
+{
+	if(hiZ.isEnabled() && (subresourceRange.baseMipLevel == 0))
+	{
+		hiZ.clear(depth, renderArea, subresourceRange.baseArrayLayer, getLastLayerIndex(subresourceRange));
+	}
+}
+
+void Image::invalidateHiZ(const VkImageSubresourceLayers& subresource)
+{
+	if(hiZ.isEnabled() && (subresource.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) && (subresource.mipLevel == 0))
+	{
+		hiZ.invalidate(subresource.baseArrayLayer, subresource.baseArrayLayer + subresource.layerCount - 1);
+	}
+}
+
 } // namespace vk
@@ -17,6 +17,8 @@
 
 #include "VkObject.hpp"
 #include "VkFormat.h"
+#include "Device/DeferredClear.hpp"
+#include "Device/HiZBuffer.hpp"
 
 namespace vk
 {
@@ -51,6 +53,11 @@ public:
 	void clear(const VkClearColorValue& color, const VkImageSubresourceRange& subresourceRange);
 	void clear(const VkClearDepthStencilValue& color, const VkImageSubresourceRange& subresourceRange);
 
+	// Clears the color of a render pass's attachment, leaving whole tiles to be written when first drawn to
+	void deferClear(const VkClearColorValue& color, const VkRect2D& renderArea, const VkImageSubresourceRange& subresourceRange);
+	// Writes the clear value into the tiles which haven't been drawn to
+	void resolveDeferredClear();
+
 	VkImageType              getImageType() const { return imageType; }
 	const Format&            getFormat() const { return format; }
 	Format                   getFormat(VkImageAspectFlagBits aspect) const;
@@ -65,6 +72,8 @@ public:
 	void*                    getTexelPointer(const VkOffset3D& offset, const VkImageSubresourceLayers& subresource) const;
 	bool                     isCube() const;
 	uint8_t*                 end() const;
+	const sw::HiZBuffer&     getHiZBuffer() const { return hiZ; }
+	const sw::DeferredClear& getDeferredClear() const { return deferredClear; }
 
 private:
 	void copy(VkBuffer buffer, const VkBufferImageCopy& region, bool bufferIsSource);
@@ -82,6 +91,8 @@ private:
 	int bytesPerTexel(VkImageAspectFlagBits flags) const;
 	VkFormat getClearFormat() const;
 	void clear(void* pixelData, VkFormat format, const VkImageSubresourceRange& subresourceRange, const VkRect2D& renderArea);
+	void clearHiZ(float depth, const VkImageSubresourceRange& subresourceRange, const VkRect2D& renderArea);
+	void invalidateHiZ(const VkImageSubresourceLayers& subresource);
 
 	const Device *const      device = nullptr;
 	DeviceMemory*            deviceMemory = nullptr;
@@ -94,6 +105,8 @@ private:
 	uint32_t                 arrayLayers = 0;
 	VkSampleCountFlagBits    samples = VK_SAMPLE_COUNT_1_BIT;
 	VkImageTiling            tiling = VK_IMAGE_TILING_OPTIMAL;
+	sw::HiZBuffer            hiZ;
+	sw::DeferredClear        deferredClear;
 };
 
 static inline Image* Cast(VkImage object)
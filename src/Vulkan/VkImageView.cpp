@@ -121,6 +121,25 @@ void ImageView::clear(const VkClearValue& clearValue, const VkImageAspectFlags a
 	image->clear(clearValue, renderArea.rect, sr);
 }
 
+void ImageView::deferClear(const VkClearValue& clearValue, const VkRect2D& renderArea)
+{
+	// Note: clearing ignores swizzling, so components is ignored.
+
+	if(!imageTypesMatch(image->getImageType()))
+	{
+		UNIMPLEMENTED("imageTypesMatch");
+	}
+
+	if(image->getFormat() != format)
+	{
+		UNIMPLEMENTED("format");
+	}
+
+	VkImageSubresourceRange sr = subresourceRange;
+	sr.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image->deferClear(clearValue.color, renderArea, sr);
+}
+
 void ImageView::resolve(ImageView* resolveAttachment)
 {
 	if((subresourceRange.levelCount != 1) || (resolveAttachment->subresourceRange.levelCount != 1))
@@ -162,4 +181,28 @@ void *ImageView::getOffsetPointer(const VkOffset3D& offset, VkImageAspectFlagBit
 	return image->getTexelPointer(offset, imageSubresourceLayers);
 }
 
+sw::HiZBuffer::Tile *ImageView::getHiZTiles() const
+{
+	const sw::HiZBuffer &hiZ = image->getHiZBuffer();
+
+	if(!hiZ.isEnabled() || !hasDepthAspect() || (subresourceRange.baseMipLevel != 0))
+	{
+		return nullptr;
+	}
+
+	return hiZ.getLayer(subresourceRange.baseArrayLayer);
+}
+
+uint8_t *ImageView::getDeferredClearTiles() const
+{
+	const sw::DeferredClear &deferredClear = image->getDeferredClear();
+
+	if(!deferredClear.isPending() || (subresourceRange.aspectMask != VK_IMAGE_ASPECT_COLOR_BIT) || (subresourceRange.baseMipLevel != 0))
+	{
+		return nullptr;
+	}
+
+	return deferredClear.getLayer(subresourceRange.baseArrayLayer);
+}
+
 }
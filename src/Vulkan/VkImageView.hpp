@@ -34,6 +34,8 @@ public:
 
 	void clear(const VkClearValue& clearValues, VkImageAspectFlags aspectMask, const VkRect2D& renderArea);
 	void clear(const VkClearValue& clearValue, VkImageAspectFlags aspectMask, const VkClearRect& renderArea);
+	void deferClear(const VkClearValue& clearValue, const VkRect2D& renderArea);
+	void resolveDeferredClear() { image->resolveDeferredClear(); }
 	void resolve(ImageView* resolveAttachment);
 
 	Format getFormat() const { return format; }
@@ -45,6 +47,15 @@ public:
 	bool hasDepthAspect() const { return (subresourceRange.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) != 0; }
 	bool hasStencilAspect() const { return (subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT) != 0; }
 
+	// Depth bounds of the tiles of the view's layer, or nullptr if they aren't tracked
+	sw::HiZBuffer::Tile *getHiZTiles() const;
+	const sw::HiZBuffer &getHiZBuffer() const { return image->getHiZBuffer(); }
+
+	// Flags of the tiles of the view's layer which still hold a deferred clear, or nullptr if there are none
+	uint8_t *getDeferredClearTiles() const;
+	const sw::DeferredClear &getDeferredClear() const { return image->getDeferredClear(); }
+	bool hasDeferredClear() const { return image->getDeferredClear().isPending(); }
+
 private:
 	bool                       imageTypesMatch(VkImageType imageType) const;
 
@@ -53,8 +53,8 @@ const VkPhysicalDeviceFeatures& PhysicalDevice::getFeatures() const
 		true,  // textureCompressionETC2
 		false, // textureCompressionASTC_LDR
 		false, // textureCompressionBC
-		false, // occlusionQueryPrecise
-		false, // pipelineStatisticsQuery
+		true,  // occlusionQueryPrecise
+		true,  // pipelineStatisticsQuery
 		false, // vertexPipelineStoresAndAtomics
 		false, // fragmentStoresAndAtomics
 		false, // shaderTessellationAndGeometryPointSize
@@ -230,8 +230,8 @@ const VkPhysicalDeviceLimits& PhysicalDevice::getLimits() const
 		sampleCounts, // sampledImageStencilSampleCounts
 		VK_SAMPLE_COUNT_1_BIT, // storageImageSampleCounts (unsupported)
 		1, // maxSampleMaskWords
-		false, // timestampComputeAndGraphics
-		60, // timestampPeriod
+		true, // timestampComputeAndGraphics
+		1, // timestampPeriod (nanoseconds)
 		8, // maxClipDistances
 		8, // maxCullDistances
 		8, // maxCombinedClipAndCullDistances
@@ -677,7 +677,7 @@ void PhysicalDevice::getQueueFamilyProperties(uint32_t pQueueFamilyPropertyCount
 		pQueueFamilyProperties[i].minImageTransferGranularity.depth = 1;
 		pQueueFamilyProperties[i].queueCount = 1;
 		pQueueFamilyProperties[i].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
-		pQueueFamilyProperties[i].timestampValidBits = 0; // No support for time stamps
+		pQueueFamilyProperties[i].timestampValidBits = 64;
 	}
 }
 
@@ -708,4 +708,23 @@ const VkPhysicalDeviceMemoryProperties& PhysicalDevice::getMemoryProperties() co
 	return properties;
 }
 
+void PhysicalDevice::getExternalMemoryProperties(VkExternalMemoryHandleTypeFlagBits handleType,
+                                                 VkExternalMemoryProperties* pExternalMemoryProperties) const
+{
+	pExternalMemoryProperties->externalMemoryFeatures = 0;
+	pExternalMemoryProperties->exportFromImportedHandleTypes = 0;
+	pExternalMemoryProperties->compatibleHandleTypes = 0;
+
+#if SWIFTSHADER_EXTERNAL_MEMORY_FD
+	// Device memory is a memfd which any buffer or image can be bound to
+	if(handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT)
+	{
+		pExternalMemoryProperties->externalMemoryFeatures = VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT |
+		                                                    VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT;
+		pExternalMemoryProperties->exportFromImportedHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+		pExternalMemoryProperties->compatibleHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+	}
+#endif
+}
+
 } // namespace vk
@@ -55,6 +55,8 @@ public:
 	void getQueueFamilyProperties(uint32_t pQueueFamilyPropertyCount,
 	                              VkQueueFamilyProperties* pQueueFamilyProperties) const;
 	const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+	void getExternalMemoryProperties(VkExternalMemoryHandleTypeFlagBits handleType,
+	                                 VkExternalMemoryProperties* pExternalMemoryProperties) const;
 
 private:
 	const VkPhysicalDeviceLimits& getLimits() const;
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "VkPipeline.hpp"
+#include "VkPipelineCache.hpp"
 #include "VkPipelineLayout.hpp"
 #include "VkShaderModule.hpp"
 #include "Pipeline/ComputeProgram.hpp"
@@ -244,6 +245,20 @@ std::vector<uint32_t> preprocessSpirv(
 	return optimized;
 }
 
+std::shared_ptr<sw::SpirvShader> createShader(const VkPipelineShaderStageCreateInfo& stage, vk::PipelineCache* pipelineCache)
+{
+	auto module = vk::Cast(stage.module);
+
+	if(!pipelineCache)
+	{
+		return std::make_shared<sw::SpirvShader>(preprocessSpirv(module->getCode(), stage.pSpecializationInfo));
+	}
+
+	const vk::PipelineCache::SpirvShaderKey key(stage.stage, stage.pName, module->getCode(), stage.pSpecializationInfo);
+
+	return pipelineCache->getOrCreateShader(key, [&] { return preprocessSpirv(key.code, stage.pSpecializationInfo); });
+}
+
 } // anonymous namespace
 
 namespace vk
@@ -422,8 +437,9 @@ GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo* pCreateIn
 
 void GraphicsPipeline::destroyPipeline(const VkAllocationCallbacks* pAllocator)
 {
-	delete vertexShader;
-	delete fragmentShader;
+	// Shaders may be shared with a pipeline cache and other pipelines
+	vertexShader.reset();
+	fragmentShader.reset();
 }
 
 size_t GraphicsPipeline::ComputeRequiredAllocationSize(const VkGraphicsPipelineCreateInfo* pCreateInfo)
@@ -431,7 +447,7 @@ size_t GraphicsPipeline::ComputeRequiredAllocationSize(const VkGraphicsPipelineC
 	return 0;
 }
 
-void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo)
+void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache)
 {
 	for (auto pStage = pCreateInfo->pStages; pStage != pCreateInfo->pStages + pCreateInfo->stageCount; pStage++)
 	{
@@ -440,20 +456,19 @@ void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, c
 			UNIMPLEMENTED("pStage->flags");
 		}
 
-		auto module = Cast(pStage->module);
-		auto code = preprocessSpirv(module->getCode(), pStage->pSpecializationInfo);
-
 		// TODO: also pass in any pipeline state which will affect shader compilation
-		auto spirvShader = new sw::SpirvShader{code};
+		auto spirvShader = createShader(*pStage, pipelineCache);
 
 		switch (pStage->stage)
 		{
 		case VK_SHADER_STAGE_VERTEX_BIT:
-			context.vertexShader = vertexShader = spirvShader;
+			vertexShader = spirvShader;
+			context.vertexShader = vertexShader.get();
 			break;
 
 		case VK_SHADER_STAGE_FRAGMENT_BIT:
-			context.pixelShader = fragmentShader = spirvShader;
+			fragmentShader = spirvShader;
+			context.pixelShader = fragmentShader.get();
 			break;
 
 		default:
@@ -512,7 +527,13 @@ ComputePipeline::ComputePipeline(const VkComputePipelineCreateInfo* pCreateInfo,
 
 void ComputePipeline::destroyPipeline(const VkAllocationCallbacks* pAllocator)
 {
-	delete shader;
+	if(routine)
+	{
+		routine->unbind();
+		routine = nullptr;
+	}
+
+	shader.reset();
 }
 
 size_t ComputePipeline::ComputeRequiredAllocationSize(const VkComputePipelineCreateInfo* pCreateInfo)
@@ -520,33 +541,38 @@ size_t ComputePipeline::ComputeRequiredAllocationSize(const VkComputePipelineCre
 	return 0;
 }
 
-void ComputePipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo)
+void ComputePipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache)
 {
-	auto module = Cast(pCreateInfo->stage.module);
+	ASSERT(shader == nullptr);
 
-	auto code = preprocessSpirv(module->getCode(), pCreateInfo->stage.pSpecializationInfo);
+	// FIXME (b/119409619): use allocator.
+	shader = createShader(pCreateInfo->stage, pipelineCache);
 
-	ASSERT_OR_RETURN(code.size() > 0);
+	ASSERT_OR_RETURN(shader->insns.size() > 0);
 
-	ASSERT(shader == nullptr);
+	auto compile = [this]
+	{
+		sw::ComputeProgram program(shader.get(), layout);
 
-	// FIXME (b/119409619): use allocator.
-	shader = new sw::SpirvShader(code);
+		program.generate();
 
-	sw::ComputeProgram program(shader, layout);
+		return program(rr::AggressiveOptimization, "ComputeRoutine");
+	};
 
-	program.generate();
+	routine = pipelineCache ? pipelineCache->getOrCreateComputeRoutine(PipelineCache::ComputeProgramKey(shader.get(), layout), compile)
+	                        : compile();
 
-	// TODO(bclayton): Cache program
-	routine = program("ComputeRoutine");
+	routine->bind();
 }
 
-void ComputePipeline::run(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+void ComputePipeline::run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
+	uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
 	size_t numDescriptorSets, VkDescriptorSet *descriptorSets, sw::PushConstantStorage const &pushConstants)
 {
 	ASSERT_OR_RETURN(routine != nullptr);
 	sw::ComputeProgram::run(
 		routine, reinterpret_cast<void**>(descriptorSets), pushConstants,
+		baseGroupX, baseGroupY, baseGroupZ,
 		groupCountX, groupCountY, groupCountZ);
 }
 
@@ -18,11 +18,14 @@
 #include "VkObject.hpp"
 #include "Device/Renderer.hpp"
 
+#include <memory>
+
 namespace sw { class SpirvShader; }
 
 namespace vk
 {
 
+class PipelineCache;
 class PipelineLayout;
 
 class Pipeline
@@ -67,7 +70,7 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkGraphicsPipelineCreateInfo* pCreateInfo);
 
-	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo);
+	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache);
 
 	uint32_t computePrimitiveCount(uint32_t vertexCount) const;
 	const sw::Context& getContext() const;
@@ -76,8 +79,8 @@ public:
 	const sw::Color<float>& getBlendConstants() const;
 
 private:
-	sw::SpirvShader *vertexShader = nullptr;
-	sw::SpirvShader *fragmentShader = nullptr;
+	std::shared_ptr<sw::SpirvShader> vertexShader;
+	std::shared_ptr<sw::SpirvShader> fragmentShader;
 
 	sw::Context context;
 	VkRect2D scissor;
@@ -101,13 +104,14 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkComputePipelineCreateInfo* pCreateInfo);
 
-	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo);
+	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache);
 
-	void run(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+	void run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
+		uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
 		size_t numDescriptorSets, VkDescriptorSet *descriptorSets, sw::PushConstantStorage const &pushConstants);
 
 protected:
-	sw::SpirvShader *shader = nullptr;
+	std::shared_ptr<sw::SpirvShader> shader;
 	rr::Routine *routine = nullptr;
 };
 
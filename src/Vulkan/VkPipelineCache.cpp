@@ -0,0 +1,523 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "VkPipelineCache.hpp"
+#include "VkPipelineLayout.hpp"
+#include "Pipeline/SpirvShader.hpp"
+#include "Reactor/Routine.hpp"
+
+#include <cstring>
+
+namespace
+{
+
+// Version of the data following the Vulkan-defined header. Bump whenever the
+// layout of the entries or the preprocessing applied to the SPIR-V changes.
+constexpr uint32_t CACHE_DATA_VERSION = 1;
+
+struct CacheDataHeader
+{
+	uint32_t dataVersion;
+	uint32_t driverVersion;
+	uint32_t entryCount;
+};
+
+struct CacheEntryHeader
+{
+	uint32_t stage;
+	uint32_t entryPointNameSize;   // In bytes, padded to a multiple of 4 in the blob
+	uint32_t codeSize;             // In words
+	uint32_t specializationSize;   // In bytes, padded to a multiple of 4 in the blob
+	uint32_t optimizedCodeSize;    // In words
+};
+
+size_t Align4(size_t size)
+{
+	return (size + 3) & ~static_cast<size_t>(3);
+}
+
+size_t HashWords(size_t hash, const uint32_t* words, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		hash = hash * 31 + words[i];
+	}
+
+	return hash;
+}
+
+size_t HashBytes(size_t hash, const uint8_t* bytes, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		hash = hash * 31 + bytes[i];
+	}
+
+	return hash;
+}
+
+class Reader
+{
+public:
+	Reader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	bool read(void* dst, size_t count)
+	{
+		if(count > size - offset)
+		{
+			return false;
+		}
+
+		memcpy(dst, data + offset, count);
+		offset += count;
+		return true;
+	}
+
+	bool skip(size_t count)
+	{
+		if(count > size - offset)
+		{
+			return false;
+		}
+
+		offset += count;
+		return true;
+	}
+
+	size_t remaining() const { return size - offset; }
+
+private:
+	const uint8_t* const data;
+	const size_t size;
+	size_t offset = 0;
+};
+
+class Writer
+{
+public:
+	Writer(uint8_t* data, size_t capacity) : data(data), capacity(capacity) {}
+
+	// When data is null only the required size is computed.
+	void write(const void* src, size_t count)
+	{
+		if(data)
+		{
+			ASSERT(offset + count <= capacity);
+			memcpy(data + offset, src, count);
+		}
+
+		offset += count;
+	}
+
+	void pad(size_t count)
+	{
+		if(data)
+		{
+			ASSERT(offset + count <= capacity);
+			memset(data + offset, 0, count);
+		}
+
+		offset += count;
+	}
+
+	size_t getOffset() const { return offset; }
+
+private:
+	uint8_t* const data;
+	const size_t capacity;
+	size_t offset = 0;
+};
+
+size_t EntrySize(const vk::PipelineCache::SpirvShaderKey& key, const std::vector<uint32_t>& optimizedCode)
+{
+	return sizeof(CacheEntryHeader) +
+	       Align4(key.entryPointName.size()) +
+	       key.code.size() * sizeof(uint32_t) +
+	       Align4(key.specialization.size()) +
+	       optimizedCode.size() * sizeof(uint32_t);
+}
+
+} // anonymous namespace
+
+namespace vk
+{
+
+PipelineCache::SpirvShaderKey::SpirvShaderKey(VkShaderStageFlagBits stage, const std::string& entryPointName,
+                                              const std::vector<uint32_t>& code, const VkSpecializationInfo* specializationInfo) :
+	stage(stage), entryPointName(entryPointName), code(code)
+{
+	if(specializationInfo)
+	{
+		const uint8_t* data = static_cast<const uint8_t*>(specializationInfo->pData);
+
+		for(uint32_t i = 0; i < specializationInfo->mapEntryCount; i++)
+		{
+			const VkSpecializationMapEntry& entry = specializationInfo->pMapEntries[i];
+			uint32_t constantID = entry.constantID;
+			uint32_t size = static_cast<uint32_t>(entry.size);
+
+			const uint8_t* id = reinterpret_cast<const uint8_t*>(&constantID);
+			specialization.insert(specialization.end(), id, id + sizeof(constantID));
+			const uint8_t* sz = reinterpret_cast<const uint8_t*>(&size);
+			specialization.insert(specialization.end(), sz, sz + sizeof(size));
+			specialization.insert(specialization.end(), data + entry.offset, data + entry.offset + entry.size);
+		}
+	}
+
+	computeHash();
+}
+
+void PipelineCache::SpirvShaderKey::computeHash()
+{
+	hash = static_cast<size_t>(stage);
+	hash = HashBytes(hash, reinterpret_cast<const uint8_t*>(entryPointName.data()), entryPointName.size());
+	hash = HashWords(hash, code.data(), code.size());
+	hash = HashBytes(hash, specialization.data(), specialization.size());
+}
+
+bool PipelineCache::SpirvShaderKey::operator==(const SpirvShaderKey& other) const
+{
+	return (hash == other.hash) &&
+	       (stage == other.stage) &&
+	       (entryPointName == other.entryPointName) &&
+	       (code == other.code) &&
+	       (specialization == other.specialization);
+}
+
+PipelineCache::ComputeProgramKey::ComputeProgramKey(const sw::SpirvShader* shader, const PipelineLayout* pipelineLayout) :
+	shaderID(shader->getSerialID())
+{
+	for(size_t set = 0; set < pipelineLayout->getNumDescriptorSets(); set++)
+	{
+		const DescriptorSetLayout* setLayout = pipelineLayout->getDescriptorSetLayout(set);
+
+		for(uint32_t i = 0; i < setLayout->getBindingCount(); i++)
+		{
+			const VkDescriptorSetLayoutBinding& binding = setLayout->getBinding(i);
+
+			layout.push_back(static_cast<uint32_t>(set));
+			layout.push_back(binding.binding);
+			layout.push_back(static_cast<uint32_t>(binding.descriptorType));
+			layout.push_back(static_cast<uint32_t>(setLayout->getBindingOffset(binding.binding)));
+		}
+	}
+
+	hash = HashWords(static_cast<size_t>(shaderID), layout.data(), layout.size());
+}
+
+bool PipelineCache::ComputeProgramKey::operator==(const ComputeProgramKey& other) const
+{
+	return (hash == other.hash) && (shaderID == other.shaderID) && (layout == other.layout);
+}
+
+PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem)
+{
+	if(pCreateInfo->initialDataSize > 0)
+	{
+		loadData(static_cast<const uint8_t*>(pCreateInfo->pInitialData), pCreateInfo->initialDataSize);
+	}
+}
+
+void PipelineCache::destroy(const VkAllocationCallbacks* pAllocator)
+{
+	// The cache's destructor is never called, so release its contents explicitly
+	for(auto& it : computeRoutines)
+	{
+		it.second->unbind();
+	}
+
+	decltype(computeRoutines)().swap(computeRoutines);
+	decltype(shaders)().swap(shaders);
+}
+
+size_t PipelineCache::ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo)
+{
+	return 0;
+}
+
+void PipelineCache::loadData(const uint8_t* data, size_t size)
+{
+	// Incompatible or corrupt data is silently ignored, leaving the cache empty
+	Reader reader(data, size);
+
+	CacheHeader header;
+	if(!reader.read(&header, sizeof(header)) ||
+	   (header.headerLength != sizeof(CacheHeader)) ||
+	   (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+	   (header.vendorID != VENDOR_ID) ||
+	   (header.deviceID != DEVICE_ID) ||
+	   (memcmp(header.pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE) != 0))
+	{
+		return;
+	}
+
+	CacheDataHeader dataHeader;
+	if(!reader.read(&dataHeader, sizeof(dataHeader)) ||
+	   (dataHeader.dataVersion != CACHE_DATA_VERSION) ||
+	   (dataHeader.driverVersion != DRIVER_VERSION))
+	{
+		return;
+	}
+
+	for(uint32_t i = 0; i < dataHeader.entryCount; i++)
+	{
+		CacheEntryHeader entryHeader;
+		if(!reader.read(&entryHeader, sizeof(entryHeader)))
+		{
+			return;
+		}
+
+		// Validate the sizes before allocating anything based on them
+		uint64_t entrySize = static_cast<uint64_t>(entryHeader.entryPointNameSize) +
+		                     static_cast<uint64_t>(entryHeader.codeSize) * sizeof(uint32_t) +
+		                     static_cast<uint64_t>(entryHeader.specializationSize) +
+		                     static_cast<uint64_t>(entryHeader.optimizedCodeSize) * sizeof(uint32_t);
+		if((entrySize > reader.remaining()) || (entryHeader.optimizedCodeSize == 0))
+		{
+			return;
+		}
+
+		SpirvShaderKey key;
+		key.stage = static_cast<VkShaderStageFlagBits>(entryHeader.stage);
+		key.entryPointName.resize(entryHeader.entryPointNameSize);
+		key.code.resize(entryHeader.codeSize);
+		key.specialization.resize(entryHeader.specializationSize);
+
+		ShaderEntry entry;
+		entry.optimizedCode.resize(entryHeader.optimizedCodeSize);
+
+		if(!reader.read(&key.entryPointName[0], key.entryPointName.size()) ||
+		   !reader.skip(Align4(key.entryPointName.size()) - key.entryPointName.size()) ||
+		   !reader.read(key.code.data(), key.code.size() * sizeof(uint32_t)) ||
+		   !reader.read(key.specialization.data(), key.specialization.size()) ||
+		   !reader.skip(Align4(key.specialization.size()) - key.specialization.size()) ||
+		   !reader.read(entry.optimizedCode.data(), entry.optimizedCode.size() * sizeof(uint32_t)))
+		{
+			return;
+		}
+
+		key.computeHash();
+		shaders.emplace(std::move(key), std::move(entry));
+	}
+}
+
+size_t PipelineCache::serialize(uint8_t* data, size_t capacity, bool* complete)
+{
+	*complete = true;
+
+	size_t size = sizeof(CacheHeader) + sizeof(CacheDataHeader);
+	if(data && (capacity < size))
+	{
+		// Not even the header fits, so nothing is written
+		*complete = false;
+		return 0;
+	}
+
+	// Only whole entries are written, so determine how many fit first
+	uint32_t entryCount = 0;
+	for(auto& it : shaders)
+	{
+		size_t entrySize = EntrySize(it.first, it.second.optimizedCode);
+		if(data && (size + entrySize > capacity))
+		{
+			*complete = false;
+			break;
+		}
+
+		size += entrySize;
+		entryCount++;
+	}
+
+	if(!data)
+	{
+		return size;
+	}
+
+	Writer writer(data, capacity);
+
+	CacheHeader header;
+	header.headerLength = sizeof(CacheHeader);
+	header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+	header.vendorID = VENDOR_ID;
+	header.deviceID = DEVICE_ID;
+	memcpy(header.pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE);
+	writer.write(&header, sizeof(header));
+
+	CacheDataHeader dataHeader;
+	dataHeader.dataVersion = CACHE_DATA_VERSION;
+	dataHeader.driverVersion = DRIVER_VERSION;
+	dataHeader.entryCount = entryCount;
+	writer.write(&dataHeader, sizeof(dataHeader));
+
+	auto it = shaders.begin();
+	for(uint32_t i = 0; i < entryCount; i++, it++)
+	{
+		const SpirvShaderKey& key = it->first;
+		const ShaderEntry& entry = it->second;
+
+		CacheEntryHeader entryHeader;
+		entryHeader.stage = static_cast<uint32_t>(key.stage);
+		entryHeader.entryPointNameSize = static_cast<uint32_t>(key.entryPointName.size());
+		entryHeader.codeSize = static_cast<uint32_t>(key.code.size());
+		entryHeader.specializationSize = static_cast<uint32_t>(key.specialization.size());
+		entryHeader.optimizedCodeSize = static_cast<uint32_t>(entry.optimizedCode.size());
+		writer.write(&entryHeader, sizeof(entryHeader));
+
+		writer.write(key.entryPointName.data(), key.entryPointName.size());
+		writer.pad(Align4(key.entryPointName.size()) - key.entryPointName.size());
+		writer.write(key.code.data(), key.code.size() * sizeof(uint32_t));
+		writer.write(key.specialization.data(), key.specialization.size());
+		writer.pad(Align4(key.specialization.size()) - key.specialization.size());
+		writer.write(entry.optimizedCode.data(), entry.optimizedCode.size() * sizeof(uint32_t));
+	}
+
+	ASSERT(writer.getOffset() == size);
+
+	return size;
+}
+
+VkResult PipelineCache::getData(size_t* pDataSize, void* pData)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	bool complete = true;
+	*pDataSize = serialize(static_cast<uint8_t*>(pData), *pDataSize, &complete);
+
+	return complete ? VK_SUCCESS : VK_INCOMPLETE;
+}
+
+VkResult PipelineCache::merge(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches)
+{
+	for(uint32_t i = 0; i < srcCacheCount; i++)
+	{
+		PipelineCache* srcCache = Cast(pSrcCaches[i]);
+		ASSERT(srcCache != this);
+
+		// Only one cache is locked at a time, so merging two caches into each other concurrently
+		// can't deadlock. The snapshot binds the routines to keep them alive in between.
+		std::vector<std::pair<SpirvShaderKey, ShaderEntry>> srcShaders;
+		std::vector<std::pair<ComputeProgramKey, rr::Routine*>> srcRoutines;
+
+		{
+			std::unique_lock<std::mutex> srcLock(srcCache->mutex);
+
+			srcShaders.assign(srcCache->shaders.begin(), srcCache->shaders.end());
+			srcRoutines.assign(srcCache->computeRoutines.begin(), srcCache->computeRoutines.end());
+
+			for(auto& it : srcRoutines)
+			{
+				it.second->bind();
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for(auto& it : srcShaders)
+		{
+			shaders.insert(std::move(it));
+		}
+
+		for(auto& it : srcRoutines)
+		{
+			if(!computeRoutines.insert(it).second)
+			{
+				it.second->unbind();  // Already cached
+			}
+		}
+	}
+
+	return VK_SUCCESS;
+}
+
+std::shared_ptr<sw::SpirvShader> PipelineCache::getOrCreateShader(const SpirvShaderKey& key, const Preprocessor& preprocess)
+{
+	std::vector<uint32_t> optimizedCode;
+	bool loaded = false;
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		auto it = shaders.find(key);
+		if(it != shaders.end())
+		{
+			const ShaderEntry& entry = it->second;
+			if(entry.shader)
+			{
+				return entry.shader;
+			}
+
+			// Loaded from the initial data, only the SpirvShader has to be built
+			optimizedCode = entry.optimizedCode;
+			loaded = true;
+		}
+	}
+
+	// Run the optimizer and construct the shader without holding the lock, so that other
+	// pipelines can be created concurrently
+	if(!loaded)
+	{
+		optimizedCode = preprocess();
+	}
+
+	auto shader = std::make_shared<sw::SpirvShader>(optimizedCode);
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	ShaderEntry entry;
+	entry.optimizedCode = std::move(optimizedCode);
+	entry.shader = shader;
+
+	// Another thread may have inserted the same shader in the meantime, in which case it is reused
+	auto inserted = shaders.emplace(key, std::move(entry));
+	ShaderEntry& cached = inserted.first->second;
+	if(!cached.shader)
+	{
+		cached.shader = shader;
+	}
+
+	return cached.shader;
+}
+
+rr::Routine* PipelineCache::getOrCreateComputeRoutine(const ComputeProgramKey& key, const Compiler& compile)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		auto it = computeRoutines.find(key);
+		if(it != computeRoutines.end())
+		{
+			return it->second;
+		}
+	}
+
+	rr::Routine* routine = compile();
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	auto inserted = computeRoutines.emplace(key, routine);
+	if(inserted.second)
+	{
+		routine->bind();
+	}
+	else
+	{
+		// Lost the race against another thread compiling the same program
+		routine->bind();
+		routine->unbind();
+	}
+
+	return inserted.first->second;
+}
+
+} // namespace vk
@@ -17,24 +17,119 @@
 
 #include "VkObject.hpp"
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rr
+{
+	class Routine;
+}
+
+namespace sw
+{
+	class SpirvShader;
+}
+
 namespace vk
 {
 
+class PipelineLayout;
+
+// PipelineCache holds the SPIR-V modules produced by the pipeline's spvtools
+// passes, and the compute routines JIT-compiled from them, so that creating an
+// equivalent pipeline can skip both steps. Only the optimized SPIR-V is part of
+// the data returned by vkGetPipelineCacheData(); compiled routines live in memory.
+// Graphics routines are cached by the Renderer, keyed on the shader's serial ID,
+// so sharing the SpirvShader objects is sufficient to also share those.
 class PipelineCache : public Object<PipelineCache, VkPipelineCache>
 {
 public:
-	PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem)
+	PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem);
+	~PipelineCache() = delete;
+	void destroy(const VkAllocationCallbacks* pAllocator);
+
+	static size_t ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo);
+
+	VkResult getData(size_t* pDataSize, void* pData);
+	VkResult merge(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches);
+
+	struct SpirvShaderKey
 	{
-	}
+		SpirvShaderKey(VkShaderStageFlagBits stage, const std::string& entryPointName,
+		               const std::vector<uint32_t>& code, const VkSpecializationInfo* specializationInfo);
 
-	~PipelineCache() = delete;
+		bool operator==(const SpirvShaderKey& other) const;
+
+		struct Hash
+		{
+			size_t operator()(const SpirvShaderKey& key) const { return key.hash; }
+		};
 
-	static size_t ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo)
+		VkShaderStageFlagBits stage;
+		std::string entryPointName;
+		std::vector<uint32_t> code;
+		std::vector<uint8_t> specialization;  // (constantID, size, value) tuples
+		size_t hash;
+
+	private:
+		friend class PipelineCache;
+		SpirvShaderKey() = default;
+		void computeHash();
+	};
+
+	struct ComputeProgramKey
 	{
-		return 0;
-	}
+		ComputeProgramKey(const sw::SpirvShader* shader, const PipelineLayout* layout);
+
+		bool operator==(const ComputeProgramKey& other) const;
+
+		struct Hash
+		{
+			size_t operator()(const ComputeProgramKey& key) const { return key.hash; }
+		};
+
+		int shaderID;
+		std::vector<uint32_t> layout;  // (set, binding, type, offset) tuples the routine was compiled against
+		size_t hash;
+	};
+
+	using Preprocessor = std::function<std::vector<uint32_t>()>;
+	using Compiler = std::function<rr::Routine*()>;
+
+	// Returns the shader for the given key, running the preprocessor and constructing
+	// the SpirvShader only for the parts which aren't already cached.
+	std::shared_ptr<sw::SpirvShader> getOrCreateShader(const SpirvShaderKey& key, const Preprocessor& preprocess);
+
+	// Returns the compute routine for the given key, compiling it on a miss.
+	// The returned routine is bound by the cache; callers must bind it themselves to retain it.
+	rr::Routine* getOrCreateComputeRoutine(const ComputeProgramKey& key, const Compiler& compile);
 
 private:
+	struct CacheHeader
+	{
+		uint32_t headerLength;
+		uint32_t headerVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+	};
+
+	struct ShaderEntry
+	{
+		std::vector<uint32_t> optimizedCode;
+		std::shared_ptr<sw::SpirvShader> shader;  // Lazily constructed from optimizedCode
+	};
+
+	void loadData(const uint8_t* data, size_t size);
+	size_t serialize(uint8_t* data, size_t capacity, bool* complete);
+
+	std::mutex mutex;
+	std::unordered_map<SpirvShaderKey, ShaderEntry, SpirvShaderKey::Hash> shaders;
+	std::unordered_map<ComputeProgramKey, rr::Routine*, ComputeProgramKey::Hash> computeRoutines;
 };
 
 static inline PipelineCache* Cast(VkPipelineCache object)
@@ -55,4 +55,10 @@ size_t PipelineLayout::getBindingOffset(size_t descriptorSet, size_t binding) co
 	return setLayouts[descriptorSet]->getBindingOffset(binding);
 }
 
+DescriptorSetLayout const* PipelineLayout::getDescriptorSetLayout(size_t descriptorSet) const
+{
+	ASSERT(descriptorSet < setLayoutCount);
+	return setLayouts[descriptorSet];
+}
+
 } // namespace vk
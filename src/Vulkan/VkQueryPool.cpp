@@ -13,31 +13,117 @@
 // limitations under the License.
 
 #include "VkQueryPool.hpp"
+#include "System/Timer.hpp"
+
+#include <cstring>
+#include <new>
+
+namespace
+{
+	sw::Query::Type ConvertQueryType(VkQueryType type)
+	{
+		switch(type)
+		{
+		case VK_QUERY_TYPE_OCCLUSION:
+			return sw::Query::FRAGMENTS_PASSED;
+		case VK_QUERY_TYPE_PIPELINE_STATISTICS:
+			return sw::Query::PIPELINE_STATISTICS;
+		case VK_QUERY_TYPE_TIMESTAMP:
+			return sw::Query::FRAGMENTS_PASSED;   // Not used by the renderer
+		default:
+			UNIMPLEMENTED("queryType");
+			return sw::Query::FRAGMENTS_PASSED;
+		}
+	}
+
+	// Maps the VkQueryPipelineStatisticFlagBits, in bit order, to the counters the renderer keeps.
+	// Geometry, tessellation and compute statistics are always zero.
+	int ConvertStatistic(VkQueryPipelineStatisticFlagBits statistic)
+	{
+		switch(statistic)
+		{
+		case VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT:     return sw::Query::INPUT_ASSEMBLY_VERTICES;
+		case VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT:   return sw::Query::INPUT_ASSEMBLY_PRIMITIVES;
+		case VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT:   return sw::Query::VERTEX_SHADER_INVOCATIONS;
+		case VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT:        return sw::Query::CLIPPING_INVOCATIONS;
+		case VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT:         return sw::Query::CLIPPING_PRIMITIVES;
+		case VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT: return sw::Query::FRAGMENT_SHADER_INVOCATIONS;
+		default:                                                          return -1;
+		}
+	}
+
+	void WriteResult(char* data, VkQueryResultFlags flags, uint64_t value)
+	{
+		if(flags & VK_QUERY_RESULT_64_BIT)
+		{
+			memcpy(data, &value, sizeof(uint64_t));
+		}
+		else
+		{
+			uint32_t value32 = static_cast<uint32_t>(value);
+			memcpy(data, &value32, sizeof(uint32_t));
+		}
+	}
+}
 
 namespace vk
 {
+	Query::Query(sw::Query::Type type) : query(type), state(UNAVAILABLE), timestamp(0)
+	{
+	}
+
+	bool Query::isAvailable() const
+	{
+		// Draws which were in flight when the query ended still hold a reference to it
+		return (state == FINISHED) && (query.reference == 0);
+	}
+
+	void Query::wait()
+	{
+		std::unique_lock<std::mutex> lock(query.mutex);
+		query.changed.wait(lock, [this]() { return isAvailable(); });
+	}
+
+	void Query::finish()
+	{
+		state = FINISHED;
+		query.signal();
+	}
+
 	QueryPool::QueryPool(const VkQueryPoolCreateInfo* pCreateInfo, void* mem) :
-		queryCount(pCreateInfo->queryCount)
+		pool(reinterpret_cast<Query*>(mem)), type(pCreateInfo->queryType),
+		queryCount(pCreateInfo->queryCount), pipelineStatistics(0)
+	{
+		if(type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+		{
+			pipelineStatistics = pCreateInfo->pipelineStatistics;
+		}
+
+		sw::Query::Type queryType = ConvertQueryType(type);
+
+		for(uint32_t i = 0; i < queryCount; i++)
+		{
+			new (&pool[i]) Query(queryType);
+		}
+	}
+
+	void QueryPool::destroy(const VkAllocationCallbacks* pAllocator)
 	{
-		// According to the Vulkan spec, section 34.1. Features:
-		// "pipelineStatisticsQuery specifies whether the pipeline statistics
-		//  queries are supported. If this feature is not enabled, queries of
-		//  type VK_QUERY_TYPE_PIPELINE_STATISTICS cannot be created, and
-		//  none of the VkQueryPipelineStatisticFlagBits bits can be set in the
-		//  pipelineStatistics member of the VkQueryPoolCreateInfo structure."
-		if(pCreateInfo->queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+		for(uint32_t i = 0; i < queryCount; i++)
 		{
-			UNIMPLEMENTED("pCreateInfo->queryType");
+			pool[i].~Query();
 		}
+
+		vk::deallocate(pool, pAllocator);
 	}
 
 	size_t QueryPool::ComputeRequiredAllocationSize(const VkQueryPoolCreateInfo* pCreateInfo)
 	{
-		return 0;
+		return sizeof(Query) * pCreateInfo->queryCount;
 	}
 
-	void QueryPool::getResults(uint32_t pFirstQuery, uint32_t pQueryCount, size_t pDataSize,
-	                           void* pData, VkDeviceSize pStride, VkQueryResultFlags pFlags) const
+	VkResult QueryPool::getResults(uint32_t pFirstQuery, uint32_t pQueryCount, size_t pDataSize,
+	                               void* pData, VkDeviceSize pStride, VkQueryResultFlags pFlags) const
 	{
 		// dataSize must be large enough to contain the result of each query
 		ASSERT(static_cast<size_t>(pStride * pQueryCount) <= pDataSize);
@@ -45,10 +131,130 @@ namespace vk
 		// The sum of firstQuery and queryCount must be less than or equal to the number of queries
 		ASSERT((pFirstQuery + pQueryCount) <= queryCount);
 
+		VkResult result = VK_SUCCESS;
+		size_t resultSize = (pFlags & VK_QUERY_RESULT_64_BIT) ? sizeof(uint64_t) : sizeof(uint32_t);
+
 		char* data = static_cast<char*>(pData);
 		for(uint32_t i = 0; i < pQueryCount; i++, data += pStride)
 		{
-			UNIMPLEMENTED("queries");
+			Query& query = pool[pFirstQuery + i];
+
+			if(pFlags & VK_QUERY_RESULT_WAIT_BIT)
+			{
+				query.wait();
+			}
+
+			bool available = query.isAvailable();
+
+			if(!available)
+			{
+				result = VK_NOT_READY;
+			}
+
+			// Unavailable results are only written when partial results are requested
+			bool writeResults = available || (pFlags & VK_QUERY_RESULT_PARTIAL_BIT);
+			char* out = data;
+
+			switch(type)
+			{
+			case VK_QUERY_TYPE_OCCLUSION:
+				if(writeResults)
+				{
+					WriteResult(out, pFlags, query.query.data);
+				}
+				out += resultSize;
+				break;
+			case VK_QUERY_TYPE_PIPELINE_STATISTICS:
+				for(uint32_t bits = pipelineStatistics; bits != 0; bits &= bits - 1)
+				{
+					int statistic = ConvertStatistic(static_cast<VkQueryPipelineStatisticFlagBits>(bits & ~(bits - 1)));
+
+					if(writeResults)
+					{
+						int64_t value = (statistic >= 0) ? query.query.statistics[statistic].load() : 0;
+						WriteResult(out, pFlags, value);
+					}
+					out += resultSize;
+				}
+				break;
+			case VK_QUERY_TYPE_TIMESTAMP:
+				if(writeResults)
+				{
+					WriteResult(out, pFlags, query.timestamp);
+				}
+				out += resultSize;
+				break;
+			default:
+				UNIMPLEMENTED("queryType");
+			}
+
+			if(pFlags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)
+			{
+				WriteResult(out, pFlags, available ? 1 : 0);
+			}
+		}
+
+		return result;
+	}
+
+	void QueryPool::begin(uint32_t query, VkQueryControlFlags flags, sw::Renderer* renderer)
+	{
+		ASSERT(query < queryCount);
+		ASSERT(type != VK_QUERY_TYPE_TIMESTAMP);
+
+		// Occlusion counts are always exact, so VK_QUERY_CONTROL_PRECISE_BIT needs no special handling
+		(void) flags;
+
+		Query& q = pool[query];
+		ASSERT(q.state == Query::UNAVAILABLE);
+
+		if(q.query.reference != 0)
+		{
+			// Draws from the previous use of this query are still in flight
+			renderer->synchronize();
 		}
+
+		q.query.begin();
+		q.state = Query::ACTIVE;
+		renderer->addQuery(&q.query);
+	}
+
+	void QueryPool::end(uint32_t query, sw::Renderer* renderer)
+	{
+		ASSERT(query < queryCount);
+
+		Query& q = pool[query];
+		ASSERT(q.state == Query::ACTIVE);
+
+		renderer->removeQuery(&q.query);
+		q.query.end();
+		q.finish();
+	}
+
+	void QueryPool::reset(uint32_t firstQuery, uint32_t queryCount)
+	{
+		ASSERT((firstQuery + queryCount) <= this->queryCount);
+
+		for(uint32_t i = firstQuery; i < firstQuery + queryCount; i++)
+		{
+			ASSERT(pool[i].state != Query::ACTIVE);
+
+			pool[i].state = Query::UNAVAILABLE;
+		}
+	}
+
+	void QueryPool::writeTimestamp(uint32_t query)
+	{
+		ASSERT(query < queryCount);
+		ASSERT(type == VK_QUERY_TYPE_TIMESTAMP);
+
+		// Timestamps are reported in nanoseconds, see VkPhysicalDeviceLimits::timestampPeriod
+		int64_t counter = sw::Timer::counter();
+		int64_t frequency = sw::Timer::frequency();
+		int64_t seconds = counter / frequency;
+		int64_t remainder = counter % frequency;
+
+		pool[query].timestamp = seconds * 1000000000 + (remainder * 1000000000) / frequency;
+		pool[query].finish();
 	}
 } // namespace vk
@@ -16,23 +16,51 @@
 #define VK_QUERY_POOL_HPP_
 
 #include "VkObject.hpp"
+#include "Device/Renderer.hpp"
+
+#include <atomic>
 
 namespace vk
 {
 
+struct Query
+{
+	Query(sw::Query::Type type);
+
+	enum State { UNAVAILABLE, ACTIVE, FINISHED };
+
+	bool isAvailable() const;
+	void wait();     // Blocks until the query is available
+	void finish();   // Sets the FINISHED state and wakes waiting threads
+
+	sw::Query query;          // Counters accumulated by the renderer while the query is active
+	std::atomic<int> state;
+	int64_t timestamp;        // Nanoseconds, for VK_QUERY_TYPE_TIMESTAMP
+};
+
 class QueryPool : public Object<QueryPool, VkQueryPool>
 {
 public:
 	QueryPool(const VkQueryPoolCreateInfo* pCreateInfo, void* mem);
 	~QueryPool() = delete;
+	void destroy(const VkAllocationCallbacks* pAllocator);
 
 	static size_t ComputeRequiredAllocationSize(const VkQueryPoolCreateInfo* pCreateInfo);
 
-	void getResults(uint32_t pFirstQuery, uint32_t pQueryCount, size_t pDataSize,
-		            void* pData, VkDeviceSize pStride, VkQueryResultFlags pFlags) const;
+	VkResult getResults(uint32_t pFirstQuery, uint32_t pQueryCount, size_t pDataSize,
+	                    void* pData, VkDeviceSize pStride, VkQueryResultFlags pFlags) const;
+
+	// Executed by the queue when the corresponding commands are played back
+	void begin(uint32_t query, VkQueryControlFlags flags, sw::Renderer* renderer);
+	void end(uint32_t query, sw::Renderer* renderer);
+	void reset(uint32_t firstQuery, uint32_t queryCount);
+	void writeTimestamp(uint32_t query);
 
 private:
+	Query* pool;
+	VkQueryType type;
 	uint32_t queryCount;
+	VkQueryPipelineStatisticFlags pipelineStatistics;
 };
 
 static inline QueryPool* Cast(VkQueryPool object)
@@ -19,6 +19,8 @@
 #include "Device/Renderer.hpp"
 #include "WSI/VkSwapchainKHR.hpp"
 
+#include <cstring>
+
 namespace vk
 {
 
@@ -26,19 +28,123 @@ Queue::Queue(uint32_t pFamilyIndex, float pPriority) : familyIndex(pFamilyIndex)
 {
 	context = new sw::Context();
 	renderer = new sw::Renderer(context, sw::OpenGL, true);
+
+	queueThread = std::thread(&Queue::taskLoop, this);
 }
 
 void Queue::destroy()
 {
+	Task task;
+	task.type = Task::KILL_THREAD;
+	enqueue(task);
+
+	queueThread.join();
+
 	delete context;
 	delete renderer;
 }
 
-void Queue::submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+void* Queue::DeepCopySubmitInfo(uint32_t submitCount, const VkSubmitInfo* pSubmits)
 {
+	// The application is free to release the submit info arrays as soon as vkQueueSubmit()
+	// returns, so everything the queue thread needs is copied into a single allocation.
+	size_t totalSize = sizeof(VkSubmitInfo) * submitCount;
+	for(uint32_t i = 0; i < submitCount; i++)
+	{
+		totalSize += pSubmits[i].waitSemaphoreCount * sizeof(VkSemaphore);
+		totalSize += pSubmits[i].waitSemaphoreCount * sizeof(VkPipelineStageFlags);
+		totalSize += pSubmits[i].signalSemaphoreCount * sizeof(VkSemaphore);
+		totalSize += pSubmits[i].commandBufferCount * sizeof(VkCommandBuffer);
+	}
+
+	uint8_t* mem = static_cast<uint8_t*>(vk::allocate(totalSize, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+	VkSubmitInfo* submits = reinterpret_cast<VkSubmitInfo*>(mem);
+	memcpy(submits, pSubmits, sizeof(VkSubmitInfo) * submitCount);
+	mem += sizeof(VkSubmitInfo) * submitCount;
+
 	for(uint32_t i = 0; i < submitCount; i++)
 	{
-		auto& submitInfo = pSubmits[i];
+		size_t size = pSubmits[i].waitSemaphoreCount * sizeof(VkSemaphore);
+		submits[i].pWaitSemaphores = reinterpret_cast<const VkSemaphore*>(mem);
+		memcpy(mem, pSubmits[i].pWaitSemaphores, size);
+		mem += size;
+
+		size = pSubmits[i].waitSemaphoreCount * sizeof(VkPipelineStageFlags);
+		submits[i].pWaitDstStageMask = reinterpret_cast<const VkPipelineStageFlags*>(mem);
+		memcpy(mem, pSubmits[i].pWaitDstStageMask, size);
+		mem += size;
+
+		size = pSubmits[i].signalSemaphoreCount * sizeof(VkSemaphore);
+		submits[i].pSignalSemaphores = reinterpret_cast<const VkSemaphore*>(mem);
+		memcpy(mem, pSubmits[i].pSignalSemaphores, size);
+		mem += size;
+
+		size = pSubmits[i].commandBufferCount * sizeof(VkCommandBuffer);
+		submits[i].pCommandBuffers = reinterpret_cast<const VkCommandBuffer*>(mem);
+		memcpy(mem, pSubmits[i].pCommandBuffers, size);
+		mem += size;
+	}
+
+	return submits;
+}
+
+void Queue::submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+{
+	Task task;
+	task.submitCount = submitCount;
+	task.pSubmits = static_cast<VkSubmitInfo*>(DeepCopySubmitInfo(submitCount, pSubmits));
+	task.fence = vk::Cast(fence);
+
+	enqueue(task);
+}
+
+void Queue::enqueue(const Task& task)
+{
+	std::unique_lock<std::mutex> lock(pendingMutex);
+	pending.push(task);
+	pendingCount++;
+	pendingCondition.notify_all();
+}
+
+void Queue::taskLoop()
+{
+	while(true)
+	{
+		Task task;
+
+		{
+			std::unique_lock<std::mutex> lock(pendingMutex);
+			pendingCondition.wait(lock, [this] { return !pending.empty(); });
+			task = pending.front();
+			pending.pop();
+		}
+
+		switch(task.type)
+		{
+		case Task::KILL_THREAD:
+			return;
+		case Task::SUBMIT_QUEUE:
+			submitQueue(task);
+			break;
+		default:
+			UNIMPLEMENTED("task.type %d", static_cast<int>(task.type));
+			break;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(pendingMutex);
+			pendingCount--;
+			pendingCondition.notify_all();
+		}
+	}
+}
+
+void Queue::submitQueue(const Task& task)
+{
+	for(uint32_t i = 0; i < task.submitCount; i++)
+	{
+		auto& submitInfo = task.pSubmits[i];
 		for(uint32_t j = 0; j < submitInfo.waitSemaphoreCount; j++)
 		{
 			vk::Cast(submitInfo.pWaitSemaphores[j])->wait(submitInfo.pWaitDstStageMask[j]);
@@ -53,25 +159,29 @@ void Queue::submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence f
 			}
 		}
 
+		// All work of this batch must be complete before its semaphores are signaled
+		renderer->synchronize();
+
 		for(uint32_t j = 0; j < submitInfo.signalSemaphoreCount; j++)
 		{
 			vk::Cast(submitInfo.pSignalSemaphores[j])->signal();
 		}
 	}
 
-	// FIXME (b/117835459): signal the fence only once the work is completed
-	if(fence != VK_NULL_HANDLE)
+	if(task.fence)
 	{
-		vk::Cast(fence)->signal();
+		task.fence->signal();
 	}
+
+	vk::deallocate(task.pSubmits, DEVICE_MEMORY);
 }
 
 void Queue::waitIdle()
 {
 	// equivalent to submitting a fence to a queue and waiting
 	// with an infinite timeout for that fence to signal
-
-	// FIXME (b/117835459): implement once we have working fences
+	std::unique_lock<std::mutex> lock(pendingMutex);
+	pendingCondition.wait(lock, [this] { return pendingCount == 0; });
 }
 
 void Queue::present(const VkPresentInfoKHR* presentInfo)
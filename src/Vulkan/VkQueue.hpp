@@ -18,6 +18,11 @@
 #include "VkObject.hpp"
 #include <vulkan/vk_icd.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
 namespace sw
 {
 	class Context;
@@ -27,6 +32,8 @@ namespace sw
 namespace vk
 {
 
+class Fence;
+
 class Queue
 {
 	VK_LOADER_DATA loaderData = { ICD_LOADER_MAGIC };
@@ -46,6 +53,27 @@ public:
 	void present(const VkPresentInfoKHR* presentInfo);
 
 private:
+	struct Task
+	{
+		enum Type { SUBMIT_QUEUE, KILL_THREAD };
+
+		Type type = SUBMIT_QUEUE;
+		uint32_t submitCount = 0;
+		VkSubmitInfo* pSubmits = nullptr;  // Deep copy of the application's submit infos, owned by the task
+		Fence* fence = nullptr;
+	};
+
+	static void* DeepCopySubmitInfo(uint32_t submitCount, const VkSubmitInfo* pSubmits);
+	void enqueue(const Task& task);
+	void taskLoop();
+	void submitQueue(const Task& task);
+
+	std::thread queueThread;
+	std::mutex pendingMutex;
+	std::condition_variable pendingCondition;  // Signaled when a task is added or the queue becomes idle
+	std::queue<Task> pending;
+	uint32_t pendingCount = 0;  // Tasks which have been enqueued but not yet completed
+
 	sw::Context* context = nullptr;
 	sw::Renderer* renderer = nullptr;
 	uint32_t familyIndex = 0;
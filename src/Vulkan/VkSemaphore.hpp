@@ -17,6 +17,9 @@
 
 #include "VkObject.hpp"
 
+#include <condition_variable>
+#include <mutex>
+
 namespace vk
 {
 
@@ -32,24 +35,33 @@ public:
 		return 0;
 	}
 
+	// Binary semaphore: a wait blocks until the semaphore is signaled, then unsignals it.
 	void wait()
 	{
-		// Semaphores are noop for now
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this] { return signaled; });
+		signaled = false;
 	}
 
 	void wait(const VkPipelineStageFlags& flag)
 	{
 		// VkPipelineStageFlags is the pipeline stage at which the semaphore wait will occur
 
-		// Semaphores are noop for now
+		// FIXME(b/117835459): We currently ignore the stage flags and wait before any work of the batch starts
+		wait();
 	}
 
 	void signal()
 	{
-		// Semaphores are noop for now
+		std::unique_lock<std::mutex> lock(mutex);
+		signaled = true;
+		condition.notify_one();
 	}
 
 private:
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool signaled = false;
 };
 
 static inline Semaphore* Cast(VkSemaphore object)
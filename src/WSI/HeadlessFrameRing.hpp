@@ -0,0 +1,68 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SWIFTSHADER_HEADLESSFRAMERING_HPP
+#define SWIFTSHADER_HEADLESSFRAMERING_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+namespace vk
+{
+
+// Layout of the POSIX shared memory object which a headless surface publishes
+// its presented frames into, when SWIFTSHADER_HEADLESS_RING names one (e.g.
+// "/swiftshader-frames"). The swapchain images live in the ring's slots, so a
+// consumer process which maps the object reads the frames without any copy.
+//
+// Frames are numbered from 1. The producer stores a frame's number in the
+// slot's slotFrame entry, then in 'published'. A consumer:
+//  - FIFO: reads frame 'consumed + 1' once published, from the slot holding it,
+//    then stores that number in 'consumed'. Every frame is delivered, and the
+//    application blocks in vkAcquireNextImageKHR while the consumer lags.
+//  - MAILBOX: stores 'published' in 'reading', checks that the slot still holds
+//    that frame (retrying otherwise), reads it, then stores 0 in 'reading'.
+//    Frames may be skipped, and the application never waits for the consumer.
+// When 'closed' becomes non-zero the swapchain has been recreated or destroyed,
+// and the consumer should unmap the object and open it again by name.
+struct HeadlessFrameRing
+{
+	enum : uint32_t
+	{
+		MAGIC = 0x52465753,   // "SWFR"
+		VERSION = 1,
+		MAX_SLOTS = 16,
+	};
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t presentMode;   // VkPresentModeKHR
+	uint32_t format;        // VkFormat
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowPitch;      // In bytes
+	uint64_t slotOffset;    // Offset of the first slot from the start of the object, in bytes
+	uint64_t slotSize;      // Distance between consecutive slots, in bytes
+
+	std::atomic<uint32_t> closed;
+	std::atomic<uint64_t> published;
+	std::atomic<uint64_t> consumed;   // Written by the consumer
+	std::atomic<uint64_t> reading;    // Written by the consumer
+	std::atomic<uint64_t> slotFrame[MAX_SLOTS];
+};
+
+}
+
+#endif //SWIFTSHADER_HEADLESSFRAMERING_HPP
@@ -0,0 +1,260 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "HeadlessSurfaceKHR.hpp"
+
+#include "VkSwapchainKHR.hpp"
+#include "Vulkan/VkConfig.h"
+#include "Vulkan/VkImage.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+namespace vk {
+
+namespace {
+
+size_t roundUp(size_t value, size_t alignment)
+{
+	return ((value + alignment - 1) / alignment) * alignment;
+}
+
+}
+
+HeadlessSurfaceKHR::HeadlessSurfaceKHR(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo, void *mem)
+{
+	presentModes.push_back(VK_PRESENT_MODE_MAILBOX_KHR);
+
+#if !defined(_WIN32)
+	const char *name = getenv("SWIFTSHADER_HEADLESS_RING");
+	if(name && (strlen(name) < sizeof(ringName)))
+	{
+		strcpy(ringName, name);
+	}
+#endif
+}
+
+void HeadlessSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
+{
+	// The destructor isn't run, so release the ring mappings here
+	slots.clear();
+	currentRing.reset();
+
+#if !defined(_WIN32)
+	if(ringCreated)
+	{
+		shm_unlink(ringName);
+	}
+#endif
+}
+
+size_t HeadlessSurfaceKHR::ComputeRequiredAllocationSize(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo)
+{
+	return 0;
+}
+
+void HeadlessSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const
+{
+	SurfaceKHR::getSurfaceCapabilities(pSurfaceCapabilities);
+
+	// The ring holds one slot per swapchain image
+	pSurfaceCapabilities->maxImageCount = HeadlessFrameRing::MAX_SLOTS;
+
+	// The extent is determined by the swapchain
+	const uint32_t maxDimension = 1 << (MAX_IMAGE_LEVELS_2D - 1);
+	pSurfaceCapabilities->currentExtent = { 0xFFFFFFFF, 0xFFFFFFFF };
+	pSurfaceCapabilities->minImageExtent = { 1, 1 };
+	pSurfaceCapabilities->maxImageExtent = { maxDimension, maxDimension };
+}
+
+std::shared_ptr<HeadlessSurfaceKHR::Ring> HeadlessSurfaceKHR::createRing(PresentImage* image, VkDeviceSize imageSize)
+{
+#if defined(_WIN32)
+	return nullptr;
+#else
+	SwapchainKHR *swapchain = vk::Cast(getAssociatedSwapchain());
+	const VkSwapchainCreateInfoKHR &createInfo = swapchain->getCreateInfo();
+	const uint32_t slotCount = swapchain->getImageCount();
+	if(slotCount > HeadlessFrameRing::MAX_SLOTS)
+	{
+		return nullptr;
+	}
+
+	// Slots are page aligned, which satisfies any image memory alignment
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t slotOffset = roundUp(sizeof(HeadlessFrameRing), pageSize);
+	const size_t slotSize = roundUp(static_cast<size_t>(imageSize), pageSize);
+	const size_t size = slotOffset + slotSize * slotCount;
+
+	// Consumers which still map the previous swapchain's object keep its pages
+	// until they unmap it, after they've seen it closed.
+	shm_unlink(ringName);
+	int fd = shm_open(ringName, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd < 0)
+	{
+		return nullptr;
+	}
+
+	ringCreated = true;
+
+	void *mapping = MAP_FAILED;
+	if(ftruncate(fd, static_cast<off_t>(size)) == 0)
+	{
+		mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+
+	close(fd);   // The mapping keeps the object alive
+
+	if(mapping == MAP_FAILED)
+	{
+		shm_unlink(ringName);
+		return nullptr;
+	}
+
+	HeadlessFrameRing *header = new (mapping) HeadlessFrameRing();
+	header->version = HeadlessFrameRing::VERSION;
+	header->slotCount = slotCount;
+	header->presentMode = createInfo.presentMode;
+	header->format = createInfo.imageFormat;
+	header->width = createInfo.imageExtent.width;
+	header->height = createInfo.imageExtent.height;
+	header->rowPitch = vk::Cast(image->image)->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+	header->slotOffset = slotOffset;
+	header->slotSize = slotSize;
+
+	// Consumers may map the object as soon as it exists, so the magic number
+	// is what tells them the header is complete.
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = HeadlessFrameRing::MAGIC;
+
+	auto ring = std::make_shared<Ring>();
+	ring->swapchain = getAssociatedSwapchain();
+	ring->header = header;
+	ring->size = size;
+
+	return ring;
+#endif
+}
+
+HeadlessSurfaceKHR::Ring::~Ring()
+{
+#if !defined(_WIN32)
+	if(header)
+	{
+		header->closed.store(1);
+		munmap(header, size);
+	}
+#endif
+}
+
+void* HeadlessSurfaceKHR::allocateImageMemory(PresentImage* image, VkDeviceSize size)
+{
+	if(ringName[0] == '\0')
+	{
+		return nullptr;
+	}
+
+	if(!currentRing || (currentRing->swapchain != getAssociatedSwapchain()))
+	{
+		currentRing = createRing(image, size);
+
+		if(!currentRing)
+		{
+			return nullptr;
+		}
+	}
+
+	HeadlessFrameRing *header = currentRing->header;
+	if((currentRing->slotsAllocated >= header->slotCount) || (size > header->slotSize))
+	{
+		return nullptr;
+	}
+
+	uint32_t index = currentRing->slotsAllocated++;
+	slots[image] = { currentRing, index };
+
+	return reinterpret_cast<uint8_t*>(header) + header->slotOffset + index * header->slotSize;
+}
+
+bool HeadlessSurfaceKHR::tryAcquireImage(PresentImage* image)
+{
+	auto it = slots.find(image);
+	if(it == slots.end())
+	{
+		return true;
+	}
+
+	HeadlessFrameRing *header = it->second.ring->header;
+	std::atomic<uint64_t> &slotFrame = header->slotFrame[it->second.index];
+	uint64_t frame = slotFrame.load();
+
+	if(frame == 0)
+	{
+		return true;
+	}
+
+	if(header->presentMode == VK_PRESENT_MODE_FIFO_KHR)
+	{
+		// Wait for the consumer to have read every frame up to this one
+		return frame <= header->consumed.load();
+	}
+
+	// MAILBOX: keep the latest frame, and the one being read. Invalidating the slot
+	// before checking 'reading', while the consumer sets 'reading' before checking
+	// the slot, guarantees at least one of the two sees the other.
+	if((frame == header->published.load()) && (header->slotCount > 1))
+	{
+		return false;
+	}
+
+	slotFrame.store(0);
+	if(header->reading.load() == frame)
+	{
+		slotFrame.store(frame);
+		return false;
+	}
+
+	return true;
+}
+
+void HeadlessSurfaceKHR::attachImage(PresentImage* image)
+{
+}
+
+void HeadlessSurfaceKHR::detachImage(PresentImage* image)
+{
+	slots.erase(image);
+}
+
+void HeadlessSurfaceKHR::present(PresentImage* image)
+{
+	auto it = slots.find(image);
+	if(it != slots.end())
+	{
+		HeadlessFrameRing *header = it->second.ring->header;
+		uint64_t frame = header->published.load() + 1;
+
+		header->slotFrame[it->second.index].store(frame);
+		header->published.store(frame);
+	}
+}
+
+}
@@ -0,0 +1,95 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SWIFTSHADER_HEADLESSSURFACEKHR_HPP
+#define SWIFTSHADER_HEADLESSSURFACEKHR_HPP
+
+#include "Vulkan/VkObject.hpp"
+#include "HeadlessFrameRing.hpp"
+#include "VkSurfaceKHR.hpp"
+
+#include <map>
+#include <memory>
+
+// VK_EXT_headless_surface is newer than the Vulkan headers in include/vulkan
+#ifndef VK_EXT_headless_surface
+#define VK_EXT_headless_surface 1
+#define VK_EXT_HEADLESS_SURFACE_SPEC_VERSION 1
+#define VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME "VK_EXT_headless_surface"
+#define VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT static_cast<VkStructureType>(1000256000)
+
+typedef VkFlags VkHeadlessSurfaceCreateFlagsEXT;
+
+typedef struct VkHeadlessSurfaceCreateInfoEXT {
+	VkStructureType                    sType;
+	const void*                        pNext;
+	VkHeadlessSurfaceCreateFlagsEXT    flags;
+} VkHeadlessSurfaceCreateInfoEXT;
+
+typedef VkResult (VKAPI_PTR *PFN_vkCreateHeadlessSurfaceEXT)(VkInstance instance, const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+
+extern "C" VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(VkInstance instance, const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+#endif
+
+namespace vk {
+
+// A surface which isn't displayed. Presented images are published into a shared
+// memory HeadlessFrameRing if the SWIFTSHADER_HEADLESS_RING environment variable
+// names one, and are otherwise discarded.
+class HeadlessSurfaceKHR : public SurfaceKHR, public ObjectBase<HeadlessSurfaceKHR, VkSurfaceKHR> {
+public:
+	HeadlessSurfaceKHR(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo, void *mem);
+
+	~HeadlessSurfaceKHR() = delete;
+
+	void destroySurface(const VkAllocationCallbacks *pAllocator) override;
+
+	static size_t ComputeRequiredAllocationSize(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo);
+
+	void getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const override;
+
+	virtual void* allocateImageMemory(PresentImage* image, VkDeviceSize size) override;
+	virtual bool tryAcquireImage(PresentImage* image) override;
+	virtual void attachImage(PresentImage* image) override;
+	virtual void detachImage(PresentImage* image) override;
+	void present(PresentImage* image) override;
+
+private:
+	// A mapping of the frame ring, shared by the images of one swapchain
+	struct Ring
+	{
+		~Ring();
+
+		VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+		HeadlessFrameRing *header = nullptr;
+		size_t size = 0;
+		uint32_t slotsAllocated = 0;
+	};
+
+	struct Slot
+	{
+		std::shared_ptr<Ring> ring;
+		uint32_t index;
+	};
+
+	std::shared_ptr<Ring> createRing(PresentImage* image, VkDeviceSize imageSize);
+
+	char ringName[256] = {};
+	bool ringCreated = false;
+	std::shared_ptr<Ring> currentRing;
+	std::map<PresentImage*, Slot> slots;
+};
+
+}
+#endif //SWIFTSHADER_HEADLESSSURFACEKHR_HPP
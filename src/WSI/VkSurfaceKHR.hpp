@@ -60,6 +60,13 @@ public:
 	uint32_t getPresentModeCount() const;
 	VkResult getPresentModes(uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes) const;
 
+	// Returns host memory which will back the image, allowing the surface to present it
+	// without a copy, or nullptr to let the swapchain allocate the memory. Called before
+	// attachImage(). The surface releases the memory in detachImage().
+	virtual void* allocateImageMemory(PresentImage* image, VkDeviceSize size) { return nullptr; }
+	// Returns false while the surface still needs an available image's contents,
+	// in which case the swapchain can't hand it out for rendering yet.
+	virtual bool tryAcquireImage(PresentImage* image) { return true; }
 	virtual void attachImage(PresentImage* image) = 0;
 	virtual void detachImage(PresentImage* image) = 0;
 	virtual void present(PresentImage* image) = 0;
@@ -68,6 +75,11 @@ public:
 	void disassociateSwapchain();
 	VkSwapchainKHR getAssociatedSwapchain();
 
+protected:
+	std::vector<VkPresentModeKHR> presentModes =
+	{
+		VK_PRESENT_MODE_FIFO_KHR,
+	};
 
 private:
 	VkSwapchainKHR associatedSwapchain;
@@ -76,11 +88,6 @@ private:
 	{
 		{VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
 	};
-
-	const std::vector<VkPresentModeKHR> presentModes =
-	{
-		VK_PRESENT_MODE_FIFO_KHR,
-	};
 };
 
 static inline SurfaceKHR* Cast(VkSurfaceKHR object)
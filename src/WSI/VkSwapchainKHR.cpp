@@ -19,6 +19,8 @@
 #include "Vulkan/VkDestroy.h"
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 namespace vk
 {
@@ -135,9 +137,19 @@ VkResult SwapchainKHR::createImages(VkDevice device)
 		allocInfo.allocationSize = memRequirements.size;
 		allocInfo.memoryTypeIndex = 0;
 
+		VkImportMemoryHostPointerInfoEXT hostPointerInfo = {};
+		hostPointerInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+		hostPointerInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+		hostPointerInfo.pHostPointer = vk::Cast(createInfo.surface)->allocateImageMemory(&currentImage, memRequirements.size);
+		if(hostPointerInfo.pHostPointer)
+		{
+			allocInfo.pNext = &hostPointerInfo;
+		}
+
 		status = vkAllocateMemory(device, &allocInfo, nullptr, &currentImage.imageMemory);
 		if(status != VK_SUCCESS)
 		{
+			vk::Cast(createInfo.surface)->detachImage(&currentImage);
 			return status;
 		}
 
@@ -178,29 +190,54 @@ VkResult SwapchainKHR::getImages(uint32_t *pSwapchainImageCount, VkImage *pSwapc
 
 VkResult SwapchainKHR::getNextImage(uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t *pImageIndex)
 {
-	for(uint32_t i = 0; i < getImageCount(); i++)
+	auto start = std::chrono::steady_clock::now();
+
+	while(true)
 	{
-		PresentImage& currentImage = images[i];
-		if(currentImage.imageStatus == AVAILABLE)
-		{
-			currentImage.imageStatus = DRAWING;
-			*pImageIndex = i;
+		bool heldBySurface = false;
 
-			if(semaphore)
+		for(uint32_t i = 0; i < getImageCount(); i++)
+		{
+			PresentImage& currentImage = images[i];
+			if(currentImage.imageStatus == AVAILABLE)
 			{
-				vk::Cast(semaphore)->signal();
+				if(!vk::Cast(createInfo.surface)->tryAcquireImage(&currentImage))
+				{
+					heldBySurface = true;
+					continue;
+				}
+
+				currentImage.imageStatus = DRAWING;
+				*pImageIndex = i;
+
+				if(semaphore)
+				{
+					vk::Cast(semaphore)->signal();
+				}
+
+				if(fence)
+				{
+					vk::Cast(fence)->signal();
+				}
+
+				return VK_SUCCESS;
 			}
+		}
 
-			if(fence)
-			{
-				vk::Cast(fence)->signal();
-			}
+		// Only wait for images which the surface will eventually release
+		if(!heldBySurface || (timeout == 0))
+		{
+			return VK_NOT_READY;
+		}
 
-			return VK_SUCCESS;
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		if((timeout != UINT64_MAX) && (static_cast<uint64_t>(elapsed.count()) >= timeout))
+		{
+			return VK_TIMEOUT;
 		}
-	}
 
-	return VK_NOT_READY;
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
 }
 
 void SwapchainKHR::present(uint32_t index)
@@ -37,6 +37,8 @@ public:
 
 	void retire();
 
+	const VkSwapchainCreateInfoKHR& getCreateInfo() const { return createInfo; }
+
 	VkResult createImages(VkDevice device);
 
 	uint32_t getImageCount() const;
@@ -13,10 +13,34 @@
 
 #include "Vulkan/VkDeviceMemory.hpp"
 
+#include <sys/ipc.h>
+#include <sys/shm.h>
 #include <string.h>
 
 namespace vk {
 
+namespace {
+
+int (*PreviousXErrorHandler)(Display *display, XErrorEvent *event) = nullptr;
+bool shmBadAccess = false;
+
+// Catches BadAccess errors so we can fall back to not using MIT-SHM,
+// e.g. when the X server runs on another host.
+int XShmErrorHandler(Display *display, XErrorEvent *event)
+{
+	if(event->error_code == BadAccess)
+	{
+		shmBadAccess = true;
+		return 0;
+	}
+	else
+	{
+		return PreviousXErrorHandler(display, event);
+	}
+}
+
+}
+
 XlibSurfaceKHR::XlibSurfaceKHR(const VkXlibSurfaceCreateInfoKHR *pCreateInfo, void *mem) :
 		pDisplay(pCreateInfo->dpy),
 		window(pCreateInfo->window)
@@ -28,6 +52,8 @@ XlibSurfaceKHR::XlibSurfaceKHR(const VkXlibSurfaceCreateInfoKHR *pCreateInfo, vo
 	Status status = libX11->XMatchVisualInfo(pDisplay, screen, 32, TrueColor, &xVisual);
 	bool match = (status != 0 && xVisual.blue_mask ==0xFF);
 	visual = match ? xVisual.visual : libX11->XDefaultVisual(pDisplay, screen);
+
+	mitShm = libX11->XShmQueryExtension && (libX11->XShmQueryExtension(pDisplay) == True);
 }
 
 void XlibSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
@@ -53,6 +79,54 @@ void XlibSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCa
 	pSurfaceCapabilities->maxImageExtent = extent;
 }
 
+void* XlibSurfaceKHR::allocateImageMemory(PresentImage* image, VkDeviceSize size)
+{
+	if(!mitShm)
+	{
+		return nullptr;
+	}
+
+	// Place the image in a SysV shared memory segment which the X server reads
+	// directly, so presenting doesn't copy the frame over the socket.
+	XShmSegmentInfo shmInfo = {};
+	shmInfo.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(size), IPC_CREAT | SHM_R | SHM_W);
+	if(shmInfo.shmid < 0)
+	{
+		return nullptr;
+	}
+
+	shmInfo.shmaddr = static_cast<char*>(shmat(shmInfo.shmid, nullptr, 0));
+	shmInfo.readOnly = False;
+
+	if(shmInfo.shmaddr == reinterpret_cast<char*>(-1))
+	{
+		shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+		return nullptr;
+	}
+
+	PreviousXErrorHandler = libX11->XSetErrorHandler(XShmErrorHandler);
+	libX11->XShmAttach(pDisplay, &shmInfo);   // May produce a BadAccess error
+	libX11->XSync(pDisplay, False);
+	libX11->XSetErrorHandler(PreviousXErrorHandler);
+
+	// Once both sides are attached the segment can be marked for removal, so that
+	// it's released when the last of them detaches, even if the process crashes.
+	shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+
+	if(shmBadAccess)
+	{
+		shmBadAccess = false;
+		mitShm = false;   // Don't attempt it again for this surface
+
+		shmdt(shmInfo.shmaddr);
+		return nullptr;
+	}
+
+	shmSegments[image] = shmInfo;
+
+	return shmInfo.shmaddr;
+}
+
 void XlibSurfaceKHR::attachImage(PresentImage* image)
 {
 	XWindowAttributes attr;
@@ -63,7 +137,23 @@ void XlibSurfaceKHR::attachImage(PresentImage* image)
 	int bytes_per_line = vk::Cast(image->image)->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 	char* buffer = static_cast<char*>(vk::Cast(image->imageMemory)->getOffsetPointer(0));
 
-	XImage* xImage = libX11->XCreateImage(pDisplay, visual, attr.depth, ZPixmap, 0, buffer, extent.width, extent.height, 32, bytes_per_line);
+	XImage* xImage = nullptr;
+
+	auto shm = shmSegments.find(image);
+	if(shm != shmSegments.end())
+	{
+		xImage = libX11->XShmCreateImage(pDisplay, visual, attr.depth, ZPixmap, buffer, &shm->second, extent.width, extent.height);
+
+		if(xImage)
+		{
+			ASSERT(xImage->bytes_per_line <= bytes_per_line);
+			xImage->bytes_per_line = bytes_per_line;
+		}
+	}
+	else
+	{
+		xImage = libX11->XCreateImage(pDisplay, visual, attr.depth, ZPixmap, 0, buffer, extent.width, extent.height, 32, bytes_per_line);
+	}
 
 	imageMap[image] = xImage;
 }
@@ -74,9 +164,21 @@ void XlibSurfaceKHR::detachImage(PresentImage* image)
 	if(it != imageMap.end())
 	{
 		XImage* xImage = it->second;
-		xImage->data = nullptr; // the XImage does not actually own the buffer
-		XDestroyImage(xImage);
-		imageMap.erase(image);
+		if(xImage)
+		{
+			xImage->data = nullptr; // the XImage does not actually own the buffer
+			XDestroyImage(xImage);
+		}
+		imageMap.erase(it);
+	}
+
+	auto shm = shmSegments.find(image);
+	if(shm != shmSegments.end())
+	{
+		libX11->XShmDetach(pDisplay, &shm->second);
+		libX11->XSync(pDisplay, False);
+		shmdt(shm->second.shmaddr);
+		shmSegments.erase(shm);
 	}
 }
 
@@ -87,10 +189,22 @@ void XlibSurfaceKHR::present(PresentImage* image)
 	{
 		XImage* xImage = it->second;
 
-		if(xImage->data)
+		if(xImage && xImage->data)
 		{
 			VkExtent3D extent = vk::Cast(image->image)->getMipLevelExtent(0);
-			libX11->XPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height);
+
+			if(shmSegments.find(image) != shmSegments.end())
+			{
+				libX11->XShmPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height, False);
+
+				// The X server reads the image asynchronously, so wait for it before the
+				// swapchain hands the image back to the application for rendering.
+				libX11->XSync(pDisplay, False);
+			}
+			else
+			{
+				libX11->XPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height);
+			}
 		}
 	}
 }
@@ -36,6 +36,7 @@ public:
 
 	void getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const override;
 
+	virtual void* allocateImageMemory(PresentImage* image, VkDeviceSize size) override;
 	virtual void attachImage(PresentImage* image) override;
 	virtual void detachImage(PresentImage* image) override;
 	void present(PresentImage* image) override;
@@ -45,7 +46,9 @@ private:
 	Window window;
 	GC gc;
 	Visual *visual = nullptr;
+	bool mitShm = false;
 	std::map<PresentImage*, XImage*> imageMap;
+	std::map<PresentImage*, XShmSegmentInfo> shmSegments;  // Images whose memory is shared with the X server
 };
 
 }
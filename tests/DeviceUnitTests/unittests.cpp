@@ -0,0 +1,457 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests of the device's routine cache and on-disk routine store, which are internal
+// to the driver.
+
+#include "Device/RoutineCache.hpp"
+#include "Device/RoutineStore.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+	#include <dirent.h>
+	#include <stdlib.h>
+	#include <unistd.h>
+#endif
+
+using namespace sw;
+
+namespace
+{
+	struct TestState
+	{
+		explicit TestState(int id) : id(id), hash(static_cast<uint32_t>(id)) {}
+
+		bool operator==(const TestState &state) const { return id == state.id; }
+
+		int id;
+		uint32_t hash;
+	};
+
+	// Counts the routines which are still alive, to tell when the cache releases them
+	class TestRoutine : public Routine
+	{
+	public:
+		explicit TestRoutine(std::atomic<int> &live) : live(live) { live++; }
+
+		~TestRoutine() override { live--; }
+
+		const void *getEntry() override { return nullptr; }
+
+	private:
+		std::atomic<int> &live;
+	};
+
+	class RoutineCacheTest : public testing::Test
+	{
+	protected:
+		// Looks up the state, and releases the caller's reference right away
+		Routine *lookup(RoutineCache<TestState> &cache, int id)
+		{
+			Routine *routine = cache.getOrCreate(TestState(id), [&]()
+			{
+				generated++;
+				return new TestRoutine(live);
+			});
+
+			if(routine)
+			{
+				routine->unbind();
+			}
+
+			return routine;
+		}
+
+		std::atomic<int> generated{0};
+		std::atomic<int> live{0};
+	};
+}
+
+TEST_F(RoutineCacheTest, Hit)
+{
+	{
+		RoutineCache<TestState> cache(4);
+
+		Routine *first = lookup(cache, 1);
+		Routine *second = lookup(cache, 1);
+
+		EXPECT_NE(first, nullptr);
+		EXPECT_EQ(first, second);
+		EXPECT_EQ(generated, 1);
+		EXPECT_EQ(live, 1);
+	}
+
+	EXPECT_EQ(live, 0);
+}
+
+TEST_F(RoutineCacheTest, Miss)
+{
+	{
+		RoutineCache<TestState> cache(4);
+
+		Routine *first = lookup(cache, 1);
+		Routine *second = lookup(cache, 2);
+
+		EXPECT_NE(first, second);
+		EXPECT_EQ(generated, 2);
+		EXPECT_EQ(live, 2);
+	}
+
+	EXPECT_EQ(live, 0);
+}
+
+TEST_F(RoutineCacheTest, FailureIsNotCached)
+{
+	RoutineCache<TestState> cache(4);
+	TestState state(1);
+	int attempts = 0;
+
+	auto fail = [&]() -> Routine* { attempts++; return nullptr; };
+
+	EXPECT_EQ(cache.getOrCreate(state, fail), nullptr);
+	EXPECT_EQ(cache.getOrCreate(state, fail), nullptr);
+	EXPECT_EQ(attempts, 2);
+
+	// The state can still be generated successfully afterwards
+	EXPECT_NE(lookup(cache, 1), nullptr);
+	EXPECT_NE(lookup(cache, 1), nullptr);
+	EXPECT_EQ(generated, 1);
+}
+
+TEST_F(RoutineCacheTest, Eviction)
+{
+	{
+		RoutineCache<TestState> cache(2);
+
+		lookup(cache, 0);
+		lookup(cache, 1);
+		lookup(cache, 2);   // Evicts 0, the least recently used
+
+		EXPECT_EQ(generated, 3);
+		EXPECT_EQ(live, 2);
+
+		lookup(cache, 1);   // Hit, which gives 1 a second chance
+		lookup(cache, 3);   // Evicts 2
+
+		EXPECT_EQ(generated, 4);
+		EXPECT_EQ(live, 2);
+
+		lookup(cache, 1);
+		lookup(cache, 3);
+
+		EXPECT_EQ(generated, 4);
+
+		lookup(cache, 2);
+
+		EXPECT_EQ(generated, 5);
+		EXPECT_EQ(live, 2);
+	}
+
+	EXPECT_EQ(live, 0);
+}
+
+TEST_F(RoutineCacheTest, EvictionKeepsRoutinesInUse)
+{
+	RoutineCache<TestState> cache(1);
+
+	Routine *routine = cache.getOrCreate(TestState(0), [&]() { return new TestRoutine(live); });
+
+	lookup(cache, 1);
+	lookup(cache, 2);
+
+	// Evicted from the cache, but still bound by the caller
+	EXPECT_EQ(live, 2);
+	routine->unbind();
+	EXPECT_EQ(live, 1);
+}
+
+TEST_F(RoutineCacheTest, ConcurrentMisses)
+{
+	RoutineCache<TestState> cache(4);
+	std::vector<std::thread> threads;
+	std::atomic<int> routines{0};
+
+	for(int i = 0; i < 8; i++)
+	{
+		threads.push_back(std::thread([&]()
+		{
+			Routine *routine = cache.getOrCreate(TestState(1), [&]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				generated++;
+				return new TestRoutine(live);
+			});
+
+			if(routine)
+			{
+				routines++;
+				routine->unbind();
+			}
+		}));
+	}
+
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(routines, 8);
+	EXPECT_EQ(generated, 1);
+	EXPECT_EQ(live, 1);
+}
+
+#if defined(__linux__)
+namespace
+{
+	// Layout of the start of each stored file
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t keySize;
+		uint64_t entrySize;
+		uint64_t codeSize;
+		uint64_t codeDigest;
+	};
+
+	class RoutineStoreTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			std::string pattern = testing::TempDir() + "swiftshader-store-XXXXXX";
+			std::vector<char> path(pattern.begin(), pattern.end());
+			path.push_back('\0');
+
+			ASSERT_NE(mkdtemp(path.data()), nullptr);
+			directory = path.data();
+
+			RoutineStore::enable(directory, &settings, sizeof(settings));
+			ASSERT_TRUE(RoutineStore::isEnabled());
+		}
+
+		void TearDown() override
+		{
+			RoutineStore::disable();
+
+			for(const std::string &file : files())
+			{
+				unlink(file.c_str());
+			}
+
+			rmdir(directory.c_str());
+		}
+
+		// Returns the value the routine returns, generating it if it isn't stored
+		int run(const RoutineStore::Key &key, int value)
+		{
+			Routine *routine = RoutineStore::getOrGenerate(key, [&]()
+			{
+				generated++;
+
+				Function<Int()> function;
+				{
+					Return(Int(value));
+				}
+
+				return function("stored");
+			});
+
+			if(!routine)
+			{
+				return -1;
+			}
+
+			int (*callable)() = (int(*)())routine->getEntry();
+			int result = callable();
+
+			delete routine;
+
+			return result;
+		}
+
+		std::vector<std::string> files() const
+		{
+			std::vector<std::string> paths;
+			DIR *dir = opendir(directory.c_str());
+
+			while(dirent *entry = dir ? readdir(dir) : nullptr)
+			{
+				if(entry->d_name[0] != '.')
+				{
+					paths.push_back(directory + "/" + entry->d_name);
+				}
+			}
+
+			if(dir)
+			{
+				closedir(dir);
+			}
+
+			return paths;
+		}
+
+		static std::vector<uint8_t> readFile(const std::string &path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		static void writeFile(const std::string &path, const std::vector<uint8_t> &contents)
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		}
+
+		std::string directory;
+		int settings = 7;
+		int generated = 0;
+	};
+}
+
+TEST_F(RoutineStoreTest, StoreAndLoad)
+{
+	RoutineStore::Key key("TestRoutine");
+	key.add(1);
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 1);
+	ASSERT_EQ(files().size(), 1u);
+
+	// The stored routine is loaded instead of generated again
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 1);
+
+	// Other keys get their own file
+	RoutineStore::Key other("TestRoutine");
+	other.add(2);
+
+	EXPECT_EQ(run(other, 43), 43);
+	EXPECT_EQ(generated, 2);
+	EXPECT_EQ(files().size(), 2u);
+}
+
+TEST_F(RoutineStoreTest, FileFormat)
+{
+	RoutineStore::Key key("TestRoutine");
+	key.add(1);
+
+	run(key, 42);
+	ASSERT_EQ(files().size(), 1u);
+
+	std::vector<uint8_t> file = readFile(files()[0]);
+	ASSERT_GE(file.size(), sizeof(FileHeader));
+
+	FileHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+
+	EXPECT_EQ(header.magic, 0x53525753u);   // "SWRS"
+	EXPECT_EQ(header.version, 1u);
+	EXPECT_GT(header.codeSize, 0u);
+	EXPECT_EQ(file.size(), sizeof(FileHeader) + header.keySize + header.entrySize + header.codeSize);
+
+	// The key starts with the build ID, and ends with the key of the routine itself
+	const uint8_t *storedKey = file.data() + sizeof(FileHeader);
+	uint64_t buildIDSize = 0;
+	memcpy(&buildIDSize, storedKey, sizeof(buildIDSize));
+
+	const char name[] = "TestRoutine";
+	int value = 1;
+	std::vector<uint8_t> routineKey(name, name + sizeof(name));
+	routineKey.insert(routineKey.end(), reinterpret_cast<uint8_t*>(&value), reinterpret_cast<uint8_t*>(&value + 1));
+
+	EXPECT_GT(buildIDSize, 0u);
+	ASSERT_GE(header.keySize, sizeof(buildIDSize) + buildIDSize + sizeof(settings) + routineKey.size());
+	EXPECT_EQ(memcmp(storedKey + header.keySize - routineKey.size(), routineKey.data(), routineKey.size()), 0);
+	EXPECT_EQ(memcmp(storedKey + header.keySize - routineKey.size() - sizeof(settings), &settings, sizeof(settings)), 0);
+}
+
+TEST_F(RoutineStoreTest, StaleBuildID)
+{
+	RoutineStore::Key key("TestRoutine");
+
+	run(key, 42);
+	ASSERT_EQ(files().size(), 1u);
+
+	// Pretend the file was written by another build of the library
+	std::string path = files()[0];
+	std::vector<uint8_t> file = readFile(path);
+	file[sizeof(FileHeader) + sizeof(uint64_t)] ^= 0xFF;
+	writeFile(path, file);
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 2);
+
+	// The stale file got replaced
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 2);
+}
+
+TEST_F(RoutineStoreTest, CorruptedFile)
+{
+	RoutineStore::Key key("TestRoutine");
+
+	run(key, 42);
+	ASSERT_EQ(files().size(), 1u);
+
+	std::string path = files()[0];
+	std::vector<uint8_t> file = readFile(path);
+
+	// Code which doesn't match its digest
+	std::vector<uint8_t> corrupted = file;
+	corrupted.back() ^= 0xFF;
+	writeFile(path, corrupted);
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 2);
+
+	// A truncated file
+	std::vector<uint8_t> truncated(file.begin(), file.end() - 1);
+	writeFile(path, truncated);
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 3);
+
+	// A file too short to hold the header
+	writeFile(path, std::vector<uint8_t>(file.begin(), file.begin() + 4));
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 4);
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 4);
+}
+
+TEST_F(RoutineStoreTest, Disabled)
+{
+	RoutineStore::Key key("TestRoutine");
+
+	run(key, 42);
+	RoutineStore::disable();
+	EXPECT_FALSE(RoutineStore::isEnabled());
+
+	EXPECT_EQ(run(key, 42), 42);
+	EXPECT_EQ(generated, 2);
+}
+#endif
@@ -217,7 +217,7 @@ VkResult Device::CreatePipelineLayout(
 
 VkResult Device::CreateComputePipeline(
 		VkShaderModule module, VkPipelineLayout pipelineLayout,
-		VkPipeline* out) const
+		VkPipeline* out, VkPipelineCache pipelineCache) const
 {
 	VkComputePipelineCreateInfo info = {
 		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, // sType
@@ -238,7 +238,41 @@ VkResult Device::CreateComputePipeline(
 		0,              // basePipelineIndex
 	};
 
-	return driver->vkCreateComputePipelines(device, 0, 1, &info, 0, out);
+	return driver->vkCreateComputePipelines(device, pipelineCache, 1, &info, 0, out);
+}
+
+VkResult Device::CreatePipelineCache(
+		const std::vector<uint8_t>& initialData, VkPipelineCache* out) const
+{
+	VkPipelineCacheCreateInfo info = {
+		VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, // sType
+		nullptr,                                      // pNext
+		0,                                            // flags
+		initialData.size(),                           // initialDataSize
+		initialData.data(),                           // pInitialData
+	};
+
+	return driver->vkCreatePipelineCache(device, &info, 0, out);
+}
+
+VkResult Device::GetPipelineCacheData(
+		VkPipelineCache pipelineCache, std::vector<uint8_t>& out) const
+{
+	size_t size = 0;
+	VkResult result = driver->vkGetPipelineCacheData(device, pipelineCache, &size, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	out.resize(size);
+	return driver->vkGetPipelineCacheData(device, pipelineCache, &size, out.data());
+}
+
+VkResult Device::MergePipelineCaches(
+		VkPipelineCache dstCache, const std::vector<VkPipelineCache>& srcCaches) const
+{
+	return driver->vkMergePipelineCaches(device, dstCache, srcCaches.size(), srcCaches.data());
 }
 
 VkResult Device::CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
@@ -261,6 +295,22 @@ VkResult Device::CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
 	return driver->vkCreateDescriptorPool(device, &info, 0, out);
 }
 
+VkResult Device::CreateDescriptorPool(VkDescriptorPoolCreateFlags flags,
+		uint32_t maxSets, const std::vector<VkDescriptorPoolSize>& poolSizes,
+		VkDescriptorPool* out) const
+{
+	VkDescriptorPoolCreateInfo info = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, // sType
+		nullptr,                                       // pNext
+		flags,                                         // flags
+		maxSets,                                       // maxSets
+		(uint32_t)poolSizes.size(),                    // poolSizeCount
+		poolSizes.data(),                              // pPoolSizes
+	};
+
+	return driver->vkCreateDescriptorPool(device, &info, 0, out);
+}
+
 VkResult Device::AllocateDescriptorSet(
 		VkDescriptorPool pool, VkDescriptorSetLayout layout,
 		VkDescriptorSet* out) const
@@ -276,6 +326,33 @@ VkResult Device::AllocateDescriptorSet(
 	return driver->vkAllocateDescriptorSets(device, &info, out);
 }
 
+VkResult Device::AllocateDescriptorSets(
+		VkDescriptorPool pool, const std::vector<VkDescriptorSetLayout>& layouts,
+		std::vector<VkDescriptorSet>& out) const
+{
+	VkDescriptorSetAllocateInfo info = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, // sType
+		nullptr,                                        // pNext
+		pool,                                           // descriptorPool
+		(uint32_t)layouts.size(),                       // descriptorSetCount
+		layouts.data(),                                 // pSetLayouts
+	};
+
+	out.resize(layouts.size());
+	return driver->vkAllocateDescriptorSets(device, &info, out.data());
+}
+
+VkResult Device::FreeDescriptorSets(
+		VkDescriptorPool pool, const std::vector<VkDescriptorSet>& descriptorSets) const
+{
+	return driver->vkFreeDescriptorSets(device, pool, descriptorSets.size(), descriptorSets.data());
+}
+
+VkResult Device::ResetDescriptorPool(VkDescriptorPool pool) const
+{
+	return driver->vkResetDescriptorPool(device, pool, 0);
+}
+
 void Device::UpdateStorageBufferDescriptorSets(
 		VkDescriptorSet descriptorSet,
 		const std::vector<VkDescriptorBufferInfo>& bufferInfos) const
@@ -62,22 +62,60 @@ public:
 			VkPipelineLayout *out) const;
 
 	// CreateComputePipeline creates a new compute pipeline with the entry point
-	// "main".
+	// "main", using the given pipeline cache if there is one.
 	VkResult CreateComputePipeline(VkShaderModule module,
 			VkPipelineLayout pipelineLayout,
-			VkPipeline *out) const;
+			VkPipeline *out,
+			VkPipelineCache pipelineCache = VK_NULL_HANDLE) const;
+
+	// CreatePipelineCache creates a new pipeline cache with the given initial
+	// data, which may be empty.
+	VkResult CreatePipelineCache(const std::vector<uint8_t> &initialData,
+			VkPipelineCache *out) const;
+
+	// GetPipelineCacheData wraps vkGetPipelineCacheData, returning all of the
+	// cache's data in out.
+	VkResult GetPipelineCacheData(VkPipelineCache pipelineCache,
+			std::vector<uint8_t> &out) const;
+
+	// MergePipelineCaches wraps vkMergePipelineCaches, supplying the first
+	// VkDevice parameter.
+	VkResult MergePipelineCaches(VkPipelineCache dstCache,
+			const std::vector<VkPipelineCache> &srcCaches) const;
 
 	// CreateStorageBufferDescriptorPool creates a new descriptor pool that can
 	// hold descriptorCount storage buffers.
 	VkResult CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
 			VkDescriptorPool *out) const;
 
+	// CreateDescriptorPool creates a new descriptor pool with the given flags,
+	// which can hold maxSets sets of the descriptors in poolSizes.
+	VkResult CreateDescriptorPool(VkDescriptorPoolCreateFlags flags,
+			uint32_t maxSets,
+			const std::vector<VkDescriptorPoolSize> &poolSizes,
+			VkDescriptorPool *out) const;
+
 	// AllocateDescriptorSet allocates a single descriptor set with the given
 	// layout from pool.
 	VkResult AllocateDescriptorSet(VkDescriptorPool pool,
 			VkDescriptorSetLayout layout,
 			VkDescriptorSet *out) const;
 
+	// AllocateDescriptorSets allocates a descriptor set for each of the given
+	// layouts from pool, with a single call.
+	VkResult AllocateDescriptorSets(VkDescriptorPool pool,
+			const std::vector<VkDescriptorSetLayout> &layouts,
+			std::vector<VkDescriptorSet> &out) const;
+
+	// FreeDescriptorSets wraps vkFreeDescriptorSets, supplying the first
+	// VkDevice parameter.
+	VkResult FreeDescriptorSets(VkDescriptorPool pool,
+			const std::vector<VkDescriptorSet> &descriptorSets) const;
+
+	// ResetDescriptorPool wraps vkResetDescriptorPool, supplying the first
+	// VkDevice parameter.
+	VkResult ResetDescriptorPool(VkDescriptorPool pool) const;
+
 	// UpdateStorageBufferDescriptorSets updates the storage buffers in
 	// descriptorSet with the given list of VkDescriptorBufferInfos.
 	void UpdateStorageBufferDescriptorSets(VkDescriptorSet descriptorSet,
@@ -38,6 +38,8 @@ VK_INSTANCE(vkCreateDescriptorSetLayout, VkResult, VkDevice, const VkDescriptorS
             const VkAllocationCallbacks*, VkDescriptorSetLayout*);
 VK_INSTANCE(vkCreateDevice, VkResult, VkPhysicalDevice, const VkDeviceCreateInfo*, const VkAllocationCallbacks*,
             VkDevice*);
+VK_INSTANCE(vkCreatePipelineCache, VkResult, VkDevice, const VkPipelineCacheCreateInfo*, const VkAllocationCallbacks*,
+            VkPipelineCache*);
 VK_INSTANCE(vkCreatePipelineLayout, VkResult, VkDevice, const VkPipelineLayoutCreateInfo*, const VkAllocationCallbacks*,
             VkPipelineLayout*);
 VK_INSTANCE(vkCreateShaderModule, VkResult, VkDevice, const VkShaderModuleCreateInfo*, const VkAllocationCallbacks*,
@@ -45,13 +47,17 @@ VK_INSTANCE(vkCreateShaderModule, VkResult, VkDevice, const VkShaderModuleCreate
 VK_INSTANCE(vkDestroyDevice, VkResult, VkDevice, const VkAllocationCallbacks*)
 VK_INSTANCE(vkEndCommandBuffer, VkResult, VkCommandBuffer);
 VK_INSTANCE(vkEnumeratePhysicalDevices, VkResult, VkInstance, uint32_t*, VkPhysicalDevice*)
+VK_INSTANCE(vkFreeDescriptorSets, VkResult, VkDevice, VkDescriptorPool, uint32_t, const VkDescriptorSet*);
 VK_INSTANCE(vkGetDeviceQueue, void, VkDevice, uint32_t, uint32_t, VkQueue*);
 VK_INSTANCE(vkGetPhysicalDeviceMemoryProperties, void, VkPhysicalDevice, VkPhysicalDeviceMemoryProperties*);
 VK_INSTANCE(vkGetPhysicalDeviceProperties, void, VkPhysicalDevice, VkPhysicalDeviceProperties*)
 VK_INSTANCE(vkGetPhysicalDeviceQueueFamilyProperties, void, VkPhysicalDevice, uint32_t*, VkQueueFamilyProperties*);
+VK_INSTANCE(vkGetPipelineCacheData, VkResult, VkDevice, VkPipelineCache, size_t*, void*);
 VK_INSTANCE(vkMapMemory, VkResult, VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void**);
+VK_INSTANCE(vkMergePipelineCaches, VkResult, VkDevice, VkPipelineCache, uint32_t, const VkPipelineCache*);
 VK_INSTANCE(vkQueueSubmit, VkResult, VkQueue, uint32_t, const VkSubmitInfo*, VkFence);
 VK_INSTANCE(vkQueueWaitIdle, VkResult, VkQueue);
+VK_INSTANCE(vkResetDescriptorPool, VkResult, VkDevice, VkDescriptorPool, VkDescriptorPoolResetFlags);
 VK_INSTANCE(vkUnmapMemory, void, VkDevice, VkDeviceMemory);
 VK_INSTANCE(vkUpdateDescriptorSets, void, VkDevice, uint32_t, const VkWriteDescriptorSet*, uint32_t,
             const VkCopyDescriptorSet*);
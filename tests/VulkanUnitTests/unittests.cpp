@@ -25,6 +25,7 @@
 
 #include <sstream>
 #include <cstring>
+#include <thread>
 
 namespace
 {
@@ -1369,3 +1370,265 @@ TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, SwitchPhi)
 
     test(src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return (i % 2) == 1 ? 1 : 2; });
 }
+
+// Base class for tests that only need a device.
+class SwiftShaderVulkanDeviceTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(driver.loadSwiftShader());
+
+        const VkInstanceCreateInfo createInfo = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+            nullptr,                                 // pNext
+            0,                                       // flags
+            nullptr,                                 // pApplicationInfo
+            0,                                       // enabledLayerCount
+            nullptr,                                 // ppEnabledLayerNames
+            0,                                       // enabledExtensionCount
+            nullptr,                                 // ppEnabledExtensionNames
+        };
+
+        VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+        ASSERT_TRUE(driver.resolve(instance));
+
+        VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+        ASSERT_TRUE(device->IsValid());
+    }
+
+    Driver driver;
+    VkInstance instance = VK_NULL_HANDLE;
+    std::unique_ptr<Device> device;
+};
+
+class SwiftShaderVulkanPipelineCacheTest : public SwiftShaderVulkanDeviceTest
+{
+protected:
+    void SetUp() override
+    {
+        SwiftShaderVulkanDeviceTest::SetUp();
+        if(HasFatalFailure())
+        {
+            return;
+        }
+
+        VK_ASSERT(device->CreateDescriptorSetLayout({}, &descriptorSetLayout));
+        VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+    }
+
+    // Creates a pipeline with an empty shader, which differs for each local size
+    void createPipeline(VkPipelineCache pipelineCache, int localSizeX)
+    {
+        std::stringstream src;
+        src <<
+                  "OpCapability Shader\n"
+                  "OpMemoryModel Logical GLSL450\n"
+                  "OpEntryPoint GLCompute %1 \"main\"\n"
+                  "OpExecutionMode %1 LocalSize " << localSizeX << " 1 1\n"
+             "%2 = OpTypeVoid\n"
+             "%3 = OpTypeFunction %2\n"         // void()
+             "%1 = OpFunction %2 None %3\n"     // -- Function begin --
+             "%4 = OpLabel\n"
+                  "OpReturn\n"
+                  "OpFunctionEnd\n";
+
+        VkShaderModule shaderModule;
+        VK_ASSERT(device->CreateShaderModule(compileSpirv(src.str().c_str()), &shaderModule));
+
+        VkPipeline pipeline;
+        VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline, pipelineCache));
+    }
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+};
+
+TEST_F(SwiftShaderVulkanPipelineCacheTest, Header)
+{
+    VkPipelineCache pipelineCache;
+    VK_ASSERT(device->CreatePipelineCache({}, &pipelineCache));
+
+    std::vector<uint8_t> data;
+    VK_ASSERT(device->GetPipelineCacheData(pipelineCache, data));
+    ASSERT_GE(data.size(), 16 + VK_UUID_SIZE);
+
+    uint32_t header[4];
+    memcpy(header, data.data(), sizeof(header));
+    EXPECT_EQ(header[0], 16U + VK_UUID_SIZE);  // headerLength
+    EXPECT_EQ(header[1], (uint32_t)VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+
+    uint32_t physicalDeviceCount = 1;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    driver.vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, &physicalDevice);
+
+    VkPhysicalDeviceProperties properties;
+    driver.vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    EXPECT_EQ(header[2], properties.vendorID);
+    EXPECT_EQ(header[3], properties.deviceID);
+    EXPECT_EQ(memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE), 0);
+}
+
+TEST_F(SwiftShaderVulkanPipelineCacheTest, RoundTrip)
+{
+    VkPipelineCache emptyCache;
+    VK_ASSERT(device->CreatePipelineCache({}, &emptyCache));
+
+    std::vector<uint8_t> emptyData;
+    VK_ASSERT(device->GetPipelineCacheData(emptyCache, emptyData));
+
+    VkPipelineCache pipelineCache;
+    VK_ASSERT(device->CreatePipelineCache({}, &pipelineCache));
+    createPipeline(pipelineCache, 1);
+
+    std::vector<uint8_t> data;
+    VK_ASSERT(device->GetPipelineCacheData(pipelineCache, data));
+    EXPECT_GT(data.size(), emptyData.size());
+
+    // A cache created from the data returns the same data
+    VkPipelineCache loadedCache;
+    VK_ASSERT(device->CreatePipelineCache(data, &loadedCache));
+
+    std::vector<uint8_t> loadedData;
+    VK_ASSERT(device->GetPipelineCacheData(loadedCache, loadedData));
+    EXPECT_EQ(loadedData, data);
+
+    // Data from another device is ignored
+    std::vector<uint8_t> otherDevice = data;
+    otherDevice[16] ^= 0xFF;  // pipelineCacheUUID
+
+    VkPipelineCache otherCache;
+    VK_ASSERT(device->CreatePipelineCache(otherDevice, &otherCache));
+
+    std::vector<uint8_t> otherData;
+    VK_ASSERT(device->GetPipelineCacheData(otherCache, otherData));
+    EXPECT_EQ(otherData, emptyData);
+}
+
+TEST_F(SwiftShaderVulkanPipelineCacheTest, Merge)
+{
+    VkPipelineCache emptyCache;
+    VK_ASSERT(device->CreatePipelineCache({}, &emptyCache));
+
+    std::vector<uint8_t> emptyData;
+    VK_ASSERT(device->GetPipelineCacheData(emptyCache, emptyData));
+
+    VkPipelineCache cacheA;
+    VK_ASSERT(device->CreatePipelineCache({}, &cacheA));
+    createPipeline(cacheA, 1);
+
+    VkPipelineCache cacheB;
+    VK_ASSERT(device->CreatePipelineCache({}, &cacheB));
+    createPipeline(cacheB, 2);
+
+    std::vector<uint8_t> dataA;
+    std::vector<uint8_t> dataB;
+    VK_ASSERT(device->GetPipelineCacheData(cacheA, dataA));
+    VK_ASSERT(device->GetPipelineCacheData(cacheB, dataB));
+    size_t mergedSize = dataA.size() + dataB.size() - emptyData.size();
+
+    // Merging two caches into each other concurrently must not deadlock
+    std::thread mergeIntoA([&] {
+        for(int i = 0; i < 100; i++)
+        {
+            EXPECT_EQ(device->MergePipelineCaches(cacheA, { cacheB }), VK_SUCCESS);
+        }
+    });
+
+    for(int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(device->MergePipelineCaches(cacheB, { cacheA }), VK_SUCCESS);
+    }
+
+    mergeIntoA.join();
+
+    VK_ASSERT(device->GetPipelineCacheData(cacheA, dataA));
+    VK_ASSERT(device->GetPipelineCacheData(cacheB, dataB));
+    EXPECT_EQ(dataA.size(), mergedSize);
+    EXPECT_EQ(dataB.size(), mergedSize);
+
+    // Merging again doesn't duplicate the entries
+    VK_ASSERT(device->MergePipelineCaches(cacheA, { cacheB }));
+    VK_ASSERT(device->GetPipelineCacheData(cacheA, dataA));
+    EXPECT_EQ(dataA.size(), mergedSize);
+}
+
+class SwiftShaderVulkanDescriptorPoolTest : public SwiftShaderVulkanDeviceTest
+{
+protected:
+    void SetUp() override
+    {
+        SwiftShaderVulkanDeviceTest::SetUp();
+        if(HasFatalFailure())
+        {
+            return;
+        }
+
+        VkDescriptorSetLayoutBinding binding = {
+            0,                                  // binding
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+            1,                                  // descriptorCount
+            VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+            0,                                  // pImmutableSamplers
+        };
+        VK_ASSERT(device->CreateDescriptorSetLayout({ binding }, &smallLayout));
+
+        binding.descriptorCount = 2;
+        VK_ASSERT(device->CreateDescriptorSetLayout({ binding }, &largeLayout));
+
+        // Exactly fits four small sets, or two large ones
+        VK_ASSERT(device->CreateDescriptorPool(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, 4,
+                                               { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 } }, &pool));
+    }
+
+    VkDescriptorSetLayout smallLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout largeLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+};
+
+TEST_F(SwiftShaderVulkanDescriptorPoolTest, FreeAndReset)
+{
+    std::vector<VkDescriptorSet> sets;
+    VK_ASSERT(device->AllocateDescriptorSets(pool, { smallLayout, smallLayout, smallLayout, smallLayout }, sets));
+
+    std::vector<VkDescriptorSet> more;
+    EXPECT_EQ(device->AllocateDescriptorSets(pool, { smallLayout }, more), VK_ERROR_OUT_OF_POOL_MEMORY);
+    EXPECT_EQ(more[0], (VkDescriptorSet)VK_NULL_HANDLE);
+
+    // A freed set gets reused by an allocation of the same size
+    VK_ASSERT(device->FreeDescriptorSets(pool, { sets[1] }));
+    VK_ASSERT(device->AllocateDescriptorSets(pool, { smallLayout }, more));
+    EXPECT_EQ(more[0], sets[1]);
+
+    // Resetting makes the whole pool available again
+    VK_ASSERT(device->ResetDescriptorPool(pool));
+
+    std::vector<VkDescriptorSet> reallocated;
+    VK_ASSERT(device->AllocateDescriptorSets(pool, { largeLayout, largeLayout }, reallocated));
+    EXPECT_EQ(reallocated[0], sets[0]);
+}
+
+TEST_F(SwiftShaderVulkanDescriptorPoolTest, FragmentedOrOutOfMemory)
+{
+    std::vector<VkDescriptorSet> sets;
+    VK_ASSERT(device->AllocateDescriptorSets(pool, { smallLayout, smallLayout, smallLayout, smallLayout }, sets));
+
+    // One freed small set can't hold a large one
+    VK_ASSERT(device->FreeDescriptorSets(pool, { sets[0] }));
+
+    std::vector<VkDescriptorSet> large;
+    EXPECT_EQ(device->AllocateDescriptorSets(pool, { largeLayout }, large), VK_ERROR_OUT_OF_POOL_MEMORY);
+
+    // Two non-adjacent ones have enough memory in total
+    VK_ASSERT(device->FreeDescriptorSets(pool, { sets[2] }));
+    EXPECT_EQ(device->AllocateDescriptorSets(pool, { largeLayout }, large), VK_ERROR_FRAGMENTED_POOL);
+
+    // Unless more sets are requested along with it
+    std::vector<VkDescriptorSet> several;
+    EXPECT_EQ(device->AllocateDescriptorSets(pool, { largeLayout, smallLayout }, several), VK_ERROR_OUT_OF_POOL_MEMORY);
+    EXPECT_EQ(several[0], (VkDescriptorSet)VK_NULL_HANDLE);
+    EXPECT_EQ(several[1], (VkDescriptorSet)VK_NULL_HANDLE);
+
+    // The freed sets are still usable
+    VK_ASSERT(device->AllocateDescriptorSets(pool, { smallLayout, smallLayout }, several));
+}
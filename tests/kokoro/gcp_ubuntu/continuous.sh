@@ -17,6 +17,9 @@ make --jobs=$(nproc)
 # Run the reactor unit tests.
 ./ReactorUnitTests
 
+# Run the unit tests of the device's caches.
+./device-unittests
+
 # Run the GLES unit tests. TODO(capn): rename.
 ./unittests
 
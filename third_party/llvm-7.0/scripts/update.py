@@ -67,7 +67,7 @@ LLVM_TRIPLES = {
 LLVM_OPTIONS = [
     '-DCMAKE_BUILD_TYPE=Release',
     '-DLLVM_TARGETS_TO_BUILD=' + ';'.join(t[0] for t in LLVM_TARGETS),
-    '-DLLVM_ENABLE_THREADS=OFF',
+    '-DLLVM_ENABLE_THREADS=ON',
     '-DLLVM_ENABLE_TERMINFO=OFF',
     '-DLLVM_ENABLE_LIBXML2=OFF',
     '-DLLVM_ENABLE_LIBEDIT=OFF',